@@ -3,6 +3,8 @@
 #include <filesystem>
 #include <iomanip>
 #include <chrono>
+#include <fstream>
+#include <sstream>
 #ifdef _WIN32
 #include <windows.h>
 #endif
@@ -10,6 +12,9 @@
 #include "video2srt_native/core.hpp"
 #include "video2srt_native/config_manager.hpp"
 #include "video2srt_native/model_manager.hpp"
+#include "video2srt_native/stats.hpp"
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/metrics.hpp"
 
 static void print_usage() {
     std::cout << "Video2SRT Native CLI " << v2s::version() << "\n";
@@ -20,6 +25,7 @@ static void print_usage() {
     std::cout << "  -o, --output <file>     输出字幕文件路径 (默认: 与输入文件同名.扩展名)\n";
     std::cout << "  -l, --language <lang>   指定语言 (默认: auto)\n";
     std::cout << "  -m, --model <size>      模型大小 (tiny/base/small/medium/large, 默认: base)\n";
+    std::cout << "  --embedded-subs <mode>  复用容器内的文本字幕流并跳过转录: off / auto（与源语言一致时，默认）/ always\n";
     std::cout << "  --gpu                   使用GPU加速 (如果可用)\n";
     std::cout << "  --threads <n>           CPU线程数 (默认: 4)\n";
     std::cout << "  --merge                 合并短段落\n";
@@ -27,11 +33,24 @@ static void print_usage() {
     std::cout << "  --max-duration <sec>    最大段落时长 (默认: 30.0)\n";
     std::cout << "  --max-chars <n>         最大字符数 (默认: 500)\n";
     std::cout << "  --format <fmt>          输出格式: srt / vtt / ass (默认: srt)\n";
-    std::cout << "  --translate <lang>      目标语言代码 (例如: zh, en)，未设置则不翻译\n";
+    std::cout << "  --translate <lang>      目标语言代码 (例如: zh, en)，逗号分隔可一次翻译多种语言\n";
+    std::cout << "                          (例如: zh,ja,es，每种语言输出 <名称>.<语言>.<格式>)，未设置则不翻译\n";
     std::cout << "  --translator <type>     翻译器类型: simple / google / openai / offline\n";
     std::cout << "  --timeout <sec>         翻译请求超时（秒），覆盖默认配置\n";
     std::cout << "  --retry <n>             翻译失败重试次数，覆盖默认配置\n";
-    std::cout << "  --ssl-bypass            (Windows) 忽略SSL证书错误（WinHTTP，谨慎使用）\n";
+    std::cout << "  --translate-concurrency <n> 同时在途的翻译请求数（OpenAI，默认读取配置，1 为串行）\n";
+    std::cout << "  --translate-batch       聚合翻译：按 token 预算把多个片段合并为一次请求（OpenAI）\n";
+    std::cout << "  --translate-adaptive-batch 按端点自适应批大小（依据每段耗时与解析成功率，结果保存在缓存目录）\n";
+    std::cout << "  --translate-stream      流式接收批量译文（SSE），译文逐段就绪，缩短首条译文等待\n";
+    std::cout << "  --translate-batch-format <fmt> 批量请求格式: lines（紧凑编号行，默认）/ json\n";
+    std::cout << "  --rate-limit <rps>      每秒翻译请求数上限（0 为不限，服务端 Retry-After/x-ratelimit-* 始终生效）\n";
+    std::cout << "  --hedge                 对冲请求：超过近期 p95 耗时仍未返回时再发一份，先返回者胜出（降低尾延迟）\n";
+    std::cout << "  --usage-log <path>      每个翻译请求追加一行 JSONL 用量记录（token、重试、浪费）\n";
+    std::cout << "  --usage-tag <tag>       写入用量记录的归属标签（如客户或任务 ID）\n";
+    std::cout << "  --no-cache              禁用持久翻译缓存（translation.cache_enabled）\n";
+    std::cout << "  --cache-dir <dir>       翻译缓存目录 (默认: 程序目录下 cache/)\n";
+    std::cout << "  --fuzzy-memory          模糊翻译记忆：复用近似重复行（标点、大小写等差异）的已有译文\n";
+    std::cout << "  --ssl-bypass            忽略SSL证书错误（谨慎使用）\n";
     std::cout << "  --ass-style-name <s>    ASS样式名称 (默认: Default)\n";
     std::cout << "  --ass-font-name <s>     ASS字体名称 (默认: Arial)\n";
     std::cout << "  --ass-font-size <n>     ASS字体大小 (默认: 36)\n";
@@ -42,6 +61,11 @@ static void print_usage() {
     std::cout << "  --bilingual             生成双语字幕 (原文+译文)\n";
     std::cout << "  --audio-only            仅提取音频 (输出WAV文件)\n";
     std::cout << "  --check                 检查系统能力\n";
+    std::cout << "  --stats-json <file>     将处理统计（各阶段耗时/RTF/IO/HTTP/峰值内存）以JSON写入文件，- 表示标准输出\n";
+    std::cout << "  --trace <file>          记录各阶段耗时区间，导出为 Chrome trace JSON（可用 Perfetto 打开）\n";
+    std::cout << "  --deadline <秒>          处理截止时长，超时后中止解码/转录/翻译并清理临时文件\n";
+    std::cout << "  --metrics-port <port>   在 127.0.0.1:<port>/metrics 暴露 Prometheus 文本格式指标\n";
+    std::cout << "  --metrics-dump <file>   退出前将指标以 Prometheus 文本格式写入文件\n";
     std::cout << "\n模型管理:\n";
     std::cout << "  --list-models           列出支持的模型及下载状态\n";
     std::cout << "  --download-model <size> 下载指定模型 (tiny/base/small/medium/large)\n";
@@ -128,6 +152,15 @@ static std::string generate_output_path(const std::string& input_path, bool audi
     return output.string();
 }
 
+static void write_trace_file(const std::string& path) {
+    v2s::trace::stop();
+    if (v2s::trace::write_chrome_json(path)) {
+        std::cout << "追踪文件已写入: " << path << "\n";
+    } else {
+        std::cerr << "警告: 无法写入追踪文件 " << path << "\n";
+    }
+}
+
 int main(int argc, char** argv) {
 #ifdef _WIN32
     // 设置 Windows 控制台为 UTF-8，避免中文输出乱码
@@ -146,6 +179,7 @@ int main(int argc, char** argv) {
     std::string model_size = "base";
     bool use_gpu = false;
     int threads = 4;
+    std::string embedded_subtitles;
     bool merge_segments = false;
     double min_duration = 1.0;
     double max_duration = 30.0;
@@ -158,6 +192,18 @@ int main(int argc, char** argv) {
     std::string translator_type;
     int translator_timeout = -1;
     int translator_retry = -1;
+    int translator_concurrency = -1;
+    double translator_rate_limit = -1.0;
+    bool translator_batch = false;
+    bool translator_stream = false;
+    bool translator_adaptive_batch = false;
+    std::string translator_batch_format;
+    bool translator_hedge = false;
+    std::string usage_log_path;
+    std::string usage_tag;
+    bool no_translation_cache = false;
+    bool fuzzy_memory = false;
+    std::string translation_cache_dir;
     bool translator_ssl_bypass = false;
     bool ssl_bypass_set = false;
     // ASS 样式选项
@@ -173,6 +219,12 @@ int main(int argc, char** argv) {
     std::string download_model_size;
     std::string delete_model_size;
     std::string model_dir;
+    // 统计输出
+    std::string stats_json_path;
+    double deadline_seconds = 0.0;
+    std::string trace_path;
+    int metrics_port = -1;
+    std::string metrics_dump_path;
     
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -203,6 +255,17 @@ int main(int argc, char** argv) {
                 std::cerr << "错误: " << arg << " 需要参数\n";
                 return 1;
             }
+        } else if (arg == "--embedded-subs") {
+            if (i + 1 < argc) {
+                embedded_subtitles = argv[++i];
+                if (embedded_subtitles != "off" && embedded_subtitles != "auto" && embedded_subtitles != "always") {
+                    std::cerr << "错误: --embedded-subs 仅支持 off/auto/always\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
         } else if (arg == "--gpu") {
             use_gpu = true;
         } else if (arg == "--threads") {
@@ -265,6 +328,58 @@ int main(int argc, char** argv) {
                 std::cerr << "错误: " << arg << " 需要参数\n";
                 return 1;
             }
+        } else if (arg == "--no-cache") {
+            no_translation_cache = true;
+        } else if (arg == "--fuzzy-memory") {
+            fuzzy_memory = true;
+        } else if (arg == "--cache-dir") {
+            if (i + 1 < argc) {
+                translation_cache_dir = argv[++i];
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
+        } else if (arg == "--translate-concurrency") {
+            if (i + 1 < argc) {
+                translator_concurrency = std::stoi(argv[++i]);
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
+        } else if (arg == "--translate-batch") {
+            translator_batch = true;
+        } else if (arg == "--translate-stream") {
+            translator_stream = true;
+        } else if (arg == "--translate-adaptive-batch") {
+            translator_batch = true;
+            translator_adaptive_batch = true;
+        } else if (arg == "--translate-batch-format") {
+            if (i + 1 < argc) {
+                translator_batch_format = argv[++i];
+                if (translator_batch_format != "lines" && translator_batch_format != "json") {
+                    std::cerr << "错误: " << arg << " 仅支持 lines 或 json\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
+        } else if (arg == "--hedge") {
+            translator_hedge = true;
+        } else if (arg == "--usage-log" || arg == "--usage-tag") {
+            if (i + 1 < argc) {
+                (arg == "--usage-log" ? usage_log_path : usage_tag) = argv[++i];
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
+        } else if (arg == "--rate-limit") {
+            if (i + 1 < argc) {
+                translator_rate_limit = std::stod(argv[++i]);
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
         } else if (arg == "--ssl-bypass") {
             translator_ssl_bypass = true;
             ssl_bypass_set = true;
@@ -349,6 +464,54 @@ int main(int argc, char** argv) {
                 std::cerr << "错误: " << arg << " 需要参数\n";
                 return 1;
             }
+        } else if (arg == "--stats-json") {
+            if (i + 1 < argc) {
+                stats_json_path = argv[++i];
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
+        } else if (arg == "--deadline") {
+            if (i + 1 < argc) {
+                try {
+                    deadline_seconds = std::stod(argv[++i]);
+                } catch (...) {
+                    std::cerr << "错误: 无效的截止时长 " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
+        } else if (arg == "--metrics-port") {
+            if (i + 1 < argc) {
+                try {
+                    metrics_port = std::stoi(argv[++i]);
+                } catch (...) {
+                    metrics_port = -1;
+                }
+                if (metrics_port < 0 || metrics_port > 65535) {
+                    std::cerr << "错误: 无效的端口号 " << argv[i] << "\n";
+                    return 1;
+                }
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
+        } else if (arg == "--metrics-dump") {
+            if (i + 1 < argc) {
+                metrics_dump_path = argv[++i];
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
+        } else if (arg == "--trace") {
+            if (i + 1 < argc) {
+                trace_path = argv[++i];
+            } else {
+                std::cerr << "错误: " << arg << " 需要参数\n";
+                return 1;
+            }
         } else if (arg[0] != '-') {
             if (input_file.empty()) {
                 input_file = arg;
@@ -436,7 +599,11 @@ int main(int argc, char** argv) {
         config.language = std::nullopt;
     }
     if (!translate_to.empty()) {
-        config.translate_to = translate_to;
+        std::stringstream targets(translate_to);
+        std::string lang;
+        while (std::getline(targets, lang, ',')) {
+            if (!lang.empty()) config.translate_to.push_back(lang);
+        }
     }
     config.bilingual = bilingual;
     config.model_size = model_size;
@@ -463,9 +630,48 @@ int main(int argc, char** argv) {
     if (translator_retry >= 0) {
         config.translator_options.retry_count = translator_retry;
     }
+    if (translator_concurrency > 0) {
+        config.translator_options.max_concurrency = translator_concurrency;
+    }
+    if (translator_batch) {
+        config.translator_options.batch_mode = true;
+    }
+    if (translator_stream) {
+        config.translator_options.stream = true;
+    }
+    if (translator_adaptive_batch) {
+        config.translator_options.adaptive_batch = true;
+    }
+    if (!translator_batch_format.empty()) {
+        config.translator_options.batch_format = translator_batch_format;
+    }
+    if (translator_hedge) {
+        config.translator_options.hedge_requests = true;
+    }
+    if (!usage_log_path.empty()) {
+        config.translator_options.usage_log_path = usage_log_path;
+    }
+    if (!usage_tag.empty()) {
+        config.translator_options.usage_tag = usage_tag;
+    }
+    if (translator_rate_limit >= 0.0) {
+        config.translator_options.rate_limit_rps = translator_rate_limit;
+    }
     if (ssl_bypass_set) {
         config.translator_options.ssl_bypass = translator_ssl_bypass;
     }
+    if (no_translation_cache) {
+        config.translator_options.cache_enabled = false;
+    }
+    if (!translation_cache_dir.empty()) {
+        config.translator_options.cache_dir = translation_cache_dir;
+    }
+    if (fuzzy_memory) {
+        config.translator_options.fuzzy_memory = true;
+    }
+    if (!embedded_subtitles.empty()) {
+        config.embedded_subtitles = embedded_subtitles;
+    }
     // 应用ASS样式覆盖
     if (!ass_style_name.empty()) {
         config.ass_style.style_name = ass_style_name;
@@ -491,6 +697,24 @@ int main(int argc, char** argv) {
     
     // 创建处理器
     v2s::Processor processor(config);
+
+    if (metrics_port >= 0) {
+        if (v2s::metrics::start_http_endpoint(static_cast<uint16_t>(metrics_port))) {
+            std::cout << "指标端点: http://127.0.0.1:" << v2s::metrics::http_endpoint_port() << "/metrics\n";
+        } else {
+            std::cerr << "警告: 无法在端口 " << metrics_port << " 启动指标端点\n";
+        }
+    }
+    // 退出时（含失败路径）停止端点并按需转储指标
+    struct MetricsFinalizer {
+        const std::string& dump_path;
+        ~MetricsFinalizer() {
+            v2s::metrics::stop_http_endpoint();
+            if (!dump_path.empty() && !v2s::metrics::write_text_file(dump_path)) {
+                std::cerr << "警告: 无法写入指标文件 " << dump_path << "\n";
+            }
+        }
+    } metrics_finalizer{metrics_dump_path};
     
     std::cout << "Video2SRT Native CLI " << v2s::version() << "\n";
     std::cout << "输入文件: " << input_file << "\n";
@@ -501,7 +725,9 @@ int main(int argc, char** argv) {
         
         auto start_time = std::chrono::high_resolution_clock::now();
         
+        if (!trace_path.empty()) v2s::trace::start();
         bool success = processor.extract_audio_only(input_file, output_file, progress_callback);
+        if (!trace_path.empty()) write_trace_file(trace_path);
         
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time);
@@ -538,19 +764,81 @@ int main(int argc, char** argv) {
         
         auto start_time = std::chrono::high_resolution_clock::now();
         
-        v2s::ProcessingResult result = processor.process(input_file, output_file, progress_callback);
+        if (!trace_path.empty()) v2s::trace::start();
+        v2s::CancellationToken cancel;
+        if (deadline_seconds > 0.0) {
+            cancel = v2s::CancellationToken::create();
+            cancel.set_deadline(v2s::CancellationToken::Clock::now() +
+                                std::chrono::milliseconds(static_cast<int64_t>(deadline_seconds * 1000.0)));
+        }
+        v2s::ProcessingResult result = processor.process(input_file, output_file, progress_callback, cancel);
+        if (!trace_path.empty()) write_trace_file(trace_path);
         
         auto end_time = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::seconds>(end_time - start_time);
+
+        if (!stats_json_path.empty()) {
+            const std::string json_text = v2s::stats_to_json(result.stats);
+            if (stats_json_path == "-") {
+                std::cout << "\n" << json_text << "\n";
+            } else {
+                std::ofstream ofs(stats_json_path, std::ios::out | std::ios::trunc);
+                if (ofs.is_open()) {
+                    ofs << json_text << "\n";
+                } else {
+                    std::cerr << "警告: 无法写入统计文件 " << stats_json_path << "\n";
+                }
+            }
+        }
         
         if (result.success) {
             std::cout << "\n转换完成!\n";
-            std::cout << "输出文件: " << result.output_path << "\n";
+            for (const auto& path : result.output_paths) {
+                std::cout << "输出文件: " << path << "\n";
+            }
             if (result.transcription.has_value()) {
                 std::cout << "检测语言: " << result.transcription->language << "\n";
                 std::cout << "段落数量: " << result.transcription->segments.size() << "\n";
             }
-            std::cout << "总耗时: " << duration.count() << "秒\n";
+            if (result.stats.subtitle_stream_index >= 0) {
+                std::cout << "字幕来源: 内嵌字幕流 #" << result.stats.subtitle_stream_index << "（未运行语音转录）\n";
+            }
+            if (result.translation.has_value() && (result.stats.translation.cache_hits > 0 || result.stats.translation.cache_misses > 0)) {
+                std::cout << "翻译缓存: 命中 " << result.stats.translation.cache_hits;
+                if (result.stats.translation.fuzzy_hits > 0) {
+                    std::cout << " / 模糊命中 " << result.stats.translation.fuzzy_hits;
+                }
+                std::cout << " / 未命中 " << result.stats.translation.cache_misses << "\n";
+            }
+            if (result.translation.has_value() && result.stats.translation.deduplicated_segments > 0) {
+                std::cout << "重复文本去重: " << result.stats.translation.deduplicated_segments << " 段未单独请求\n";
+            }
+            if (result.translation.has_value() && result.stats.translation.hedged_requests > 0) {
+                std::cout << "对冲请求: " << result.stats.translation.hedged_requests
+                          << " 次（胜出 " << result.stats.translation.hedge_wins << " 次）\n";
+            }
+            if (result.translation.has_value() && result.stats.translation.failover_segments > 0) {
+                std::cout << "故障转移: " << result.stats.translation.failover_segments << " 段由后备翻译器完成\n";
+            }
+            if (result.translation.has_value() && result.stats.translation.usage.requests_with_usage > 0) {
+                const auto& usage = result.stats.translation.usage;
+                std::cout << "Token 用量: 提示 " << usage.prompt_tokens << "（缓存 " << usage.cached_prompt_tokens
+                          << "）/ 生成 " << usage.completion_tokens << " / 浪费 " << usage.wasted_tokens
+                          << "，重试 " << result.stats.translation.retries << " 次";
+                if (result.stats.translation.estimated_cost > 0.0) {
+                    std::cout << "，估算费用 " << std::fixed << std::setprecision(4) << result.stats.translation.estimated_cost;
+                }
+                std::cout << "\n";
+            }
+            if (result.processing_time.has_value()) {
+                std::cout << "总耗时: " << std::fixed << std::setprecision(2) << result.processing_time.value() << "秒";
+                if (result.stats.real_time_factor > 0.0) {
+                    std::cout << " (RTF " << std::setprecision(3) << result.stats.real_time_factor << ")";
+                }
+                std::cout << "\n";
+            } else {
+                std::cout << "总耗时: " << duration.count() << "秒\n";
+            }
             return 0;
         } else {
             std::cerr << "\n转换失败: " << result.error_message << "\n";
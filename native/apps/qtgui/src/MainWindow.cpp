@@ -37,8 +37,8 @@
 class Worker : public QObject {
     Q_OBJECT
 public:
-    explicit Worker(v2s::ProcessingConfig cfg, bool audioOnly, QObject *parent = nullptr)
-        : QObject(parent), m_cfg(std::move(cfg)), m_audioOnly(audioOnly) {}
+    explicit Worker(v2s::ProcessingConfig cfg, bool audioOnly, v2s::CancellationToken cancel, QObject *parent = nullptr)
+        : QObject(parent), m_cfg(std::move(cfg)), m_audioOnly(audioOnly), m_cancel(std::move(cancel)) {}
 
 public slots:
     void run() {
@@ -48,11 +48,12 @@ public slots:
         };
 
         if (m_audioOnly) {
-            bool ok = processor.extract_audio_only(m_cfg.input_path, m_cfg.output_path, progress_cb);
+            bool ok = processor.extract_audio_only(m_cfg.input_path, m_cfg.output_path, progress_cb, m_cancel);
+            const char* failMsg = m_cancel.is_cancelled() ? v2s::cancellation_message(m_cancel.reason()) : "音频提取失败";
             Q_EMIT finished(ok, QString::fromUtf8(ok ? (std::string("完成: ") + m_cfg.output_path).c_str()
-                                                    : "音频提取失败"));
+                                                    : failMsg));
         } else {
-            v2s::ProcessingResult res = processor.process(m_cfg.input_path, m_cfg.output_path, progress_cb);
+            v2s::ProcessingResult res = processor.process(m_cfg.input_path, m_cfg.output_path, progress_cb, m_cancel);
             Q_EMIT finished(res.success, QString::fromUtf8(res.success ? (std::string("完成: ") + res.output_path).c_str()
                                                                       : res.error_message.c_str()));
         }
@@ -65,6 +66,7 @@ signals:
 private:
     v2s::ProcessingConfig m_cfg;
     bool m_audioOnly{false};
+    v2s::CancellationToken m_cancel;
 };
 
 MainWindow::MainWindow(QWidget *parent)
@@ -145,6 +147,10 @@ void MainWindow::setupUi() {
     m_startBtn = new QPushButton("开始转换");
     form->addWidget(m_startBtn, row, 0);
     connect(m_startBtn, &QPushButton::clicked, this, &MainWindow::onStart);
+    m_cancelBtn = new QPushButton("取消");
+    m_cancelBtn->setEnabled(false);
+    form->addWidget(m_cancelBtn, row, 4);
+    connect(m_cancelBtn, &QPushButton::clicked, this, &MainWindow::onCancel);
 
     m_progressBar = new QProgressBar; m_progressBar->setRange(0, 100); m_progressBar->setValue(0);
     form->addWidget(m_progressBar, row, 1, 1, 3);
@@ -351,6 +357,7 @@ void MainWindow::setControlsEnabled(bool enabled) {
     m_bilingualCheck->setEnabled(enabled);
     m_audioOnlyCheck->setEnabled(enabled);
     m_startBtn->setEnabled(enabled);
+    m_cancelBtn->setEnabled(!enabled);
     // 翻译器相关控件
     m_translatorCombo->setEnabled(enabled);
     m_targetLanguageCombo->setEnabled(enabled);
@@ -460,10 +467,10 @@ void MainWindow::onStart() {
     QString translatorType = m_translatorCombo->currentText();
     QString targetLang = m_targetLanguageCombo->currentText();
     if (translatorType == "不翻译" || targetLang == "不翻译") {
-        cfg.translate_to = std::nullopt;
+        cfg.translate_to.clear();
         cfg.translator_type = "simple"; // 保持 simple，确保管线连通
     } else {
-        cfg.translate_to = targetLang.toUtf8().constData();
+        cfg.translate_to = {targetLang.toUtf8().constData()};
         cfg.translator_type = translatorType.toUtf8().constData();
         // 通用选项
         cfg.translator_options.timeout_seconds = m_translatorTimeoutSpin->value();
@@ -490,7 +497,8 @@ void MainWindow::onStart() {
 
     // 创建线程与 worker
     auto *thread = new QThread(this);
-    auto *worker = new Worker(cfg, audioOnly);
+    m_cancelToken = v2s::CancellationToken::create();
+    auto *worker = new Worker(cfg, audioOnly, m_cancelToken);
     worker->moveToThread(thread);
     connect(thread, &QThread::started, worker, &Worker::run);
     connect(worker, &Worker::progress, this, &MainWindow::onProgress, Qt::QueuedConnection);
@@ -501,6 +509,13 @@ void MainWindow::onStart() {
     thread->start();
 }
 
+void MainWindow::onCancel() {
+    if (!m_processing) return;
+    m_cancelToken.cancel();
+    m_cancelBtn->setEnabled(false);
+    m_logEdit->appendPlainText("正在取消...");
+}
+
 void MainWindow::onProgress(const QString &stage, double progress, const QString &message) {
     int percent = qBound(0, static_cast<int>(progress * 100.0), 100);
     m_progressBar->setValue(percent);
@@ -511,6 +526,10 @@ void MainWindow::onFinished(bool ok, const QString &info) {
     m_processing = false;
     setControlsEnabled(true);
     m_logEdit->appendPlainText(info);
+    if (!ok && m_cancelToken.is_cancelled()) {
+        QMessageBox::information(this, "已取消", info);
+        return;
+    }
     QMessageBox::information(this, ok ? "成功" : "失败", ok ? "处理完成" : "处理失败");
 }
 
@@ -3,6 +3,8 @@
 #include <QMainWindow>
 #include <memory>
 
+#include "video2srt_native/cancellation.hpp"
+
 class QLineEdit;
 class QComboBox;
 class QCheckBox;
@@ -31,6 +33,7 @@ private slots:
     void onBrowseInput();
     void onBrowseOutput();
     void onStart();
+    void onCancel();
     void onFormatChanged(int);
 
     // 后台线程回调到 UI
@@ -61,6 +64,7 @@ private:
     QCheckBox *m_audioOnlyCheck;
     QPushButton *m_modelManageBtn;
     QPushButton *m_startBtn;
+    QPushButton *m_cancelBtn;
     QProgressBar *m_progressBar;
     QPlainTextEdit *m_logEdit;
 
@@ -89,6 +93,8 @@ private:
 
     // 线程状态
     bool m_processing{false};
+    // 当前作业的取消令牌（每次开始处理时重新创建）
+    v2s::CancellationToken m_cancelToken;
 
 private slots:
     void onManageModels();
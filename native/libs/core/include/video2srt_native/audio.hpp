@@ -1,13 +1,49 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include "cancellation.hpp"
+#include "models.hpp"
 
 namespace v2s {
 
+// 容器内的字幕流
+struct SubtitleStreamInfo {
+    int index = -1;                  // 容器内的流序号
+    std::string codec;               // 编解码器名称（subrip/ass/mov_text/hdmv_pgs_subtitle...）
+    std::string language;            // 容器语言标签（多为 ISO 639-2，如 eng/chi），缺失时为空
+    std::string title;               // 轨道标题，缺失时为空
+    bool is_text = false;            // 文本字幕（可直接解码为文字；位图字幕为 false）
+    bool is_default = false;         // 默认轨道
+    bool is_forced = false;          // 强制轨道（通常只含外语对白或标牌，不是完整字幕）
+};
+
+// 媒体探测信息
+struct MediaInfo {
+    double duration_seconds = 0.0;   // 容器时长（秒），未知时为 0
+    bool has_audio = false;          // 是否包含音频流
+    std::string audio_language;      // 首选音频流的语言标签，缺失时为空
+    std::vector<SubtitleStreamInfo> subtitle_streams;  // 全部字幕流
+};
+
+// 探测输入多媒体的基本信息（仅读取容器头部，不解码）
+// 返回 true 表示成功，false 表示失败或未编译 FFmpeg 支持。
+bool probe_media(const std::string& input_path, MediaInfo& info);
+
 // 将输入多媒体（视频/音频）解码为统一 WAV（如 16 kHz mono s16le）
 // 返回 true 表示成功，false 表示失败（可在日志中输出错误原因）。
+// cancel 被取消时通过 FFmpeg 中断回调尽快终止读取并返回 false。
 bool extract_audio_to_wav(const std::string& input_path,
                           const std::string& output_wav_path,
-                          int sample_rate = 16000);
+                          int sample_rate = 16000,
+                          const CancellationToken& cancel = CancellationToken{});
+
+// 将容器内的文本字幕流（SubRip/ASS/mov_text/WebVTT 等）解码为字幕段
+// 去除 ASS 覆盖标签与绘图指令，同一时间区间的多个事件合并为一段；其余流在解复用时直接丢弃
+// 返回 true 表示成功（segments 按开始时间排序，可能为空），false 表示失败、非文本流或未编译 FFmpeg 支持。
+bool extract_subtitle_segments(const std::string& input_path,
+                               int stream_index,
+                               std::vector<Segment>& segments,
+                               const CancellationToken& cancel = CancellationToken{});
 
 }
\ No newline at end of file
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace v2s {
+
+/**
+ * 按端点自适应的批大小（每次批量请求的字幕段数上限）
+ * - 爬坡：每积累若干个满批次的成功样本，比较“每段耗时”；仍在下降且解析成功率高时批大小增加 25%
+ * - 平台：每段耗时不再下降时退回到目前最优的批大小，稳定一段时间后重新试探（跟踪端点变化）
+ * - 退避：超时或请求过大（413/400）时批大小减半，输出畸形/截断时乘以 0.7，并暂停增长若干批次
+ * - 持久化：学到的批大小与每段耗时写入状态文件（JSON，按键合并），下次运行从该值开始
+ * 同一进程内同一键（端点 + 模型 + 格式 + 目标语言数）共享一个实例；线程安全
+ * token 预算（max_batch_prompt_tokens、max_tokens）仍是硬上限
+ */
+class AdaptiveBatchSizer {
+public:
+    struct Limits {
+        size_t min_segments = 4;       // 批大小下限
+        size_t max_segments = 256;     // 批大小上限
+        size_t initial_segments = 16;  // 状态文件中没有记录时的初始值
+    };
+
+    // 一次批量请求的结果分类
+    enum class Feedback {
+        Ok,          // 响应可用（可能个别条目无效）
+        Malformed,   // 输出畸形、截断或缺项
+        TooSlow,     // 超时或请求过大（413/400）
+        Ignore       // 与批大小无关的失败（5xx、429、取消等）
+    };
+
+    /**
+     * 获取共享实例；首次创建时从 state_file 读取该键学到的批大小
+     * @param key 端点、模型等组成的标识
+     * @param state_file 状态文件路径（为空则不持久化）
+     */
+    static std::shared_ptr<AdaptiveBatchSizer> for_key(const std::string& key,
+                                                       const std::filesystem::path& state_file,
+                                                       const Limits& limits);
+
+    AdaptiveBatchSizer(std::string key, std::filesystem::path state_file, const Limits& limits);
+
+    /**
+     * 当前批大小（段数）
+     */
+    size_t batch_segments() const;
+
+    /**
+     * 反馈一次批量请求（仅统计首个请求，不含恢复阶段的补发）
+     * @param segments 本批段数
+     * @param latency_ms 请求耗时（毫秒）
+     */
+    void record(size_t segments, double latency_ms, Feedback feedback);
+
+    /**
+     * 若批大小有变化则写回状态文件（与文件中其他键合并）
+     */
+    void save();
+
+private:
+    void load();
+    void grow();
+
+    const std::string key_;
+    const std::filesystem::path state_file_;
+    const Limits limits_;
+
+    mutable std::mutex mutex_;
+    double limit_ = 0.0;               // 当前批大小
+    size_t best_limit_ = 0;            // 每段耗时最低的批大小
+    double best_ms_per_segment_ = 0.0; // best_limit_ 处的每段耗时（0 表示尚无样本）
+    double success_rate_ = 1.0;        // 解析成功率（指数滑动平均）
+    // 当前批大小下的样本窗口
+    size_t window_batches_ = 0;
+    size_t window_segments_ = 0;
+    double window_ms_ = 0.0;
+    size_t cooldown_batches_ = 0;      // 退避后暂停增长的剩余批次
+    size_t plateau_windows_ = 0;       // 处于平台期的窗口数
+    bool dirty_ = false;
+};
+
+} // namespace v2s
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace v2s {
+
+/**
+ * 批量翻译的紧凑编号行格式（v2s-lines/1）
+ * 请求与响应均为每段一行 "<n>|<文本>"，n 从 1 开始；段内换行写作 "<br>"
+ * 与 JSON 数组相比省去引号、逗号与转义，译文侧同样更短
+ * 多目标语言响应以 "@<语言>" 行分节，每节内为编号行
+ * 格式变化时必须更新版本号（同时写入系统提示词与缓存命名空间）
+ */
+constexpr const char* kLinesWireFormatVersion = "v2s-lines/1";
+
+/**
+ * 把若干段文本编码为编号行（段内 \r\n、\n、\r 替换为 <br>）
+ */
+std::string encode_numbered_lines(const std::vector<std::string>& texts);
+
+/**
+ * 编号行解析结果
+ */
+struct NumberedLines {
+    std::vector<std::optional<std::string>> items;   // 按段下标（0 起）；未出现的编号为 nullopt
+    size_t numbered_lines = 0;                       // 识别出的有效编号行数
+    std::optional<size_t> last_index;                // 文本末尾所写的项（截断时该项可能不完整）；末尾为重复编号时为空
+    bool duplicates = false;                         // 出现重复编号（保留第一次）
+};
+
+/**
+ * 宽容解析编号行：
+ * - 分隔符接受 '|'、全角 '｜'、':'、'.'、')'，编号前可有空白或 "- "/"* " 列表标记
+ * - 超出 [1, count] 的编号与无编号的行视为上一项的续行（模型自行换行时以 \n 拼接）
+ * - 第一项之前的无编号行（如前言）、空行与代码块标记被忽略
+ * - <br>、<br/>、<br /> 还原为 \n，译文两端空白被去除
+ */
+NumberedLines parse_numbered_lines(std::string_view content, size_t count);
+
+/**
+ * 按 "@<语言>" 分节行（也接受 "[语言]"、"## 语言"、"语言:"，忽略大小写）拆分多语言响应
+ * @return 与 languages 一一对应的节内容；缺失的语言为空串
+ */
+std::vector<std::string> split_language_sections(std::string_view content, const std::vector<std::string>& languages);
+
+/**
+ * 流式编号行解析：按任意边界喂入文本，某一项在下一条编号行开始时视为完整并回调
+ * （续行会并入当前项）；finish() 回调最后一项，输出被截断时不应调用
+ */
+class NumberedLinesStreamer {
+public:
+    using ItemCallback = std::function<void(size_t index, std::string value)>;
+
+    NumberedLinesStreamer(size_t count, ItemCallback on_item);
+
+    void feed(std::string_view chunk);
+    void finish();
+
+    size_t emitted() const { return emitted_; }
+
+private:
+    void process_line(std::string_view line);
+    void flush();
+
+    size_t count_;
+    ItemCallback on_item_;
+    std::string line_;
+    std::optional<size_t> pending_index_;
+    std::string pending_;
+    std::vector<char> seen_;
+    size_t emitted_ = 0;
+};
+
+} // namespace v2s
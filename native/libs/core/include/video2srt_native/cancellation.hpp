@@ -0,0 +1,89 @@
+#pragma once
+
+#include <chrono>
+#include <initializer_list>
+#include <memory>
+#include <optional>
+
+namespace v2s {
+
+/**
+ * 取消令牌：在调用方与长耗时流程（音频解码、Whisper 推理、HTTP 请求）之间共享取消状态
+ * 拷贝后共享同一状态；默认构造的令牌永远不会被取消，可作为“无取消”参数
+ * 线程安全：任意线程均可调用 cancel()/set_deadline()/is_cancelled()
+ */
+class CancellationToken {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    enum class Reason {
+        None,               // 未取消
+        Cancelled,          // 调用方主动取消
+        DeadlineExceeded    // 超过截止时间
+    };
+
+    /**
+     * 默认构造：空令牌（不可取消）
+     */
+    CancellationToken() = default;
+
+    /**
+     * 创建可取消的令牌
+     */
+    static CancellationToken create();
+
+    /**
+     * 创建联动令牌：自身被取消，或任一上级令牌被取消/超过截止时间时均视为已取消
+     * 上级令牌的取消不会主动唤醒本令牌上的 wait_for，等待按较短的间隔轮询
+     * @param parents 上级令牌（空令牌会被忽略）
+     */
+    static CancellationToken create_linked(std::initializer_list<CancellationToken> parents);
+
+    /**
+     * 是否为可取消的令牌（create() 得到）
+     */
+    bool can_be_cancelled() const { return static_cast<bool>(state_); }
+
+    /**
+     * 请求取消（唤醒所有 wait_for 中的线程）；空令牌调用无效果
+     */
+    void cancel() const;
+
+    /**
+     * 设置截止时间；到期后 is_cancelled() 返回 true
+     */
+    void set_deadline(Clock::time_point deadline) const;
+
+    /**
+     * 是否已取消或超过截止时间
+     */
+    bool is_cancelled() const;
+
+    /**
+     * 取消原因
+     */
+    Reason reason() const;
+
+    /**
+     * 距截止时间的剩余时长（未设置截止时间时为空，已过期时为 0）
+     */
+    std::optional<std::chrono::milliseconds> remaining() const;
+
+    /**
+     * 可被取消打断的等待（用于重试退避）
+     * @param duration 最长等待时长（同时受截止时间约束）
+     * @return 等待结束时是否已取消
+     */
+    bool wait_for(std::chrono::milliseconds duration) const;
+
+private:
+    struct State;
+    std::shared_ptr<State> state_;
+};
+
+/**
+ * 取消原因的中文描述（用于错误消息）
+ */
+const char* cancellation_message(CancellationToken::Reason reason);
+
+} // namespace v2s
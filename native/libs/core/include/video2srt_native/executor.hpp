@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+
+namespace v2s {
+
+/**
+ * 进程级共享线程池
+ * 用于并发发起网络请求等以等待为主的任务；工作线程按需增长，进程退出时回收
+ * 线程安全：任意线程均可提交任务
+ */
+class Executor {
+public:
+    /**
+     * 进程级共享实例
+     */
+    static Executor& shared();
+
+    Executor();
+    ~Executor();
+
+    Executor(const Executor&) = delete;
+    Executor& operator=(const Executor&) = delete;
+
+    /**
+     * 提交任务（异步执行，异常会被吞掉，需由任务自行处理）
+     */
+    void submit(std::function<void()> task);
+
+    /**
+     * 确保至少有 n 个工作线程（上限 kMaxWorkers）
+     */
+    void ensure_workers(size_t n);
+
+    /**
+     * 当前工作线程数
+     */
+    size_t worker_count() const;
+
+    static constexpr size_t kMaxWorkers = 64;
+
+private:
+    struct Impl;
+    Impl* impl_;
+};
+
+/**
+ * 并发执行 fn(0..count-1)，最多 max_parallel 个任务同时运行
+ * 调用线程本身参与执行，其余由共享线程池承担；即使线程池繁忙或嵌套调用也不会死锁。
+ * max_parallel <= 1 时在调用线程内顺序执行。
+ * 任一 fn 抛出异常时，停止分派剩余下标，等待已开始的任务完成后重新抛出第一个异常。
+ * @param count 任务数
+ * @param max_parallel 最大并发数
+ * @param fn 任务函数，参数为下标
+ */
+void parallel_for(size_t count, size_t max_parallel, const std::function<void(size_t)>& fn);
+
+} // namespace v2s
@@ -0,0 +1,152 @@
+#pragma once
+
+#include "translator.hpp"
+#include "models.hpp"
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace v2s {
+
+/**
+ * 按类型与选项创建基础翻译器（不含去重/缓存装饰）
+ */
+using TranslatorFactory = std::function<std::unique_ptr<ITranslator>(const std::string& type,
+                                                                     const TranslatorOptions& opts)>;
+
+/**
+ * 对冲 + 故障转移组合翻译器（面向 p99 延迟）
+ * - 字幕段按翻译单元切分（与主翻译器的 request_groups 一致：逐段模式 1 段，批量翻译器为按其令牌预算与当前批量大小打包的一个批次），单元之间按主翻译器的 max_concurrency 并发
+ * - 对冲：单元耗时超过该翻译器近期 p95（不低于 hedge_min_delay_ms）仍未返回时，
+ *   向同一翻译器或链中下一个翻译器再发一份，先成功返回者胜出，另一份立即取消；
+ *   对冲数量受预算限制（约为单元数的 10%），端点整体变慢时不会成倍放大负载
+ * - 故障转移：某个翻译器在重试后仍失败的段交给链中的下一个翻译器；
+ *   连续多个单元整体失败的翻译器在冷却期内直接跳过
+ * 尝试在共享线程池中执行，每次尝试使用独立的子取消令牌，外部取消会传递给所有进行中的尝试；
+ * 各翻译器实例在单元与调用之间复用（并发的尝试各占一个实例）
+ * 尝试内部的单段回调（如流式译文）映射回调用方下标后立即转发，同一单元只转发最先产生事件的尝试；
+ * 胜出结果中未转发过的段在单元完成后补发
+ * 多目标语言：每个单元先在第一个可用的翻译器上一次翻译全部语言（走其 translate_call_multi，
+ * 批量翻译器的原文只发送一次），各语言仍失败的段再逐语言交给链中后续的翻译器；单段回调在单元完成后触发
+ */
+class FailoverTranslator : public ITranslator {
+public:
+    /**
+     * @param chain 翻译器链，第一个为主翻译器（其选项中的对冲设置与取消令牌对整条链生效）
+     * @param factory 基础翻译器工厂
+     */
+    FailoverTranslator(std::vector<TranslatorBackend> chain, TranslatorFactory factory);
+    ~FailoverTranslator() override;
+
+    TranslationResult translate_segments(const std::vector<Segment>& segments,
+                                         const std::string& target_language,
+                                         const std::string& source_language = "auto") override;
+
+    /**
+     * 调用令牌与主翻译器选项中的取消令牌联动，传递给所有进行中的尝试
+     */
+    TranslationResult translate_call(const std::vector<Segment>& segments,
+                                     const std::string& target_language,
+                                     const std::string& source_language,
+                                     const TranslationCall& call) override;
+
+    std::vector<TranslationResult> translate_call_multi(const std::vector<Segment>& segments,
+                                                        const std::vector<std::string>& target_languages,
+                                                        const std::string& source_language,
+                                                        const TranslationCall& call) override;
+
+    /**
+     * 链中所有翻译器的命名空间拼接（任一不可缓存则整体不可缓存），
+     * 避免后备翻译器的译文混入主翻译器的缓存分区
+     */
+    std::string cache_namespace() const override { return cache_namespace_; }
+
+    /**
+     * 近期单元耗时窗口（按翻译器端点在进程内共享），用于计算对冲延迟
+     */
+    class LatencyWindow {
+    public:
+        void record(double ms);
+        /**
+         * 近期样本的分位数；样本不足时为空
+         */
+        std::optional<double> percentile(double p) const;
+
+        static constexpr size_t kCapacity = 256;
+        static constexpr size_t kMinSamples = 8;
+
+    private:
+        mutable std::mutex mutex_;
+        std::vector<double> samples_;
+        size_t next_ = 0;
+    };
+
+private:
+    struct Backend {
+        TranslatorBackend config;
+        std::shared_ptr<LatencyWindow> latency;
+        std::mutex idle_mutex;
+        std::vector<std::unique_ptr<ITranslator>> idle;   // 空闲的翻译器实例（同一实例同一时间只服务一次尝试）
+        std::atomic<int> consecutive_failures{0};
+        std::atomic<int64_t> down_until_ms{0};   // steady_clock 毫秒，冷却截止
+    };
+
+    // 单次调用的状态（生效的取消令牌与对冲预算），按引用向下传递，并发调用互不干扰
+    struct CallState {
+        CancellationToken cancel;          // 选项令牌 + 调用令牌
+        std::atomic<size_t> units_started{0};
+        std::atomic<size_t> hedges_sent{0};
+    };
+
+    struct Race;
+    struct Attempt;
+    struct UnitOutcome;
+
+    std::vector<std::unique_ptr<Backend>> chain_;
+    TranslatorFactory factory_;
+    std::string cache_namespace_;
+    CancellationToken options_cancel_;  // 主翻译器选项中的外部取消令牌
+
+    bool backend_available(size_t index) const;
+    void record_health(size_t index, bool all_failed);
+    std::chrono::milliseconds hedge_delay(const Backend& backend, const LatencyWindow& latency) const;
+    static bool take_hedge_budget(CallState& state);
+
+    std::unique_ptr<ITranslator> lease(size_t backend_index);
+    void release(size_t backend_index, std::unique_ptr<ITranslator> translator);
+
+    /**
+     * 执行一次尝试（单目标语言走 translate_call，多目标语言走 translate_call_multi）：
+     * 单目标语言的单段事件经 race 过滤后按 indices 映射为调用方下标转发给 call
+     */
+    void run_attempt(Race& race,
+                     Attempt& attempt,
+                     const std::vector<Segment>& segments,
+                     const std::vector<std::string>& target_languages,
+                     const std::string& source_language,
+                     const std::vector<size_t>& indices,
+                     const TranslationCall& call);
+
+    UnitOutcome run_on_backend(CallState& state,
+                               size_t backend_index,
+                               const std::vector<Segment>& segments,
+                               const std::vector<std::string>& target_languages,
+                               const std::string& source_language,
+                               const std::vector<size_t>& indices,
+                               const TranslationCall& call);
+
+    /**
+     * translate_call 与 translate_call_multi 的共同实现：结果与 target_languages 一一对应，请求统计在第一个结果上
+     */
+    std::vector<TranslationResult> run_call(const std::vector<Segment>& segments,
+                                            const std::vector<std::string>& target_languages,
+                                            const std::string& source_language,
+                                            const TranslationCall& call);
+};
+
+} // namespace v2s
@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+
+namespace v2s {
+
+/**
+ * 平台文件封装：按偏移读取、追加写入（持久缓存与翻译记忆的日志文件）
+ * Windows 使用 Win32 句柄，其他平台使用 POSIX 文件描述符
+ */
+class AppendFile {
+public:
+    AppendFile() = default;
+    ~AppendFile() { close(); }
+
+    AppendFile(const AppendFile&) = delete;
+    AppendFile& operator=(const AppendFile&) = delete;
+
+    /**
+     * 以读取 + 追加方式打开
+     * @param create 文件不存在时是否创建
+     */
+    bool open(const std::filesystem::path& path, bool create);
+    void close();
+
+    uint64_t size() const;
+
+    /**
+     * 从 offset 处读取 n 字节（不足 n 字节视为失败）
+     */
+    bool read_at(uint64_t offset, void* buf, size_t n) const;
+
+    /**
+     * 追加写入（调用方持有独占锁，单次写入整批记录）
+     */
+    bool append(const std::string& data);
+
+private:
+#if defined(_WIN32)
+    void* handle_ = reinterpret_cast<void*>(static_cast<intptr_t>(-1));   // INVALID_HANDLE_VALUE
+#else
+    int fd_ = -1;
+#endif
+};
+
+/**
+ * 跨进程独占文件锁（RAII，构造时阻塞等待）
+ */
+class FileLock {
+public:
+    explicit FileLock(const std::filesystem::path& path);
+    ~FileLock();
+
+    FileLock(const FileLock&) = delete;
+    FileLock& operator=(const FileLock&) = delete;
+
+    bool locked() const { return locked_; }
+
+private:
+#if defined(_WIN32)
+    void* handle_ = reinterpret_cast<void*>(static_cast<intptr_t>(-1));
+#else
+    int fd_ = -1;
+#endif
+    bool locked_ = false;
+};
+
+/**
+ * 只读内存映射（整文件）；映射后文件可被其他进程原子替换，本映射保持旧内容有效
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile() { close(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * 映射文件；空文件或打开失败时返回 false
+     */
+    bool open(const std::filesystem::path& path);
+    void close();
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool is_open() const { return data_ != nullptr; }
+
+private:
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+#if defined(_WIN32)
+    void* file_ = reinterpret_cast<void*>(static_cast<intptr_t>(-1));
+    void* mapping_ = nullptr;
+#endif
+};
+
+} // namespace v2s
@@ -0,0 +1,114 @@
+#pragma once
+
+#include "file_io.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace v2s {
+
+/**
+ * 模糊翻译记忆：复用近似重复行（仅标点、大小写或个别词不同）的已有译文
+ * - 相似度：归一化文本（小写、标点视为空白、折叠空白）按码点三元组集合计算的 Jaccard 系数
+ * - 索引：32 个 MinHash 分为 8 个 band × 4 行做 LSH 取候选，候选再按精确 Jaccard 复核
+ * - 存储（目录下）：
+ *   fuzzy.log 追加写记录（作用域、band 键、源文本、译文，带校验和），多进程在 fuzzy.lock 下追加
+ *   fuzzy.idx 按 band 键排序的只读索引，内存映射后直接二分查找（无需加载），覆盖日志的一个前缀；
+ *             之后追加的记录进入内存增量索引，增量过大时重建索引（超过容量上限时先按新近优先淘汰）
+ *   日志头的格式版本不符时不读取，首次写入前把旧日志改名为 fuzzy.log.old 再新建
+ * - 复用条件：相似度达到阈值，且两行的数字串与否定词（not/n't/never、不/没/别/未/无 等）按顺序完全一致
+ * 线程安全：同一进程内对同一目录共享一个实例（见 open()）
+ */
+class FuzzyTranslationMemory {
+public:
+    struct Match {
+        std::string translation;   // 复用的译文
+        double similarity = 0.0;   // 与记忆中源文本的相似度
+    };
+
+    /**
+     * 打开（或创建）记忆目录；同一进程内相同目录返回同一实例
+     * @param max_bytes 日志文件大小上限（字节），0 表示不限
+     * @return 实例；目录无法创建时返回空
+     */
+    static std::shared_ptr<FuzzyTranslationMemory> open(const std::filesystem::path& dir, uint64_t max_bytes);
+
+    /**
+     * 作用域：翻译器命名空间 + 语言对，只在同一作用域内匹配
+     */
+    static uint64_t make_scope(const std::string& translator_namespace,
+                               const std::string& source_language,
+                               const std::string& target_language);
+
+    /**
+     * 两段文本的相似度（0~1，归一化后相同为 1）
+     */
+    static double similarity(const std::string& a, const std::string& b);
+
+    /**
+     * 两行的数字串与否定词是否一致（不一致时即使相似度达标也不复用）
+     */
+    static bool guard_tokens_match(const std::string& a, const std::string& b);
+
+    /**
+     * 文本长度（UTF-8 码点数），用于“仅短行”限制
+     */
+    static size_t char_count(const std::string& text);
+
+    ~FuzzyTranslationMemory();
+
+    FuzzyTranslationMemory(const FuzzyTranslationMemory&) = delete;
+    FuzzyTranslationMemory& operator=(const FuzzyTranslationMemory&) = delete;
+
+    /**
+     * 批量查询
+     * @param threshold 最低相似度
+     * @return 与 texts 等长，未找到达到阈值（且数字、否定词一致）的记录时为空
+     */
+    std::vector<std::optional<Match>> lookup(uint64_t scope, const std::vector<std::string>& texts, double threshold);
+
+    /**
+     * 批量写入（源文本, 译文）
+     */
+    void insert(uint64_t scope, const std::vector<std::pair<std::string, std::string>>& entries);
+
+    /**
+     * 当前记录数（索引 + 增量，含被更新覆盖的旧记录）
+     */
+    size_t entry_count();
+
+private:
+    FuzzyTranslationMemory(std::filesystem::path dir, uint64_t max_bytes);
+
+    bool refresh_locked();
+    void load_index_locked();
+    void scan_locked(uint64_t from, uint64_t to);
+    bool append_locked(const std::string& records);
+    void rebuild_locked();
+    std::vector<uint64_t> candidates_locked(const uint64_t* band_keys) const;
+
+    std::filesystem::path dir_;
+    std::filesystem::path log_path_;
+    std::filesystem::path index_path_;
+    std::filesystem::path lock_path_;
+    uint64_t max_bytes_;
+
+    std::mutex mutex_;
+    std::unique_ptr<AppendFile> log_;
+    uint64_t generation_ = 0;             // 日志代数（重建并淘汰时更换）
+    uint64_t scanned_ = 0;                // 已纳入索引或增量的日志偏移
+    bool foreign_ = false;                // 日志头不是本格式版本（首次写入时改名为 .old 后新建）
+    MappedFile index_;                    // 只读索引（内存映射）
+    uint64_t index_entries_ = 0;
+    uint64_t index_stamp_ = 0;            // 索引文件的修改时间与大小摘要，变化时重新映射
+    std::unordered_multimap<uint64_t, uint64_t> delta_;   // band 键 -> 记录偏移（索引之后追加的记录）
+    size_t delta_records_ = 0;
+};
+
+} // namespace v2s
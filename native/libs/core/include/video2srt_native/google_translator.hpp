@@ -2,27 +2,80 @@
 
 #include "translator.hpp"
 #include "models.hpp"
+#include "rate_limiter.hpp"
+#include <memory>
+#include <mutex>
+#include <optional>
 
 namespace v2s {
 
 /**
- * Google 翻译器实现（使用 WinHTTP 发起请求）
+ * Google 翻译器实现（经由共享 HttpClient：Windows 使用 WinHTTP，其他平台使用 libcurl）
+ * 多个字幕段打包为一次 POST（重复的 q 参数），按字符数与段数分批；
+ * 批量响应无法对齐时该批退回逐段请求
  * 注意：使用的是非官方端点 translate.googleapis.com
  */
 class GoogleTranslator : public ITranslator {
 public:
     explicit GoogleTranslator(const TranslatorOptions& opts);
+    ~GoogleTranslator() override { finish_calls(); }
 
     TranslationResult translate_segments(const std::vector<Segment>& segments,
                                          const std::string& target_language,
                                          const std::string& source_language = "auto") override;
 
+    /**
+     * 一次调用的翻译过程（同步与异步入口共用）
+     */
+    TranslationResult translate_call(const std::vector<Segment>& segments,
+                                     const std::string& target_language,
+                                     const std::string& source_language,
+                                     const TranslationCall& call) override;
+
+    std::string cache_namespace() const override { return "google/gtx/p1"; }
+
+    /**
+     * 按字符数与段数分批（空文本无需请求）
+     */
+    std::vector<std::vector<size_t>> request_groups(const std::vector<Segment>& segments,
+                                                    const std::string& target_language,
+                                                    const std::string& source_language) const override;
+
 private:
+    /**
+     * 一次调用的状态（随参数传递，不写入成员，同一实例上的并发调用互不干扰）
+     */
+    struct CallState {
+        CancellationToken cancel;   // 联动 opts_.cancel 与调用令牌
+        std::mutex stats_mutex;     // 并发批次时保护 stats
+        TranslationStats stats;     // 本次调用的请求统计
+    };
+
     TranslatorOptions opts_;
+    std::shared_ptr<EndpointLimiter> limiter_;   // translate.googleapis.com 的共享限流器
+    EndpointLimiter::Registration limiter_config_;   // 本实例的限流配置登记（析构时撤销）
+
+    /**
+     * 发送请求（限流 + 重试），返回成功的响应体；全部失败时为空
+     */
+    std::optional<std::string> send_with_retry(CallState& state, HttpRequest req);
+
+    /**
+     * 逐段翻译（translate_a/single，拼接全部句子片段）
+     */
+    std::optional<std::string> translate_text(CallState& state,
+                                              const std::string& text,
+                                              const std::string& target_language,
+                                              const std::string& source_language);
 
-    std::string translate_text(const std::string& text,
-                               const std::string& target_language,
-                               const std::string& source_language);
+    /**
+     * 批量翻译（translate_a/t，POST 多个 q）
+     * @return 请求失败时为空；响应无法与输入对齐时为空列表
+     */
+    std::optional<std::vector<std::string>> translate_texts_batch(CallState& state,
+                                                                  const std::vector<std::string>& texts,
+                                                                  const std::string& target_language,
+                                                                  const std::string& source_language);
 };
 
-} // namespace v2s
\ No newline at end of file
+} // namespace v2s
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+#include "cancellation.hpp"
+
+namespace v2s {
+
+/**
+ * HTTP 请求描述
+ */
+struct HttpRequest {
+    std::string method = "GET";                                   // GET / POST
+    std::string url;                                              // 完整 URL（http:// 或 https://）
+    std::vector<std::pair<std::string, std::string>> headers;     // 附加请求头
+    std::string body;                                             // 请求体（POST）
+    int timeout_seconds = 15;            // 整个请求的超时（秒），0 表示不限（仅在长时间无数据时中止）
+    int connect_timeout_seconds = 10;    // 建立连接超时（秒）
+    bool ssl_bypass = false;             // 是否忽略SSL证书错误（谨慎使用）
+    int max_redirects = 5;               // 自动跟随重定向的最大次数，0 表示不跟随
+    CancellationToken cancel;            // 取消令牌（取消后尽快中止进行中的请求）
+
+    // 可选：流式接收响应体（设置后 HttpResponse::body 不再累积），返回 false 中止传输
+    // 注意：libcurl 后端在共享的网络线程中回调，应避免耗时操作
+    std::function<bool(const char* data, size_t size)> on_data;
+    // 可选：下载进度（已接收字节数、总字节数，未知时为 0）
+    std::function<void(uint64_t received, uint64_t total)> on_progress;
+};
+
+/**
+ * HTTP 响应
+ */
+struct HttpResponse {
+    int status = 0;                                               // HTTP 状态码，0 表示传输失败
+    std::string body;                                             // 响应体（未设置 on_data 时）
+    std::vector<std::pair<std::string, std::string>> headers;     // 响应头（名称为小写，仅最终响应）
+    std::string error;                                            // 传输失败原因
+    bool cancelled = false;                                       // 是否因取消而中止
+    bool timed_out = false;                                       // 是否因超时而失败
+    double elapsed_ms = 0.0;                                      // 本次请求耗时（毫秒）
+
+    bool ok() const { return status >= 200 && status < 300; }
+
+    /**
+     * 查找响应头（名称不区分大小写）
+     */
+    std::optional<std::string> header(const std::string& name) const;
+};
+
+/**
+ * 统一的重试策略（翻译器、模型下载等共用）
+ * 调用方在每次失败后用 is_retryable() 判断是否继续，并通过 CancellationToken::wait_for(next_delay(...)) 退避
+ */
+struct HttpRetryPolicy {
+    int max_retries = 0;                                          // 最大重试次数（不含首次请求）
+    std::chrono::milliseconds backoff{500};                       // 基础等待时长（抖动下限）
+    std::chrono::milliseconds max_backoff{10000};                 // 单次等待上限
+    std::chrono::milliseconds max_retry_after{60000};             // 采纳服务端 Retry-After 的上限
+
+    /**
+     * 该响应是否值得重试：传输失败、408、429 与 5xx 可重试，其余 4xx 不重试
+     */
+    static bool is_retryable(const HttpResponse& resp);
+
+    /**
+     * 下一次重试前的等待时长
+     * 采用 decorrelated jitter：在 [backoff, 3 * previous] 间均匀随机并封顶 max_backoff，
+     * 避免多个并发请求同步重试；响应带 Retry-After 时至少等待该时长（封顶 max_retry_after）
+     * @param previous 上一次的等待时长（首次重试传 0）
+     * @param resp 失败的响应
+     */
+    std::chrono::milliseconds next_delay(std::chrono::milliseconds previous, const HttpResponse& resp) const;
+};
+
+/**
+ * 解析响应中的 Retry-After（秒数或 HTTP 日期）
+ * @return 需等待的时长；不存在或无法解析时为空
+ */
+std::optional<std::chrono::milliseconds> parse_retry_after(const HttpResponse& resp);
+
+/**
+ * 进程级共享 HTTP 客户端
+ * - libcurl：单个 multi 句柄 + 后台网络线程，连接池/keep-alive、HTTP/2 多路复用（可用时）、
+ *   DNS 缓存与 TLS 会话复用在所有请求间共享；取消在 100ms 内生效
+ * - Windows：单个 WinHTTP 会话，连接池与 keep-alive 由 WinHTTP 维护，系统支持时启用 HTTP/2
+ * 线程安全：任意线程均可并发调用 send()
+ */
+class HttpClient {
+public:
+    /**
+     * 进程级共享实例
+     */
+    static HttpClient& shared();
+
+    ~HttpClient();
+
+    HttpClient(const HttpClient&) = delete;
+    HttpClient& operator=(const HttpClient&) = delete;
+
+    /**
+     * 同步发送一次请求（阻塞当前线程直到完成、失败或取消）
+     */
+    HttpResponse send(const HttpRequest& req);
+
+    /**
+     * 是否编译了可用的 HTTP 后端（WinHTTP 或 libcurl）
+     */
+    static bool available();
+
+private:
+    HttpClient();
+
+    struct Impl;
+    Impl* impl_;
+};
+
+} // namespace v2s
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace v2s {
+
+/**
+ * 极简 HTTP/1.1 服务端（仅用于本机调试端点与测试桩，不面向公网）
+ * 每个连接一个线程，支持 keep-alive 与 Content-Length 请求体
+ */
+class LocalHttpServer {
+public:
+    struct Request {
+        std::string method;
+        std::string path;                              // 含查询串
+        std::map<std::string, std::string> headers;    // 头名已转小写
+        std::string body;
+    };
+
+    struct Response {
+        int status = 200;
+        std::string content_type = "text/plain; charset=utf-8";
+        std::vector<std::pair<std::string, std::string>> headers;
+        std::string body;
+        bool close_connection = false;                 // 响应后关闭连接（用于模拟断连）
+    };
+
+    using Handler = std::function<Response(const Request&)>;
+
+    explicit LocalHttpServer(Handler handler);
+    ~LocalHttpServer();
+
+    LocalHttpServer(const LocalHttpServer&) = delete;
+    LocalHttpServer& operator=(const LocalHttpServer&) = delete;
+
+    /**
+     * 绑定并开始监听（后台线程接受连接）
+     * @param host 监听地址（IPv4）
+     * @param port 监听端口（0 表示由系统分配）
+     * @return 是否启动成功
+     */
+    bool start(const std::string& host, uint16_t port);
+
+    /**
+     * 停止监听并关闭所有连接（阻塞直到工作线程退出）
+     */
+    void stop();
+
+    /**
+     * 实际监听端口
+     */
+    uint16_t port() const { return port_; }
+
+    bool is_running() const { return running_.load(); }
+
+private:
+    void accept_loop();
+    void serve_connection(intptr_t fd);
+
+    Handler handler_;
+    intptr_t listen_fd_ = -1;
+    uint16_t port_ = 0;
+    std::atomic<bool> running_{false};
+    std::thread accept_thread_;
+
+    std::mutex conn_mutex_;
+    std::condition_variable conn_cv_;
+    std::vector<intptr_t> open_fds_;               // 活动连接（stop 时统一关闭）
+};
+
+} // namespace v2s
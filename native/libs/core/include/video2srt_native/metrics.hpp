@@ -0,0 +1,155 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace v2s {
+namespace metrics {
+
+/**
+ * 标签集合（按给定顺序输出），例如 {{"stage", "transcribe"}}
+ */
+using Labels = std::vector<std::pair<std::string, std::string>>;
+
+/**
+ * 单调递增计数器
+ */
+class Counter {
+public:
+    void inc(double v = 1.0);
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+/**
+ * 可增可减的瞬时值
+ */
+class Gauge {
+public:
+    void set(double v) { value_.store(v, std::memory_order_relaxed); }
+    void inc(double v = 1.0);
+    void dec(double v = 1.0) { inc(-v); }
+    double value() const { return value_.load(std::memory_order_relaxed); }
+
+private:
+    std::atomic<double> value_{0.0};
+};
+
+/**
+ * RAII：构造时 gauge += v，析构时 gauge -= v（用于进行中任务数/队列深度）
+ */
+class ScopedGaugeInc {
+public:
+    explicit ScopedGaugeInc(Gauge& g, double v = 1.0) : gauge_(g), v_(v) { gauge_.inc(v_); }
+    ~ScopedGaugeInc() { gauge_.dec(v_); }
+
+    ScopedGaugeInc(const ScopedGaugeInc&) = delete;
+    ScopedGaugeInc& operator=(const ScopedGaugeInc&) = delete;
+
+private:
+    Gauge& gauge_;
+    double v_;
+};
+
+/**
+ * 固定桶直方图（桶上界升序，+Inf 桶自动追加）
+ */
+class Histogram {
+public:
+    explicit Histogram(std::vector<double> bounds);
+
+    void observe(double v);
+
+    const std::vector<double>& bounds() const { return bounds_; }
+    /** 各桶（非累计）计数，最后一个为 +Inf 桶 */
+    std::vector<uint64_t> bucket_counts() const;
+    uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+    double sum() const { return sum_.load(std::memory_order_relaxed); }
+
+private:
+    std::vector<double> bounds_;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets_;
+    std::atomic<uint64_t> count_{0};
+    std::atomic<double> sum_{0.0};
+};
+
+/**
+ * 进程级指标注册表
+ * 同名同标签的指标只创建一次，返回的引用在进程生命周期内有效，
+ * 热路径可用函数内 static 引用缓存，避免重复查找
+ */
+class Registry {
+public:
+    static Registry& instance();
+
+    Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+    Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+    Histogram& histogram(const std::string& name, const std::string& help,
+                         const std::vector<double>& bounds, const Labels& labels = {});
+
+    /**
+     * 注册在导出时才求值的 gauge（例如当前常驻内存），同名重复注册会覆盖
+     */
+    void gauge_callback(const std::string& name, const std::string& help, std::function<double()> fn);
+
+    /**
+     * 按 Prometheus 文本格式（version 0.0.4）导出全部指标
+     */
+    std::string render_text() const;
+
+    Registry(const Registry&) = delete;
+    Registry& operator=(const Registry&) = delete;
+
+private:
+    Registry();
+    ~Registry();
+
+    struct Impl;
+    std::unique_ptr<Impl> impl_;
+};
+
+// 便捷函数：转发到 Registry::instance()
+Counter& counter(const std::string& name, const std::string& help, const Labels& labels = {});
+Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels = {});
+Histogram& histogram(const std::string& name, const std::string& help,
+                     const std::vector<double>& bounds, const Labels& labels = {});
+
+/**
+ * 默认延迟桶（秒）：5ms ~ 120s
+ */
+const std::vector<double>& latency_buckets_seconds();
+
+/**
+ * 将当前指标写入文本文件（用于进程退出时转储）
+ * @return 是否写入成功
+ */
+bool write_text_file(const std::filesystem::path& path);
+
+/**
+ * 在本地地址启动 /metrics HTTP 端点（后台线程）
+ * @param port 监听端口（0 表示由系统分配）
+ * @param host 监听地址，默认仅本机可访问
+ * @return 是否启动成功
+ */
+bool start_http_endpoint(uint16_t port, const std::string& host = "127.0.0.1");
+
+/**
+ * 当前端点实际监听端口（未启动时为 0）
+ */
+uint16_t http_endpoint_port();
+
+/**
+ * 停止 /metrics HTTP 端点
+ */
+void stop_http_endpoint();
+
+} // namespace metrics
+} // namespace v2s
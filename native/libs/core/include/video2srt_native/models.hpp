@@ -4,6 +4,8 @@
 #include <vector>
 #include <optional>
 #include <chrono>
+#include <cstdint>
+#include "cancellation.hpp"
 
 namespace v2s {
 
@@ -77,6 +79,46 @@ struct TranscriptionResult {
     }
 };
 
+/**
+ * 翻译请求的 token 用量（来自服务端响应的 usage；未返回 usage 的请求不计入）
+ */
+struct TokenUsage {
+    size_t prompt_tokens = 0;                   // 提示词 token（含命中缓存的部分）
+    size_t cached_prompt_tokens = 0;            // 其中命中服务端提示词缓存的 token
+    size_t completion_tokens = 0;               // 生成 token
+    size_t wasted_tokens = 0;                   // 回复未能使用的部分（解析失败、缺项、截断）按缺失比例折算的 token，缺失项会重新请求
+    size_t requests_with_usage = 0;             // 返回了 usage 的请求数
+
+    size_t total_tokens() const { return prompt_tokens + completion_tokens; }
+
+    TokenUsage& operator+=(const TokenUsage& other) {
+        prompt_tokens += other.prompt_tokens;
+        cached_prompt_tokens += other.cached_prompt_tokens;
+        completion_tokens += other.completion_tokens;
+        wasted_tokens += other.wasted_tokens;
+        requests_with_usage += other.requests_with_usage;
+        return *this;
+    }
+};
+
+/**
+ * 翻译过程统计（由翻译器在 translate_segments 中填充）
+ */
+struct TranslationStats {
+    size_t request_count = 0;                   // 发出的HTTP请求数（含重试）
+    size_t failed_requests = 0;                 // 失败的HTTP请求数（网络错误/非2xx/解析失败）
+    std::vector<double> request_latencies_ms;   // 每个HTTP请求的耗时（毫秒）
+    size_t cache_hits = 0;                      // 持久缓存命中的段数
+    size_t cache_misses = 0;                    // 持久缓存未命中（需要翻译）的段数
+    size_t fuzzy_hits = 0;                      // 由模糊翻译记忆复用近似行译文的段数
+    size_t deduplicated_segments = 0;           // 与前文完全相同（规范化后）而未单独请求的段数（逐段模式下即节省的请求数）
+    size_t hedged_requests = 0;                 // 发出的对冲请求数（主请求超过 p95 延迟仍未返回）
+    size_t hedge_wins = 0;                      // 对冲请求先于主请求返回的次数
+    size_t failover_segments = 0;               // 由故障转移链中后续翻译器完成的段数
+    size_t retries = 0;                         // 重试请求数（同一请求的第 2 次及以后的尝试）
+    TokenUsage usage;                           // token 用量
+};
+
 /**
  * 翻译结果数据结构
  * 对应Python版本的TranslationResult类
@@ -86,6 +128,8 @@ struct TranslationResult {
     std::string source_language;          // 源语言
     std::string target_language;          // 目标语言
     std::string translator_name;          // 翻译器名称
+    TranslationStats stats;               // 请求统计
+    std::vector<size_t> failed_indices;   // 翻译失败（保留原文）的段下标，升序
     
     TranslationResult() = default;
     
@@ -110,17 +154,53 @@ struct TranslationResult {
 struct TranslatorOptions {
     int timeout_seconds = 15;            // 请求超时
     int retry_count = 3;                 // 重试次数
-    bool ssl_bypass = false;             // 是否忽略SSL证书错误（仅Windows WinHTTP）
+    bool ssl_bypass = false;             // 是否忽略SSL证书错误（WinHTTP 与 libcurl 后端均生效）
     std::string api_key;                 // API密钥（OpenAI等）
     std::string base_url;                // 基础URL（OpenAI/自建网关）
     std::string model;                   // 模型名称（OpenAI）
-    int max_tokens = 4000;               // 最大tokens（OpenAI）
+    int max_tokens = 4000;               // 最大tokens（OpenAI，批量模式下同时作为译文 token 预算）
     double temperature = 0.3;            // 采样温度（OpenAI）
     // 批量/聚合翻译控制（可选，默认关闭以保持现有行为）
     bool batch_mode = false;             // 是否启用聚合翻译（一次请求翻译多个片段）
-    size_t max_batch_chars = 2000;       // 每批次最大字符数（按文本总长度控制）
-    int max_batch_segments = 8;          // 每批次最大字幕段数量
-    bool structured_json_output = true;  // 是否要求模型输出结构化 JSON（提升解析稳健性）
+    int max_batch_prompt_tokens = 2000;  // 每批次提示词 token 预算（估算值，含系统提示词与 JSON 封装）
+    int max_batch_segments = 0;          // 每批次最大字幕段数量，0 表示仅受 token 预算限制
+    bool adaptive_batch = false;         // 按端点自适应批大小（依据每段耗时与解析成功率，学到的值保存在缓存目录），max_batch_segments 为其上限
+    bool coalesce_batches = false;       // 跨任务合并批次：同进程内并发任务的待译段拼入同一请求（需 batch_mode）
+    int coalesce_linger_ms = 30;         // 未满批次等待其他任务补齐的最长时间（毫秒）
+    std::string batch_format = "lines";  // 批量请求格式：lines（紧凑编号行 v2s-lines/1，省 token）或 json（JSON 数组/对象）
+    bool structured_json_output = true;  // json 格式下是否要求模型输出结构化 JSON（response_format，提升解析稳健性）
+    bool stream = false;                 // 批量模式下使用流式响应（SSE），数组元素一闭合即回调下游
+    int max_concurrency = 1;             // 同时在途的翻译请求数（按片段或批次并发，1 为逐个串行）
+    // 端点限流（按 scheme://host:port 在进程内共享；服务端的 Retry-After / x-ratelimit-* 始终生效）
+    double rate_limit_rps = 0.0;         // 每秒请求数上限（令牌桶），0 表示不限
+    int rate_limit_burst = 0;            // 令牌桶容量（突发请求数），0 表示取 max(1, rps)
+    // 持久翻译缓存（键：规范化原文、源/目标语言、翻译器、模型、提示词版本）
+    bool cache_enabled = false;          // 是否启用持久翻译缓存
+    std::string cache_dir;               // 缓存目录（为空时使用当前目录下 cache/）
+    uint64_t cache_max_bytes = 64ull * 1024 * 1024; // 缓存日志大小上限（字节），超出后淘汰较旧条目
+    bool fuzzy_memory = false;           // 启用模糊翻译记忆（需启用持久缓存，存储于缓存目录下 fuzzy/）
+    double fuzzy_threshold = 0.9;        // 模糊匹配的最低相似度（归一化文本字符三元组的 Jaccard 系数）
+    size_t fuzzy_max_chars = 0;          // 仅对不超过该字符数的行做模糊匹配（0 表示不限）
+    bool deduplicate = true;             // 翻译前合并完全相同（规范化后）的段文本，每个唯一文本只翻译一次
+    // 对冲请求（尾延迟优化）：一个翻译单元超过近期 p95 耗时仍未返回时，再发一份请求，先返回者胜出，另一份被取消
+    bool hedge_requests = false;         // 是否启用对冲请求
+    bool hedge_to_fallback = false;      // 对冲请求发往故障转移链中的下一个翻译器（否则发往同一翻译器）
+    int hedge_min_delay_ms = 200;        // 对冲延迟下限（毫秒），避免在极快的端点上成倍放大请求
+    // 用量记录与计费
+    std::string usage_log_path;          // 每个请求追加一行 JSONL 用量记录（为空则不记录）
+    std::string usage_tag;               // 写入用量记录的归属标签（如客户或任务 ID）
+    double price_per_million_prompt_tokens = 0.0;      // 提示词单价（每百万 token），0 表示不估算费用
+    double price_per_million_cached_tokens = 0.0;      // 命中缓存的提示词单价，0 表示与普通提示词相同
+    double price_per_million_completion_tokens = 0.0;  // 生成单价
+    CancellationToken cancel;            // 取消令牌（由处理器注入，取消后停止重试并中断进行中的请求）
+};
+
+/**
+ * 故障转移链中的一个翻译器（类型与其独立的选项：端点、密钥、超时等）
+ */
+struct TranslatorBackend {
+    std::string type;                    // 翻译器类型（google / openai）
+    TranslatorOptions options;           // 该翻译器的选项
 };
 
 /**
@@ -145,11 +225,13 @@ struct ProcessingConfig {
     std::string output_path;               // 输出文件路径（可选）
     std::string model_size = "base";       // 模型大小
     std::optional<std::string> language;   // 源语言（None表示自动检测）
-    std::optional<std::string> translate_to; // 目标语言（None表示不翻译）
+    std::vector<std::string> translate_to; // 目标语言（为空表示不翻译；多个时每种语言输出一个文件）
     bool bilingual = false;                // 是否生成双语字幕
     std::string translator_type = "simple"; // 翻译器类型（默认simple，避免外部依赖）
     std::string device = "auto";           // 设备类型 (cpu, cuda, auto)
+    std::string embedded_subtitles = "auto"; // 内嵌文本字幕复用策略：off 不复用 / auto 语言与源语言匹配时复用 / always 有文本字幕即复用（复用时跳过音频提取与转录）
     TranslatorOptions translator_options;   // 翻译器选项
+    std::vector<TranslatorBackend> fallback_translators; // 故障转移链（general.fallback_translator），主翻译器持续失败时依次接替
 
     // 片段合并与格式控制
     bool merge_segments = false;           // 是否合并短片段
@@ -185,17 +267,87 @@ struct ProcessingConfig {
     }
 };
 
+/**
+ * 单个处理阶段的耗时
+ */
+struct StageTiming {
+    double wall_seconds = 0.0;             // 墙钟耗时（秒）
+    double cpu_seconds = 0.0;              // 进程CPU耗时（用户态+内核态，秒）
+};
+
+/**
+ * HTTP 请求统计汇总（延迟分位数，毫秒）
+ */
+struct HttpRequestStats {
+    size_t request_count = 0;              // 请求总数
+    size_t failed_count = 0;               // 失败请求数
+    double latency_p50_ms = 0.0;
+    double latency_p90_ms = 0.0;
+    double latency_p99_ms = 0.0;
+    double latency_max_ms = 0.0;
+};
+
+/**
+ * 翻译阶段汇总
+ */
+struct TranslationSummary {
+    size_t segment_count = 0;              // 待翻译段数
+    size_t failed_count = 0;               // 翻译失败（保留原文）的段数
+    size_t cache_hits = 0;                 // 持久缓存命中段数
+    size_t cache_misses = 0;               // 持久缓存未命中段数
+    size_t fuzzy_hits = 0;                 // 模糊翻译记忆命中段数
+    size_t deduplicated_segments = 0;      // 去重后未单独请求的重复段数
+    size_t hedged_requests = 0;            // 对冲请求数
+    size_t hedge_wins = 0;                 // 对冲请求胜出次数
+    size_t failover_segments = 0;          // 由后备翻译器完成的段数
+    size_t retries = 0;                    // 重试请求数
+    TokenUsage usage;                      // token 用量
+    double estimated_cost = 0.0;           // 按 TranslatorOptions 中的单价估算的费用（未配置单价时为 0）
+};
+
+/**
+ * 处理过程的结构化统计
+ * 各阶段耗时、实时率、I/O 字节数、HTTP 请求与峰值内存
+ */
+struct ProcessingStats {
+    // 各阶段耗时
+    StageTiming probe;                     // 媒体探测
+    StageTiming extract;                   // 音频提取
+    StageTiming model_load;                // 模型加载
+    StageTiming transcribe;                // 语音转录
+    StageTiming merge;                     // 片段合并
+    StageTiming translate;                 // 翻译
+    StageTiming format;                    // 字幕格式化
+    StageTiming write;                     // 写出文件
+    StageTiming total;                     // 总计
+
+    int subtitle_stream_index = -1;        // 复用的内嵌字幕流序号（-1 表示经语音转录）
+    double audio_duration_seconds = 0.0;   // 音频时长（秒）
+    double real_time_factor = 0.0;         // 实时率 = 总耗时 / 音频时长（越小越快）
+
+    uint64_t bytes_read = 0;               // 读取字节数（输入文件 + 中间 WAV）
+    uint64_t bytes_written = 0;            // 写入字节数（中间 WAV + 输出字幕）
+
+    HttpRequestStats http;                 // 翻译等网络请求统计
+    TranslationSummary translation;        // 翻译段数与缓存命中
+    uint64_t peak_rss_bytes = 0;           // 进程峰值常驻内存（字节）
+};
+
 /**
  * 处理结果数据结构
  * 对应Python版本的ProcessingResult类
  */
 struct ProcessingResult {
     bool success = false;                           // 是否成功
-    std::string output_path;                        // 输出文件路径
+    std::string output_path;                        // 输出文件路径（多个目标语言时为第一个）
+    std::vector<std::string> output_paths;          // 全部输出文件（每个目标语言一个）
     std::optional<TranscriptionResult> transcription; // 转录结果
-    std::optional<TranslationResult> translation;   // 翻译结果
+    std::optional<TranslationResult> translation;   // 翻译结果（多个目标语言时为第一个）
+    std::vector<TranslationResult> translations;    // 每个目标语言的翻译结果，顺序同 translate_to
     std::string error_message;                      // 错误信息
+    bool cancelled = false;                         // 是否因取消或超过截止时间而终止
     std::optional<double> processing_time;          // 处理耗时（秒）
+    ProcessingStats stats;                          // 结构化统计
     
     ProcessingResult() = default;
     
@@ -2,31 +2,146 @@
 
 #include <string>
 #include <vector>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include "video2srt_native/models.hpp"
 #include "video2srt_native/translator.hpp"
+#include "video2srt_native/http_client.hpp"
+#include "video2srt_native/rate_limiter.hpp"
+#include "video2srt_native/usage_log.hpp"
+#include "video2srt_native/batch_sizer.hpp"
 
 namespace v2s {
 
 class OpenAITranslator : public ITranslator {
 public:
     explicit OpenAITranslator(const TranslatorOptions& opts);
+    ~OpenAITranslator() override { finish_calls(); }
 
     TranslationResult translate_segments(const std::vector<Segment>& segments,
                                          const std::string& target_language,
                                          const std::string& source_language) override;
 
+    // One call's translation, shared by the sync and async entry points
+    TranslationResult translate_call(const std::vector<Segment>& segments,
+                                     const std::string& target_language,
+                                     const std::string& source_language,
+                                     const TranslationCall& call) override;
+
+    // Batch mode with several targets: each batch asks for {lang: [translations]} in one request,
+    // so source tokens are paid once. Items a response misses are recovered per language.
+    // Request statistics are reported on the first result only.
+    std::vector<TranslationResult> translate_call_multi(const std::vector<Segment>& segments,
+                                                        const std::vector<std::string>& target_languages,
+                                                        const std::string& source_language,
+                                                        const TranslationCall& call) override;
+
+    std::string cache_namespace() const override;
+
+    // Batch mode: the batches the token packer would send right now (adaptive size or max_batch_segments)
+    std::vector<std::vector<size_t>> request_groups(const std::vector<Segment>& segments,
+                                                    const std::string& target_language,
+                                                    const std::string& source_language) const override;
+
+    // Why a batch response was not fully usable
+    enum class BatchFailure {
+        None,                  // every item translated
+        Http,                  // transport/HTTP failure after retries
+        MalformedJson,         // content is not valid JSON
+        MissingTranslations,   // JSON without a "translations" array
+        Truncated,             // output cut off by max_tokens
+        ShortArray,            // fewer items than requested
+        LengthMismatch,        // more items than requested (positions unreliable)
+        InvalidItem            // non-string / empty item(s)
+    };
+
 private:
+    // Result of one batch request: per-item translations (nullopt = missing/invalid)
+    struct BatchOutcome {
+        std::vector<std::optional<std::string>> items;
+        BatchFailure failure = BatchFailure::None;
+        int status = 0;        // last HTTP status
+        double latency_ms = 0.0;   // last attempt's latency
+        bool timed_out = false;    // last attempt timed out
+    };
+
+    // One call's state, passed down to every request instead of living in members,
+    // so calls running on the same instance never share a token or statistics
+    struct CallState {
+        CancellationToken cancel;   // linked to opts_.cancel and the call's own token
+        std::mutex stats_mutex;     // guards stats across concurrent requests
+        TranslationStats stats;
+    };
+
+    // One HTTP attempt as seen by token accounting (call statistics, metrics and the usage log)
+    struct RequestAccounting {
+        const char* kind = "segment";   // segment | batch | multi
+        std::string targets;            // comma-separated target languages
+        const std::string* source = nullptr;
+        size_t items = 0;               // requested items (segments x targets)
+        size_t unusable_items = 0;      // items the reply did not deliver (they are re-requested)
+        int attempt = 0;
+        const char* outcome = "none";   // "none" (fully usable) or a batch failure reason
+    };
+
     TranslatorOptions opts_;
+    std::shared_ptr<EndpointLimiter> limiter_;   // 按端点共享的限流器（令牌桶 + AIMD 并发）
+    EndpointLimiter::Registration limiter_config_;   // 本实例的限流配置登记（析构时撤销）
+    std::shared_ptr<UsageLog> usage_log_;        // 按请求的 JSONL 用量记录（未配置时为空）
+
+    // Record one HTTP request (count + latency)
+    void record_request(CallState& state, double latency_ms);
+
+    // Account tokens/retries of one attempt; unusable items turn their share of the tokens into wasted tokens
+    void account_request(CallState& state, const RequestAccounting& acct, const HttpRequest& req,
+                         const HttpResponse& resp, TokenUsage usage);
+
+    // Send one request through the endpoint limiter (waits for a permit, feeds the response back)
+    HttpResponse send_limited(CallState& state, const HttpRequest& req);
+
+    // Build a chat completion POST for the shared HttpClient
+    HttpRequest build_request(const CallState& state, std::string body) const;
+
+    // Retry policy derived from opts_ (retry_count, jittered back-off from 500ms)
+    HttpRetryPolicy retry_policy() const;
+
+    // Translate a single text string (nullopt when every attempt failed)
+    std::optional<std::string> translate_text(CallState& state,
+                                              const std::string& text,
+                                              const std::string& target_language,
+                                              const std::string& source_language);
+
+    // Translate multiple text strings in one request, salvaging every usable item.
+    // With opts_.stream, on_item receives each element (batch-relative index) as soon as it is streamed.
+    BatchOutcome translate_texts_batch(CallState& state,
+                                       const std::vector<std::string>& texts,
+                                       const std::string& target_language,
+                                       const std::string& source_language,
+                                       const SegmentCallback& on_item);
+
+    // Translate multiple texts into several languages in one (non-streamed) request; one outcome per target
+    std::vector<BatchOutcome> translate_texts_multi(CallState& state,
+                                                    const std::vector<std::string>& texts,
+                                                    const std::vector<std::string>& target_languages,
+                                                    const std::string& source_language);
+
+    // Batch translation that re-requests missing items and bisects failed batches.
+    // sizer (top level only) receives the first request's latency and outcome.
+    std::vector<std::optional<std::string>> translate_batch_recovering(CallState& state,
+                                                                       const std::vector<std::string>& texts,
+                                                                       const std::string& target_language,
+                                                                       const std::string& source_language,
+                                                                       int depth,
+                                                                       const SegmentCallback& on_item,
+                                                                       AdaptiveBatchSizer* sizer = nullptr);
 
-    // Translate a single text string
-    std::string translate_text(const std::string& text,
-                               const std::string& target_language,
-                               const std::string& source_language);
+    // Cross-job broker key: requests that only differ in their texts share batches
+    std::string coalesce_key(const std::string& target_language, const std::string& source_language) const;
 
-    // Translate multiple text strings in one request
-    std::vector<std::string> translate_texts_batch(const std::vector<std::string>& texts,
-                                                   const std::string& target_language,
-                                                   const std::string& source_language);
+    // Shared adaptive batch sizer for this endpoint/model/format (nullptr unless batch_mode && adaptive_batch)
+    std::shared_ptr<AdaptiveBatchSizer> batch_sizer(size_t targets) const;
 };
 
 } // namespace v2s
\ No newline at end of file
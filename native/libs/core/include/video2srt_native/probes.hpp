@@ -0,0 +1,33 @@
+#pragma once
+
+// USDT 静态探针（SystemTap sys/sdt.h 兼容），provider 名为 video2srt
+// 由 CMake 选项 V2S_ENABLE_USDT 开启；未附加时探针点仅为一条 nop 指令。
+// 关闭或平台不支持时宏展开为空语句，参数不会被求值。
+//
+// 探针列表（参数按顺序）：
+//   audio_packet_decode(packet_bytes, pts)
+//   audio_resample(in_samples, out_samples)
+//   whisper_full_start(n_samples, n_threads)
+//   whisper_full_end(n_samples, result_code)
+//   segment_emitted(index, start_ms, end_ms, text_bytes)
+//   translator_request(translator, attempt, body_bytes)
+//   translator_retry(translator, attempt)
+//   translator_response(translator, attempt, ok, latency_us)
+//   formatter_write(format, bytes, ok)
+//
+// 例：bpftrace -e 'usdt:./v2s_cli:video2srt:segment_emitted { @[arg3] = count(); }'
+
+#if defined(V2S_ENABLE_USDT) && V2S_ENABLE_USDT
+#  include <sys/sdt.h>
+#  define V2S_PROBE0(name)                   DTRACE_PROBE(video2srt, name)
+#  define V2S_PROBE1(name, a)                DTRACE_PROBE1(video2srt, name, a)
+#  define V2S_PROBE2(name, a, b)             DTRACE_PROBE2(video2srt, name, a, b)
+#  define V2S_PROBE3(name, a, b, c)          DTRACE_PROBE3(video2srt, name, a, b, c)
+#  define V2S_PROBE4(name, a, b, c, d)       DTRACE_PROBE4(video2srt, name, a, b, c, d)
+#else
+#  define V2S_PROBE0(name)                   do {} while (0)
+#  define V2S_PROBE1(name, a)                do {} while (0)
+#  define V2S_PROBE2(name, a, b)             do {} while (0)
+#  define V2S_PROBE3(name, a, b, c)          do {} while (0)
+#  define V2S_PROBE4(name, a, b, c, d)       do {} while (0)
+#endif
@@ -4,10 +4,13 @@
 #include "audio.hpp"
 #include "formatter.hpp"
 #include "transcriber.hpp"
+#include "cancellation.hpp"
 #include <string>
 #include <memory>
 #include <filesystem>
 #include <functional>
+#include <future>
+#include <chrono>
 
 namespace v2s {
 
@@ -19,6 +22,52 @@ namespace v2s {
  */
 using ProgressCallback = std::function<void(const std::string& stage, double progress, const std::string& message)>;
 
+/**
+ * 异步处理句柄（由 Processor::process_async 返回）
+ * 可复制；所有副本共享同一作业与取消令牌
+ */
+class ProcessingHandle {
+public:
+    ProcessingHandle() = default;
+
+    /**
+     * 是否关联了作业
+     */
+    bool valid() const { return future_.valid(); }
+
+    /**
+     * 请求取消（立即返回；作业会在下一个检查点尽快结束并清理临时文件）
+     */
+    void cancel() const { token_.cancel(); }
+
+    /**
+     * 作业是否已结束
+     */
+    bool is_ready() const;
+
+    /**
+     * 等待作业结束
+     * @param timeout 最长等待时长
+     * @return 是否已结束
+     */
+    bool wait_for(std::chrono::milliseconds timeout) const;
+
+    /**
+     * 阻塞等待并获取结果（可多次调用）
+     */
+    ProcessingResult get() const;
+
+    /**
+     * 作业使用的取消令牌
+     */
+    const CancellationToken& token() const { return token_; }
+
+private:
+    friend class Processor;
+    std::shared_future<ProcessingResult> future_;
+    CancellationToken token_;
+};
+
 /**
  * 核心处理器
  * 整合音频提取、转录、格式化的完整流水线
@@ -49,22 +98,40 @@ public:
      * @param input_path 输入文件路径（视频或音频）
      * @param output_path 输出SRT文件路径
      * @param progress_callback 进度回调函数（可选）
+     * @param cancel 取消令牌（可选）；取消或超过截止时间后返回 cancelled=true 的失败结果
      * @return 处理结果
      */
     ProcessingResult process(const std::filesystem::path& input_path,
                            const std::filesystem::path& output_path,
-                           ProgressCallback progress_callback = nullptr);
+                           ProgressCallback progress_callback = nullptr,
+                           const CancellationToken& cancel = CancellationToken{});
+
+    /**
+     * 在后台线程中处理文件
+     * 注意：作业运行期间 Processor 必须保持存活，且同一 Processor 同时只应运行一个作业
+     * @param input_path 输入文件路径
+     * @param output_path 输出文件路径
+     * @param progress_callback 进度回调函数（可选，在后台线程中调用）
+     * @param timeout 截止时长（<=0 表示不限制）
+     * @return 处理句柄（cancel()/wait_for()/get()）
+     */
+    ProcessingHandle process_async(const std::filesystem::path& input_path,
+                                   const std::filesystem::path& output_path,
+                                   ProgressCallback progress_callback = nullptr,
+                                   std::chrono::milliseconds timeout = std::chrono::milliseconds::zero());
     
     /**
      * 仅提取音频（不进行转录）
      * @param input_path 输入文件路径
      * @param output_path 输出WAV文件路径
      * @param progress_callback 进度回调函数（可选）
+     * @param cancel 取消令牌（可选）
      * @return 是否成功
      */
     bool extract_audio_only(const std::filesystem::path& input_path,
                           const std::filesystem::path& output_path,
-                          ProgressCallback progress_callback = nullptr);
+                          ProgressCallback progress_callback = nullptr,
+                          const CancellationToken& cancel = CancellationToken{});
     
     /**
      * 仅转录音频文件（假设已是WAV格式）
@@ -117,6 +184,14 @@ private:
     ProcessingConfig config_;
     std::unique_ptr<Transcriber> transcriber_;
     
+    /**
+     * 执行完整流水线（由 process 调用，负责各阶段计时）
+     */
+    ProcessingResult run_pipeline(const std::filesystem::path& input_path,
+                                  const std::filesystem::path& output_path,
+                                  ProgressCallback progress_callback,
+                                  const CancellationToken& cancel);
+
     /**
      * 初始化转录器
      * @return 是否成功
@@ -0,0 +1,147 @@
+#pragma once
+
+#include "http_client.hpp"
+#include "cancellation.hpp"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <string>
+
+namespace v2s {
+
+/**
+ * 按端点（scheme://host:port）共享的自适应限流器
+ * - 令牌桶：限制请求速率（rps），可由配置指定，也可从 x-ratelimit-limit-requests 学习
+ * - 暂停窗口：遇到 Retry-After 或 x-ratelimit-remaining-* 为 0 时，该端点的所有请求统一等待到重置时刻
+ * - AIMD 并发控制：成功时并发上限加性增加（每个上限周期 +1），429/503 时乘性减半
+ * 同一进程内所有翻译器实例共享同一端点的限流状态，避免各自重试形成风暴
+ * 各翻译器实例以 configure() 登记自己的配置，生效值由仍在登记的配置重新计算（见 configure）
+ * 线程安全
+ */
+class EndpointLimiter {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * 请求许可（RAII）：析构时归还并发名额
+     */
+    class Permit {
+    public:
+        Permit() = default;
+        Permit(Permit&& other) noexcept : owner_(other.owner_) { other.owner_ = nullptr; }
+        Permit& operator=(Permit&& other) noexcept;
+        ~Permit();
+
+        /**
+         * 是否获得许可（取消或超过截止时间时为 false）
+         */
+        bool valid() const { return owner_ != nullptr; }
+
+    private:
+        friend class EndpointLimiter;
+        explicit Permit(EndpointLimiter* owner) : owner_(owner) {}
+        EndpointLimiter* owner_ = nullptr;
+    };
+
+    /**
+     * 一个调用方的配置登记（RAII）：析构时撤销，限流器按剩余登记重新计算生效值
+     */
+    class Registration {
+    public:
+        Registration() = default;
+        Registration(Registration&& other) noexcept : owner_(other.owner_), id_(other.id_) { other.owner_ = nullptr; }
+        Registration& operator=(Registration&& other) noexcept;
+        ~Registration();
+
+    private:
+        friend class EndpointLimiter;
+        Registration(EndpointLimiter* owner, uint64_t id) : owner_(owner), id_(id) {}
+        EndpointLimiter* owner_ = nullptr;
+        uint64_t id_ = 0;
+    };
+
+    /**
+     * 获取 URL 所属端点的共享限流器
+     */
+    static std::shared_ptr<EndpointLimiter> for_url(const std::string& url);
+
+    explicit EndpointLimiter(std::string endpoint);
+
+    /**
+     * 登记一个调用方的限流参数，返回的登记存续期间生效
+     * 生效值按所有仍在登记的配置计算：速率取最严格者（连同其 burst），并发上限取最大值；
+     * 登记撤销（如翻译器析构）后立即重新计算，长驻进程中调高速率或调低并发无需重启
+     * @param requests_per_second 速率上限，<=0 表示不限（仍遵循服务端头部）
+     * @param burst 令牌桶容量（突发请求数），<=0 时取 max(1, rps)
+     * @param max_concurrency 并发上限（AIMD 的增长上界）
+     */
+    [[nodiscard]] Registration configure(double requests_per_second, int burst, int max_concurrency);
+
+    /**
+     * 阻塞直到可以发送下一个请求（速率、暂停窗口与并发上限均满足）
+     * @param cancel 取消令牌；取消后立即返回无效许可
+     */
+    Permit acquire(const CancellationToken& cancel);
+
+    /**
+     * 根据响应调整限流状态（AIMD、Retry-After、x-ratelimit-* 头）
+     */
+    void on_response(const HttpResponse& resp);
+
+    /**
+     * 当前 AIMD 并发上限
+     */
+    double concurrency_limit() const;
+
+    /**
+     * 当前生效的速率上限（登记的配置与从响应头学习的速率中更严格者，0 表示不限）
+     */
+    double rate_limit() const;
+
+    /**
+     * 端点标识
+     */
+    const std::string& endpoint() const { return endpoint_; }
+
+private:
+    struct Config {
+        double requests_per_second = 0.0;
+        int burst = 0;
+        int max_concurrency = 1;
+    };
+
+    void release();
+    void unregister(uint64_t id);
+    void apply_configs_locked();
+    void pause_for(std::chrono::milliseconds duration);
+    void refill_locked(Clock::time_point now);
+
+    const std::string endpoint_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+
+    // 仍在登记的调用方配置
+    std::map<uint64_t, Config> configs_;
+    uint64_t next_config_id_ = 1;
+
+    // 令牌桶
+    double rate_ = 0.0;             // 令牌/秒，0 表示不限
+    double learned_rate_ = 0.0;     // 从响应头学习到的速率
+    double burst_ = 1.0;
+    double tokens_ = 1.0;
+    Clock::time_point last_refill_ = Clock::now();
+
+    // 暂停窗口
+    Clock::time_point paused_until_{};
+
+    // AIMD
+    int max_concurrency_ = 1;
+    double limit_ = 1.0;
+    int in_flight_ = 0;
+    Clock::time_point last_decrease_{};
+};
+
+} // namespace v2s
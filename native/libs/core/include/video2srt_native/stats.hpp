@@ -0,0 +1,70 @@
+#pragma once
+
+#include "models.hpp"
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+namespace v2s {
+
+/**
+ * 当前进程累计CPU时间（用户态+内核态，秒）
+ */
+double process_cpu_seconds();
+
+/**
+ * 当前进程峰值常驻内存（字节），不可用时返回 0
+ */
+uint64_t peak_rss_bytes();
+
+/**
+ * 当前进程常驻内存（字节），不可用时返回峰值或 0
+ */
+uint64_t current_rss_bytes();
+
+/**
+ * 阶段计时器（RAII）
+ * 构造时记录起点，析构或 stop() 时把墙钟与CPU耗时累加到目标 StageTiming
+ */
+class StageTimer {
+public:
+    explicit StageTimer(StageTiming& out);
+    ~StageTimer();
+
+    StageTimer(const StageTimer&) = delete;
+    StageTimer& operator=(const StageTimer&) = delete;
+
+    /**
+     * 提前结束计时（重复调用无副作用）
+     */
+    void stop();
+
+private:
+    StageTiming* out_;
+    std::chrono::steady_clock::time_point wall_start_;
+    double cpu_start_;
+};
+
+/**
+ * 汇总翻译请求统计（计算延迟分位数）
+ * @param stats 翻译器填充的原始统计
+ * @return 汇总后的HTTP统计
+ */
+HttpRequestStats summarize_http_requests(const TranslationStats& stats);
+
+/**
+ * 按 TranslatorOptions 中的每百万 token 单价估算费用
+ * 命中缓存的提示词按 price_per_million_cached_tokens 计（未配置时按普通提示词单价）
+ * @return 估算费用；未配置任何单价时为 0
+ */
+double estimate_translation_cost(const TokenUsage& usage, const TranslatorOptions& options);
+
+/**
+ * 将处理统计序列化为 JSON 字符串
+ * @param stats 处理统计
+ * @param indent 缩进空格数（<0 表示紧凑输出）
+ * @return JSON 文本
+ */
+std::string stats_to_json(const ProcessingStats& stats, int indent = 2);
+
+} // namespace v2s
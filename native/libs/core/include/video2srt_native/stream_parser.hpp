@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <string_view>
+
+namespace v2s {
+
+/**
+ * Server-Sent Events 解码器（text/event-stream）
+ * 按任意边界喂入字节，遇到空行时派发一个事件（多行 data 以 '\n' 连接）
+ * 支持 \n、\r\n、\r 换行；以 ':' 开头的注释行被忽略
+ */
+class SseDecoder {
+public:
+    using EventCallback = std::function<void(const std::string& event, const std::string& data)>;
+
+    explicit SseDecoder(EventCallback on_event);
+
+    /**
+     * 喂入一段数据
+     */
+    void feed(std::string_view chunk);
+
+    /**
+     * 流结束：派发末尾未以空行结束的事件
+     */
+    void finish();
+
+    /**
+     * 已派发的事件数
+     */
+    size_t event_count() const { return events_; }
+
+private:
+    void process_line(std::string_view line);
+    void dispatch();
+
+    EventCallback on_event_;
+    std::string line_;
+    std::string event_;
+    std::string data_;
+    bool has_data_ = false;
+    bool pending_cr_ = false;
+    size_t events_ = 0;
+};
+
+/**
+ * 增量 JSON 解析：在（可能分片到达的）JSON 文本中定位 "key": [ ... ]，
+ * 每当数组中的一个字符串元素闭合即回调
+ * 仅处理字符串元素；遇到非字符串元素后停止（stopped() 为 true），由调用方在完整文本上回退解析
+ * key 之前的任意前缀（如 ```json 代码块标记）会被跳过
+ */
+class JsonStringArrayStreamer {
+public:
+    using ItemCallback = std::function<void(size_t index, std::string value)>;
+
+    JsonStringArrayStreamer(std::string key, ItemCallback on_item);
+
+    /**
+     * 喂入一段文本
+     */
+    void feed(std::string_view chunk);
+
+    /**
+     * 已回调的元素数
+     */
+    size_t emitted() const { return emitted_; }
+
+    /**
+     * 是否已读到数组结尾 ']'
+     */
+    bool finished() const { return state_ == State::Done; }
+
+    /**
+     * 是否因非字符串元素或语法错误而停止
+     */
+    bool stopped() const { return state_ == State::Stopped; }
+
+private:
+    enum class State { SeekKey, SeekColon, SeekArray, InArray, InString, Done, Stopped };
+
+    void step(char c);
+
+    std::string needle_;       // "key"（含引号）
+    ItemCallback on_item_;
+    State state_ = State::SeekKey;
+    std::string window_;       // SeekKey 阶段的滑动窗口
+    std::string current_;      // 当前字符串元素（未解码的原始字面量）
+    bool escape_ = false;
+    size_t emitted_ = 0;
+};
+
+} // namespace v2s
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace v2s {
+
+/**
+ * 快速 token 估算（近似 GPT 系列的 BPE 分词，无词表依赖）
+ * 按 UTF-8 码点分类累计：
+ * - ASCII 单词按长度折算（常见短词 1 token，前导空格并入单词），数字每 3 位 1 token，标点各 1 token
+ * - 汉字/假名/谚文约 1 token/字，西里尔/希腊等字母约 0.4 token/字，阿拉伯约 0.5，印度/东南亚文字约 1，emoji 约 2
+ * 误差通常在 ±15% 以内，宁可略高估；用于批次装箱与成本预估，不用于计费
+ */
+size_t estimate_tokens(std::string_view text);
+
+/**
+ * 估算 text 作为 JSON 字符串字面量（含引号与转义）时的 token 数
+ */
+size_t estimate_json_string_tokens(std::string_view text);
+
+/**
+ * 目标语言相对源语言的译文 token 膨胀系数（按各语言相对英文的 token 密度估计）
+ * 例如 en -> zh 约 1.2，zh -> en 约 0.83；未知语言（含 auto）按英文计
+ */
+double translation_token_ratio(const std::string& source_language, const std::string& target_language);
+
+} // namespace v2s
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <filesystem>
+
+namespace v2s {
+namespace trace {
+
+namespace detail {
+// 全局开关：关闭时 Span 仅做一次 relaxed 原子读取
+extern std::atomic<bool> g_enabled;
+void record(const char* name, const char* category, int64_t start_us, int64_t end_us);
+int64_t now_us();
+}
+
+/**
+ * 是否正在采集追踪事件
+ */
+inline bool enabled() {
+    return detail::g_enabled.load(std::memory_order_relaxed);
+}
+
+/**
+ * 开始采集（清空之前已采集的事件）
+ */
+void start();
+
+/**
+ * 停止采集（已采集事件保留，可继续导出）
+ */
+void stop();
+
+/**
+ * 导出为 Chrome trace-event JSON（可用 Perfetto / chrome://tracing 打开）
+ * @param path 输出文件路径
+ * @return 是否写入成功
+ */
+bool write_chrome_json(const std::filesystem::path& path);
+
+/**
+ * RAII 追踪区间：构造时记录起点，析构时写入当前线程的事件缓冲
+ * name/category 必须是静态生命周期字符串（例如字面量）
+ */
+class Span {
+public:
+    explicit Span(const char* name, const char* category = "v2s")
+        : name_(name), category_(category), start_us_(enabled() ? detail::now_us() : -1) {}
+
+    ~Span() {
+        if (start_us_ >= 0) {
+            detail::record(name_, category_, start_us_, detail::now_us());
+        }
+    }
+
+    Span(const Span&) = delete;
+    Span& operator=(const Span&) = delete;
+
+private:
+    const char* name_;
+    const char* category_;
+    int64_t start_us_;
+};
+
+} // namespace trace
+} // namespace v2s
+
+#define V2S_TRACE_CONCAT_INNER(a, b) a##b
+#define V2S_TRACE_CONCAT(a, b) V2S_TRACE_CONCAT_INNER(a, b)
+
+// 在当前作用域内记录一个追踪区间，例如：V2S_TRACE_SPAN("whisper_full");
+#define V2S_TRACE_SPAN(...) ::v2s::trace::Span V2S_TRACE_CONCAT(v2s_trace_span_, __LINE__)(__VA_ARGS__)
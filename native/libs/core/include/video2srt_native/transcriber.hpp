@@ -80,10 +80,12 @@ public:
      * 转录音频文件
      * @param audio_path 音频文件路径（WAV格式，16kHz，单声道）
      * @param language 指定语言（可选，空表示自动检测）
+     * @param cancel 取消令牌（通过 whisper abort_callback 中断推理，取消后抛出异常）
      * @return 转录结果
      */
     TranscriptionResult transcribe(const std::filesystem::path& audio_path,
-                                 const std::optional<std::string>& language = std::nullopt);
+                                 const std::optional<std::string>& language = std::nullopt,
+                                 const CancellationToken& cancel = CancellationToken{});
     
     /**
      * 获取模型信息
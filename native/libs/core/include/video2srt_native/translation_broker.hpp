@@ -0,0 +1,93 @@
+#pragma once
+
+#include "cancellation.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace v2s {
+
+/**
+ * 跨任务的批量翻译合并器
+ * 同一进程内多个任务并发翻译时，相同键（端点、模型、提示词、语言对、API Key 与用量标签）的待译条目
+ * 进入同一队列，按请求容量（token 预算）拼成整批，或在最早的条目等待超过 linger 后发出未满的批次，
+ * 结果按条目路由回各自的任务
+ * 发送由正在等待的任务线程轮流担任（leader），使用调用方自己的发送函数，因此不持有任何翻译器实例；
+ * 混合批次的请求数与 token 用量计入发出该请求的任务
+ * 线程安全：同一进程内相同键共享一个实例（见 for_key()）
+ */
+class TranslationBroker {
+public:
+    // 发送一批文本，返回与 texts 等长的结果（nullopt 表示该条失败）
+    using BatchSender = std::function<std::vector<std::optional<std::string>>(const std::vector<std::string>& texts)>;
+    // 单条译文就绪（下标为 translate() 传入条目的下标），在调用方自己的线程中回调
+    using ItemCallback = std::function<void(size_t index, const std::string& text)>;
+
+    struct Item {
+        std::string text;
+        double weight = 0.0;   // 占一次请求容量的比例（提示词与生成两项预算中占比较大者）
+    };
+
+    /**
+     * 获取键对应的共享实例
+     */
+    static std::shared_ptr<TranslationBroker> for_key(const std::string& key);
+
+    explicit TranslationBroker(std::string key);
+
+    /**
+     * 提交条目并阻塞等待全部完成（取消时尽快返回，未完成的条目为 nullopt）
+     * @param items 待译条目
+     * @param send 本任务担任 leader 时用于发送批次的函数
+     * @param max_items 每批最大条目数（每次组批时读取，可随自适应批大小变化）
+     * @param linger 未满批次的最长等待时间
+     * @param parallel 本任务最多同时发出的批次数
+     * @param cancel 取消令牌
+     * @param on_item 单条译文就绪回调（可为空）
+     * @return 与 items 等长的结果
+     */
+    std::vector<std::optional<std::string>> translate(const std::vector<Item>& items,
+                                                      const BatchSender& send,
+                                                      const std::function<size_t()>& max_items,
+                                                      std::chrono::milliseconds linger,
+                                                      size_t parallel,
+                                                      const CancellationToken& cancel,
+                                                      const ItemCallback& on_item);
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    // 一次 translate() 调用的状态
+    struct Ticket {
+        std::vector<std::optional<std::string>> results;
+        std::vector<size_t> ready;   // 已送达、尚未回调的下标
+        size_t remaining = 0;        // 尚未送达的条目数（排队中或发送中）
+        bool abandoned = false;      // 调用方已因取消返回
+    };
+
+    struct Pending {
+        std::shared_ptr<Ticket> ticket;
+        size_t index = 0;
+        std::string text;
+        double weight = 0.0;
+        Clock::time_point enqueued;
+    };
+
+    // 从队首取出一批（至少一条，容量不超过 1.0 且不超过 max_items 条）
+    std::vector<Pending> take_batch(size_t max_items);
+
+    const std::string key_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<Pending> queue_;
+    double queued_weight_ = 0.0;
+};
+
+} // namespace v2s
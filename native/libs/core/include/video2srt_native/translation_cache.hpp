@@ -0,0 +1,159 @@
+#pragma once
+
+#include "translator.hpp"
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace v2s {
+
+class AppendFile;
+class FuzzyTranslationMemory;
+
+/**
+ * 持久化翻译缓存
+ * 存储格式：追加写日志（translations.log）+ 内存索引（打开时扫描日志重建）
+ * - 日志头含“代数”（generation），压缩时整体重写并更换代数，其他进程据此重新加载
+ * - 追加与压缩在独占文件锁（translations.lock）下进行，多个进程可安全并发读写
+ * - 每条记录带校验和，写入中断或损坏的记录会被跳过
+ * - 日志头的格式版本不符时不读取，首次写入前把旧日志改名为 translations.log.old 再新建
+ * - 超过 max_bytes 时按“新近优先”保留约 3/4 容量（旧记录被命中时会重新追加，近似 LRU）
+ * 线程安全：同一进程内对同一目录共享一个实例（见 open()）
+ */
+class TranslationCache {
+public:
+    /**
+     * 打开（或创建）缓存目录；同一进程内相同目录返回同一实例
+     * @param dir 缓存目录
+     * @param max_bytes 日志文件大小上限（字节）
+     * @return 缓存实例；目录无法创建时返回空
+     */
+    static std::shared_ptr<TranslationCache> open(const std::filesystem::path& dir, uint64_t max_bytes);
+
+    /**
+     * 规范化源文本：去除首尾空白，连续空白折叠为单个空格
+     */
+    static std::string normalize_text(const std::string& text);
+
+    /**
+     * 构造缓存键
+     * @param translator_namespace 翻译器标识（含名称、模型与提示词版本，见 ITranslator::cache_namespace）
+     * @param source_language 源语言
+     * @param target_language 目标语言
+     * @param text 源文本（内部会规范化）
+     */
+    static std::string make_key(const std::string& translator_namespace,
+                                const std::string& source_language,
+                                const std::string& target_language,
+                                const std::string& text);
+
+    ~TranslationCache();
+
+    TranslationCache(const TranslationCache&) = delete;
+    TranslationCache& operator=(const TranslationCache&) = delete;
+
+    /**
+     * 批量查询
+     * @return 与 keys 等长，未命中为空
+     */
+    std::vector<std::optional<std::string>> lookup(const std::vector<std::string>& keys);
+
+    /**
+     * 批量写入（一次追加写入，必要时触发压缩）
+     */
+    void insert(const std::vector<std::pair<std::string, std::string>>& entries);
+
+    /**
+     * 当前索引中的条目数
+     */
+    size_t entry_count();
+
+    /**
+     * 日志文件大小（字节）
+     */
+    uint64_t size_bytes();
+
+private:
+    TranslationCache(std::filesystem::path dir, uint64_t max_bytes);
+
+    struct Entry {
+        uint64_t record_offset = 0;   // 记录起始偏移
+        uint32_t key_len = 0;
+        uint32_t value_len = 0;
+    };
+
+    bool refresh_locked();
+    void scan_locked(uint64_t from, uint64_t to);
+    bool append_locked(const std::vector<std::pair<std::string, std::string>>& entries);
+    void compact_locked();
+    std::optional<std::string> read_value_locked(const Entry& e, const std::string& key);
+
+    std::filesystem::path dir_;
+    std::filesystem::path log_path_;
+    std::filesystem::path lock_path_;
+    uint64_t max_bytes_;
+
+    std::mutex mutex_;
+    std::unique_ptr<AppendFile> file_;
+    uint64_t generation_ = 0;
+    uint64_t scanned_ = 0;            // 已扫描到的偏移
+    bool foreign_ = false;            // 日志头不是本格式版本（首次写入时改名为 .old 后新建）
+    std::unordered_map<uint64_t, Entry> index_;   // 键哈希 -> 最新记录
+};
+
+/**
+ * 缓存装饰器：请求前先查询持久缓存，只把未命中的段交给内部翻译器，成功结果写回缓存
+ * 启用模糊翻译记忆时，精确未命中的段再按相似度复用近似行的译文（不写回精确缓存）
+ * 内部翻译器 cache_namespace() 为空时直接透传
+ */
+class CachedTranslator : public ITranslator {
+public:
+    CachedTranslator(std::unique_ptr<ITranslator> inner, std::shared_ptr<TranslationCache> cache);
+    ~CachedTranslator() override { finish_calls(); }
+
+    TranslationResult translate_segments(const std::vector<Segment>& segments,
+                                         const std::string& target_language,
+                                         const std::string& source_language = "auto") override;
+
+    TranslationResult translate_call(const std::vector<Segment>& segments,
+                                     const std::string& target_language,
+                                     const std::string& source_language,
+                                     const TranslationCall& call) override;
+
+    /**
+     * 多目标语言：任一目标语言未命中的段合并为一次内部多语言请求，各语言的命中仍直接取自缓存
+     */
+    std::vector<TranslationResult> translate_call_multi(const std::vector<Segment>& segments,
+                                                        const std::vector<std::string>& target_languages,
+                                                        const std::string& source_language,
+                                                        const TranslationCall& call) override;
+
+    std::string cache_namespace() const override { return inner_->cache_namespace(); }
+
+    /**
+     * 启用模糊翻译记忆
+     * @param threshold 最低相似度（0~1）
+     * @param max_chars 仅对不超过该字符数（码点）的行启用，0 表示不限
+     */
+    void set_fuzzy_memory(std::shared_ptr<FuzzyTranslationMemory> memory, double threshold, size_t max_chars);
+
+private:
+    std::vector<TranslationResult> run(const std::vector<Segment>& segments,
+                                       const std::vector<std::string>& target_languages,
+                                       const std::string& source_language,
+                                       const TranslationCall& call);
+
+    std::unique_ptr<ITranslator> inner_;
+    std::shared_ptr<TranslationCache> cache_;
+    std::shared_ptr<FuzzyTranslationMemory> fuzzy_;
+    double fuzzy_threshold_ = 0.9;
+    size_t fuzzy_max_chars_ = 0;
+};
+
+} // namespace v2s
@@ -1,19 +1,119 @@
 #pragma once
 
 #include "models.hpp"
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <vector>
 #include <memory>
 
 namespace v2s {
 
+/**
+ * 单段译文就绪回调
+ * @param index 该段在传入 translate_segments 的列表中的下标
+ * @param text 译文
+ */
+using SegmentCallback = std::function<void(size_t index, const std::string& text)>;
+
+/**
+ * 单次翻译调用的上下文：取消令牌与单段回调按参数逐层传递（装饰器映射下标后转交内部翻译器），
+ * 不写入翻译器成员，异步调用与调用方线程之间没有共享的可变状态
+ */
+struct TranslationCall {
+    CancellationToken cancel;      // 本次调用的取消令牌（翻译器另外联动自身选项中的令牌）
+    SegmentCallback on_segment;    // 单段译文就绪回调，可为空
+
+    void notify(size_t index, const std::string& text) const {
+        if (on_segment) on_segment(index, text);
+    }
+};
+
+/**
+ * 异步翻译句柄（ITranslator::translate_segments_async 的返回值）
+ * - 逐段完成事件：on_segment() 注册回调，注册前已完成的段会先按完成顺序补发，每个事件恰好送达一次
+ *   （仅在没有回调时暂存事件；替换回调时不会向新回调补发已送达旧回调的事件）
+ * - 进度：progress() 返回已完成（至少送达过一次译文）的段数与总段数
+ * - 取消：cancel() 只取消本次调用，未完成的段保留原文并记入结果的 failed_indices
+ * - 结果：future() / get() 在调用结束后就绪；翻译器抛出的异常由 get() 重新抛出
+ * 线程安全：任意线程均可调用；事件回调在翻译线程中触发，应只做轻量工作
+ */
+class TranslationHandle {
+public:
+    struct Progress {
+        size_t completed = 0;   // 已完成段数
+        size_t total = 0;       // 总段数
+    };
+
+    TranslationHandle(size_t total, CancellationToken cancel);
+
+    TranslationHandle(const TranslationHandle&) = delete;
+    TranslationHandle& operator=(const TranslationHandle&) = delete;
+
+    /**
+     * 注册逐段完成回调（替换之前的回调）
+     */
+    void on_segment(SegmentCallback callback);
+
+    Progress progress() const;
+
+    void cancel() const { cancel_.cancel(); }
+    bool cancelled() const { return cancel_.is_cancelled(); }
+
+    /**
+     * 本次调用的取消令牌（联动翻译器选项中的取消令牌）
+     */
+    const CancellationToken& cancellation() const { return cancel_; }
+
+    bool done() const { return wait_for(std::chrono::milliseconds(0)); }
+
+    /**
+     * 等待调用结束
+     * @return 超时前是否已结束
+     */
+    bool wait_for(std::chrono::milliseconds timeout) const {
+        return future_.wait_for(timeout) == std::future_status::ready;
+    }
+
+    std::shared_future<TranslationResult> future() const { return future_; }
+
+    /**
+     * 阻塞等待并返回结果
+     */
+    const TranslationResult& get() const { return future_.get(); }
+
+    // 以下由翻译器实现调用
+    void report_segment(size_t index, const std::string& text);
+    void finish(TranslationResult result);
+    void fail(std::exception_ptr error);
+
+private:
+    mutable std::mutex mutex_;
+    SegmentCallback callback_;
+    std::vector<std::pair<size_t, std::string>> events_;   // 尚无回调时到达的事件（供后注册的回调补发）
+    std::vector<char> completed_;
+    size_t completed_count_ = 0;
+    const CancellationToken cancel_;
+    std::promise<TranslationResult> promise_;
+    std::shared_future<TranslationResult> future_;
+};
+
 /**
  * 翻译器基础接口
  * 提供统一的字幕段翻译能力
  */
 class ITranslator {
 public:
-    virtual ~ITranslator() = default;
+    ITranslator() = default;
+    virtual ~ITranslator();
+
+    ITranslator(const ITranslator&) = delete;
+    ITranslator& operator=(const ITranslator&) = delete;
 
     /**
      * 翻译字幕段列表
@@ -25,6 +125,94 @@ public:
     virtual TranslationResult translate_segments(const std::vector<Segment>& segments,
                                                  const std::string& target_language,
                                                  const std::string& source_language = "auto") = 0;
+
+    /**
+     * 一次翻译到多个目标语言
+     * 以 set_segment_callback 的回调调用 translate_call_multi
+     * @param target_languages 目标语言代码列表
+     * @return 与 target_languages 一一对应的翻译结果；请求统计（请求数、延迟、重试、token 用量、对冲、故障转移）
+     *         汇总在第一个结果上，缓存与失败段按语言各自记录
+     * 单段回调按（段，目标语言）各触发一次，下标仍为段下标
+     */
+    virtual std::vector<TranslationResult> translate_segments_multi(const std::vector<Segment>& segments,
+                                                                    const std::vector<std::string>& target_languages,
+                                                                    const std::string& source_language = "auto");
+
+    /**
+     * 带调用上下文的翻译：取消令牌与单段回调随参数传入（与 TranslatorOptions::cancel 任一取消即停止）
+     * 内置翻译器与装饰器均覆盖此方法，其 translate_segments 以 set_segment_callback 的回调调用本方法；
+     * 默认实现调用 translate_segments，结束后再逐段回调，不感知 call.cancel
+     */
+    virtual TranslationResult translate_call(const std::vector<Segment>& segments,
+                                             const std::string& target_language,
+                                             const std::string& source_language,
+                                             const TranslationCall& call);
+
+    /**
+     * 带调用上下文的多目标语言翻译（translate_segments_multi 的 translate_call 对应版本）
+     * 源文本只发送一次的翻译器覆盖此方法以节省请求与 token；装饰器覆盖此方法以便按参数传递回调与令牌
+     * 默认实现逐个目标语言调用 translate_call，请求统计并入第一个结果
+     */
+    virtual std::vector<TranslationResult> translate_call_multi(const std::vector<Segment>& segments,
+                                                                const std::vector<std::string>& target_languages,
+                                                                const std::string& source_language,
+                                                                const TranslationCall& call);
+
+    /**
+     * 异步翻译字幕段列表：立即返回句柄，translate_call 在异步调用专用线程池中执行（线程数有上限，超出的调用排队）
+     * 同一实例同一时间只应有一个调用在进行；析构时取消并等待仍在进行的异步调用
+     */
+    virtual std::shared_ptr<TranslationHandle> translate_segments_async(const std::vector<Segment>& segments,
+                                                                        const std::string& target_language,
+                                                                        const std::string& source_language = "auto");
+
+    /**
+     * 持久缓存命名空间（翻译器名称、模型与提示词版本），决定缓存键的隔离范围
+     * 返回空表示结果不可缓存（如占位翻译器）
+     */
+    virtual std::string cache_namespace() const { return {}; }
+
+    /**
+     * 一次调用会怎样把字幕段拆成请求（每组一个请求，组内为原下标），供组合翻译器按请求粒度切分
+     * 不在任何组中的段无需请求（如空文本）；默认每段一个请求
+     */
+    virtual std::vector<std::vector<size_t>> request_groups(const std::vector<Segment>& segments,
+                                                            const std::string& target_language,
+                                                            const std::string& source_language) const;
+
+    /**
+     * 设置单段译文就绪回调（可选），让下游（预览、进度）不必等整次调用结束
+     * 流式模式下回调可能早于对应批次完成、在网络线程中并发触发，应只做轻量工作；
+     * 最终结果以 translate_segments 的返回值为准（批次恢复时个别段可能被再次回调）
+     */
+    virtual void set_segment_callback(SegmentCallback callback) { segment_callback_ = std::move(callback); }
+
+protected:
+    /**
+     * 启动一次异步调用：创建句柄，在异步调用线程池中执行 body
+     * 单段回调同时送达句柄与启动时 set_segment_callback 设置的回调（在调用方线程取快照）
+     * @param body 翻译过程，参数为本次调用的上下文
+     */
+    std::shared_ptr<TranslationHandle> start_call(size_t total,
+                                                  std::function<TranslationResult(const TranslationCall&)> body);
+
+    /**
+     * 取消并等待本实例仍在进行的异步调用
+     * 派生类若在 translate_call 中访问自身成员，须在析构函数开头调用，保证调用体不会访问已析构的成员
+     */
+    void finish_calls();
+
+    /**
+     * 本次调用的生效令牌：选项中的令牌与调用令牌任一取消即取消
+     */
+    static CancellationToken link_cancel(const CancellationToken& options_cancel, const CancellationToken& call_cancel);
+
+    SegmentCallback segment_callback_;
+
+private:
+    std::mutex calls_mutex_;
+    std::condition_variable calls_cv_;
+    std::vector<std::shared_ptr<TranslationHandle>> calls_;   // 进行中的异步调用
 };
 
 /**
@@ -33,9 +221,51 @@ public:
  */
 class SimpleTranslator : public ITranslator {
 public:
+    ~SimpleTranslator() override { finish_calls(); }
+
     TranslationResult translate_segments(const std::vector<Segment>& segments,
                                          const std::string& target_language,
                                          const std::string& source_language = "auto") override;
+
+    TranslationResult translate_call(const std::vector<Segment>& segments,
+                                     const std::string& target_language,
+                                     const std::string& source_language,
+                                     const TranslationCall& call) override;
+};
+
+/**
+ * 去重装饰器：按规范化文本（TranslationCache::normalize_text）合并完全相同的段，
+ * 每个唯一文本只交给内部翻译器一次（仍按正常的批次/并发策略发送），结果回填到所有重复下标
+ * 节省的段数记入 TranslationStats::deduplicated_segments
+ */
+class DeduplicatingTranslator : public ITranslator {
+public:
+    explicit DeduplicatingTranslator(std::unique_ptr<ITranslator> inner);
+    ~DeduplicatingTranslator() override { finish_calls(); }
+
+    TranslationResult translate_segments(const std::vector<Segment>& segments,
+                                         const std::string& target_language,
+                                         const std::string& source_language = "auto") override;
+
+    TranslationResult translate_call(const std::vector<Segment>& segments,
+                                     const std::string& target_language,
+                                     const std::string& source_language,
+                                     const TranslationCall& call) override;
+
+    std::vector<TranslationResult> translate_call_multi(const std::vector<Segment>& segments,
+                                                        const std::vector<std::string>& target_languages,
+                                                        const std::string& source_language,
+                                                        const TranslationCall& call) override;
+
+    std::string cache_namespace() const override { return inner_->cache_namespace(); }
+
+private:
+    std::vector<TranslationResult> run(const std::vector<Segment>& segments,
+                                       const std::vector<std::string>& target_languages,
+                                       const std::string& source_language,
+                                       const TranslationCall& call);
+
+    std::unique_ptr<ITranslator> inner_;
 };
 
 /**
@@ -45,4 +275,13 @@ public:
 std::unique_ptr<ITranslator> create_translator(const std::string& translator_type,
                                                const TranslatorOptions& opts = TranslatorOptions{});
 
+/**
+ * 带故障转移链的翻译器工厂
+ * fallbacks 非空或 opts.hedge_requests 开启时，以 FailoverTranslator 组合主翻译器与后备翻译器
+ * （与主翻译器同类型或不可缓存的占位翻译器会被忽略），再套上去重与持久缓存
+ */
+std::unique_ptr<ITranslator> create_translator(const std::string& translator_type,
+                                               const TranslatorOptions& opts,
+                                               const std::vector<TranslatorBackend>& fallbacks);
+
 } // namespace v2s
\ No newline at end of file
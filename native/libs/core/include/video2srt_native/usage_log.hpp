@@ -0,0 +1,39 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+
+namespace v2s {
+
+/**
+ * 翻译请求用量日志（JSONL，每个 HTTP 请求一行，追加写入）
+ * 用于按批次分析 token 用量、调整批大小，以及按 usage_tag 归集费用
+ * 线程安全：同一进程内对同一路径共享一个实例（见 open()），整行在锁内写入
+ */
+class UsageLog {
+public:
+    /**
+     * 打开（或创建）用量日志；同一进程内相同路径返回同一实例
+     * @return 日志实例；文件无法打开时返回空
+     */
+    static std::shared_ptr<UsageLog> open(const std::filesystem::path& path);
+
+    explicit UsageLog(std::ofstream out);
+
+    UsageLog(const UsageLog&) = delete;
+    UsageLog& operator=(const UsageLog&) = delete;
+
+    /**
+     * 追加一行（line 不含换行符），写入后立即刷新
+     */
+    void append(const std::string& line);
+
+private:
+    std::mutex mutex_;
+    std::ofstream out_;
+};
+
+} // namespace v2s
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "models.hpp"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace v2s {
+
+/**
+ * UTF-8 校验与修复
+ * 按 Unicode 规范判定合法性（拒绝过长编码、代理区码点与超出 U+10FFFF 的码点）；
+ * ASCII 部分按 8 字节一组（SWAR）跳过，只在遇到非 ASCII 字节时逐码点校验
+ */
+
+/**
+ * 第一个非法字节的偏移；全部合法时返回 text.size()
+ * 末尾被截断的多字节字符同样视为非法
+ */
+size_t find_invalid_utf8(std::string_view text);
+
+/**
+ * 是否为合法 UTF-8
+ */
+inline bool is_valid_utf8(std::string_view text) { return find_invalid_utf8(text) == text.size(); }
+
+/**
+ * 原地修复：每个非法字节序列（Unicode 定义的最大非法子序列）替换为一个 U+FFFD，合法字符保持不变
+ * @return 替换的序列数（0 表示原文已合法，未做任何改动）
+ */
+size_t repair_utf8(std::string& text);
+
+/**
+ * 修复相邻字幕段的文本（如 Whisper 分段）：
+ * 段末被截断的多字节字符若能由下一段开头的续字节补全，则把这些续字节移回前一段；
+ * 其余真正非法的字节替换为 U+FFFD
+ * @return 替换的序列数与拼接的字符数之和
+ */
+size_t repair_utf8_segments(std::vector<Segment>& segments);
+
+} // namespace v2s
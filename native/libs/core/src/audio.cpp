@@ -1,4 +1,10 @@
 #include "video2srt_native/audio.hpp"
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/probes.hpp"
+#include "video2srt_native/utf8.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
 #include <cstdio>
 #include <vector>
 #include <stdexcept>
@@ -50,11 +56,66 @@ static void write_wav_header(FILE* f, const WavHeader& h) {
     fwrite(&h.data_size, 4, 1, f);
 }
 
+bool probe_media(const std::string& input_path, MediaInfo& info) {
+    info = MediaInfo{};
+    V2S_TRACE_SPAN("probe_media", "ffmpeg");
+#if !V2S_HAVE_FFMPEG
+    (void)input_path;
+    return false;
+#else
+    AVFormatContext* fmt_ctx = nullptr;
+    if (avformat_open_input(&fmt_ctx, input_path.c_str(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx, nullptr) < 0) {
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    if (fmt_ctx->duration != AV_NOPTS_VALUE && fmt_ctx->duration > 0) {
+        info.duration_seconds = static_cast<double>(fmt_ctx->duration) / AV_TIME_BASE;
+    }
+    auto tag = [](const AVStream* st, const char* key) {
+        const AVDictionaryEntry* e = av_dict_get(st->metadata, key, nullptr, 0);
+        return std::string(e && e->value ? e->value : "");
+    };
+    const int audio_index = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_AUDIO, -1, -1, nullptr, 0);
+    info.has_audio = audio_index >= 0;
+    if (info.has_audio) {
+        info.audio_language = tag(fmt_ctx->streams[audio_index], "language");
+    }
+    for (unsigned i = 0; i < fmt_ctx->nb_streams; ++i) {
+        const AVStream* st = fmt_ctx->streams[i];
+        if (st->codecpar->codec_type != AVMEDIA_TYPE_SUBTITLE) continue;
+        SubtitleStreamInfo sub;
+        sub.index = static_cast<int>(i);
+        sub.codec = avcodec_get_name(st->codecpar->codec_id);
+        sub.language = tag(st, "language");
+        sub.title = tag(st, "title");
+        const AVCodecDescriptor* desc = avcodec_descriptor_get(st->codecpar->codec_id);
+        sub.is_text = desc && (desc->props & AV_CODEC_PROP_TEXT_SUB);
+        sub.is_default = (st->disposition & AV_DISPOSITION_DEFAULT) != 0;
+        sub.is_forced = (st->disposition & AV_DISPOSITION_FORCED) != 0;
+        info.subtitle_streams.push_back(std::move(sub));
+    }
+    avformat_close_input(&fmt_ctx);
+    return true;
+#endif
+}
+
+#if V2S_HAVE_FFMPEG
+// FFmpeg 阻塞 IO 的中断回调：返回非 0 时 av_read_frame 等调用立即以 AVERROR_EXIT 返回
+static int ffmpeg_interrupt_cb(void* opaque) {
+    return static_cast<const CancellationToken*>(opaque)->is_cancelled() ? 1 : 0;
+}
+#endif
+
 bool extract_audio_to_wav(const std::string& input_path,
                           const std::string& output_wav_path,
-                          int sample_rate) {
+                          int sample_rate,
+                          const CancellationToken& cancel) {
+    V2S_TRACE_SPAN("extract_audio_to_wav", "ffmpeg");
 #if !V2S_HAVE_FFMPEG
-    (void)input_path; (void)output_wav_path; (void)sample_rate;
+    (void)input_path; (void)output_wav_path; (void)sample_rate; (void)cancel;
     std::cerr << "错误: FFmpeg 支持未编译，无法进行音频提取" << std::endl;
     std::cerr << "请通过 vcpkg 安装 FFmpeg 并重新编译项目" << std::endl;
     return false;
@@ -73,9 +134,15 @@ bool extract_audio_to_wav(const std::string& input_path,
     
     std::cout << "开始提取音频: " << input_path << " -> " << output_wav_path << std::endl;
     std::cout << "目标采样率: " << sample_rate << "Hz, 单声道, 16-bit PCM" << std::endl;
-    AVFormatContext* fmt_ctx = nullptr;
+    AVFormatContext* fmt_ctx = avformat_alloc_context();
     int ret = 0;
+    if (!fmt_ctx) {
+        return false;
+    }
+    fmt_ctx->interrupt_callback.callback = ffmpeg_interrupt_cb;
+    fmt_ctx->interrupt_callback.opaque = const_cast<CancellationToken*>(&cancel);
 
+    // 打开失败时 avformat_open_input 会释放 fmt_ctx
     if ((ret = avformat_open_input(&fmt_ctx, input_path.c_str(), nullptr, nullptr)) < 0) {
         return false;
     }
@@ -165,7 +232,13 @@ bool extract_audio_to_wav(const std::string& input_path,
     
     std::cout << "开始解码和重采样..." << std::endl;
 
+    bool cancelled = false;
     while ((ret = av_read_frame(fmt_ctx, pkt)) >= 0) {
+        if (cancel.is_cancelled()) {
+            av_packet_unref(pkt);
+            cancelled = true;
+            break;
+        }
         if (pkt->stream_index != audio_stream_index) {
             av_packet_unref(pkt);
             continue;
@@ -174,6 +247,7 @@ bool extract_audio_to_wav(const std::string& input_path,
             av_packet_unref(pkt);
             break;
         }
+        V2S_PROBE2(audio_packet_decode, pkt->size, pkt->pts);
         av_packet_unref(pkt);
 
         while ((ret = avcodec_receive_frame(dec_ctx, frame)) >= 0) {
@@ -192,6 +266,7 @@ bool extract_audio_to_wav(const std::string& input_path,
             if (converted < 0) {
                 break;
             }
+            V2S_PROBE2(audio_resample, frame->nb_samples, converted);
 
             int bytes_written = converted * out_channels * out_bytes_per_sample;
             if (bytes_written > 0) {
@@ -208,6 +283,19 @@ bool extract_audio_to_wav(const std::string& input_path,
         }
     }
 
+    // 被取消（循环内检测或中断回调使 av_read_frame 返回 AVERROR_EXIT）：释放资源并删除不完整输出
+    if (cancelled || cancel.is_cancelled()) {
+        std::fclose(out);
+        av_frame_free(&frame);
+        av_packet_free(&pkt);
+        swr_free(&swr);
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        std::remove(output_wav_path.c_str());
+        std::cerr << "音频提取已取消" << std::endl;
+        return false;
+    }
+
     // 刷新解码器
     avcodec_send_packet(dec_ctx, nullptr);
     while (avcodec_receive_frame(dec_ctx, frame) >= 0) {
@@ -220,6 +308,7 @@ bool extract_audio_to_wav(const std::string& input_path,
         uint8_t* out_data[1] = { out_buf.data() };
         int converted = swr_convert(swr, out_data, out_nb_samples,
                                     (const uint8_t**)frame->extended_data, frame->nb_samples);
+        V2S_PROBE2(audio_resample, frame->nb_samples, converted);
         if (converted > 0) {
             int bytes_written = converted * out_channels * out_bytes_per_sample;
             fwrite(out_buf.data(), 1, bytes_written, out);
@@ -257,4 +346,222 @@ bool extract_audio_to_wav(const std::string& input_path,
 #endif
 }
 
-}
\ No newline at end of file
+#if V2S_HAVE_FFMPEG
+// 多行字幕文本压成一行（字幕段在翻译与格式化时按单行处理）：逐行去除首尾空白，跳过空行，以空格连接
+static std::string flatten_subtitle_lines(const std::string& text) {
+    std::string out;
+    size_t pos = 0;
+    while (pos <= text.size()) {
+        size_t end = text.find('\n', pos);
+        if (end == std::string::npos) end = text.size();
+        size_t b = pos, e = end;
+        while (b < e && std::isspace(static_cast<unsigned char>(text[b]))) ++b;
+        while (e > b && std::isspace(static_cast<unsigned char>(text[e - 1]))) --e;
+        if (e > b) {
+            if (!out.empty()) out += ' ';
+            out.append(text, b, e - b);
+        }
+        pos = end + 1;
+    }
+    return out;
+}
+
+// 解码器输出的 ASS 事件取出 Text 字段并转为纯文本
+// 新版 FFmpeg 为 "ReadOrder,Layer,Style,Name,MarginL,MarginR,MarginV,Effect,Text"，
+// 旧版为完整的 "Dialogue: Layer,Start,End,Style,Name,MarginL,MarginR,MarginV,Effect,Text"
+// 去掉 {...} 覆盖标签以及 \p 绘图模式下的矢量指令，\N/\n 换行、\h 不换行空格
+static std::string ass_event_text(const char* event) {
+    const std::string line(event);
+    const size_t fields = line.compare(0, 9, "Dialogue:") == 0 ? 9 : 8;
+    size_t pos = 0;
+    for (size_t i = 0; i < fields; ++i) {
+        pos = line.find(',', pos);
+        if (pos == std::string::npos) return {};
+        ++pos;
+    }
+    std::string text;
+    bool drawing = false;
+    for (size_t i = pos; i < line.size(); ++i) {
+        const char c = line[i];
+        if (c == '{') {
+            const size_t close = line.find('}', i);
+            if (close == std::string::npos) break;
+            for (size_t k = i + 1; k + 2 < close; ++k) {
+                if (line[k] == '\\' && line[k + 1] == 'p' && std::isdigit(static_cast<unsigned char>(line[k + 2]))) {
+                    drawing = line[k + 2] != '0';
+                }
+            }
+            i = close;
+            continue;
+        }
+        if (drawing) continue;
+        if (c == '\\' && i + 1 < line.size()) {
+            const char n = line[i + 1];
+            if (n == 'N' || n == 'n') { text += '\n'; ++i; continue; }
+            if (n == 'h') { text += ' '; ++i; continue; }
+        }
+        text += c;
+    }
+    return flatten_subtitle_lines(text);
+}
+#endif
+
+bool extract_subtitle_segments(const std::string& input_path,
+                               int stream_index,
+                               std::vector<Segment>& segments,
+                               const CancellationToken& cancel) {
+    segments.clear();
+    V2S_TRACE_SPAN("extract_subtitle_segments", "ffmpeg");
+#if !V2S_HAVE_FFMPEG
+    (void)input_path; (void)stream_index; (void)cancel;
+    return false;
+#else
+    AVFormatContext* fmt_ctx = avformat_alloc_context();
+    if (!fmt_ctx) {
+        return false;
+    }
+    fmt_ctx->interrupt_callback.callback = ffmpeg_interrupt_cb;
+    fmt_ctx->interrupt_callback.opaque = const_cast<CancellationToken*>(&cancel);
+
+    // 打开失败时 avformat_open_input 会释放 fmt_ctx
+    if (avformat_open_input(&fmt_ctx, input_path.c_str(), nullptr, nullptr) < 0) {
+        return false;
+    }
+    if (avformat_find_stream_info(fmt_ctx, nullptr) < 0 ||
+        stream_index < 0 || stream_index >= static_cast<int>(fmt_ctx->nb_streams)) {
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    AVStream* stream = fmt_ctx->streams[stream_index];
+    const AVCodecDescriptor* desc = avcodec_descriptor_get(stream->codecpar->codec_id);
+    const AVCodec* dec = avcodec_find_decoder(stream->codecpar->codec_id);
+    if (stream->codecpar->codec_type != AVMEDIA_TYPE_SUBTITLE || !desc ||
+        !(desc->props & AV_CODEC_PROP_TEXT_SUB) || !dec) {
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    AVCodecContext* dec_ctx = avcodec_alloc_context3(dec);
+    if (!dec_ctx) {
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    if (avcodec_parameters_to_context(dec_ctx, stream->codecpar) < 0) {
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+    dec_ctx->pkt_timebase = stream->time_base;
+    if (avcodec_open2(dec_ctx, dec, nullptr) < 0) {
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    // 只解复用字幕流：音视频包在容器层直接丢弃，整部影片的字幕通常在数百毫秒内读完
+    for (unsigned i = 0; i < fmt_ctx->nb_streams; ++i) {
+        if (static_cast<int>(i) != stream_index) {
+            fmt_ctx->streams[i]->discard = AVDISCARD_ALL;
+        }
+    }
+
+    AVPacket* pkt = av_packet_alloc();
+    if (!pkt) {
+        avcodec_free_context(&dec_ctx);
+        avformat_close_input(&fmt_ctx);
+        return false;
+    }
+
+    // 时间轴与 ffmpeg 命令行导出一致：减去容器起始时间
+    const double time_base = av_q2d(stream->time_base);
+    const double start_offset = fmt_ctx->start_time != AV_NOPTS_VALUE
+        ? static_cast<double>(fmt_ctx->start_time) / AV_TIME_BASE : 0.0;
+
+    bool ok = true;
+    for (;;) {
+        const int ret = av_read_frame(fmt_ctx, pkt);
+        if (ret == AVERROR_EOF) break;
+        if (ret < 0) {
+            ok = false;   // 含取消时的 AVERROR_EXIT
+            break;
+        }
+        if (pkt->stream_index == stream_index && pkt->pts != AV_NOPTS_VALUE) {
+            AVSubtitle sub{};
+            int got = 0;
+            if (avcodec_decode_subtitle2(dec_ctx, &sub, &got, pkt) >= 0 && got) {
+                const double base = static_cast<double>(pkt->pts) * time_base - start_offset;
+                const double start = base + sub.start_display_time / 1000.0;
+                double end = start;
+                if (sub.end_display_time > sub.start_display_time && sub.end_display_time != UINT32_MAX) {
+                    end = base + sub.end_display_time / 1000.0;
+                } else if (pkt->duration > 0) {
+                    end = base + static_cast<double>(pkt->duration) * time_base;
+                }
+                std::string text;
+                for (unsigned r = 0; r < sub.num_rects; ++r) {
+                    const AVSubtitleRect* rect = sub.rects[r];
+                    std::string part;
+                    if (rect->type == SUBTITLE_ASS && rect->ass) {
+                        part = ass_event_text(rect->ass);
+                    } else if (rect->type == SUBTITLE_TEXT && rect->text) {
+                        part = flatten_subtitle_lines(rect->text);
+                    }
+                    if (part.empty()) continue;
+                    if (!text.empty()) text += ' ';
+                    text += part;
+                }
+                avsubtitle_free(&sub);
+                if (!text.empty()) {
+                    segments.emplace_back(std::max(0.0, start), std::max(0.0, end), text);
+                }
+            }
+        }
+        av_packet_unref(pkt);
+    }
+
+    av_packet_free(&pkt);
+    avcodec_free_context(&dec_ctx);
+    avformat_close_input(&fmt_ctx);
+
+    if (!ok || cancel.is_cancelled()) {
+        segments.clear();
+        return false;
+    }
+
+    // 按开始时间排序；同一时间区间的多个事件（ASS 多行对白、叠加图层的同一句）合并为一段
+    std::stable_sort(segments.begin(), segments.end(),
+                     [](const Segment& a, const Segment& b) { return a.start < b.start; });
+    std::vector<Segment> merged;
+    merged.reserve(segments.size());
+    for (auto& seg : segments) {
+        if (!merged.empty()) {
+            Segment& prev = merged.back();
+            if (std::fabs(prev.start - seg.start) < 0.001 && std::fabs(prev.end - seg.end) < 0.001) {
+                const bool duplicate = prev.text == seg.text ||
+                    (prev.text.size() > seg.text.size() &&
+                     prev.text.compare(prev.text.size() - seg.text.size(), seg.text.size(), seg.text) == 0 &&
+                     prev.text[prev.text.size() - seg.text.size() - 1] == ' ');
+                if (!duplicate) prev.text += " " + seg.text;
+                continue;
+            }
+        }
+        merged.push_back(std::move(seg));
+    }
+    // 缺少显示时长的事件：持续到下一条开始，最长 5 秒
+    constexpr double kDefaultDuration = 5.0;
+    for (size_t i = 0; i < merged.size(); ++i) {
+        if (merged[i].end > merged[i].start) continue;
+        double end = merged[i].start + kDefaultDuration;
+        if (i + 1 < merged.size() && merged[i + 1].start > merged[i].start) {
+            end = std::min(end, merged[i + 1].start);
+        }
+        merged[i].end = end;
+    }
+    segments = std::move(merged);
+    // 容器内的字幕文本不保证是合法 UTF-8（如误标编码的 SRT）
+    repair_utf8_segments(segments);
+    return true;
+#endif
+}
+
+}
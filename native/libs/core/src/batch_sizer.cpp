@@ -0,0 +1,182 @@
+#include "video2srt_native/batch_sizer.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <unordered_map>
+#include <nlohmann/json.hpp>
+
+namespace v2s {
+
+namespace {
+
+constexpr size_t kWindowBatches = 3;        // 每次决策所需的满批次样本数
+constexpr double kGrowthFactor = 1.25;      // 爬坡步长
+constexpr double kImprovement = 0.97;       // 每段耗时低于最优值的 97% 视为仍在下降
+constexpr double kRegression = 1.05;        // 高于最优值的 105% 视为变差
+constexpr double kMinSuccessRate = 0.9;     // 允许增长的最低解析成功率
+constexpr size_t kCooldownBatches = 4;      // 退避后暂停增长的批次数
+constexpr size_t kReprobeWindows = 8;       // 平台期持续多少个窗口后重新试探
+
+// 状态文件读写在进程内串行化（多个键写同一文件）
+std::mutex& state_file_mutex() {
+    static std::mutex m;
+    return m;
+}
+
+nlohmann::json read_state(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return nlohmann::json::object();
+    try {
+        auto j = nlohmann::json::parse(in);
+        if (j.is_object()) return j;
+    } catch (...) {
+        // 损坏的状态文件按空处理，下次保存时覆盖
+    }
+    return nlohmann::json::object();
+}
+
+} // namespace
+
+std::shared_ptr<AdaptiveBatchSizer> AdaptiveBatchSizer::for_key(const std::string& key,
+                                                                const std::filesystem::path& state_file,
+                                                                const Limits& limits) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<AdaptiveBatchSizer>> registry;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[key];
+    if (!slot) slot = std::make_shared<AdaptiveBatchSizer>(key, state_file, limits);
+    return slot;
+}
+
+AdaptiveBatchSizer::AdaptiveBatchSizer(std::string key, std::filesystem::path state_file, const Limits& limits)
+    : key_(std::move(key)), state_file_(std::move(state_file)), limits_(limits) {
+    limit_ = static_cast<double>(std::clamp(limits_.initial_segments, limits_.min_segments, limits_.max_segments));
+    load();
+}
+
+size_t AdaptiveBatchSizer::batch_segments() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<size_t>(limit_);
+}
+
+void AdaptiveBatchSizer::record(size_t segments, double latency_ms, Feedback feedback) {
+    if (feedback == Feedback::Ignore || segments == 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    const double min_limit = static_cast<double>(limits_.min_segments);
+
+    if (feedback != Feedback::Ok) {
+        // 退避：以失败批次的实际大小为基准，避免并发中的旧批次把已缩小的值再放大
+        const double base = std::min(limit_, static_cast<double>(segments));
+        const double factor = feedback == Feedback::TooSlow ? 0.5 : 0.7;
+        const double next = std::max(min_limit, std::floor(base * factor));
+        success_rate_ *= 0.9;
+        cooldown_batches_ = kCooldownBatches;
+        window_batches_ = window_segments_ = 0;
+        window_ms_ = 0.0;
+        if (next < limit_) {
+            limit_ = next;
+            dirty_ = true;
+            // 最优点已不可用，重新学习
+            if (best_limit_ > static_cast<size_t>(limit_)) best_ms_per_segment_ = 0.0;
+        }
+        return;
+    }
+
+    success_rate_ = success_rate_ * 0.9 + 0.1;
+    if (cooldown_batches_ > 0) --cooldown_batches_;
+    // 只有接近满批的样本能代表当前批大小（尾批、受 token 预算截断的批次不计）
+    if (static_cast<double>(segments) * 4.0 < limit_ * 3.0) return;
+    window_batches_++;
+    window_segments_ += segments;
+    window_ms_ += latency_ms;
+    if (window_batches_ < kWindowBatches) return;
+
+    const double ms_per_segment = window_ms_ / static_cast<double>(window_segments_);
+    window_batches_ = window_segments_ = 0;
+    window_ms_ = 0.0;
+    const bool may_grow = cooldown_batches_ == 0 && success_rate_ >= kMinSuccessRate;
+
+    if (best_ms_per_segment_ <= 0.0 || ms_per_segment <= best_ms_per_segment_ * kImprovement) {
+        // 每段耗时仍在下降：记为最优并继续增长
+        best_ms_per_segment_ = ms_per_segment;
+        best_limit_ = static_cast<size_t>(limit_);
+        plateau_windows_ = 0;
+        if (may_grow) grow();
+    } else if (ms_per_segment >= best_ms_per_segment_ * kRegression && static_cast<size_t>(limit_) > best_limit_) {
+        // 变大后反而变慢：退回最优点
+        limit_ = static_cast<double>(std::max(best_limit_, limits_.min_segments));
+        plateau_windows_ = 0;
+        dirty_ = true;
+    } else {
+        // 平台期：跟踪最优点耗时的漂移，定期重新试探
+        if (static_cast<size_t>(limit_) == best_limit_) {
+            best_ms_per_segment_ = 0.5 * (best_ms_per_segment_ + ms_per_segment);
+        }
+        if (++plateau_windows_ >= kReprobeWindows && may_grow) {
+            plateau_windows_ = 0;
+            grow();
+        }
+    }
+}
+
+void AdaptiveBatchSizer::grow() {
+    const double max_limit = static_cast<double>(limits_.max_segments);
+    const double next = std::min(max_limit, std::max(limit_ + 1.0, std::floor(limit_ * kGrowthFactor)));
+    if (next > limit_) {
+        limit_ = next;
+        dirty_ = true;
+    }
+}
+
+void AdaptiveBatchSizer::load() {
+    if (state_file_.empty()) return;
+    std::lock_guard<std::mutex> file_lock(state_file_mutex());
+    const auto state = read_state(state_file_);
+    if (!state.contains(key_) || !state[key_].is_object()) return;
+    const auto& entry = state[key_];
+    if (entry.contains("batch_segments") && entry["batch_segments"].is_number_unsigned()) {
+        const size_t learned = entry["batch_segments"].get<size_t>();
+        limit_ = static_cast<double>(std::clamp(learned, limits_.min_segments, limits_.max_segments));
+    }
+}
+
+void AdaptiveBatchSizer::save() {
+    nlohmann::json entry;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!dirty_ || state_file_.empty()) return;
+        dirty_ = false;
+        entry = {
+            {"batch_segments", static_cast<size_t>(limit_)},
+            {"ms_per_segment", best_ms_per_segment_},
+            {"success_rate", success_rate_},
+            {"updated_ms", std::chrono::duration_cast<std::chrono::milliseconds>(
+                               std::chrono::system_clock::now().time_since_epoch()).count()}
+        };
+    }
+
+    std::lock_guard<std::mutex> file_lock(state_file_mutex());
+    std::error_code ec;
+    if (state_file_.has_parent_path()) std::filesystem::create_directories(state_file_.parent_path(), ec);
+    auto state = read_state(state_file_);
+    state[key_] = std::move(entry);
+    // 先写临时文件再改名，读到的总是完整文件
+    std::filesystem::path tmp = state_file_;
+    tmp += ".tmp";
+    {
+        std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "[AdaptiveBatchSizer] 无法写入状态文件: " << tmp.string() << std::endl;
+            return;
+        }
+        out << state.dump(2);
+    }
+    std::filesystem::rename(tmp, state_file_, ec);
+    if (ec) {
+        std::cerr << "[AdaptiveBatchSizer] 无法更新状态文件: " << state_file_.string() << " (" << ec.message() << ")" << std::endl;
+    }
+}
+
+} // namespace v2s
@@ -0,0 +1,215 @@
+#include "video2srt_native/batch_wire_format.hpp"
+#include <algorithm>
+#include <cctype>
+
+namespace v2s {
+
+namespace {
+
+std::string_view trim_view(std::string_view s) {
+    const auto start = s.find_first_not_of(" \t\r\n");
+    if (start == std::string_view::npos) return {};
+    const auto end = s.find_last_not_of(" \t\r\n");
+    return s.substr(start, end - start + 1);
+}
+
+bool iequals(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i]))) return false;
+    }
+    return true;
+}
+
+// <br>、<br/>、<br /> -> \n
+std::string decode_value(std::string_view value) {
+    std::string out;
+    out.reserve(value.size());
+    size_t i = 0;
+    while (i < value.size()) {
+        if (value[i] == '<' && i + 3 < value.size() && (value[i + 1] == 'b' || value[i + 1] == 'B') &&
+            (value[i + 2] == 'r' || value[i + 2] == 'R')) {
+            size_t j = i + 3;
+            while (j < value.size() && value[j] == ' ') ++j;
+            if (j < value.size() && value[j] == '/') ++j;
+            if (j < value.size() && value[j] == '>') {
+                out += '\n';
+                i = j + 1;
+                continue;
+            }
+        }
+        out += value[i++];
+    }
+    return out;
+}
+
+// "<n>|<text>"：成功时给出 0 起下标与（未解码的）文本
+bool match_numbered_line(std::string_view line, size_t count, size_t& index, std::string_view& value) {
+    line = trim_view(line);
+    if (line.size() >= 2 && (line[0] == '-' || line[0] == '*') && line[1] == ' ') line = trim_view(line.substr(2));
+    size_t pos = 0;
+    size_t n = 0;
+    while (pos < line.size() && pos < 7 && std::isdigit(static_cast<unsigned char>(line[pos]))) {
+        n = n * 10 + static_cast<size_t>(line[pos] - '0');
+        ++pos;
+    }
+    if (pos == 0 || n < 1 || n > count) return false;
+    while (pos < line.size() && line[pos] == ' ') ++pos;
+    if (pos >= line.size()) return false;
+    if (line[pos] == '|' || line[pos] == ':' || line[pos] == '.' || line[pos] == ')') {
+        ++pos;
+    } else if (line.compare(pos, 3, "\xEF\xBD\x9C") == 0) {   // 全角竖线 ｜
+        pos += 3;
+    } else {
+        return false;
+    }
+    index = n - 1;
+    value = trim_view(line.substr(pos));
+    return true;
+}
+
+bool is_fence(std::string_view line) {
+    return trim_view(line).substr(0, 3) == "```";
+}
+
+} // namespace
+
+std::string encode_numbered_lines(const std::vector<std::string>& texts) {
+    std::string out;
+    size_t total = 0;
+    for (const auto& t : texts) total += t.size() + 8;
+    out.reserve(total);
+    for (size_t i = 0; i < texts.size(); ++i) {
+        if (i) out += '\n';
+        out += std::to_string(i + 1);
+        out += '|';
+        const std::string& t = texts[i];
+        for (size_t k = 0; k < t.size(); ++k) {
+            if (t[k] == '\r' || t[k] == '\n') {
+                if (t[k] == '\r' && k + 1 < t.size() && t[k + 1] == '\n') ++k;
+                out += "<br>";
+            } else {
+                out += t[k];
+            }
+        }
+    }
+    return out;
+}
+
+NumberedLines parse_numbered_lines(std::string_view content, size_t count) {
+    NumberedLines result;
+    result.items.resize(count);
+    std::optional<size_t> current;   // 当前项（接收续行），重复编号时为空
+    size_t start = 0;
+    while (start <= content.size()) {
+        size_t end = content.find('\n', start);
+        if (end == std::string_view::npos) end = content.size();
+        const std::string_view line = content.substr(start, end - start);
+        start = end + 1;
+
+        if (trim_view(line).empty() || is_fence(line)) continue;
+        size_t index = 0;
+        std::string_view value;
+        if (match_numbered_line(line, count, index, value)) {
+            if (result.items[index]) {
+                result.duplicates = true;
+                current.reset();
+                result.last_index.reset();
+                continue;
+            }
+            ++result.numbered_lines;
+            result.items[index] = decode_value(value);
+            current = index;
+            result.last_index = index;
+        } else if (current) {
+            std::string& item = *result.items[*current];
+            const std::string more = decode_value(trim_view(line));
+            if (!item.empty()) item += '\n';
+            item += more;
+        }
+    }
+    return result;
+}
+
+std::vector<std::string> split_language_sections(std::string_view content, const std::vector<std::string>& languages) {
+    std::vector<std::string> sections(languages.size());
+    std::optional<size_t> current;
+    size_t start = 0;
+    while (start <= content.size()) {
+        size_t end = content.find('\n', start);
+        if (end == std::string_view::npos) end = content.size();
+        const std::string_view line = content.substr(start, end - start);
+        start = end + 1;
+
+        // 分节行："@zh"、"[zh]"、"## zh"、"zh:"
+        std::string_view t = trim_view(line);
+        std::string_view name;
+        if (!t.empty() && t.front() == '@') name = trim_view(t.substr(1));
+        else if (t.size() > 2 && t.front() == '[' && t.back() == ']') name = trim_view(t.substr(1, t.size() - 2));
+        else if (t.size() > 2 && t.substr(0, 2) == "##") name = trim_view(t.substr(2));
+        else if (t.size() > 1 && t.back() == ':') name = trim_view(t.substr(0, t.size() - 1));
+        if (!name.empty()) {
+            const auto it = std::find_if(languages.begin(), languages.end(),
+                                         [&](const std::string& lang) { return iequals(lang, name); });
+            if (it != languages.end()) {
+                current = static_cast<size_t>(it - languages.begin());
+                continue;
+            }
+        }
+        if (current) {
+            sections[*current].append(line.data(), line.size());
+            sections[*current] += '\n';
+        }
+    }
+    return sections;
+}
+
+// ---------------- NumberedLinesStreamer ----------------
+
+NumberedLinesStreamer::NumberedLinesStreamer(size_t count, ItemCallback on_item)
+    : count_(count), on_item_(std::move(on_item)), seen_(count, 0) {}
+
+void NumberedLinesStreamer::feed(std::string_view chunk) {
+    for (char c : chunk) {
+        if (c == '\n') {
+            process_line(line_);
+            line_.clear();
+        } else {
+            line_ += c;
+        }
+    }
+}
+
+void NumberedLinesStreamer::finish() {
+    if (!line_.empty()) {
+        process_line(line_);
+        line_.clear();
+    }
+    flush();
+}
+
+void NumberedLinesStreamer::process_line(std::string_view line) {
+    if (trim_view(line).empty() || is_fence(line)) return;
+    size_t index = 0;
+    std::string_view value;
+    if (match_numbered_line(line, count_, index, value)) {
+        flush();
+        if (seen_[index]) return;   // 重复编号：保留第一次
+        seen_[index] = 1;
+        pending_index_ = index;
+        pending_ = decode_value(value);
+    } else if (pending_index_) {
+        if (!pending_.empty()) pending_ += '\n';
+        pending_ += decode_value(trim_view(line));
+    }
+}
+
+void NumberedLinesStreamer::flush() {
+    if (!pending_index_) return;
+    ++emitted_;
+    if (on_item_) on_item_(*pending_index_, std::move(pending_));
+    pending_index_.reset();
+    pending_.clear();
+}
+
+} // namespace v2s
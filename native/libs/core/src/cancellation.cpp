@@ -0,0 +1,127 @@
+#include "video2srt_native/cancellation.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace v2s {
+
+// 联动令牌等待时检查上级令牌的间隔（上级取消不会唤醒下级的条件变量）
+static constexpr std::chrono::milliseconds kLinkedPoll{50};
+
+static int64_t to_ns(CancellationToken::Clock::time_point tp) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(tp.time_since_epoch()).count();
+}
+
+struct CancellationToken::State {
+    std::atomic<bool> cancelled{false};
+    // 截止时间（steady_clock 纳秒计数），max 表示未设置
+    std::atomic<int64_t> deadline_ns{std::numeric_limits<int64_t>::max()};
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::vector<std::shared_ptr<State>> parents;   // 联动的上级令牌（创建后不再修改）
+
+    Reason reason_at(int64_t now_ns) const {
+        if (cancelled.load(std::memory_order_acquire)) return Reason::Cancelled;
+        const int64_t deadline = deadline_ns.load(std::memory_order_acquire);
+        if (deadline != std::numeric_limits<int64_t>::max() && now_ns >= deadline) return Reason::DeadlineExceeded;
+        for (const auto& parent : parents) {
+            const Reason reason = parent->reason_at(now_ns);
+            if (reason != Reason::None) return reason;
+        }
+        return Reason::None;
+    }
+
+    // 自身与上级令牌中最早的截止时间
+    int64_t earliest_deadline() const {
+        int64_t deadline = deadline_ns.load(std::memory_order_acquire);
+        for (const auto& parent : parents) deadline = std::min(deadline, parent->earliest_deadline());
+        return deadline;
+    }
+};
+
+CancellationToken CancellationToken::create() {
+    CancellationToken token;
+    token.state_ = std::make_shared<State>();
+    return token;
+}
+
+CancellationToken CancellationToken::create_linked(std::initializer_list<CancellationToken> parents) {
+    CancellationToken token = create();
+    for (const auto& parent : parents) {
+        if (parent.state_) token.state_->parents.push_back(parent.state_);
+    }
+    return token;
+}
+
+void CancellationToken::cancel() const {
+    if (!state_) return;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->cancelled.store(true, std::memory_order_release);
+    }
+    state_->cv.notify_all();
+}
+
+void CancellationToken::set_deadline(Clock::time_point deadline) const {
+    if (!state_) return;
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex);
+        state_->deadline_ns.store(to_ns(deadline), std::memory_order_release);
+    }
+    state_->cv.notify_all();
+}
+
+bool CancellationToken::is_cancelled() const {
+    return reason() != Reason::None;
+}
+
+CancellationToken::Reason CancellationToken::reason() const {
+    if (!state_) return Reason::None;
+    return state_->reason_at(to_ns(Clock::now()));
+}
+
+std::optional<std::chrono::milliseconds> CancellationToken::remaining() const {
+    if (!state_) return std::nullopt;
+    const int64_t deadline = state_->earliest_deadline();
+    if (deadline == std::numeric_limits<int64_t>::max()) return std::nullopt;
+    const int64_t left_ns = deadline - to_ns(Clock::now());
+    return std::chrono::milliseconds(std::max<int64_t>(0, left_ns / 1000000));
+}
+
+bool CancellationToken::wait_for(std::chrono::milliseconds duration) const {
+    if (!state_) {
+        std::this_thread::sleep_for(duration);
+        return false;
+    }
+    auto until = Clock::now() + duration;
+    const int64_t deadline = state_->earliest_deadline();
+    if (deadline != std::numeric_limits<int64_t>::max()) {
+        until = std::min(until, Clock::time_point(std::chrono::duration_cast<Clock::duration>(std::chrono::nanoseconds(deadline))));
+    }
+    std::unique_lock<std::mutex> lock(state_->mutex);
+    if (state_->parents.empty()) {
+        state_->cv.wait_until(lock, until, [this] { return state_->cancelled.load(std::memory_order_acquire); });
+    } else {
+        while (!is_cancelled() && Clock::now() < until) {
+            state_->cv.wait_until(lock, std::min(until, Clock::now() + kLinkedPoll),
+                                  [this] { return state_->cancelled.load(std::memory_order_acquire); });
+        }
+    }
+    lock.unlock();
+    return is_cancelled();
+}
+
+const char* cancellation_message(CancellationToken::Reason reason) {
+    switch (reason) {
+        case CancellationToken::Reason::Cancelled: return "任务已取消";
+        case CancellationToken::Reason::DeadlineExceeded: return "任务超过截止时间";
+        case CancellationToken::Reason::None: break;
+    }
+    return "";
+}
+
+} // namespace v2s
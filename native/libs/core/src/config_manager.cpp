@@ -1,5 +1,6 @@
 #include "video2srt_native/config_manager.hpp"
 #include "video2srt_native/model_manager.hpp"
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <nlohmann/json.hpp>
@@ -70,6 +71,58 @@ static bool read_json_file(const std::filesystem::path& path, json& out) {
     }
 }
 
+// translators.google 节点 -> 翻译器选项
+static void apply_google_options(const json& ggl, TranslatorOptions& opts) {
+    opts.timeout_seconds = ggl.value("timeout", opts.timeout_seconds);
+    opts.retry_count = ggl.value("retry_count", opts.retry_count);
+    opts.ssl_bypass = ggl.value("use_ssl_bypass", opts.ssl_bypass);
+    opts.max_concurrency = ggl.value("max_concurrency", opts.max_concurrency);
+    opts.rate_limit_rps = ggl.value("rate_limit_rps", opts.rate_limit_rps);
+    opts.rate_limit_burst = ggl.value("rate_limit_burst", opts.rate_limit_burst);
+    // 默认 base_url（注：非官方端点）
+    opts.base_url = "https://translate.googleapis.com";
+}
+
+// translators.openai 节点 -> 翻译器选项
+static void apply_openai_options(const json& oa, TranslatorOptions& opts) {
+    if (oa.contains("api_key") && oa["api_key"].is_string()) {
+        opts.api_key = oa["api_key"].get<std::string>();
+    }
+    if (oa.contains("base_url") && oa["base_url"].is_string()) {
+        opts.base_url = oa["base_url"].get<std::string>();
+    }
+    if (oa.contains("model") && oa["model"].is_string()) {
+        opts.model = oa["model"].get<std::string>();
+    }
+    opts.max_tokens = oa.value("max_tokens", opts.max_tokens);
+    opts.temperature = oa.value("temperature", opts.temperature);
+    opts.timeout_seconds = oa.value("timeout", opts.timeout_seconds);
+    opts.retry_count = oa.value("retry_count", opts.retry_count);
+    opts.max_concurrency = oa.value("max_concurrency", opts.max_concurrency);
+    opts.rate_limit_rps = oa.value("rate_limit_rps", opts.rate_limit_rps);
+    opts.rate_limit_burst = oa.value("rate_limit_burst", opts.rate_limit_burst);
+    opts.batch_mode = oa.value("batch_mode", opts.batch_mode);
+    opts.stream = oa.value("stream", opts.stream);
+    opts.max_batch_prompt_tokens = oa.value("max_batch_prompt_tokens", opts.max_batch_prompt_tokens);
+    opts.max_batch_segments = oa.value("max_batch_segments", opts.max_batch_segments);
+    opts.adaptive_batch = oa.value("adaptive_batch", opts.adaptive_batch);
+    opts.coalesce_batches = oa.value("coalesce_batches", opts.coalesce_batches);
+    opts.coalesce_linger_ms = oa.value("coalesce_linger_ms", opts.coalesce_linger_ms);
+    if (oa.contains("batch_format") && oa["batch_format"].is_string()) {
+        // 未知取值忽略，保留默认的 lines
+        const std::string format = oa["batch_format"].get<std::string>();
+        if (format == "lines" || format == "json") opts.batch_format = format;
+    }
+    opts.structured_json_output = oa.value("structured_json_output", opts.structured_json_output);
+    // pricing：每百万 token 单价，用于估算任务费用
+    if (oa.contains("pricing") && oa["pricing"].is_object()) {
+        const auto& p = oa["pricing"];
+        opts.price_per_million_prompt_tokens = p.value("prompt", opts.price_per_million_prompt_tokens);
+        opts.price_per_million_cached_tokens = p.value("cached_prompt", opts.price_per_million_cached_tokens);
+        opts.price_per_million_completion_tokens = p.value("completion", opts.price_per_million_completion_tokens);
+    }
+}
+
 bool ConfigManager::apply_default_config(ProcessingConfig& config,
                                          const std::filesystem::path& config_path) {
     const auto abs_config = resolve_to_app_dir(config_path);
@@ -89,6 +142,52 @@ bool ConfigManager::apply_default_config(ProcessingConfig& config,
         }
     }
 
+    // translation.*（持久缓存、模糊翻译记忆、去重、对冲请求、用量记录）
+    if (j.contains("translation") && j["translation"].is_object()) {
+        const auto& tr = j["translation"];
+        config.translator_options.cache_enabled = tr.value("cache_enabled", config.translator_options.cache_enabled);
+        config.translator_options.deduplicate = tr.value("deduplicate", config.translator_options.deduplicate);
+        config.translator_options.fuzzy_memory = tr.value("fuzzy_memory", config.translator_options.fuzzy_memory);
+        if (tr.contains("fuzzy_threshold") && tr["fuzzy_threshold"].is_number()) {
+            const double threshold = tr["fuzzy_threshold"].get<double>();
+            if (threshold > 0.0 && threshold <= 1.0) {
+                config.translator_options.fuzzy_threshold = threshold;
+            }
+        }
+        if (tr.contains("fuzzy_max_chars") && tr["fuzzy_max_chars"].is_number_integer()) {
+            const int64_t max_chars = tr["fuzzy_max_chars"].get<int64_t>();
+            if (max_chars >= 0) {
+                config.translator_options.fuzzy_max_chars = static_cast<size_t>(max_chars);
+            }
+        }
+        config.translator_options.hedge_requests = tr.value("hedge_requests", config.translator_options.hedge_requests);
+        config.translator_options.hedge_to_fallback = tr.value("hedge_to_fallback", config.translator_options.hedge_to_fallback);
+        config.translator_options.hedge_min_delay_ms = tr.value("hedge_min_delay_ms", config.translator_options.hedge_min_delay_ms);
+        if (tr.contains("cache_dir") && tr["cache_dir"].is_string()) {
+            std::filesystem::path dir(tr["cache_dir"].get<std::string>());
+            if (!dir.empty() && !dir.is_absolute()) {
+                dir = get_executable_dir() / dir;
+            }
+            config.translator_options.cache_dir = dir.string();
+        }
+        if (tr.contains("usage_log") && tr["usage_log"].is_string()) {
+            std::filesystem::path path(tr["usage_log"].get<std::string>());
+            if (!path.empty() && !path.is_absolute()) {
+                path = get_executable_dir() / path;
+            }
+            config.translator_options.usage_log_path = path.string();
+        }
+        if (tr.contains("usage_tag") && tr["usage_tag"].is_string()) {
+            config.translator_options.usage_tag = tr["usage_tag"].get<std::string>();
+        }
+        if (tr.contains("cache_max_mb") && tr["cache_max_mb"].is_number()) {
+            const double mb = tr["cache_max_mb"].get<double>();
+            if (mb > 0) {
+                config.translator_options.cache_max_bytes = static_cast<uint64_t>(mb * 1024.0 * 1024.0);
+            }
+        }
+    }
+
     // whisper.*
     if (j.contains("whisper") && j["whisper"].is_object()) {
         const auto& w = j["whisper"];
@@ -106,6 +205,13 @@ bool ConfigManager::apply_default_config(ProcessingConfig& config,
                 }
             }
         }
+        // 内嵌文本字幕复用策略（off/auto/always），其他取值忽略
+        if (w.contains("embedded_subtitles") && w["embedded_subtitles"].is_string()) {
+            const std::string policy = w["embedded_subtitles"].get<std::string>();
+            if (policy == "off" || policy == "auto" || policy == "always") {
+                config.embedded_subtitles = policy;
+            }
+        }
         if (w.contains("model_dir") && w["model_dir"].is_string()) {
             std::string model_dir = w["model_dir"].get<std::string>();
             if (!model_dir.empty()) {
@@ -135,31 +241,41 @@ bool ConfigManager::apply_default_config(ProcessingConfig& config,
             const auto& ggl = t["google"];
             bool google_enabled = ggl.value("enabled", false);
             if (config.translator_type == "google" && google_enabled) {
-                config.translator_options.timeout_seconds = ggl.value("timeout", config.translator_options.timeout_seconds);
-                config.translator_options.retry_count = ggl.value("retry_count", config.translator_options.retry_count);
-                config.translator_options.ssl_bypass = ggl.value("use_ssl_bypass", config.translator_options.ssl_bypass);
-                // 默认 base_url（注：非官方端点）
-                config.translator_options.base_url = "https://translate.googleapis.com";
+                apply_google_options(ggl, config.translator_options);
             }
         }
         if (t.contains("openai") && t["openai"].is_object()) {
             const auto& oa = t["openai"];
             bool openai_enabled = oa.value("enabled", false);
             if (config.translator_type == "openai" && openai_enabled) {
-                if (oa.contains("api_key") && oa["api_key"].is_string()) {
-                    config.translator_options.api_key = oa["api_key"].get<std::string>();
-                }
-                if (oa.contains("base_url") && oa["base_url"].is_string()) {
-                    config.translator_options.base_url = oa["base_url"].get<std::string>();
-                }
-                if (oa.contains("model") && oa["model"].is_string()) {
-                    config.translator_options.model = oa["model"].get<std::string>();
-                }
-                config.translator_options.max_tokens = oa.value("max_tokens", config.translator_options.max_tokens);
-                config.translator_options.temperature = oa.value("temperature", config.translator_options.temperature);
-                config.translator_options.timeout_seconds = oa.value("timeout", config.translator_options.timeout_seconds);
-                config.translator_options.retry_count = oa.value("retry_count", config.translator_options.retry_count);
+                apply_openai_options(oa, config.translator_options);
+            }
+        }
+    }
+
+    // general.fallback_translator：单个类型或类型数组，按顺序组成故障转移链；
+    // 各后备翻译器使用 translators.<type> 中自己的端点与超时设置（无论 enabled 与否）
+    config.fallback_translators.clear();
+    if (j.contains("general") && j["general"].is_object() && j["general"].contains("fallback_translator")) {
+        const auto& fb = j["general"]["fallback_translator"];
+        std::vector<std::string> types;
+        if (fb.is_string()) {
+            types.push_back(fb.get<std::string>());
+        } else if (fb.is_array()) {
+            for (const auto& item : fb) {
+                if (item.is_string()) types.push_back(item.get<std::string>());
+            }
+        }
+        const json translators = j.contains("translators") && j["translators"].is_object() ? j["translators"] : json::object();
+        for (const auto& type : types) {
+            if (type != "google" && type != "openai") continue;   // 其余类型暂无原生实现
+            TranslatorBackend backend;
+            backend.type = type;
+            if (translators.contains(type) && translators[type].is_object()) {
+                if (type == "google") apply_google_options(translators[type], backend.options);
+                else apply_openai_options(translators[type], backend.options);
             }
+            config.fallback_translators.push_back(std::move(backend));
         }
     }
 
@@ -247,7 +363,7 @@ bool ConfigManager::save_user_config(const std::filesystem::path& user_config_pa
                     {"whisper", json{{"model_size", "base"}, {"language", "auto"}, {"device", "auto"}}},
                     {"translators", json{
                         {"google", json{{"enabled", false}, {"timeout", 15}, {"retry_count", 3}, {"use_ssl_bypass", false}}},
-                        {"openai", json{{"enabled", false}, {"api_key", ""}, {"base_url", "https://api.openai.com/v1"}, {"model", "gpt-3.5-turbo"}, {"max_tokens", 4000}, {"temperature", 0.3}, {"timeout", 15}, {"retry_count", 3}}}
+                        {"openai", json{{"enabled", false}, {"api_key", ""}, {"base_url", "https://api.openai.com/v1"}, {"model", "gpt-3.5-turbo"}, {"max_tokens", 4000}, {"temperature", 0.3}, {"timeout", 15}, {"retry_count", 3}, {"max_concurrency", 4}}}
                     }}
                 };
             }
@@ -288,6 +404,11 @@ bool ConfigManager::save_user_config(const std::filesystem::path& user_config_pa
         j["translators"]["openai"]["temperature"] = cfg.translator_options.temperature;
         j["translators"]["openai"]["timeout"] = cfg.translator_options.timeout_seconds;
         j["translators"]["openai"]["retry_count"] = cfg.translator_options.retry_count;
+        j["translators"]["openai"]["max_concurrency"] = std::max(1, cfg.translator_options.max_concurrency);
+        j["translators"]["openai"]["rate_limit_rps"] = std::max(0.0, cfg.translator_options.rate_limit_rps);
+        j["translators"]["openai"]["batch_mode"] = cfg.translator_options.batch_mode;
+        j["translators"]["openai"]["stream"] = cfg.translator_options.stream;
+        j["translators"]["openai"]["max_batch_prompt_tokens"] = std::max(1, cfg.translator_options.max_batch_prompt_tokens);
 
         // 写回（美化缩进）
         std::filesystem::create_directories(abs_user.parent_path());
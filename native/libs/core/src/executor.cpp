@@ -0,0 +1,147 @@
+#include "video2srt_native/executor.hpp"
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace v2s {
+
+struct Executor::Impl {
+    mutable std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::function<void()>> queue;
+    std::vector<std::thread> workers;
+    bool stopping = false;
+
+    void worker_loop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                cv.wait(lock, [this] { return stopping || !queue.empty(); });
+                if (queue.empty()) return; // stopping 且队列已清空
+                task = std::move(queue.front());
+                queue.pop_front();
+            }
+            try {
+                task();
+            } catch (...) {
+                // 任务应自行处理异常；此处仅防止工作线程退出
+            }
+        }
+    }
+};
+
+Executor& Executor::shared() {
+    static Executor instance;
+    return instance;
+}
+
+Executor::Executor() : impl_(new Impl) {}
+
+Executor::~Executor() {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        impl_->stopping = true;
+    }
+    impl_->cv.notify_all();
+    for (auto& t : impl_->workers) {
+        if (t.joinable()) t.join();
+    }
+    delete impl_;
+}
+
+void Executor::submit(std::function<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(impl_->mutex);
+        if (impl_->workers.empty()) {
+            impl_->workers.emplace_back([this] { impl_->worker_loop(); });
+        }
+        impl_->queue.push_back(std::move(task));
+    }
+    impl_->cv.notify_one();
+}
+
+void Executor::ensure_workers(size_t n) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    n = std::min(n, kMaxWorkers);
+    while (impl_->workers.size() < n) {
+        impl_->workers.emplace_back([this] { impl_->worker_loop(); });
+    }
+}
+
+size_t Executor::worker_count() const {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    return impl_->workers.size();
+}
+
+namespace {
+
+// parallel_for 的共享状态：辅助任务可能在调用方返回后才被线程池调度，
+// 因此以 shared_ptr 持有，且只在领取到有效下标时才访问 fn
+struct ParallelState {
+    size_t count = 0;
+    const std::function<void(size_t)>* fn = nullptr;
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t finished = 0;        // 已完成（含因失败跳过）的下标数
+    std::exception_ptr error;
+
+    // 领取并执行下标，直到无剩余
+    void run() {
+        for (;;) {
+            const size_t i = next.fetch_add(1, std::memory_order_relaxed);
+            if (i >= count) return;
+            if (!failed.load(std::memory_order_acquire)) {
+                try {
+                    (*fn)(i);
+                } catch (...) {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (!error) error = std::current_exception();
+                    failed.store(true, std::memory_order_release);
+                }
+            }
+            bool all_done = false;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                all_done = (++finished == count);
+            }
+            if (all_done) cv.notify_all();
+        }
+    }
+};
+
+} // namespace
+
+void parallel_for(size_t count, size_t max_parallel, const std::function<void(size_t)>& fn) {
+    if (count == 0) return;
+    if (max_parallel <= 1 || count == 1) {
+        for (size_t i = 0; i < count; ++i) fn(i);
+        return;
+    }
+
+    auto state = std::make_shared<ParallelState>();
+    state->count = count;
+    state->fn = &fn;
+
+    const size_t helpers = std::min(max_parallel, count) - 1;
+    auto& executor = Executor::shared();
+    executor.ensure_workers(helpers);
+    for (size_t h = 0; h < helpers; ++h) {
+        executor.submit([state] { state->run(); });
+    }
+    state->run();
+
+    std::unique_lock<std::mutex> lock(state->mutex);
+    state->cv.wait(lock, [&] { return state->finished == state->count; });
+    if (state->error) std::rethrow_exception(state->error);
+}
+
+} // namespace v2s
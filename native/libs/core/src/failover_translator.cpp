@@ -0,0 +1,508 @@
+#include "video2srt_native/failover_translator.hpp"
+#include "video2srt_native/executor.hpp"
+#include "video2srt_native/metrics.hpp"
+#include "video2srt_native/trace.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <unordered_map>
+
+namespace v2s {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 连续整体失败的单元数达到阈值后，该翻译器冷却一段时间（期间直接交给链中下一个）
+constexpr int kFailureThreshold = 3;
+constexpr std::chrono::milliseconds kCooldown{30000};
+// 对冲预算：对冲请求数不超过 1 + 已开始单元数的 10%
+constexpr size_t kHedgeBudgetDivisor = 10;
+// 等待胜者时检查外部取消的间隔
+constexpr std::chrono::milliseconds kPollInterval{50};
+
+int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// 进程内按翻译器端点共享的耗时窗口，新任务的前几个单元也能用上历史 p95；
+// 一次翻译到多个目标语言的单元耗时明显更长，按目标语言数分开统计
+std::shared_ptr<FailoverTranslator::LatencyWindow> latency_window_for(const TranslatorBackend& backend,
+                                                                      size_t target_count = 1) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<FailoverTranslator::LatencyWindow>> registry;
+    std::string key = backend.type + "|" + backend.options.base_url + "|" + backend.options.model
+        + (backend.options.batch_mode ? "|batch" : "|single");
+    if (target_count > 1) key += "|x" + std::to_string(target_count);
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[key];
+    if (!slot) slot = std::make_shared<FailoverTranslator::LatencyWindow>();
+    return slot;
+}
+
+void merge_stats(TranslationStats& into, TranslationStats&& from) {
+    into.request_count += from.request_count;
+    into.failed_requests += from.failed_requests;
+    into.request_latencies_ms.insert(into.request_latencies_ms.end(),
+                                     from.request_latencies_ms.begin(), from.request_latencies_ms.end());
+    into.cache_hits += from.cache_hits;
+    into.cache_misses += from.cache_misses;
+    into.fuzzy_hits += from.fuzzy_hits;
+    into.deduplicated_segments += from.deduplicated_segments;
+    into.retries += from.retries;
+    into.usage += from.usage;
+}
+
+} // namespace
+
+// ---------------- LatencyWindow ----------------
+
+void FailoverTranslator::LatencyWindow::record(double ms) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (samples_.size() < kCapacity) {
+        samples_.push_back(ms);
+    } else {
+        samples_[next_] = ms;
+        next_ = (next_ + 1) % kCapacity;
+    }
+}
+
+std::optional<double> FailoverTranslator::LatencyWindow::percentile(double p) const {
+    std::vector<double> sorted;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (samples_.size() < kMinSamples) return std::nullopt;
+        sorted = samples_;
+    }
+    std::sort(sorted.begin(), sorted.end());
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    if (rank == 0) rank = 1;
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+// ---------------- FailoverTranslator ----------------
+
+// 同一单元的各次尝试共用一把锁与条件变量，任一尝试完成即唤醒等待方
+struct FailoverTranslator::Race {
+    std::mutex mutex;
+    std::condition_variable cv;
+    const Attempt* streamer = nullptr;   // 最先产生单段事件的尝试，只转发它的事件
+    std::vector<char> streamed;          // streamer 已转发的单元内下标
+};
+
+struct FailoverTranslator::Attempt {
+    size_t backend_index = 0;
+    CancellationToken cancel;      // 子令牌：落败或外部取消时取消
+    Clock::time_point started;
+    // 以下字段受 Race::mutex 保护
+    bool done = false;
+    std::vector<TranslationResult> results;   // 与目标语言一一对应，请求统计在第一个结果上
+    double elapsed_ms = 0.0;
+    Clock::time_point finished;
+
+    size_t failed_count() const {
+        size_t failed = 0;
+        for (const auto& r : results) failed += r.failed_indices.size();
+        return failed;
+    }
+};
+
+struct FailoverTranslator::UnitOutcome {
+    std::vector<TranslationResult> results;
+    size_t backend_index = 0;      // 胜出结果来自的翻译器
+    bool hedged = false;
+    bool hedge_won = false;
+    std::vector<char> notified;    // 已以胜出结果的译文回调过的单元内下标（仅单目标语言）
+};
+
+FailoverTranslator::FailoverTranslator(std::vector<TranslatorBackend> chain, TranslatorFactory factory)
+    : factory_(std::move(factory)) {
+    if (!chain.empty()) options_cancel_ = chain.front().options.cancel;
+    bool cacheable = true;
+    for (auto& config : chain) {
+        auto backend = std::make_unique<Backend>();
+        backend->latency = latency_window_for(config);
+        auto translator = factory_(config.type, config.options);
+        const std::string ns = translator->cache_namespace();
+        if (ns.empty()) cacheable = false;
+        if (!cache_namespace_.empty()) cache_namespace_ += '+';
+        cache_namespace_ += ns;
+        backend->idle.push_back(std::move(translator));
+        backend->config = std::move(config);
+        chain_.push_back(std::move(backend));
+    }
+    if (!cacheable) cache_namespace_.clear();
+}
+
+FailoverTranslator::~FailoverTranslator() {
+    finish_calls();
+}
+
+bool FailoverTranslator::backend_available(size_t index) const {
+    return chain_[index]->down_until_ms.load(std::memory_order_relaxed) <= now_ms();
+}
+
+void FailoverTranslator::record_health(size_t index, bool all_failed) {
+    Backend& backend = *chain_[index];
+    if (!all_failed) {
+        backend.consecutive_failures.store(0, std::memory_order_relaxed);
+        return;
+    }
+    if (backend.consecutive_failures.fetch_add(1, std::memory_order_relaxed) + 1 == kFailureThreshold
+        && index + 1 < chain_.size()) {
+        backend.down_until_ms.store(now_ms() + kCooldown.count(), std::memory_order_relaxed);
+        std::cerr << "[FailoverTranslator] " << backend.config.type << " 连续 " << kFailureThreshold
+                  << " 个翻译单元失败，" << kCooldown.count() / 1000 << " 秒内改用 "
+                  << chain_[index + 1]->config.type << std::endl;
+    }
+}
+
+std::chrono::milliseconds FailoverTranslator::hedge_delay(const Backend& backend, const LatencyWindow& latency) const {
+    const auto& opts = chain_.front()->config.options;
+    const double floor_ms = static_cast<double>(std::max(0, opts.hedge_min_delay_ms));
+    double delay_ms;
+    if (auto p95 = latency.percentile(0.95)) {
+        delay_ms = *p95;
+    } else {
+        // 样本不足：保守地取请求超时的四分之一
+        delay_ms = static_cast<double>(std::max(1, backend.config.options.timeout_seconds)) * 1000.0 / 4.0;
+    }
+    return std::chrono::milliseconds(static_cast<int64_t>(std::max(floor_ms, delay_ms)));
+}
+
+bool FailoverTranslator::take_hedge_budget(CallState& state) {
+    const size_t allowed = 1 + state.units_started.load(std::memory_order_relaxed) / kHedgeBudgetDivisor;
+    size_t sent = state.hedges_sent.load(std::memory_order_relaxed);
+    while (sent < allowed) {
+        if (state.hedges_sent.compare_exchange_weak(sent, sent + 1, std::memory_order_relaxed)) return true;
+    }
+    return false;
+}
+
+std::unique_ptr<ITranslator> FailoverTranslator::lease(size_t backend_index) {
+    Backend& backend = *chain_[backend_index];
+    {
+        std::lock_guard<std::mutex> lock(backend.idle_mutex);
+        if (!backend.idle.empty()) {
+            auto translator = std::move(backend.idle.back());
+            backend.idle.pop_back();
+            return translator;
+        }
+    }
+    return factory_(backend.config.type, backend.config.options);
+}
+
+void FailoverTranslator::release(size_t backend_index, std::unique_ptr<ITranslator> translator) {
+    Backend& backend = *chain_[backend_index];
+    std::lock_guard<std::mutex> lock(backend.idle_mutex);
+    backend.idle.push_back(std::move(translator));
+}
+
+
+void FailoverTranslator::run_attempt(Race& race,
+                                     Attempt& attempt,
+                                     const std::vector<Segment>& segments,
+                                     const std::vector<std::string>& target_languages,
+                                     const std::string& source_language,
+                                     const std::vector<size_t>& indices,
+                                     const TranslationCall& call) {
+    // 尝试内部的单段事件映射回调用方下标；同一单元只转发最先产生事件的尝试。
+    // 多目标语言的事件不带语言，无法逐语言去重，由调用方在单元完成后按胜出结果统一回调
+    TranslationCall attempt_call{attempt.cancel, nullptr};
+    if (call.on_segment && target_languages.size() == 1) {
+        attempt_call.on_segment = [&race, &attempt, &indices, &call](size_t i, const std::string& text) {
+            if (i >= indices.size()) return;
+            {
+                std::lock_guard<std::mutex> lock(race.mutex);
+                if (!race.streamer) race.streamer = &attempt;
+                if (race.streamer != &attempt) return;
+                race.streamed[i] = 1;
+            }
+            call.notify(indices[i], text);
+        };
+    }
+
+    const std::string& type = chain_[attempt.backend_index]->config.type;
+    auto translator = lease(attempt.backend_index);
+    std::vector<TranslationResult> results;
+    try {
+        if (target_languages.size() == 1) {
+            results.push_back(translator->translate_call(segments, target_languages.front(), source_language, attempt_call));
+        } else {
+            results = translator->translate_call_multi(segments, target_languages, source_language, attempt_call);
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "[FailoverTranslator] " << type << " 翻译异常: " << e.what() << std::endl;
+        results.clear();
+        for (const auto& target : target_languages) {
+            TranslationResult failed(segments, source_language, target, type);
+            failed.failed_indices.clear();
+            for (size_t i = 0; i < segments.size(); ++i) failed.failed_indices.push_back(i);
+            results.push_back(std::move(failed));
+        }
+    }
+    release(attempt.backend_index, std::move(translator));
+
+    const Clock::time_point finished = Clock::now();
+    {
+        std::lock_guard<std::mutex> lock(race.mutex);
+        attempt.results = std::move(results);
+        attempt.elapsed_ms = std::chrono::duration<double, std::milli>(finished - attempt.started).count();
+        attempt.finished = finished;
+        attempt.done = true;
+    }
+    race.cv.notify_all();
+}
+
+FailoverTranslator::UnitOutcome FailoverTranslator::run_on_backend(CallState& state,
+                                                                   size_t backend_index,
+                                                                   const std::vector<Segment>& segments,
+                                                                   const std::vector<std::string>& target_languages,
+                                                                   const std::string& source_language,
+                                                                   const std::vector<size_t>& indices,
+                                                                   const TranslationCall& call) {
+    state.units_started.fetch_add(1, std::memory_order_relaxed);
+    const auto& primary_opts = chain_.front()->config.options;
+    Backend& backend = *chain_[backend_index];
+    auto window_of = [&](size_t index) {
+        return target_languages.size() == 1 ? chain_[index]->latency
+                                            : latency_window_for(chain_[index]->config, target_languages.size());
+    };
+
+    // 对冲目标：同一翻译器，或链中下一个可用的翻译器
+    const bool hedging = primary_opts.hedge_requests;
+    size_t hedge_index = backend_index;
+    if (hedging && primary_opts.hedge_to_fallback) {
+        for (size_t b = backend_index + 1; b < chain_.size(); ++b) {
+            if (backend_available(b)) {
+                hedge_index = b;
+                break;
+            }
+        }
+    }
+
+    auto make_attempt = [&](size_t index) {
+        auto attempt = std::make_unique<Attempt>();
+        attempt->backend_index = index;
+        attempt->cancel = state.cancel.can_be_cancelled() ? CancellationToken::create_linked({state.cancel})
+                                                           : CancellationToken::create();
+        attempt->started = Clock::now();
+        return attempt;
+    };
+    auto clean = [](const Attempt* a) {
+        return a && a->done && a->failed_count() == 0;
+    };
+
+    Race race;
+    race.streamed.assign(segments.size(), 0);
+    const auto latency = window_of(backend_index);
+    std::unique_ptr<Attempt> primary = make_attempt(backend_index);
+    std::unique_ptr<Attempt> hedge;
+    const Clock::time_point hedge_at = primary->started + hedge_delay(backend, *latency);
+
+    // 主请求与对冲在共享线程池中并行（调用线程参与执行）：下标 0 为主请求，
+    // 下标 1 等到对冲时刻仍无干净结果时发出对冲；任一尝试干净完成即取消另一份
+    parallel_for(hedging ? 2 : 1, 2, [&](size_t slot) {
+        if (slot == 0) {
+            run_attempt(race, *primary, segments, target_languages, source_language, indices, call);
+            std::lock_guard<std::mutex> lock(race.mutex);
+            if (clean(primary.get()) && hedge) hedge->cancel.cancel();
+            return;
+        }
+        {
+            std::unique_lock<std::mutex> lock(race.mutex);
+            while (!primary->done && !state.cancel.is_cancelled() && Clock::now() < hedge_at) {
+                race.cv.wait_until(lock, std::min(hedge_at, Clock::now() + kPollInterval));
+            }
+            if (primary->done || state.cancel.is_cancelled()) return;
+            if (!take_hedge_budget(state)) return;   // 预算用尽：本单元只等主请求
+            hedge = make_attempt(hedge_index);
+        }
+        run_attempt(race, *hedge, segments, target_languages, source_language, indices, call);
+        std::lock_guard<std::mutex> lock(race.mutex);
+        if (clean(hedge.get()) && !primary->done) primary->cancel.cancel();
+    });
+
+    // 胜者：先干净完成者；都有失败段时取失败较少者，剩余失败段交给故障转移
+    Attempt* winner = primary.get();
+    if (hedge) {
+        if (clean(hedge.get()) && (!clean(primary.get()) || hedge->finished < primary->finished)) {
+            winner = hedge.get();
+        } else if (!clean(primary.get()) && hedge->failed_count() < primary->failed_count()) {
+            winner = hedge.get();
+        }
+    }
+
+    UnitOutcome outcome;
+    outcome.hedged = static_cast<bool>(hedge);
+    outcome.hedge_won = winner == hedge.get();
+    outcome.backend_index = winner->backend_index;
+    if (winner->failed_count() == 0) {
+        window_of(winner->backend_index)->record(winner->elapsed_ms);
+    }
+    if (outcome.hedge_won) {
+        // 主请求被取消时的已等待时长是其耗时的下界，仍计入窗口，避免 p95 因对冲而被低估
+        latency->record(primary->elapsed_ms);
+    }
+    outcome.notified = race.streamer == winner ? std::move(race.streamed) : std::vector<char>(segments.size(), 0);
+    outcome.results = std::move(winner->results);
+    // 落败尝试已发出的请求与 token 同样计入统计
+    Attempt* loser = winner == primary.get() ? hedge.get() : primary.get();
+    if (loser && !outcome.results.empty()) {
+        for (auto& r : loser->results) merge_stats(outcome.results.front().stats, std::move(r.stats));
+    }
+    return outcome;
+}
+
+TranslationResult FailoverTranslator::translate_segments(const std::vector<Segment>& segments,
+                                                         const std::string& target_language,
+                                                         const std::string& source_language) {
+    return translate_call(segments, target_language, source_language, TranslationCall{CancellationToken{}, segment_callback_});
+}
+
+TranslationResult FailoverTranslator::translate_call(const std::vector<Segment>& segments,
+                                                     const std::string& target_language,
+                                                     const std::string& source_language,
+                                                     const TranslationCall& call) {
+    V2S_TRACE_SPAN("FailoverTranslator::translate_segments", "translate");
+    return std::move(run_call(segments, {target_language}, source_language, call).front());
+}
+
+std::vector<TranslationResult> FailoverTranslator::translate_call_multi(const std::vector<Segment>& segments,
+                                                                        const std::vector<std::string>& target_languages,
+                                                                        const std::string& source_language,
+                                                                        const TranslationCall& call) {
+    if (target_languages.size() < 2) return ITranslator::translate_call_multi(segments, target_languages, source_language, call);
+    V2S_TRACE_SPAN("FailoverTranslator::translate_segments_multi", "translate");
+    return run_call(segments, target_languages, source_language, call);
+}
+
+std::vector<TranslationResult> FailoverTranslator::run_call(const std::vector<Segment>& segments,
+                                                            const std::vector<std::string>& target_languages,
+                                                            const std::string& source_language,
+                                                            const TranslationCall& call) {
+    const size_t targets = target_languages.size();
+    std::vector<TranslationResult> results(targets);
+    for (size_t t = 0; t < targets; ++t) {
+        results[t].source_language = source_language.empty() ? "auto" : source_language;
+        results[t].target_language = target_languages[t];
+        results[t].translator_name = chain_.empty() ? std::string("simple") : chain_.front()->config.type;
+        results[t].segments = segments;
+        for (auto& seg : results[t].segments) seg.language = target_languages[t];
+    }
+    if (chain_.empty() || segments.empty()) return results;
+    const std::string& source = results.front().source_language;
+
+    CallState state;
+    state.cancel = link_cancel(options_cancel_, call.cancel);
+
+    const auto& primary = chain_.front()->config;
+    // 单元与主翻译器的请求粒度对齐：逐段翻译器每段一个请求，批量翻译器按其自身的打包与当前批量大小
+    std::vector<std::vector<size_t>> units;
+    {
+        auto translator = lease(0);
+        units = translator->request_groups(segments, target_languages.front(), source);
+        release(0, std::move(translator));
+    }
+
+    const metrics::Labels labels = {{"translator", primary.type}};
+    std::mutex result_mutex;
+    std::vector<std::vector<char>> failed(targets, std::vector<char>(segments.size(), 0));
+
+    // 在翻译器 b 上翻译 pending 中的段到 langs（target_languages 的下标）指定的语言，
+    // 写回译文并返回每种语言仍失败的段
+    auto run_unit = [&](size_t b, const std::vector<size_t>& langs, const std::vector<size_t>& pending) {
+        std::vector<Segment> unit_segments;
+        unit_segments.reserve(pending.size());
+        for (size_t idx : pending) unit_segments.push_back(segments[idx]);
+        std::vector<std::string> unit_targets;
+        for (size_t t : langs) unit_targets.push_back(target_languages[t]);
+        UnitOutcome outcome = run_on_backend(state, b, unit_segments, unit_targets, source, pending, call);
+
+        // 每种语言的单元内失败标记（缺少结果或结果段数不足也视为失败）
+        std::vector<std::vector<char>> unit_failed(langs.size(), std::vector<char>(pending.size(), 1));
+        for (size_t l = 0; l < langs.size() && l < outcome.results.size(); ++l) {
+            const auto& unit_result = outcome.results[l];
+            std::fill(unit_failed[l].begin(), unit_failed[l].begin() + std::min(pending.size(), unit_result.segments.size()), 0);
+            for (size_t f : unit_result.failed_indices) {
+                if (f < pending.size()) unit_failed[l][f] = 1;
+            }
+        }
+        std::vector<std::vector<size_t>> still_pending(langs.size());
+        size_t recovered = 0;
+        bool all_failed = true;
+        {
+            std::lock_guard<std::mutex> lock(result_mutex);
+            auto& stats = results.front().stats;
+            for (auto& r : outcome.results) merge_stats(stats, std::move(r.stats));
+            if (outcome.hedged) stats.hedged_requests++;
+            if (outcome.hedge_won) stats.hedge_wins++;
+            for (size_t l = 0; l < langs.size(); ++l) {
+                auto& target = results[langs[l]];
+                for (size_t k = 0; k < pending.size(); ++k) {
+                    if (unit_failed[l][k]) {
+                        still_pending[l].push_back(pending[k]);
+                        continue;
+                    }
+                    target.segments[pending[k]].text = outcome.results[l].segments[k].text;
+                    if (outcome.backend_index > 0) recovered++;
+                }
+                if (still_pending[l].size() < pending.size()) all_failed = false;
+            }
+            stats.failover_segments += recovered;
+        }
+        if (outcome.hedged) metrics::counter("v2s_translator_hedged_requests_total", "Hedged duplicate translation requests", labels).inc();
+        if (outcome.hedge_won) metrics::counter("v2s_translator_hedge_wins_total", "Hedged requests that finished before the primary", labels).inc();
+        if (recovered > 0) {
+            metrics::counter("v2s_translator_failover_segments_total", "Segments translated by a fallback translator", labels).inc(static_cast<double>(recovered));
+        }
+        // 流式事件来自落败尝试或未送达的段，按胜出结果补发
+        for (size_t l = 0; l < langs.size(); ++l) {
+            for (size_t k = 0; k < pending.size(); ++k) {
+                if (!unit_failed[l][k] && !outcome.notified[k]) call.notify(pending[k], outcome.results[l].segments[k].text);
+            }
+        }
+        if (!state.cancel.is_cancelled()) record_health(b, all_failed);
+        return still_pending;
+    };
+
+    const size_t concurrency = static_cast<size_t>(std::max(1, primary.options.max_concurrency));
+    // 对冲时每个并发单元可能同时有两份尝试在线程池中运行
+    if (primary.options.hedge_requests) Executor::shared().ensure_workers(2 * concurrency);
+    std::vector<size_t> all_langs(targets);
+    for (size_t t = 0; t < targets; ++t) all_langs[t] = t;
+    parallel_for(units.size(), concurrency, [&](size_t u) {
+        // 先在第一个可用的翻译器上一次翻译全部目标语言（批量翻译器的多语言请求只发送一次原文），
+        // 其后各语言仍失败的段逐语言交给链中后续的翻译器
+        std::vector<std::vector<size_t>> pending(targets, units[u]);
+        size_t next = 0;
+        for (size_t b = 0; b < chain_.size(); ++b) {
+            if (state.cancel.is_cancelled()) break;
+            // 冷却中的翻译器跳过（链尾总会尝试）
+            if (b + 1 < chain_.size() && !backend_available(b)) continue;
+            pending = run_unit(b, all_langs, units[u]);
+            next = b + 1;
+            break;
+        }
+        for (size_t t = 0; t < targets; ++t) {
+            for (size_t b = next; b < chain_.size() && !pending[t].empty(); ++b) {
+                if (state.cancel.is_cancelled()) break;
+                if (b + 1 < chain_.size() && !backend_available(b)) continue;
+                pending[t] = std::move(run_unit(b, {t}, pending[t]).front());
+            }
+            if (!pending[t].empty()) {
+                std::lock_guard<std::mutex> lock(result_mutex);
+                for (size_t idx : pending[t]) failed[t][idx] = 1;
+            }
+        }
+    });
+
+    for (size_t t = 0; t < targets; ++t) {
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (failed[t][i]) results[t].failed_indices.push_back(i);
+        }
+    }
+    return results;
+}
+
+} // namespace v2s
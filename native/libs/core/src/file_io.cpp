@@ -0,0 +1,199 @@
+#include "video2srt_native/file_io.hpp"
+#include <algorithm>
+#include <cerrno>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#else
+#  include <fcntl.h>
+#  include <sys/file.h>
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <unistd.h>
+#endif
+
+namespace v2s {
+
+// ---------------------------------------------------------------------------
+// AppendFile：按偏移读取、原子追加
+// ---------------------------------------------------------------------------
+
+bool AppendFile::open(const std::filesystem::path& path, bool create) {
+    close();
+#if defined(_WIN32)
+    handle_ = CreateFileW(path.wstring().c_str(), GENERIC_READ | FILE_APPEND_DATA,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                          create ? OPEN_ALWAYS : OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return handle_ != INVALID_HANDLE_VALUE;
+#else
+    fd_ = ::open(path.c_str(), O_RDWR | O_APPEND | O_CLOEXEC | (create ? O_CREAT : 0), 0644);
+    return fd_ >= 0;
+#endif
+}
+
+void AppendFile::close() {
+#if defined(_WIN32)
+    if (handle_ != INVALID_HANDLE_VALUE) CloseHandle(handle_);
+    handle_ = INVALID_HANDLE_VALUE;
+#else
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+#endif
+}
+
+uint64_t AppendFile::size() const {
+#if defined(_WIN32)
+    LARGE_INTEGER li{};
+    return GetFileSizeEx(handle_, &li) ? static_cast<uint64_t>(li.QuadPart) : 0;
+#else
+    struct stat st{};
+    return fstat(fd_, &st) == 0 ? static_cast<uint64_t>(st.st_size) : 0;
+#endif
+}
+
+bool AppendFile::read_at(uint64_t offset, void* buf, size_t n) const {
+#if defined(_WIN32)
+    char* p = static_cast<char*>(buf);
+    while (n > 0) {
+        OVERLAPPED ov{};
+        ov.Offset = static_cast<DWORD>(offset & 0xFFFFFFFFu);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        const DWORD want = static_cast<DWORD>(std::min<size_t>(n, 1u << 30));
+        if (!ReadFile(handle_, p, want, &got, &ov) || got == 0) return false;
+        p += got; n -= got; offset += got;
+    }
+    return true;
+#else
+    char* p = static_cast<char*>(buf);
+    while (n > 0) {
+        ssize_t got = ::pread(fd_, p, n, static_cast<off_t>(offset));
+        if (got <= 0) return false;
+        p += got; n -= static_cast<size_t>(got); offset += static_cast<uint64_t>(got);
+    }
+    return true;
+#endif
+}
+
+bool AppendFile::append(const std::string& data) {
+#if defined(_WIN32)
+    const char* p = data.data();
+    size_t n = data.size();
+    while (n > 0) {
+        DWORD wrote = 0;
+        if (!WriteFile(handle_, p, static_cast<DWORD>(std::min<size_t>(n, 1u << 30)), &wrote, nullptr) || wrote == 0) return false;
+        p += wrote; n -= wrote;
+    }
+    return true;
+#else
+    const char* p = data.data();
+    size_t n = data.size();
+    while (n > 0) {
+        ssize_t wrote = ::write(fd_, p, n);
+        if (wrote <= 0) return false;
+        p += wrote; n -= static_cast<size_t>(wrote);
+    }
+    return true;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// FileLock：跨进程独占锁
+// ---------------------------------------------------------------------------
+
+FileLock::FileLock(const std::filesystem::path& path) {
+#if defined(_WIN32)
+    handle_ = CreateFileW(path.wstring().c_str(), GENERIC_READ | GENERIC_WRITE,
+                          FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                          OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        OVERLAPPED ov{};
+        locked_ = LockFileEx(handle_, LOCKFILE_EXCLUSIVE_LOCK, 0, 1, 0, &ov) != 0;
+    }
+#else
+    fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ >= 0) {
+        int rc;
+        do { rc = ::flock(fd_, LOCK_EX); } while (rc != 0 && errno == EINTR);
+        locked_ = (rc == 0);
+    }
+#endif
+}
+
+FileLock::~FileLock() {
+#if defined(_WIN32)
+    if (handle_ != INVALID_HANDLE_VALUE) {
+        if (locked_) {
+            OVERLAPPED ov{};
+            UnlockFileEx(handle_, 0, 1, 0, &ov);
+        }
+        CloseHandle(handle_);
+    }
+#else
+    if (fd_ >= 0) {
+        if (locked_) ::flock(fd_, LOCK_UN);
+        ::close(fd_);
+    }
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// MappedFile：只读内存映射
+// ---------------------------------------------------------------------------
+
+bool MappedFile::open(const std::filesystem::path& path) {
+    close();
+#if defined(_WIN32)
+    file_ = CreateFileW(path.wstring().c_str(), GENERIC_READ,
+                        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER li{};
+    if (!GetFileSizeEx(file_, &li) || li.QuadPart <= 0) {
+        close();
+        return false;
+    }
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+        close();
+        return false;
+    }
+    data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+        close();
+        return false;
+    }
+    size_ = static_cast<size_t>(li.QuadPart);
+    return true;
+#else
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st{};
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        return false;
+    }
+    void* p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);   // 映射独立于描述符存在
+    if (p == MAP_FAILED) return false;
+    data_ = static_cast<const unsigned char*>(p);
+    size_ = static_cast<size_t>(st.st_size);
+    return true;
+#endif
+}
+
+void MappedFile::close() {
+#if defined(_WIN32)
+    if (data_) UnmapViewOfFile(data_);
+    if (mapping_) CloseHandle(mapping_);
+    if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = INVALID_HANDLE_VALUE;
+#else
+    if (data_) ::munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+} // namespace v2s
@@ -1,4 +1,6 @@
 #include "video2srt_native/formatter.hpp"
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/probes.hpp"
 #include <sstream>
 #include <iomanip>
 #include <fstream>
@@ -30,6 +32,7 @@ std::string SRTFormatter::format_segment(const Segment& segment, int index) {
 
 std::string SRTFormatter::format_segments(const std::vector<Segment>& segments, 
                                         double min_duration) {
+    V2S_TRACE_SPAN("SRTFormatter::format_segments", "format");
     if (segments.empty()) {
         return "";
     }
@@ -50,6 +53,7 @@ std::string SRTFormatter::format_segments(const std::vector<Segment>& segments,
 
 bool SRTFormatter::save_srt(const std::string& content, 
                           const std::filesystem::path& output_path) {
+    V2S_TRACE_SPAN("SRTFormatter::save_srt", "io");
     try {
         // 确保输出目录存在
         std::filesystem::create_directories(output_path.parent_path());
@@ -62,6 +66,7 @@ bool SRTFormatter::save_srt(const std::string& content,
         
         file << content;
         file.close();
+        V2S_PROBE3(formatter_write, "srt", content.size(), file.good() ? 1 : 0);
         
         return true;
     } catch (const std::exception&) {
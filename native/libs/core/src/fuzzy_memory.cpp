@@ -0,0 +1,720 @@
+#include "video2srt_native/fuzzy_memory.hpp"
+#include "video2srt_native/metrics.hpp"
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/translation_cache.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace v2s {
+
+namespace {
+
+// 日志格式（fuzzy.log）：
+//   头部 16 字节：magic "V2FM" | u32 格式版本 | u64 代数
+//   记录：u32 src_len | u32 tr_len | u32 checksum | u32 保留 | u64 作用域 | u64 band 键[8] | src | tr
+// 索引格式（fuzzy.idx）：
+//   头部 48 字节：magic "V2FI" | u32 格式版本 | u64 日志代数 | u64 覆盖到的日志偏移 | u64 记录数 n
+//                 | u32 band 数 | u32 保留 | u64 保留
+//   u64 记录偏移[n]，随后每个 band 一个按 (键高 32 位, 记录号降序) 排序的 {u32 键, u32 记录号}[n]
+// 整数均为小端序（与目标平台一致，直接按内存布局读写）
+constexpr char kLogMagic[4] = {'V', '2', 'F', 'M'};
+constexpr char kIndexMagic[4] = {'V', '2', 'F', 'I'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint64_t kHeaderSize = 16;
+constexpr uint64_t kIndexHeaderSize = 48;
+constexpr size_t kHashes = 32;
+constexpr size_t kBands = 8;
+constexpr size_t kRows = kHashes / kBands;
+constexpr uint32_t kMaxFieldLen = 1u << 16;     // 单条源文本/译文上限 64KB（字幕行远小于此）
+constexpr size_t kMaxPerBand = 32;              // 每个 band 最多取的候选数（新近优先）
+constexpr size_t kMaxCandidates = 64;           // 每条查询最多复核的候选数
+constexpr size_t kMinRebuildDelta = 4096;       // 增量记录达到该数（且超过索引的 1/8）时重建索引
+constexpr size_t kScanChunk = 1u << 20;
+
+struct RecordHeader {
+    uint32_t src_len;
+    uint32_t tr_len;
+    uint32_t checksum;
+    uint32_t reserved;
+    uint64_t scope;
+    uint64_t bands[kBands];
+};
+static_assert(sizeof(RecordHeader) == 88, "unexpected record header layout");
+constexpr uint64_t kRecordHeaderSize = sizeof(RecordHeader);
+
+struct IndexSlot {
+    uint32_t key;
+    uint32_t record;
+};
+static_assert(sizeof(IndexSlot) == 8, "unexpected index slot layout");
+
+uint64_t mix64(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint32_t fnv1a32(const void* data, size_t n, uint32_t h = 2166136261u) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < n; ++i) {
+        h ^= p[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+uint32_t record_checksum(const RecordHeader& h, const char* payload) {
+    uint32_t c = fnv1a32(&h.scope, sizeof(h.scope) + sizeof(h.bands));
+    return fnv1a32(payload, static_cast<size_t>(h.src_len) + h.tr_len, c);
+}
+
+uint64_t new_generation() {
+    std::random_device rd;
+    const uint64_t t = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd() ^ t;
+}
+
+void put_u32(std::string& out, uint32_t v) { out.append(reinterpret_cast<const char*>(&v), 4); }
+void put_u64(std::string& out, uint64_t v) { out.append(reinterpret_cast<const char*>(&v), 8); }
+
+std::string make_header(uint64_t generation) {
+    std::string h(kLogMagic, 4);
+    put_u32(h, kFormatVersion);
+    put_u64(h, generation);
+    return h;
+}
+
+// 宽松 UTF-8 解码：非法字节按单字节 U+FFFD 处理，保证任意输入都能推进
+uint32_t next_codepoint(const std::string& s, size_t& i) {
+    const unsigned char c = static_cast<unsigned char>(s[i]);
+    size_t len = c < 0x80 ? 1 : (c >> 5) == 0x6 ? 2 : (c >> 4) == 0xE ? 3 : (c >> 3) == 0x1E ? 4 : 0;
+    if (len == 0 || i + len > s.size()) {
+        ++i;
+        return 0xFFFD;
+    }
+    uint32_t cp = len == 1 ? c : len == 2 ? (c & 0x1F) : len == 3 ? (c & 0x0F) : (c & 0x07);
+    for (size_t k = 1; k < len; ++k) {
+        const unsigned char cc = static_cast<unsigned char>(s[i + k]);
+        if ((cc & 0xC0) != 0x80) {
+            ++i;
+            return 0xFFFD;
+        }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    i += len;
+    return cp;
+}
+
+// 标点与空白：归一化时视为分隔符
+bool is_separator(uint32_t cp) {
+    if (cp < 0x80) return !((cp >= '0' && cp <= '9') || (cp >= 'a' && cp <= 'z') || (cp >= 'A' && cp <= 'Z'));
+    return (cp >= 0x2000 && cp <= 0x206F)       // 通用标点（含各类空格、引号、省略号）
+        || (cp >= 0x3000 && cp <= 0x303F)       // CJK 符号与标点
+        || (cp >= 0xFF01 && cp <= 0xFF0F) || (cp >= 0xFF1A && cp <= 0xFF20)
+        || (cp >= 0xFF3B && cp <= 0xFF40) || (cp >= 0xFF5B && cp <= 0xFF65)   // 全角标点
+        || cp == 0x00A0 || cp == 0x00A1 || cp == 0x00AB || cp == 0x00BB || cp == 0x00BF
+        || cp == 0x00B7 || cp == 0x30FB || cp == 0xFEFF;
+}
+
+uint32_t fold_case(uint32_t cp) {
+    if (cp >= 'A' && cp <= 'Z') return cp + 32;
+    if (cp >= 0xC0 && cp <= 0xDE && cp != 0xD7) return cp + 32;   // Latin-1 大写字母
+    if (cp >= 0xFF21 && cp <= 0xFF3A) return cp - 0xFF21 + 'a';   // 全角字母
+    if (cp >= 0xFF41 && cp <= 0xFF5A) return cp - 0xFF41 + 'a';
+    if (cp >= 0xFF10 && cp <= 0xFF19) return cp - 0xFF10 + '0';   // 全角数字
+    return cp;
+}
+
+// 归一化后的码点三元组（首尾补边界符），排序去重；归一化后为空时返回空
+std::vector<uint64_t> shingles(const std::string& text) {
+    constexpr uint32_t kBoundary = 0x110000;   // 超出 Unicode 范围，不与任何字符冲突
+    std::vector<uint32_t> cps;
+    cps.reserve(text.size() + 2);
+    cps.push_back(kBoundary);
+    bool pending_space = false;
+    for (size_t i = 0; i < text.size();) {
+        const uint32_t cp = next_codepoint(text, i);
+        if (is_separator(cp)) {
+            pending_space = cps.size() > 1;
+            continue;
+        }
+        if (pending_space) {
+            cps.push_back(' ');
+            pending_space = false;
+        }
+        cps.push_back(fold_case(cp));
+    }
+    if (cps.size() == 1) return {};
+    cps.push_back(kBoundary);
+
+    std::vector<uint64_t> grams;
+    grams.reserve(cps.size());
+    for (size_t i = 0; i + 2 < cps.size(); ++i) {
+        grams.push_back(mix64(static_cast<uint64_t>(cps[i]) | (static_cast<uint64_t>(cps[i + 1]) << 21)
+                              | (static_cast<uint64_t>(cps[i + 2]) << 42)));
+    }
+    if (grams.empty()) grams.push_back(mix64(cps[1]));   // 单字符：两端边界 + 字符
+    std::sort(grams.begin(), grams.end());
+    grams.erase(std::unique(grams.begin(), grams.end()), grams.end());
+    return grams;
+}
+
+double jaccard(const std::vector<uint64_t>& a, const std::vector<uint64_t>& b) {
+    if (a.empty() || b.empty()) return 0.0;
+    size_t common = 0;
+    for (size_t i = 0, j = 0; i < a.size() && j < b.size();) {
+        if (a[i] < b[j]) {
+            ++i;
+        } else if (b[j] < a[i]) {
+            ++j;
+        } else {
+            ++common;
+            ++i;
+            ++j;
+        }
+    }
+    return static_cast<double>(common) / static_cast<double>(a.size() + b.size() - common);
+}
+
+bool is_negation_word(const std::string& w) {
+    if (w == "not" || w == "no" || w == "never" || w == "nor" || w == "cannot") return true;
+    return w.size() > 3 && w.compare(w.size() - 3, 3, "n't") == 0;   // isn't / don't / can't ...
+}
+
+bool is_negation_char(uint32_t cp) {
+    return cp == 0x4E0D                    // 不
+        || cp == 0x6CA1 || cp == 0x6C92    // 没 沒
+        || cp == 0x522B || cp == 0x5225    // 别 別
+        || cp == 0x672A                    // 未
+        || cp == 0x65E0 || cp == 0x7121;   // 无 無
+}
+
+// 只差一个数字或一个否定词的两行，三元组相似度仍可能达到阈值（"at 10" / "at 11"、"is not" / "is"），
+// 但译文含义不同；这类记号按顺序取出，必须完全一致才允许复用：
+// 数字串原样保留（全角数字折叠为半角），英文否定词与中文否定字统一记为一个否定标记
+std::vector<std::string> guard_tokens(const std::string& text) {
+    std::vector<std::string> out;
+    std::string digits;
+    std::string word;
+    auto flush = [&]() {
+        if (!digits.empty()) out.push_back(digits);
+        if (!word.empty() && is_negation_word(word)) out.emplace_back("!");
+        digits.clear();
+        word.clear();
+    };
+    for (size_t i = 0; i < text.size();) {
+        const uint32_t cp = fold_case(next_codepoint(text, i));
+        if (cp >= '0' && cp <= '9') {
+            if (!word.empty()) flush();
+            digits += static_cast<char>(cp);
+        } else if ((cp >= 'a' && cp <= 'z') || cp == '\'' || cp == 0x2019) {
+            if (!digits.empty()) flush();
+            word += cp == 0x2019 ? '\'' : static_cast<char>(cp);
+        } else {
+            flush();
+            if (is_negation_char(cp)) out.emplace_back("!");
+        }
+    }
+    flush();
+    return out;
+}
+
+const std::array<uint64_t, kHashes>& hash_seeds() {
+    static const std::array<uint64_t, kHashes> seeds = [] {
+        std::array<uint64_t, kHashes> s{};
+        for (size_t i = 0; i < kHashes; ++i) s[i] = mix64(0x5EED0000ull + i);
+        return s;
+    }();
+    return seeds;
+}
+
+// MinHash 签名按 band 合并为 LSH 键（作用域参与混合，不同语言对互不命中）
+std::array<uint64_t, kBands> band_keys(uint64_t scope, const std::vector<uint64_t>& grams) {
+    const auto& seeds = hash_seeds();
+    std::array<uint64_t, kHashes> mins;
+    mins.fill(~0ull);
+    for (uint64_t g : grams) {
+        for (size_t k = 0; k < kHashes; ++k) mins[k] = std::min(mins[k], mix64(g ^ seeds[k]));
+    }
+    std::array<uint64_t, kBands> keys{};
+    for (size_t b = 0; b < kBands; ++b) {
+        uint64_t h = mix64(scope ^ (0xB4D0ull + b));
+        for (size_t r = 0; r < kRows; ++r) h = mix64(h ^ mins[b * kRows + r]);
+        keys[b] = h;
+    }
+    return keys;
+}
+
+uint32_t index_key(uint64_t band_key) { return static_cast<uint32_t>(band_key >> 32); }
+
+// 顺序遍历 [from, to) 内的完整记录（只读记录头，按块读取），返回停止处的偏移
+template <typename Fn>
+uint64_t for_each_record(const AppendFile& file, uint64_t from, uint64_t to, Fn&& fn) {
+    std::string buf;
+    uint64_t buf_start = 0;
+    uint64_t off = from;
+    while (off + kRecordHeaderSize <= to) {
+        if (off < buf_start || off + kRecordHeaderSize > buf_start + buf.size()) {
+            buf.resize(static_cast<size_t>(std::min<uint64_t>(kScanChunk, to - off)));
+            if (!file.read_at(off, &buf[0], buf.size())) break;
+            buf_start = off;
+        }
+        RecordHeader h;
+        std::memcpy(&h, buf.data() + (off - buf_start), sizeof(h));
+        if (h.src_len == 0 || h.src_len > kMaxFieldLen || h.tr_len > kMaxFieldLen) {
+            // 长度字段损坏，无法定位后续记录：停止扫描（下次重建时丢弃尾部）
+            return to;
+        }
+        const uint64_t record_size = kRecordHeaderSize + h.src_len + h.tr_len;
+        if (off + record_size > to) break;   // 尾部记录尚未写完（或写入中断）
+        fn(off, h);
+        off += record_size;
+    }
+    return off;
+}
+
+struct FuzzyMetrics {
+    metrics::Counter& rebuilds;
+    metrics::Counter& candidates;
+};
+
+FuzzyMetrics& fuzzy_metrics() {
+    static FuzzyMetrics m{
+        metrics::counter("v2s_translation_memory_fuzzy_rebuilds_total", "Fuzzy translation memory index rebuilds"),
+        metrics::counter("v2s_translation_memory_fuzzy_candidates_total",
+                         "Fuzzy translation memory candidates verified by exact similarity")
+    };
+    return m;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+
+std::shared_ptr<FuzzyTranslationMemory> FuzzyTranslationMemory::open(const std::filesystem::path& dir, uint64_t max_bytes) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<FuzzyTranslationMemory>> registry;
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (!std::filesystem::is_directory(dir, ec)) return nullptr;
+    const std::string canonical = std::filesystem::weakly_canonical(dir, ec).string();
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[canonical.empty() ? dir.string() : canonical];
+    if (auto existing = slot.lock()) {
+        // insert 在实例锁下读取上限
+        std::lock_guard<std::mutex> instance_lock(existing->mutex_);
+        existing->max_bytes_ = max_bytes;
+        return existing;
+    }
+    std::shared_ptr<FuzzyTranslationMemory> memory(new FuzzyTranslationMemory(dir, max_bytes));
+    slot = memory;
+    return memory;
+}
+
+FuzzyTranslationMemory::FuzzyTranslationMemory(std::filesystem::path dir, uint64_t max_bytes)
+    : dir_(std::move(dir)),
+      log_path_(dir_ / "fuzzy.log"),
+      index_path_(dir_ / "fuzzy.idx"),
+      lock_path_(dir_ / "fuzzy.lock"),
+      max_bytes_(max_bytes) {}
+
+FuzzyTranslationMemory::~FuzzyTranslationMemory() = default;
+
+uint64_t FuzzyTranslationMemory::make_scope(const std::string& translator_namespace,
+                                            const std::string& source_language,
+                                            const std::string& target_language) {
+    // 与精确缓存的键前缀一致（含键版本与语言规范化）
+    const std::string prefix = TranslationCache::make_key(translator_namespace, source_language, target_language, "");
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : prefix) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+double FuzzyTranslationMemory::similarity(const std::string& a, const std::string& b) {
+    return jaccard(shingles(a), shingles(b));
+}
+
+bool FuzzyTranslationMemory::guard_tokens_match(const std::string& a, const std::string& b) {
+    return guard_tokens(a) == guard_tokens(b);
+}
+
+size_t FuzzyTranslationMemory::char_count(const std::string& text) {
+    size_t n = 0;
+    for (unsigned char c : text) {
+        if ((c & 0xC0) != 0x80) ++n;
+    }
+    return n;
+}
+
+// 重新打开日志：代数变化（其他进程重建过）时丢弃增量与映射，否则只扫描新增部分
+bool FuzzyTranslationMemory::refresh_locked() {
+    auto reset = [this] {
+        index_.close();
+        index_entries_ = 0;
+        index_stamp_ = 0;
+        delta_.clear();
+        delta_records_ = 0;
+        generation_ = 0;
+        scanned_ = 0;
+    };
+    auto fresh = std::make_unique<AppendFile>();
+    if (!fresh->open(log_path_, false)) {
+        log_.reset();
+        reset();
+        return false;
+    }
+    const uint64_t size = fresh->size();
+    if (size < kHeaderSize) {
+        log_ = std::move(fresh);
+        reset();
+        return true;
+    }
+    char header[kHeaderSize];
+    uint32_t version = 0;
+    uint64_t generation = 0;
+    const bool read = fresh->read_at(0, header, sizeof(header));
+    if (read) {
+        std::memcpy(&version, header + 4, 4);
+        std::memcpy(&generation, header + 8, 8);
+    }
+    if (!read || std::memcmp(header, kLogMagic, 4) != 0 || version != kFormatVersion) {
+        // 不是本格式版本的日志：不读也不写（追加时先改名保留，见 append_locked）
+        log_.reset();
+        reset();
+        foreign_ = read;
+        return false;
+    }
+
+    foreign_ = false;
+    log_ = std::move(fresh);
+    if (generation != generation_ || size < scanned_) {
+        reset();
+        generation_ = generation;
+        scanned_ = kHeaderSize;
+    }
+    load_index_locked();
+    if (size > scanned_) scan_locked(scanned_, size);
+    return true;
+}
+
+// 索引文件被替换（本进程或其他进程重建）时重新映射；与当前日志代数不符的索引不使用
+void FuzzyTranslationMemory::load_index_locked() {
+    std::error_code ec;
+    const uint64_t file_size = std::filesystem::file_size(index_path_, ec);
+    uint64_t stamp = 0;
+    if (!ec) {
+        const auto mtime = std::filesystem::last_write_time(index_path_, ec);
+        if (!ec) stamp = mix64(static_cast<uint64_t>(mtime.time_since_epoch().count()) ^ mix64(file_size)) | 1;
+    }
+    if (stamp == index_stamp_) return;
+    index_stamp_ = stamp;
+
+    index_.close();
+    index_entries_ = 0;
+    delta_.clear();
+    delta_records_ = 0;
+    scanned_ = kHeaderSize;
+    if (stamp == 0 || !index_.open(index_path_) || index_.size() < kIndexHeaderSize) {
+        index_.close();
+        return;
+    }
+    const unsigned char* p = index_.data();
+    uint32_t version = 0, bands = 0;
+    uint64_t generation = 0, indexed_end = 0, entries = 0;
+    std::memcpy(&version, p + 4, 4);
+    std::memcpy(&generation, p + 8, 8);
+    std::memcpy(&indexed_end, p + 16, 8);
+    std::memcpy(&entries, p + 24, 8);
+    std::memcpy(&bands, p + 32, 4);
+    const bool valid = std::memcmp(p, kIndexMagic, 4) == 0 && version == kFormatVersion && bands == kBands
+        && generation == generation_ && indexed_end >= kHeaderSize && log_ && indexed_end <= log_->size()
+        && entries <= 0xFFFFFFFFull
+        && index_.size() == kIndexHeaderSize + entries * sizeof(uint64_t) + kBands * entries * sizeof(IndexSlot);
+    if (!valid) {
+        index_.close();
+        return;
+    }
+    index_entries_ = entries;
+    scanned_ = indexed_end;
+}
+
+void FuzzyTranslationMemory::scan_locked(uint64_t from, uint64_t to) {
+    scanned_ = for_each_record(*log_, from, to, [this](uint64_t off, const RecordHeader& h) {
+        for (size_t b = 0; b < kBands; ++b) delta_.emplace(h.bands[b], off);
+        ++delta_records_;
+    });
+}
+
+// 候选记录偏移：命中 band 数多者优先，其次新近优先
+std::vector<uint64_t> FuzzyTranslationMemory::candidates_locked(const uint64_t* keys) const {
+    std::vector<uint64_t> found;
+    if (index_entries_ > 0) {
+        const unsigned char* base = index_.data();
+        const uint64_t* offsets = reinterpret_cast<const uint64_t*>(base + kIndexHeaderSize);
+        const IndexSlot* slots = reinterpret_cast<const IndexSlot*>(offsets + index_entries_);
+        for (size_t b = 0; b < kBands; ++b) {
+            const IndexSlot* first = slots + b * index_entries_;
+            const IndexSlot* last = first + index_entries_;
+            const uint32_t key = index_key(keys[b]);
+            const IndexSlot* it = std::lower_bound(first, last, key,
+                                                   [](const IndexSlot& s, uint32_t k) { return s.key < k; });
+            for (size_t n = 0; it != last && it->key == key && n < kMaxPerBand; ++it, ++n) {
+                found.push_back(offsets[it->record]);
+            }
+        }
+    }
+    for (size_t b = 0; b < kBands; ++b) {
+        auto range = delta_.equal_range(keys[b]);
+        size_t n = 0;
+        for (auto it = range.first; it != range.second && n < kMaxPerBand; ++it, ++n) found.push_back(it->second);
+    }
+    if (found.size() <= 1) return found;
+
+    std::sort(found.begin(), found.end());
+    std::vector<std::pair<size_t, uint64_t>> ranked;   // (命中 band 数, 偏移)
+    for (size_t i = 0; i < found.size();) {
+        size_t j = i;
+        while (j < found.size() && found[j] == found[i]) ++j;
+        ranked.emplace_back(j - i, found[i]);
+        i = j;
+    }
+    std::sort(ranked.begin(), ranked.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second > b.second;
+    });
+    if (ranked.size() > kMaxCandidates) ranked.resize(kMaxCandidates);
+    found.clear();
+    for (const auto& r : ranked) found.push_back(r.second);
+    return found;
+}
+
+std::vector<std::optional<FuzzyTranslationMemory::Match>> FuzzyTranslationMemory::lookup(uint64_t scope,
+                                                                                         const std::vector<std::string>& texts,
+                                                                                         double threshold) {
+    V2S_TRACE_SPAN("FuzzyTranslationMemory::lookup", "cache");
+    std::vector<std::optional<Match>> out(texts.size());
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_locked();
+    if (!log_ || (index_entries_ == 0 && delta_records_ == 0)) return out;
+
+    size_t verified = 0;
+    std::string record;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        const auto grams = shingles(texts[i]);
+        if (grams.empty()) continue;
+        const auto keys = band_keys(scope, grams);
+        const auto guards = guard_tokens(texts[i]);
+        double best = -1.0;
+        uint64_t best_offset = 0;
+        std::string best_translation;
+        for (uint64_t off : candidates_locked(keys.data())) {
+            RecordHeader h;
+            if (!log_->read_at(off, &h, sizeof(h)) || h.scope != scope) continue;
+            if (h.src_len == 0 || h.src_len > kMaxFieldLen || h.tr_len > kMaxFieldLen) continue;
+            record.resize(static_cast<size_t>(h.src_len) + h.tr_len);
+            if (!log_->read_at(off + kRecordHeaderSize, &record[0], record.size())) continue;
+            if (record_checksum(h, record.data()) != h.checksum) continue;
+            ++verified;
+            const std::string source = record.substr(0, h.src_len);
+            const double sim = jaccard(grams, shingles(source));
+            if (sim < threshold || guard_tokens(source) != guards) continue;
+            // 相同相似度时取较新的记录（同一源文本的译文被更新过）
+            if (sim > best || (sim == best && off > best_offset)) {
+                best = sim;
+                best_offset = off;
+                best_translation.assign(record, h.src_len, h.tr_len);
+            }
+        }
+        if (best_offset != 0) out[i] = Match{std::move(best_translation), best};
+    }
+    fuzzy_metrics().candidates.inc(static_cast<double>(verified));
+    return out;
+}
+
+bool FuzzyTranslationMemory::append_locked(const std::string& records) {
+    if (!log_) {
+        if (foreign_) {
+            // 其他格式版本的日志：改名保留后新建，绝不在其上截断或追加
+            const auto aside = log_path_.string() + ".old";
+            std::error_code ec;
+            std::filesystem::rename(log_path_, aside, ec);
+            if (ec) return false;
+            std::cerr << "[FuzzyTranslationMemory] 日志格式不兼容，已改名为 " << aside << " 并新建记忆日志" << std::endl;
+            foreign_ = false;
+        }
+        log_ = std::make_unique<AppendFile>();
+        if (!log_->open(log_path_, true)) {
+            log_.reset();
+            return false;
+        }
+    }
+    if (generation_ == 0 && log_->size() >= kHeaderSize) {
+        // 头部未经 refresh_locked 校验（不应发生）：不写入
+        return false;
+    }
+    if (log_->size() < kHeaderSize) {
+        // 新文件（或上次创建时只写了半个头部）：写入头部
+        if (log_->size() != 0) return false;
+        generation_ = new_generation();
+        if (!log_->append(make_header(generation_))) return false;
+        scanned_ = kHeaderSize;
+    }
+    if (log_->size() > scanned_) {
+        // 头部已校验（generation_ 非 0），尾部是中断写入留下的不完整记录（持有独占锁）：先截掉，避免新记录接在残片之后而无法对齐
+        std::error_code ec;
+        std::filesystem::resize_file(log_path_, scanned_, ec);
+        if (ec || log_->size() != scanned_) return false;
+    }
+    const uint64_t start = log_->size();
+    if (!log_->append(records)) return false;
+    // 持有独占锁，新记录紧跟在 start 之后；直接扫描进增量索引
+    scan_locked(start, start + records.size());
+    return true;
+}
+
+void FuzzyTranslationMemory::insert(uint64_t scope, const std::vector<std::pair<std::string, std::string>>& entries) {
+    std::string buf;
+    for (const auto& [src, tr] : entries) {
+        if (src.empty() || src.size() > kMaxFieldLen || tr.size() > kMaxFieldLen) continue;
+        const auto grams = shingles(src);
+        if (grams.empty()) continue;   // 纯标点/空白：无可比较的内容
+        RecordHeader h{};
+        h.src_len = static_cast<uint32_t>(src.size());
+        h.tr_len = static_cast<uint32_t>(tr.size());
+        h.scope = scope;
+        const auto keys = band_keys(scope, grams);
+        std::copy(keys.begin(), keys.end(), h.bands);
+        const std::string payload = src + tr;
+        h.checksum = record_checksum(h, payload.data());
+        buf.append(reinterpret_cast<const char*>(&h), sizeof(h));
+        buf += payload;
+    }
+    if (buf.empty()) return;
+
+    V2S_TRACE_SPAN("FuzzyTranslationMemory::insert", "cache");
+    std::lock_guard<std::mutex> lock(mutex_);
+    FileLock file_lock(lock_path_);
+    if (!file_lock.locked()) return;
+    refresh_locked();
+    if (!append_locked(buf)) return;
+    const bool oversized = max_bytes_ > 0 && log_->size() > max_bytes_;
+    if (oversized || delta_records_ >= std::max<uint64_t>(kMinRebuildDelta, index_entries_ / 8)) {
+        rebuild_locked();
+    }
+}
+
+// 重建：超过容量上限时先保留最新的约 3/4 上限（日志后缀，整体复制），再写出全量排序索引；
+// 均写入临时文件后原子替换
+void FuzzyTranslationMemory::rebuild_locked() {
+    V2S_TRACE_SPAN("FuzzyTranslationMemory::rebuild", "cache");
+    struct Record {
+        uint64_t offset;
+        uint64_t size;
+        std::array<uint32_t, kBands> keys;
+    };
+    std::vector<Record> records;
+    records.reserve(static_cast<size_t>(index_entries_ + delta_records_));
+    const uint64_t end = for_each_record(*log_, kHeaderSize, log_->size(), [&](uint64_t off, const RecordHeader& h) {
+        Record r{off, kRecordHeaderSize + h.src_len + h.tr_len, {}};
+        for (size_t b = 0; b < kBands; ++b) r.keys[b] = index_key(h.bands[b]);
+        records.push_back(r);
+    });
+
+    size_t first = 0;
+    uint64_t generation = generation_;
+    if (max_bytes_ > 0 && end > max_bytes_) {
+        const uint64_t budget = max_bytes_ - max_bytes_ / 4;
+        uint64_t total = kHeaderSize;
+        first = records.size();
+        while (first > 0 && total + records[first - 1].size <= budget) total += records[--first].size;
+
+        // 保留的记录是日志的一个连续后缀：按块复制到新日志
+        generation = new_generation();
+        const uint64_t keep_from = first < records.size() ? records[first].offset : end;
+        const auto tmp_path = log_path_.string() + ".tmp";
+        std::error_code ec;
+        std::filesystem::remove(tmp_path, ec);
+        {
+            AppendFile tmp;
+            bool ok = tmp.open(tmp_path, true) && tmp.append(make_header(generation));
+            std::string chunk;
+            for (uint64_t off = keep_from; ok && off < end;) {
+                chunk.resize(static_cast<size_t>(std::min<uint64_t>(kScanChunk, end - off)));
+                ok = log_->read_at(off, &chunk[0], chunk.size()) && tmp.append(chunk);
+                off += chunk.size();
+            }
+            if (!ok) {
+                tmp.close();
+                std::filesystem::remove(tmp_path, ec);
+                return;
+            }
+        }
+        log_.reset();   // Windows 需先关闭自身句柄才能替换
+        std::filesystem::rename(tmp_path, log_path_, ec);
+        if (ec) {
+            // 其他进程仍占用旧文件（Windows）：保留旧日志，下次写入时重试
+            std::filesystem::remove(tmp_path, ec);
+            generation_ = 0;
+            refresh_locked();
+            return;
+        }
+        for (size_t i = first; i < records.size(); ++i) records[i].offset = records[i].offset - keep_from + kHeaderSize;
+        records.erase(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(first));
+    }
+
+    const uint64_t n = records.size();
+    const uint64_t indexed_end = records.empty() ? kHeaderSize : records.back().offset + records.back().size;
+    std::string buf(kIndexMagic, 4);
+    put_u32(buf, kFormatVersion);
+    put_u64(buf, generation);
+    put_u64(buf, indexed_end);
+    put_u64(buf, n);
+    put_u32(buf, static_cast<uint32_t>(kBands));
+    put_u32(buf, 0);
+    put_u64(buf, 0);
+    buf.reserve(static_cast<size_t>(kIndexHeaderSize + n * (sizeof(uint64_t) + kBands * sizeof(IndexSlot))));
+    for (const auto& r : records) put_u64(buf, r.offset);
+    std::vector<IndexSlot> slots(static_cast<size_t>(n));
+    for (size_t b = 0; b < kBands; ++b) {
+        for (size_t i = 0; i < records.size(); ++i) slots[i] = IndexSlot{records[i].keys[b], static_cast<uint32_t>(i)};
+        std::sort(slots.begin(), slots.end(), [](const IndexSlot& x, const IndexSlot& y) {
+            return x.key != y.key ? x.key < y.key : x.record > y.record;
+        });
+        buf.append(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(IndexSlot));
+    }
+
+    const auto tmp_path = index_path_.string() + ".tmp";
+    std::error_code ec;
+    std::filesystem::remove(tmp_path, ec);
+    {
+        AppendFile tmp;
+        if (!tmp.open(tmp_path, true) || !tmp.append(buf)) {
+            tmp.close();
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+    index_.close();   // Windows 需先解除自身映射才能替换
+    std::filesystem::rename(tmp_path, index_path_, ec);
+    if (ec) std::filesystem::remove(tmp_path, ec);
+    fuzzy_metrics().rebuilds.inc();
+    generation_ = 0;
+    refresh_locked();
+}
+
+size_t FuzzyTranslationMemory::entry_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_locked();
+    return static_cast<size_t>(index_entries_) + delta_records_;
+}
+
+} // namespace v2s
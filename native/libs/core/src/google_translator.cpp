@@ -1,14 +1,18 @@
 #include "video2srt_native/google_translator.hpp"
-#include <windows.h>
-#include <winhttp.h>
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/metrics.hpp"
+#include "video2srt_native/probes.hpp"
+#include "video2srt_native/http_client.hpp"
+#include "video2srt_native/executor.hpp"
 #include <string>
 #include <vector>
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
 #include <cctype>
+#include <chrono>
 
-#pragma comment(lib, "winhttp.lib")
+#include <nlohmann/json.hpp>
 
 namespace v2s {
 
@@ -26,132 +30,257 @@ static std::string url_encode(const std::string& value) {
     return escaped.str();
 }
 
-static std::string parse_google_response_first_string(const std::string& body) {
-    // 简单解析：定位到 [[["xxx" 的第一个字符串
-    size_t pos = body.find("[[[");
-    if (pos == std::string::npos) return {};
-    pos = body.find('"', pos);
-    if (pos == std::string::npos) return {};
-    size_t end = pos + 1;
-    std::string out;
-    while (end < body.size()) {
-        char ch = body[end++];
-        if (ch == '\\') {
-            if (end < body.size()) {
-                char next = body[end++];
-                if (next == 'n') out += '\n';
-                else if (next == 'r') out += '\r';
-                else out += next;
+// translate_a/single：根节点 [0] 是句子片段数组，每个片段的 [0] 为译文；长文本会被切成多句，需全部拼接
+static std::optional<std::string> parse_single_response(const std::string& body) {
+    try {
+        auto j = nlohmann::json::parse(body);
+        if (!j.is_array() || j.empty() || !j[0].is_array()) return std::nullopt;
+        std::string out;
+        for (const auto& sentence : j[0]) {
+            if (sentence.is_array() && !sentence.empty() && sentence[0].is_string()) {
+                out += sentence[0].get<std::string>();
             }
-        } else if (ch == '"') {
-            break;
-        } else {
-            out += ch;
         }
+        if (out.empty()) return std::nullopt;
+        return out;
+    } catch (...) {
+        return std::nullopt;
     }
-    return out;
 }
 
-GoogleTranslator::GoogleTranslator(const TranslatorOptions& opts) : opts_(opts) {}
-
-std::string GoogleTranslator::translate_text(const std::string& text,
-                                             const std::string& target_language,
-                                             const std::string& source_language) {
-    // 构造URL
-    std::wstring host = L"translate.googleapis.com";
-    std::ostringstream path_qs;
-    path_qs << "/translate_a/single?client=gtx&sl=" << source_language
-            << "&tl=" << target_language << "&dt=t&q=" << url_encode(text);
-    std::string path_qs_utf8 = path_qs.str();
-    std::wstring path;
-    path.assign(path_qs_utf8.begin(), path_qs_utf8.end());
-
-    HINTERNET hSession = WinHttpOpen(L"Video2SRT-Native/1.0",
-                                     WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                                     WINHTTP_NO_PROXY_NAME,
-                                     WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) return {};
-
-    // 设置超时
-    if (opts_.timeout_seconds > 0) {
-        int ms = opts_.timeout_seconds * 1000;
-        WinHttpSetTimeouts(hSession, ms, ms, ms, ms);
+// translate_a/t：每个 q 对应一个元素；指定源语言时为字符串，sl=auto 时为 [译文, 检测到的语言]
+static std::optional<std::vector<std::string>> parse_multi_response(const std::string& body, size_t expected) {
+    try {
+        auto j = nlohmann::json::parse(body);
+        if (j.is_string()) j = nlohmann::json::array({j});
+        if (!j.is_array()) return std::nullopt;
+        // 单个 q 且 sl=auto 时可能直接返回 ["译文","en"]
+        if (expected == 1 && j.size() == 2 && j[0].is_string() && j[1].is_string()) {
+            j = nlohmann::json::array({j});
+        }
+        if (j.size() != expected) return std::nullopt;
+        std::vector<std::string> out;
+        out.reserve(expected);
+        for (const auto& item : j) {
+            if (item.is_string()) {
+                out.push_back(item.get<std::string>());
+            } else if (item.is_array() && !item.empty() && item[0].is_string()) {
+                out.push_back(item[0].get<std::string>());
+            } else {
+                return std::nullopt;
+            }
+        }
+        return out;
+    } catch (...) {
+        return std::nullopt;
     }
+}
 
-    HINTERNET hConnect = WinHttpConnect(hSession, host.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
-    if (!hConnect) { WinHttpCloseHandle(hSession); return {}; }
+static const char* kGoogleDefaultBase = "https://translate.googleapis.com";
+// 单次批量请求的上限（原文字符数 / 段数），超出非官方端点的长度限制会被拒绝
+static constexpr size_t kGoogleMaxBatchChars = 4000;
+static constexpr size_t kGoogleMaxBatchSegments = 64;
 
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET", path.c_str(),
-                                            NULL, WINHTTP_NO_REFERER,
-                                            WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                            WINHTTP_FLAG_SECURE);
-    if (!hRequest) { WinHttpCloseHandle(hConnect); WinHttpCloseHandle(hSession); return {}; }
+static std::string google_base(const TranslatorOptions& opts) {
+    std::string base = opts.base_url.empty() ? kGoogleDefaultBase : opts.base_url;
+    while (!base.empty() && base.back() == '/') base.pop_back();
+    return base;
+}
 
-    if (opts_.ssl_bypass) {
-        DWORD flags = SECURITY_FLAG_IGNORE_UNKNOWN_CA | SECURITY_FLAG_IGNORE_CERT_CN_INVALID |
-                     SECURITY_FLAG_IGNORE_CERT_DATE_INVALID | SECURITY_FLAG_IGNORE_CERT_WRONG_USAGE;
-        WinHttpSetOption(hRequest, WINHTTP_OPTION_SECURITY_FLAGS, &flags, sizeof(flags));
-    }
+GoogleTranslator::GoogleTranslator(const TranslatorOptions& opts) : opts_(opts) {
+    limiter_ = EndpointLimiter::for_url(google_base(opts_));
+    limiter_config_ = limiter_->configure(opts_.rate_limit_rps, opts_.rate_limit_burst, std::max(1, opts_.max_concurrency));
+}
+
+std::optional<std::string> GoogleTranslator::send_with_retry(CallState& state, HttpRequest req) {
+    const CancellationToken& cancel = state.cancel;
+    req.timeout_seconds = opts_.timeout_seconds;
+    req.ssl_bypass = opts_.ssl_bypass;
+    req.cancel = cancel;
 
-    std::string result_body;
-    for (int attempt = 0; attempt <= std::max(0, opts_.retry_count); ++attempt) {
-        BOOL ok = WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                                     WINHTTP_NO_REQUEST_DATA, 0, 0, 0);
-        if (!ok) {
-            continue;
+    HttpRetryPolicy policy;
+    policy.max_retries = std::max(0, opts_.retry_count);
+    policy.backoff = std::chrono::milliseconds(200);
+
+    static const metrics::Labels labels = {{"translator", "google"}};
+    std::chrono::milliseconds delay{0};
+    for (int attempt = 0; attempt <= policy.max_retries; ++attempt) {
+        if (cancel.is_cancelled()) break;
+        V2S_PROBE3(translator_request, "google", attempt, req.body.size());
+        HttpResponse resp;
+        {
+            // 许可只覆盖请求本身，退避等待期间不占用并发名额
+            EndpointLimiter::Permit permit = limiter_->acquire(cancel);
+            if (!permit.valid()) break;
+            resp = HttpClient::shared().send(req);
+            limiter_->on_response(resp);
+        }
+        const bool failed = !resp.ok() || resp.body.empty();
+        {
+            std::lock_guard<std::mutex> lock(state.stats_mutex);
+            state.stats.request_count++;
+            if (attempt > 0) state.stats.retries++;
+            if (failed) state.stats.failed_requests++;
+            state.stats.request_latencies_ms.push_back(resp.elapsed_ms);
+        }
+        V2S_PROBE4(translator_response, "google", attempt, failed ? 0 : 1, static_cast<long long>(resp.elapsed_ms * 1000.0));
+        metrics::counter("v2s_translator_requests_total", "Translator HTTP requests sent", labels).inc();
+        if (failed) {
+            metrics::counter("v2s_translator_request_failures_total", "Translator requests that failed or returned unusable content", labels).inc();
+            if (attempt < policy.max_retries) {
+                metrics::counter("v2s_translator_retries_total", "Translator request retries", labels).inc();
+                V2S_PROBE2(translator_retry, "google", attempt + 1);
+            }
         }
-        ok = WinHttpReceiveResponse(hRequest, NULL);
-        if (!ok) {
-            continue;
+        metrics::histogram("v2s_http_request_duration_seconds", "Translator HTTP request latency",
+                           metrics::latency_buckets_seconds(), labels).observe(resp.elapsed_ms / 1000.0);
+        if (!failed) {
+            return std::move(resp.body); // 成功
         }
-        DWORD dwSize = 0;
-        do {
-            dwSize = 0;
-            if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) break;
-            if (dwSize == 0) break;
-            std::string buffer;
-            buffer.resize(dwSize);
-            DWORD dwDownloaded = 0;
-            if (!WinHttpReadData(hRequest, &buffer[0], dwSize, &dwDownloaded)) break;
-            buffer.resize(dwDownloaded);
-            result_body += buffer;
-        } while (dwSize > 0);
-
-        if (!result_body.empty()) break; // 成功
-        // 失败则重试
-        Sleep(200);
+        if (!resp.ok() && !HttpRetryPolicy::is_retryable(resp)) break;
+        // 失败则重试（可被取消打断）
+        if (attempt < policy.max_retries) {
+            delay = policy.next_delay(delay, resp);
+            if (cancel.wait_for(delay)) break;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> GoogleTranslator::translate_text(CallState& state,
+                                                            const std::string& text,
+                                                            const std::string& target_language,
+                                                            const std::string& source_language) {
+    V2S_TRACE_SPAN("GoogleTranslator::translate_text", "translate");
+    std::ostringstream url;
+    url << google_base(opts_) << "/translate_a/single?client=gtx&sl=" << url_encode(source_language)
+        << "&tl=" << url_encode(target_language) << "&dt=t&q=" << url_encode(text);
+
+    HttpRequest req;
+    req.url = url.str();
+    auto body = send_with_retry(state, std::move(req));
+    if (!body) return std::nullopt;
+    return parse_single_response(*body);
+}
+
+std::optional<std::vector<std::string>> GoogleTranslator::translate_texts_batch(CallState& state,
+                                                                                const std::vector<std::string>& texts,
+                                                                                const std::string& target_language,
+                                                                                const std::string& source_language) {
+    V2S_TRACE_SPAN("GoogleTranslator::translate_texts_batch", "translate");
+    std::ostringstream url;
+    url << google_base(opts_) << "/translate_a/t?client=gtx&format=text&sl=" << url_encode(source_language)
+        << "&tl=" << url_encode(target_language);
+    std::string form;
+    for (const auto& t : texts) {
+        if (!form.empty()) form += '&';
+        form += "q=" + url_encode(t);
     }
 
-    if (hRequest) WinHttpCloseHandle(hRequest);
-    if (hConnect) WinHttpCloseHandle(hConnect);
-    if (hSession) WinHttpCloseHandle(hSession);
+    HttpRequest req;
+    req.method = "POST";
+    req.url = url.str();
+    req.headers = {{"Content-Type", "application/x-www-form-urlencoded;charset=utf-8"}};
+    req.body = std::move(form);
+    auto body = send_with_retry(state, std::move(req));
+    if (!body) return std::nullopt;
+    // 请求成功但条数不符/格式异常：返回空列表，由调用方逐段补救
+    return parse_multi_response(*body, texts.size()).value_or(std::vector<std::string>{});
+}
 
-    if (result_body.empty()) return {};
-    return parse_google_response_first_string(result_body);
+std::vector<std::vector<size_t>> GoogleTranslator::request_groups(const std::vector<Segment>& segments,
+                                                                 const std::string& target_language,
+                                                                 const std::string& source_language) const {
+    (void)target_language; (void)source_language;
+    const size_t max_segments = opts_.max_batch_segments > 0
+        ? std::min(kGoogleMaxBatchSegments, static_cast<size_t>(opts_.max_batch_segments))
+        : kGoogleMaxBatchSegments;
+    std::vector<std::vector<size_t>> groups;
+    std::vector<size_t> current;
+    size_t chars = 0;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const size_t len = segments[i].text.size();
+        if (len == 0) continue;
+        if (!current.empty() && (chars + len > kGoogleMaxBatchChars || current.size() >= max_segments)) {
+            groups.push_back(std::move(current));
+            current.clear();
+            chars = 0;
+        }
+        current.push_back(i);
+        chars += len;
+    }
+    if (!current.empty()) groups.push_back(std::move(current));
+    return groups;
 }
 
 TranslationResult GoogleTranslator::translate_segments(const std::vector<Segment>& segments,
                                                        const std::string& target_language,
                                                        const std::string& source_language) {
+    return translate_call(segments, target_language, source_language, TranslationCall{CancellationToken{}, segment_callback_});
+}
+
+TranslationResult GoogleTranslator::translate_call(const std::vector<Segment>& segments,
+                                                   const std::string& target_language,
+                                                   const std::string& source_language,
+                                                   const TranslationCall& call) {
+    CallState state;
+    state.cancel = link_cancel(opts_.cancel, call.cancel);
     TranslationResult result;
     result.source_language = source_language.empty() ? "auto" : source_language;
     result.target_language = target_language;
     result.translator_name = "google";
 
-    result.segments.reserve(segments.size());
-    for (const auto& seg : segments) {
-        Segment tseg = seg;
-        std::string translated = translate_text(seg.text, target_language, result.source_language);
-        if (!translated.empty()) {
-            tseg.text = translated;
-            tseg.language = target_language;
-        } else {
-            // 如果失败，保留原文以保证管线不中断
-            tseg.language = target_language;
+    // 结果按原下标写回；失败或未执行（取消）的段保留原文并记入 failed_indices
+    result.segments = segments;
+    for (auto& seg : result.segments) seg.language = target_language;
+    std::vector<char> failed(segments.size(), 1);
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (segments[i].text.empty()) failed[i] = 0;
+    }
+    const std::vector<std::vector<size_t>> groups = request_groups(segments, target_language, source_language);
+
+    const size_t concurrency = static_cast<size_t>(std::max(1, opts_.max_concurrency));
+    parallel_for(groups.size(), concurrency, [&](size_t g) {
+        if (state.cancel.is_cancelled()) return;
+        const auto& group = groups[g];
+        std::optional<std::vector<std::string>> translated;
+        if (group.size() > 1) {
+            std::vector<std::string> texts;
+            texts.reserve(group.size());
+            for (size_t idx : group) texts.push_back(segments[idx].text);
+            translated = translate_texts_batch(state, texts, target_language, result.source_language);
+        }
+        if (translated && translated->empty()) {
+            translated.reset();
+        } else if (group.size() > 1 && !translated) {
+            return;   // 批量请求在重试后仍失败：不再逐段重复请求，整批保留原文
+        }
+        if (translated) {
+            for (size_t k = 0; k < group.size(); ++k) {
+                const size_t idx = group[k];
+                if ((*translated)[k].empty()) continue;
+                result.segments[idx].text = std::move((*translated)[k]);
+                failed[idx] = 0;
+                call.notify(idx, result.segments[idx].text);
+            }
+            return;
+        }
+        // 单段批次，或批量响应无法对齐：逐段请求
+        for (size_t idx : group) {
+            if (state.cancel.is_cancelled()) return;
+            if (auto text = translate_text(state, segments[idx].text, target_language, result.source_language)) {
+                result.segments[idx].text = std::move(*text);
+                failed[idx] = 0;
+                call.notify(idx, result.segments[idx].text);
+            }
         }
-        result.segments.push_back(std::move(tseg));
+    });
+
+    for (size_t i = 0; i < failed.size(); ++i) {
+        if (failed[i]) result.failed_indices.push_back(i);
     }
+    result.stats = std::move(state.stats);
     return result;
 }
 
-} // namespace v2s
\ No newline at end of file
+} // namespace v2s
@@ -0,0 +1,612 @@
+#include "video2srt_native/http_client.hpp"
+#include "video2srt_native/trace.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <winhttp.h>
+#pragma comment(lib, "winhttp.lib")
+#elif defined(V2S_HAVE_LIBCURL)
+#include <curl/curl.h>
+#endif
+
+namespace v2s {
+
+namespace {
+
+std::string to_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+std::string trim_ws(const std::string& s) {
+    auto start = s.find_first_not_of("\r\n\t ");
+    auto end = s.find_last_not_of("\r\n\t ");
+    if (start == std::string::npos) return "";
+    return s.substr(start, end - start + 1);
+}
+
+// 解析一行响应头；状态行（HTTP/x 200）表示新响应开始（如重定向后），清空已收集的头
+void parse_header_line(const std::string& line, std::vector<std::pair<std::string, std::string>>& out) {
+    if (line.rfind("HTTP/", 0) == 0) {
+        out.clear();
+        return;
+    }
+    auto colon = line.find(':');
+    if (colon == std::string::npos || colon == 0) return;
+    out.emplace_back(to_lower(trim_ws(line.substr(0, colon))), trim_ws(line.substr(colon + 1)));
+}
+
+// 单次请求超时（毫秒），受截止时间约束；0 表示不限
+long effective_timeout_ms(const HttpRequest& req) {
+    long timeout_ms = req.timeout_seconds > 0 ? static_cast<long>(req.timeout_seconds) * 1000L : 0L;
+    if (auto left = req.cancel.remaining()) {
+        const long left_ms = std::max<long>(1, static_cast<long>(left->count()));
+        timeout_ms = timeout_ms > 0 ? std::min(timeout_ms, left_ms) : left_ms;
+    }
+    return timeout_ms;
+}
+
+} // namespace
+
+std::optional<std::string> HttpResponse::header(const std::string& name) const {
+    const std::string key = to_lower(name);
+    for (const auto& kv : headers) {
+        if (kv.first == key) return kv.second;
+    }
+    return std::nullopt;
+}
+
+bool HttpRetryPolicy::is_retryable(const HttpResponse& resp) {
+    if (resp.cancelled) return false;
+    if (resp.status == 0) return true;
+    return resp.status == 408 || resp.status == 429 || resp.status >= 500;
+}
+
+std::chrono::milliseconds HttpRetryPolicy::next_delay(std::chrono::milliseconds previous, const HttpResponse& resp) const {
+    thread_local std::mt19937_64 rng(std::random_device{}());
+    const long long base = std::max<long long>(1, backoff.count());
+    const long long cap = std::max(base, static_cast<long long>(max_backoff.count()));
+    const long long upper = std::min(cap, std::max<long long>(base, previous.count() * 3));
+    long long ms = std::uniform_int_distribution<long long>(base, upper)(rng);
+    if (auto retry_after = parse_retry_after(resp)) {
+        ms = std::max(ms, std::min<long long>(retry_after->count(), max_retry_after.count()));
+    }
+    return std::chrono::milliseconds(ms);
+}
+
+// 公历日期 -> 距 1970-01-01 的天数（Howard Hinnant 的 days_from_civil）
+static long long days_from_civil(long long y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const long long era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<long long>(doe) - 719468;
+}
+
+// 解析 IMF-fixdate（如 "Sun, 06 Nov 1994 08:49:37 GMT"），返回 Unix 秒
+static std::optional<long long> parse_http_date(const std::string& s) {
+    static const char* months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun", "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    auto comma = s.find(',');
+    std::istringstream in(comma == std::string::npos ? s : s.substr(comma + 1));
+    int day = 0, year = 0, hh = 0, mm = 0, ss = 0;
+    std::string mon;
+    char c1 = 0, c2 = 0;
+    if (!(in >> day >> mon >> year >> hh >> c1 >> mm >> c2 >> ss) || c1 != ':' || c2 != ':') return std::nullopt;
+    for (unsigned m = 0; m < 12; ++m) {
+        if (mon == months[m]) {
+            return days_from_civil(year, m + 1, static_cast<unsigned>(day)) * 86400LL + hh * 3600LL + mm * 60LL + ss;
+        }
+    }
+    return std::nullopt;
+}
+
+std::optional<std::chrono::milliseconds> parse_retry_after(const HttpResponse& resp) {
+    auto value = resp.header("retry-after");
+    if (!value || value->empty()) return std::nullopt;
+    const std::string v = trim_ws(*value);
+    if (std::all_of(v.begin(), v.end(), [](unsigned char c) { return std::isdigit(c) || c == '.'; })) {
+        try {
+            return std::chrono::milliseconds(static_cast<long long>(std::stod(v) * 1000.0));
+        } catch (...) {
+            return std::nullopt;
+        }
+    }
+    if (auto when = parse_http_date(v)) {
+        const long long now = std::chrono::duration_cast<std::chrono::seconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        return std::chrono::milliseconds(std::max<long long>(0, *when - now) * 1000);
+    }
+    return std::nullopt;
+}
+
+#ifdef _WIN32
+// ---------------------------------------------------------------------------
+// WinHTTP 后端：单个会话（连接池/keep-alive 由会话维护），请求在调用线程同步执行
+// ---------------------------------------------------------------------------
+
+static std::wstring utf8_to_wide(const std::string& s) {
+    if (s.empty()) return {};
+    int n = MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0);
+    std::wstring out(static_cast<size_t>(n), L'\0');
+    MultiByteToWideChar(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), &out[0], n);
+    return out;
+}
+
+static std::string wide_to_utf8(const std::wstring& s) {
+    if (s.empty()) return {};
+    int n = WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), nullptr, 0, nullptr, nullptr);
+    std::string out(static_cast<size_t>(n), '\0');
+    WideCharToMultiByte(CP_UTF8, 0, s.data(), static_cast<int>(s.size()), &out[0], n, nullptr, nullptr);
+    return out;
+}
+
+struct HttpClient::Impl {
+    HINTERNET session = nullptr;
+
+    Impl() {
+        session = WinHttpOpen(L"Video2SRT-Native/1.0",
+                              WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+                              WINHTTP_NO_PROXY_NAME,
+                              WINHTTP_NO_PROXY_BYPASS, 0);
+        if (!session) return;
+        // 优先 TLS1.2/1.3，避免旧系统默认不启用导致握手失败
+#ifdef WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_3
+        DWORD protocols = WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2 | WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_3;
+        if (!WinHttpSetOption(session, WINHTTP_OPTION_SECURE_PROTOCOLS, &protocols, sizeof(protocols)))
+#endif
+        {
+            DWORD tls12 = WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2;
+            WinHttpSetOption(session, WINHTTP_OPTION_SECURE_PROTOCOLS, &tls12, sizeof(tls12));
+        }
+#ifdef WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL
+        // Windows 10 1607+ 支持 HTTP/2，失败时保持 HTTP/1.1 keep-alive
+        DWORD http2 = WINHTTP_PROTOCOL_FLAG_HTTP2;
+        WinHttpSetOption(session, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL, &http2, sizeof(http2));
+#endif
+#ifdef WINHTTP_OPTION_DECOMPRESSION
+        DWORD decompression = WINHTTP_DECOMPRESSION_FLAG_ALL;
+        WinHttpSetOption(session, WINHTTP_OPTION_DECOMPRESSION, &decompression, sizeof(decompression));
+#endif
+    }
+
+    ~Impl() {
+        if (session) WinHttpCloseHandle(session);
+    }
+
+    HttpResponse send(const HttpRequest& req) {
+        HttpResponse resp;
+        if (!session) { resp.error = "WinHttpOpen 失败"; return resp; }
+
+        std::wstring wurl = utf8_to_wide(req.url);
+        URL_COMPONENTS uc{};
+        uc.dwStructSize = sizeof(uc);
+        uc.dwHostNameLength = static_cast<DWORD>(-1);
+        uc.dwUrlPathLength = static_cast<DWORD>(-1);
+        uc.dwExtraInfoLength = static_cast<DWORD>(-1);
+        if (!WinHttpCrackUrl(wurl.c_str(), 0, 0, &uc)) {
+            resp.error = "URL 解析失败: " + req.url;
+            return resp;
+        }
+        std::wstring host(uc.lpszHostName, uc.dwHostNameLength);
+        std::wstring path(uc.lpszUrlPath, uc.dwUrlPathLength);
+        if (uc.lpszExtraInfo) path.append(uc.lpszExtraInfo, uc.dwExtraInfoLength);
+        if (path.empty()) path = L"/";
+        const bool secure = (uc.nScheme == INTERNET_SCHEME_HTTPS);
+
+        HINTERNET hConnect = WinHttpConnect(session, host.c_str(), uc.nPort, 0);
+        if (!hConnect) { resp.error = "WinHttpConnect 失败"; return resp; }
+        std::wstring method = utf8_to_wide(req.method);
+        HINTERNET hRequest = WinHttpOpenRequest(hConnect, method.c_str(), path.c_str(),
+                                                NULL, WINHTTP_NO_REFERER,
+                                                WINHTTP_DEFAULT_ACCEPT_TYPES,
+                                                secure ? WINHTTP_FLAG_SECURE : 0);
+        if (!hRequest) {
+            WinHttpCloseHandle(hConnect);
+            resp.error = "WinHttpOpenRequest 失败";
+            return resp;
+        }
+        auto close_all = [&] {
+            WinHttpCloseHandle(hRequest);
+            WinHttpCloseHandle(hConnect);
+        };
+
+        // 超时（WinHTTP 同步请求无法从外部中断，按截止时间收紧超时）
+        const long timeout_ms = effective_timeout_ms(req);
+        const int io_ms = timeout_ms > 0 ? static_cast<int>(timeout_ms) : 60000;
+        const int connect_ms = std::min(io_ms, std::max(1, req.connect_timeout_seconds) * 1000);
+        WinHttpSetTimeouts(hRequest, connect_ms, connect_ms, io_ms, io_ms);
+
+        if (req.max_redirects <= 0) {
+            DWORD disable = WINHTTP_DISABLE_REDIRECTS;
+            WinHttpSetOption(hRequest, WINHTTP_OPTION_DISABLE_FEATURE, &disable, sizeof(disable));
+        } else {
+            DWORD max_redirects = static_cast<DWORD>(req.max_redirects);
+            WinHttpSetOption(hRequest, WINHTTP_OPTION_MAX_HTTP_AUTOMATIC_REDIRECTS, &max_redirects, sizeof(max_redirects));
+        }
+        if (req.ssl_bypass) {
+            DWORD flags = SECURITY_FLAG_IGNORE_UNKNOWN_CA |
+                          SECURITY_FLAG_IGNORE_CERT_CN_INVALID |
+                          SECURITY_FLAG_IGNORE_CERT_DATE_INVALID |
+                          SECURITY_FLAG_IGNORE_CERT_WRONG_USAGE;
+            WinHttpSetOption(hRequest, WINHTTP_OPTION_SECURITY_FLAGS, &flags, sizeof(flags));
+        }
+
+        std::wstring hdrs;
+        for (const auto& kv : req.headers) {
+            hdrs += utf8_to_wide(kv.first) + L": " + utf8_to_wide(kv.second) + L"\r\n";
+        }
+        BOOL sent = WinHttpSendRequest(hRequest,
+                                       hdrs.empty() ? WINHTTP_NO_ADDITIONAL_HEADERS : hdrs.c_str(),
+                                       hdrs.empty() ? 0 : static_cast<DWORD>(-1L),
+                                       req.body.empty() ? WINHTTP_NO_REQUEST_DATA : (LPVOID)req.body.data(),
+                                       static_cast<DWORD>(req.body.size()),
+                                       static_cast<DWORD>(req.body.size()), 0);
+        if (!sent || !WinHttpReceiveResponse(hRequest, NULL)) {
+            const DWORD err = GetLastError();
+            resp.timed_out = err == ERROR_WINHTTP_TIMEOUT;
+            resp.error = "WinHTTP 请求失败, 错误码: " + std::to_string(err);
+            close_all();
+            return resp;
+        }
+
+        DWORD status = 0, status_size = sizeof(status);
+        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+                            WINHTTP_HEADER_NAME_BY_INDEX, &status, &status_size, WINHTTP_NO_HEADER_INDEX);
+
+        DWORD raw_size = 0;
+        WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                            NULL, &raw_size, WINHTTP_NO_HEADER_INDEX);
+        if (GetLastError() == ERROR_INSUFFICIENT_BUFFER && raw_size > 0) {
+            std::wstring raw(raw_size / sizeof(wchar_t), L'\0');
+            if (WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_RAW_HEADERS_CRLF, WINHTTP_HEADER_NAME_BY_INDEX,
+                                    &raw[0], &raw_size, WINHTTP_NO_HEADER_INDEX)) {
+                std::string text = wide_to_utf8(raw);
+                size_t pos = 0;
+                while (pos < text.size()) {
+                    size_t eol = text.find("\r\n", pos);
+                    if (eol == std::string::npos) eol = text.size();
+                    parse_header_line(text.substr(pos, eol - pos), resp.headers);
+                    pos = eol + 2;
+                }
+            }
+        }
+
+        uint64_t total = 0;
+        if (auto cl = resp.header("content-length")) {
+            try { total = std::stoull(*cl); } catch (...) { total = 0; }
+        }
+
+        uint64_t received = 0;
+        std::string buffer;
+        bool read_ok = true;
+        for (;;) {
+            if (req.cancel.is_cancelled()) { resp.cancelled = true; read_ok = false; break; }
+            DWORD avail = 0;
+            if (!WinHttpQueryDataAvailable(hRequest, &avail)) { read_ok = false; break; }
+            if (avail == 0) break;
+            buffer.resize(std::max<size_t>(avail, 1 << 14));
+            DWORD read = 0;
+            if (!WinHttpReadData(hRequest, &buffer[0], static_cast<DWORD>(buffer.size()), &read)) {
+                resp.timed_out = GetLastError() == ERROR_WINHTTP_TIMEOUT;
+                read_ok = false;
+                break;
+            }
+            if (read == 0) break;
+            received += read;
+            if (req.on_data) {
+                if (!req.on_data(buffer.data(), read)) { read_ok = false; break; }
+            } else {
+                resp.body.append(buffer.data(), read);
+            }
+            if (req.on_progress) req.on_progress(received, total);
+        }
+        close_all();
+
+        if (!read_ok) {
+            resp.error = resp.cancelled ? "请求已取消" : "读取响应失败";
+            resp.status = 0;
+            return resp;
+        }
+        resp.status = static_cast<int>(status);
+        return resp;
+    }
+};
+
+bool HttpClient::available() { return true; }
+
+#elif defined(V2S_HAVE_LIBCURL)
+// ---------------------------------------------------------------------------
+// libcurl 后端：所有传输都加入同一个 multi 句柄，由一个后台线程驱动。
+// 连接缓存、DNS 缓存与 TLS 会话都保存在 multi 句柄/共享句柄中，跨请求复用；
+// 同一主机的并发请求在 HTTP/2 下复用同一连接（CURLPIPE_MULTIPLEX + PIPEWAIT）。
+// 所有 curl_* 调用都在后台线程内完成，因此共享句柄无需加锁回调。
+// ---------------------------------------------------------------------------
+
+namespace {
+
+struct Transfer {
+    const HttpRequest* req = nullptr;
+    HttpResponse resp;
+    CURL* easy = nullptr;
+    curl_slist* headers = nullptr;
+    bool sink_aborted = false;
+
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool done = false;
+};
+
+size_t write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) {
+    auto* t = static_cast<Transfer*>(userdata);
+    const size_t n = size * nmemb;
+    if (t->req->on_data) {
+        if (!t->req->on_data(ptr, n)) {
+            t->sink_aborted = true;
+            return 0;
+        }
+    } else {
+        t->resp.body.append(ptr, n);
+    }
+    return n;
+}
+
+size_t header_cb(char* buffer, size_t size, size_t nitems, void* userdata) {
+    auto* t = static_cast<Transfer*>(userdata);
+    const size_t n = size * nitems;
+    parse_header_line(std::string(buffer, n), t->resp.headers);
+    return n;
+}
+
+int xferinfo_cb(void* clientp, curl_off_t dltotal, curl_off_t dlnow, curl_off_t, curl_off_t) {
+    auto* t = static_cast<Transfer*>(clientp);
+    if (t->req->on_progress && dlnow > 0) {
+        t->req->on_progress(static_cast<uint64_t>(dlnow), static_cast<uint64_t>(std::max<curl_off_t>(0, dltotal)));
+    }
+    return 0;
+}
+
+} // namespace
+
+struct HttpClient::Impl {
+    CURLM* multi = nullptr;
+    CURLSH* share = nullptr;
+    std::thread loop;
+    std::mutex mutex;
+    std::deque<Transfer*> pending;
+    std::vector<Transfer*> active;
+    std::atomic<bool> stopping{false};
+
+    Impl() {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        multi = curl_multi_init();
+        share = curl_share_init();
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+        curl_share_setopt(share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+        curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, 16L);
+        curl_multi_setopt(multi, CURLMOPT_MAXCONNECTS, 32L);
+        loop = std::thread([this] { run(); });
+    }
+
+    ~Impl() {
+        stopping.store(true);
+        wakeup();
+        if (loop.joinable()) loop.join();
+        curl_multi_cleanup(multi);
+        curl_share_cleanup(share);
+    }
+
+    void wakeup() {
+#if LIBCURL_VERSION_NUM >= 0x074400
+        curl_multi_wakeup(multi);
+#endif
+    }
+
+    void setup(Transfer* t) {
+        const HttpRequest& req = *t->req;
+        CURL* curl = curl_easy_init();
+        t->easy = curl;
+        curl_easy_setopt(curl, CURLOPT_PRIVATE, t);
+        curl_easy_setopt(curl, CURLOPT_SHARE, share);
+        curl_easy_setopt(curl, CURLOPT_URL, req.url.c_str());
+        if (req.method == "POST") {
+            curl_easy_setopt(curl, CURLOPT_POST, 1L);
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req.body.data());
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(req.body.size()));
+        } else if (req.method != "GET") {
+            curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, req.method.c_str());
+            if (!req.body.empty()) {
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDS, req.body.data());
+                curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE_LARGE, static_cast<curl_off_t>(req.body.size()));
+            }
+        }
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, t);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_cb);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, t);
+        if (req.on_progress) {
+            curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, xferinfo_cb);
+            curl_easy_setopt(curl, CURLOPT_XFERINFODATA, t);
+            curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        }
+        curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, "");
+        curl_easy_setopt(curl, CURLOPT_USERAGENT, "Video2SRT-Native/1.0");
+
+        const long timeout_ms = effective_timeout_ms(req);
+        if (timeout_ms > 0) {
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeout_ms);
+        } else {
+            // 不限总时长（大文件下载），但 60 秒内几乎无数据时中止
+            curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+            curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, 60L);
+        }
+        long connect_ms = std::max(1, req.connect_timeout_seconds) * 1000L;
+        if (timeout_ms > 0) connect_ms = std::min(connect_ms, timeout_ms);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS, connect_ms);
+
+        if (req.max_redirects > 0) {
+            curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+            curl_easy_setopt(curl, CURLOPT_MAXREDIRS, static_cast<long>(req.max_redirects));
+        }
+        if (req.ssl_bypass) {
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        }
+        for (const auto& kv : req.headers) {
+            std::string h = kv.first + ": " + kv.second;
+            t->headers = curl_slist_append(t->headers, h.c_str());
+        }
+        if (t->headers) curl_easy_setopt(curl, CURLOPT_HTTPHEADER, t->headers);
+    }
+
+    // 结束传输：释放 curl 资源并唤醒等待线程（在后台线程内调用）
+    void finish(Transfer* t, CURLcode rc, bool cancelled) {
+        if (cancelled) {
+            t->resp.status = 0;
+            t->resp.cancelled = true;
+            t->resp.error = "请求已取消";
+        } else if (rc != CURLE_OK) {
+            t->resp.status = 0;
+            t->resp.error = t->sink_aborted ? "接收方中止传输" : curl_easy_strerror(rc);
+            t->resp.timed_out = rc == CURLE_OPERATION_TIMEDOUT;
+        } else {
+            long code = 0;
+            curl_easy_getinfo(t->easy, CURLINFO_RESPONSE_CODE, &code);
+            t->resp.status = static_cast<int>(code);
+        }
+        curl_multi_remove_handle(multi, t->easy);
+        curl_easy_cleanup(t->easy);
+        t->easy = nullptr;
+        if (t->headers) {
+            curl_slist_free_all(t->headers);
+            t->headers = nullptr;
+        }
+        // 在锁内通知：等待方一旦看到 done 就会返回并析构 Transfer（含 cv）
+        std::lock_guard<std::mutex> lock(t->mutex);
+        t->done = true;
+        t->cv.notify_all();
+    }
+
+    void run() {
+        for (;;) {
+            std::deque<Transfer*> incoming;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                incoming.swap(pending);
+            }
+            for (Transfer* t : incoming) {
+                setup(t);
+                curl_multi_add_handle(multi, t->easy);
+                active.push_back(t);
+            }
+            if (stopping.load() && incoming.empty()) {
+                for (Transfer* t : active) finish(t, CURLE_ABORTED_BY_CALLBACK, true);
+                active.clear();
+                return;
+            }
+
+            int running = 0;
+            curl_multi_perform(multi, &running);
+
+            int queued = 0;
+            while (CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+                if (msg->msg != CURLMSG_DONE) continue;
+                Transfer* t = nullptr;
+                curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, reinterpret_cast<char**>(&t));
+                const CURLcode rc = msg->data.result;
+                active.erase(std::remove(active.begin(), active.end(), t), active.end());
+                finish(t, rc, false);
+            }
+
+            // 取消/截止时间：直接移出 multi 句柄，无需等待 curl 回调
+            for (auto it = active.begin(); it != active.end();) {
+                if ((*it)->req->cancel.is_cancelled()) {
+                    finish(*it, CURLE_ABORTED_BY_CALLBACK, true);
+                    it = active.erase(it);
+                } else {
+                    ++it;
+                }
+            }
+
+#if LIBCURL_VERSION_NUM >= 0x074400
+            curl_multi_poll(multi, nullptr, 0, 100, nullptr);
+#else
+            curl_multi_wait(multi, nullptr, 0, active.empty() ? 20 : 100, nullptr);
+#endif
+        }
+    }
+
+    HttpResponse send(const HttpRequest& req) {
+        Transfer t;
+        t.req = &req;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping.load()) {
+                t.resp.error = "HTTP 客户端已关闭";
+                return t.resp;
+            }
+            pending.push_back(&t);
+        }
+        wakeup();
+        std::unique_lock<std::mutex> lock(t.mutex);
+        t.cv.wait(lock, [&] { return t.done; });
+        return std::move(t.resp);
+    }
+};
+
+bool HttpClient::available() { return true; }
+
+#else
+
+struct HttpClient::Impl {
+    HttpResponse send(const HttpRequest&) {
+        HttpResponse resp;
+        resp.error = "未编译 HTTP 支持（需要 WinHTTP 或 libcurl）";
+        return resp;
+    }
+};
+
+bool HttpClient::available() { return false; }
+
+#endif
+
+HttpClient& HttpClient::shared() {
+    static HttpClient instance;
+    return instance;
+}
+
+HttpClient::HttpClient() : impl_(new Impl) {}
+
+HttpClient::~HttpClient() {
+    delete impl_;
+}
+
+HttpResponse HttpClient::send(const HttpRequest& req) {
+    V2S_TRACE_SPAN("http_request", "http");
+    if (req.cancel.is_cancelled()) {
+        HttpResponse resp;
+        resp.cancelled = true;
+        resp.error = "请求已取消";
+        return resp;
+    }
+    const auto t0 = std::chrono::steady_clock::now();
+    HttpResponse resp = impl_->send(req);
+    resp.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    return resp;
+}
+
+} // namespace v2s
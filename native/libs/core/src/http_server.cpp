@@ -0,0 +1,282 @@
+#include "video2srt_native/http_server.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <sstream>
+
+#ifdef _WIN32
+#  ifndef WIN32_LEAN_AND_MEAN
+#    define WIN32_LEAN_AND_MEAN
+#  endif
+#  include <winsock2.h>
+#  include <ws2tcpip.h>
+#else
+#  include <arpa/inet.h>
+#  include <netinet/in.h>
+#  include <netinet/tcp.h>
+#  include <sys/socket.h>
+#  include <unistd.h>
+#endif
+
+namespace v2s {
+
+namespace {
+
+#ifdef _WIN32
+using socket_t = SOCKET;
+const socket_t kInvalidSocket = INVALID_SOCKET;
+
+const int kSendFlags = 0;
+
+void close_socket(socket_t s) { closesocket(s); }
+void shutdown_socket(socket_t s) { shutdown(s, SD_BOTH); }
+
+// WSAStartup 引用计数由系统维护，进程内调用一次即可
+bool ensure_winsock() {
+    static const bool ok = [] {
+        WSADATA data;
+        return WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    }();
+    return ok;
+}
+#else
+using socket_t = int;
+const socket_t kInvalidSocket = -1;
+
+// 对端已断开时避免 SIGPIPE 终止进程
+#  ifdef MSG_NOSIGNAL
+const int kSendFlags = MSG_NOSIGNAL;
+#  else
+const int kSendFlags = 0;
+#  endif
+
+void close_socket(socket_t s) { ::close(s); }
+void shutdown_socket(socket_t s) { ::shutdown(s, SHUT_RDWR); }
+bool ensure_winsock() { return true; }
+#endif
+
+socket_t to_socket(intptr_t fd) { return static_cast<socket_t>(fd); }
+
+const char* status_text(int status) {
+    switch (status) {
+        case 200: return "OK";
+        case 204: return "No Content";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 429: return "Too Many Requests";
+        case 500: return "Internal Server Error";
+        case 502: return "Bad Gateway";
+        case 503: return "Service Unavailable";
+        default: return "Unknown";
+    }
+}
+
+std::string to_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+std::string trim(const std::string& s) {
+    size_t b = s.find_first_not_of(" \t\r\n");
+    if (b == std::string::npos) return {};
+    size_t e = s.find_last_not_of(" \t\r\n");
+    return s.substr(b, e - b + 1);
+}
+
+bool send_all(socket_t s, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = ::send(s, data.data() + sent, static_cast<int>(data.size() - sent), kSendFlags);
+        if (n <= 0) return false;
+        sent += static_cast<size_t>(n);
+    }
+    return true;
+}
+
+constexpr size_t kMaxHeaderBytes = 64 * 1024;
+constexpr size_t kMaxBodyBytes = 64 * 1024 * 1024;
+
+} // namespace
+
+LocalHttpServer::LocalHttpServer(Handler handler)
+    : handler_(std::move(handler)) {
+}
+
+LocalHttpServer::~LocalHttpServer() {
+    stop();
+}
+
+bool LocalHttpServer::start(const std::string& host, uint16_t port) {
+    if (running_.load()) return false;
+    if (!ensure_winsock()) return false;
+
+    socket_t s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == kInvalidSocket) return false;
+
+    int yes = 1;
+    setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&yes), sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    if (inet_pton(AF_INET, host.c_str(), &addr.sin_addr) != 1) {
+        close_socket(s);
+        return false;
+    }
+    if (::bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(s, 64) != 0) {
+        close_socket(s);
+        return false;
+    }
+
+    sockaddr_in bound{};
+    socklen_t len = sizeof(bound);
+    if (::getsockname(s, reinterpret_cast<sockaddr*>(&bound), &len) == 0) {
+        port_ = ntohs(bound.sin_port);
+    } else {
+        port_ = port;
+    }
+
+    listen_fd_ = static_cast<intptr_t>(s);
+    running_.store(true);
+    accept_thread_ = std::thread(&LocalHttpServer::accept_loop, this);
+    return true;
+}
+
+void LocalHttpServer::stop() {
+    if (!running_.exchange(false)) return;
+
+    // 关闭监听套接字以唤醒 accept
+    socket_t ls = to_socket(listen_fd_);
+    shutdown_socket(ls);
+    close_socket(ls);
+    if (accept_thread_.joinable()) accept_thread_.join();
+    listen_fd_ = -1;
+
+    // 唤醒阻塞在 recv 的连接线程，并等待其全部退出
+    std::unique_lock<std::mutex> lock(conn_mutex_);
+    for (intptr_t fd : open_fds_) {
+        shutdown_socket(to_socket(fd));
+    }
+    conn_cv_.wait(lock, [this] { return open_fds_.empty(); });
+    port_ = 0;
+}
+
+void LocalHttpServer::accept_loop() {
+    socket_t ls = to_socket(listen_fd_);
+    while (running_.load()) {
+        socket_t c = ::accept(ls, nullptr, nullptr);
+        if (c == kInvalidSocket) {
+            if (!running_.load()) break;
+            continue;
+        }
+        int yes = 1;
+        setsockopt(c, IPPROTO_TCP, TCP_NODELAY, reinterpret_cast<const char*>(&yes), sizeof(yes));
+
+        std::lock_guard<std::mutex> lock(conn_mutex_);
+        if (!running_.load()) {
+            close_socket(c);
+            break;
+        }
+        intptr_t fd = static_cast<intptr_t>(c);
+        open_fds_.push_back(fd);
+        std::thread(&LocalHttpServer::serve_connection, this, fd).detach();
+    }
+}
+
+void LocalHttpServer::serve_connection(intptr_t fd) {
+    socket_t s = to_socket(fd);
+    std::string buffer;
+    char chunk[16 * 1024];
+
+    auto recv_more = [&]() -> bool {
+        int n = ::recv(s, chunk, static_cast<int>(sizeof(chunk)), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+        return true;
+    };
+
+    bool keep_alive = true;
+    while (keep_alive && running_.load()) {
+        // 读取请求头
+        size_t header_end = std::string::npos;
+        while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+            if (buffer.size() > kMaxHeaderBytes || !recv_more()) {
+                header_end = std::string::npos;
+                break;
+            }
+        }
+        if (header_end == std::string::npos) break;
+
+        Request req;
+        std::istringstream head(buffer.substr(0, header_end));
+        std::string line;
+        std::getline(head, line);
+        {
+            std::istringstream rl(trim(line));
+            std::string version;
+            rl >> req.method >> req.path >> version;
+            keep_alive = (version != "HTTP/1.0");
+        }
+        while (std::getline(head, line)) {
+            size_t colon = line.find(':');
+            if (colon == std::string::npos) continue;
+            req.headers[to_lower(trim(line.substr(0, colon)))] = trim(line.substr(colon + 1));
+        }
+        buffer.erase(0, header_end + 4);
+
+        size_t content_length = 0;
+        auto cl = req.headers.find("content-length");
+        if (cl != req.headers.end()) {
+            try { content_length = static_cast<size_t>(std::stoull(cl->second)); } catch (...) { content_length = 0; }
+        }
+        auto conn = req.headers.find("connection");
+        if (conn != req.headers.end()) {
+            std::string v = to_lower(conn->second);
+            if (v == "close") keep_alive = false;
+            else if (v == "keep-alive") keep_alive = true;
+        }
+
+        Response resp;
+        if (content_length > kMaxBodyBytes) {
+            resp.status = 413;
+            resp.body = "payload too large\n";
+            keep_alive = false;
+        } else {
+            while (buffer.size() < content_length) {
+                if (!recv_more()) { keep_alive = false; break; }
+            }
+            if (buffer.size() < content_length) break;
+            req.body = buffer.substr(0, content_length);
+            buffer.erase(0, content_length);
+
+            try {
+                resp = handler_(req);
+            } catch (const std::exception& e) {
+                resp = Response{};
+                resp.status = 500;
+                resp.body = std::string("handler error: ") + e.what() + "\n";
+            }
+        }
+        if (resp.close_connection) keep_alive = false;
+
+        std::ostringstream out;
+        out << "HTTP/1.1 " << resp.status << " " << status_text(resp.status) << "\r\n";
+        out << "Content-Type: " << resp.content_type << "\r\n";
+        out << "Content-Length: " << resp.body.size() << "\r\n";
+        for (const auto& h : resp.headers) {
+            out << h.first << ": " << h.second << "\r\n";
+        }
+        out << "Connection: " << (keep_alive ? "keep-alive" : "close") << "\r\n\r\n";
+        if (!send_all(s, out.str()) || !send_all(s, resp.body)) break;
+    }
+
+    // 在锁内关闭并移除，避免 stop() 对已被复用的描述符执行 shutdown
+    std::lock_guard<std::mutex> lock(conn_mutex_);
+    close_socket(s);
+    open_fds_.erase(std::remove(open_fds_.begin(), open_fds_.end(), fd), open_fds_.end());
+    conn_cv_.notify_all();
+}
+
+} // namespace v2s
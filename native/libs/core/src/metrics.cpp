@@ -0,0 +1,318 @@
+#include "video2srt_native/metrics.hpp"
+#include "video2srt_native/http_server.hpp"
+#include "video2srt_native/stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <sstream>
+
+namespace v2s {
+namespace metrics {
+
+namespace {
+
+// C++17 没有 atomic<double>::fetch_add，使用 CAS 循环
+void atomic_add(std::atomic<double>& target, double v) {
+    double cur = target.load(std::memory_order_relaxed);
+    while (!target.compare_exchange_weak(cur, cur + v, std::memory_order_relaxed)) {
+    }
+}
+
+std::string escape_label_value(const std::string& v) {
+    std::string out;
+    out.reserve(v.size());
+    for (char c : v) {
+        switch (c) {
+            case '\\': out += "\\\\"; break;
+            case '"': out += "\\\""; break;
+            case '\n': out += "\\n"; break;
+            default: out += c;
+        }
+    }
+    return out;
+}
+
+std::string escape_help(const std::string& v) {
+    std::string out;
+    for (char c : v) {
+        if (c == '\\') out += "\\\\";
+        else if (c == '\n') out += "\\n";
+        else out += c;
+    }
+    return out;
+}
+
+// 序列化标签为 {k="v",...}；extra 用于直方图的 le 标签
+std::string format_labels(const Labels& labels, const std::string& extra = {}) {
+    if (labels.empty() && extra.empty()) return {};
+    std::string out = "{";
+    bool first = true;
+    for (const auto& kv : labels) {
+        if (!first) out += ",";
+        first = false;
+        out += kv.first + "=\"" + escape_label_value(kv.second) + "\"";
+    }
+    if (!extra.empty()) {
+        if (!first) out += ",";
+        out += extra;
+    }
+    out += "}";
+    return out;
+}
+
+std::string format_value(double v) {
+    if (std::isnan(v)) return "NaN";
+    if (std::isinf(v)) return v > 0 ? "+Inf" : "-Inf";
+    std::ostringstream oss;
+    oss.precision(15);
+    oss << v;
+    return oss.str();
+}
+
+enum class Type { Counter, Gauge, Histogram };
+
+const char* type_name(Type t) {
+    switch (t) {
+        case Type::Counter: return "counter";
+        case Type::Gauge: return "gauge";
+        case Type::Histogram: return "histogram";
+    }
+    return "untyped";
+}
+
+struct Series {
+    Labels labels;
+    std::unique_ptr<Counter> counter;
+    std::unique_ptr<Gauge> gauge;
+    std::unique_ptr<Histogram> histogram;
+};
+
+struct Family {
+    Type type = Type::Counter;
+    std::string help;
+    std::map<std::string, Series> series;   // key：序列化后的标签
+    std::function<double()> callback;        // 仅回调型 gauge 使用
+};
+
+} // namespace
+
+void Counter::inc(double v) {
+    if (v < 0) return; // 计数器只增不减
+    atomic_add(value_, v);
+}
+
+void Gauge::inc(double v) {
+    atomic_add(value_, v);
+}
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)) {
+    std::sort(bounds_.begin(), bounds_.end());
+    bounds_.erase(std::unique(bounds_.begin(), bounds_.end()), bounds_.end());
+    buckets_.reset(new std::atomic<uint64_t>[bounds_.size() + 1]);
+    for (size_t i = 0; i <= bounds_.size(); ++i) {
+        buckets_[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+void Histogram::observe(double v) {
+    size_t idx = static_cast<size_t>(std::lower_bound(bounds_.begin(), bounds_.end(), v) - bounds_.begin());
+    buckets_[idx].fetch_add(1, std::memory_order_relaxed);
+    count_.fetch_add(1, std::memory_order_relaxed);
+    atomic_add(sum_, v);
+}
+
+std::vector<uint64_t> Histogram::bucket_counts() const {
+    std::vector<uint64_t> out(bounds_.size() + 1);
+    for (size_t i = 0; i < out.size(); ++i) {
+        out[i] = buckets_[i].load(std::memory_order_relaxed);
+    }
+    return out;
+}
+
+struct Registry::Impl {
+    mutable std::mutex mutex;
+    std::map<std::string, Family> families;
+
+    Series& get_series(const std::string& name, const std::string& help, Type type, const Labels& labels) {
+        Family& fam = families[name];
+        if (fam.series.empty() && !fam.callback) {
+            fam.type = type;
+            fam.help = help;
+        }
+        return fam.series[format_labels(labels)];
+    }
+};
+
+Registry::Registry() : impl_(new Impl) {}
+Registry::~Registry() = default;
+
+Registry& Registry::instance() {
+    // 故意不析构：静态对象析构期间仍可能有线程更新指标
+    static Registry* r = [] {
+        auto* reg = new Registry();
+        reg->gauge_callback("v2s_process_resident_memory_bytes", "Current resident set size in bytes",
+                            [] { return static_cast<double>(current_rss_bytes()); });
+        reg->gauge_callback("v2s_process_peak_resident_memory_bytes", "Peak resident set size in bytes",
+                            [] { return static_cast<double>(peak_rss_bytes()); });
+        return reg;
+    }();
+    return *r;
+}
+
+Counter& Registry::counter(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    Series& s = impl_->get_series(name, help, Type::Counter, labels);
+    if (!s.counter) {
+        s.labels = labels;
+        s.counter.reset(new Counter());
+    }
+    return *s.counter;
+}
+
+Gauge& Registry::gauge(const std::string& name, const std::string& help, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    Series& s = impl_->get_series(name, help, Type::Gauge, labels);
+    if (!s.gauge) {
+        s.labels = labels;
+        s.gauge.reset(new Gauge());
+    }
+    return *s.gauge;
+}
+
+Histogram& Registry::histogram(const std::string& name, const std::string& help,
+                               const std::vector<double>& bounds, const Labels& labels) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    Series& s = impl_->get_series(name, help, Type::Histogram, labels);
+    if (!s.histogram) {
+        s.labels = labels;
+        s.histogram.reset(new Histogram(bounds));
+    }
+    return *s.histogram;
+}
+
+void Registry::gauge_callback(const std::string& name, const std::string& help, std::function<double()> fn) {
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    Family& fam = impl_->families[name];
+    fam.type = Type::Gauge;
+    fam.help = help;
+    fam.callback = std::move(fn);
+}
+
+std::string Registry::render_text() const {
+    std::ostringstream out;
+    std::lock_guard<std::mutex> lock(impl_->mutex);
+    for (const auto& entry : impl_->families) {
+        const std::string& name = entry.first;
+        const Family& fam = entry.second;
+        out << "# HELP " << name << " " << escape_help(fam.help) << "\n";
+        out << "# TYPE " << name << " " << type_name(fam.type) << "\n";
+
+        if (fam.callback) {
+            out << name << " " << format_value(fam.callback()) << "\n";
+            continue;
+        }
+        for (const auto& se : fam.series) {
+            const Series& s = se.second;
+            if (s.counter) {
+                out << name << se.first << " " << format_value(s.counter->value()) << "\n";
+            } else if (s.gauge) {
+                out << name << se.first << " " << format_value(s.gauge->value()) << "\n";
+            } else if (s.histogram) {
+                const auto& bounds = s.histogram->bounds();
+                auto counts = s.histogram->bucket_counts();
+                uint64_t cumulative = 0;
+                for (size_t i = 0; i < counts.size(); ++i) {
+                    cumulative += counts[i];
+                    std::string le = i < bounds.size() ? format_value(bounds[i]) : "+Inf";
+                    out << name << "_bucket" << format_labels(s.labels, "le=\"" + le + "\"")
+                        << " " << cumulative << "\n";
+                }
+                out << name << "_sum" << se.first << " " << format_value(s.histogram->sum()) << "\n";
+                out << name << "_count" << se.first << " " << s.histogram->count() << "\n";
+            }
+        }
+    }
+    return out.str();
+}
+
+Counter& counter(const std::string& name, const std::string& help, const Labels& labels) {
+    return Registry::instance().counter(name, help, labels);
+}
+
+Gauge& gauge(const std::string& name, const std::string& help, const Labels& labels) {
+    return Registry::instance().gauge(name, help, labels);
+}
+
+Histogram& histogram(const std::string& name, const std::string& help,
+                     const std::vector<double>& bounds, const Labels& labels) {
+    return Registry::instance().histogram(name, help, bounds, labels);
+}
+
+const std::vector<double>& latency_buckets_seconds() {
+    static const std::vector<double> buckets = {
+        0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30, 60, 120
+    };
+    return buckets;
+}
+
+bool write_text_file(const std::filesystem::path& path) {
+    std::ofstream ofs(path, std::ios::out | std::ios::trunc);
+    if (!ofs.is_open()) {
+        return false;
+    }
+    ofs << Registry::instance().render_text();
+    return ofs.good();
+}
+
+namespace {
+
+std::mutex g_endpoint_mutex;
+std::unique_ptr<LocalHttpServer> g_endpoint;
+
+} // namespace
+
+bool start_http_endpoint(uint16_t port, const std::string& host) {
+    std::lock_guard<std::mutex> lock(g_endpoint_mutex);
+    if (g_endpoint) return false;
+
+    auto server = std::make_unique<LocalHttpServer>([](const LocalHttpServer::Request& req) {
+        LocalHttpServer::Response resp;
+        std::string path = req.path.substr(0, req.path.find('?'));
+        if (req.method != "GET") {
+            resp.status = 405;
+            resp.body = "method not allowed\n";
+        } else if (path == "/metrics") {
+            resp.content_type = "text/plain; version=0.0.4; charset=utf-8";
+            resp.body = Registry::instance().render_text();
+        } else {
+            resp.status = 404;
+            resp.body = "not found\n";
+        }
+        return resp;
+    });
+    if (!server->start(host, port)) {
+        return false;
+    }
+    g_endpoint = std::move(server);
+    return true;
+}
+
+uint16_t http_endpoint_port() {
+    std::lock_guard<std::mutex> lock(g_endpoint_mutex);
+    return g_endpoint ? g_endpoint->port() : 0;
+}
+
+void stop_http_endpoint() {
+    std::unique_ptr<LocalHttpServer> server;
+    {
+        std::lock_guard<std::mutex> lock(g_endpoint_mutex);
+        server = std::move(g_endpoint);
+    }
+    if (server) server->stop();
+}
+
+} // namespace metrics
+} // namespace v2s
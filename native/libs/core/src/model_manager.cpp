@@ -1,15 +1,12 @@
 #include "video2srt_native/model_manager.hpp"
+#include "video2srt_native/metrics.hpp"
+#include "video2srt_native/http_client.hpp"
 #include <algorithm>
+#include <chrono>
 #include <fstream>
 #include <iostream>
 #include <sstream>
 
-#if defined(_WIN32)
-#include <windows.h>
-#include <winhttp.h>
-#pragma comment(lib, "winhttp.lib")
-#endif
-
 namespace v2s {
 
 std::filesystem::path ModelManager::s_model_dir = std::filesystem::current_path() / "models";
@@ -86,6 +83,17 @@ std::vector<ModelInfo> ModelManager::list_models() {
     return infos;
 }
 
+// 模型下载指标：按结果计数、累计下载字节数
+static void record_download_result(bool success) {
+    metrics::counter("v2s_model_downloads_total", "Model download attempts",
+                     {{"result", success ? "success" : "failure"}}).inc();
+}
+
+static metrics::Counter& download_bytes_counter() {
+    static metrics::Counter& c = metrics::counter("v2s_model_download_bytes_total", "Bytes downloaded for model files");
+    return c;
+}
+
 bool ModelManager::download_model(const std::string& size, DownloadProgress progress_cb) {
     std::filesystem::create_directories(get_model_dir());
     auto path = get_model_file_path(size);
@@ -100,181 +108,70 @@ bool ModelManager::download_model(const std::string& size, DownloadProgress prog
         std::string("https://hf-mirror.com/ggerganov/whisper.cpp/resolve/main/") + build_model_filename(size)
     };
 
-#if defined(_WIN32)
-    auto parse_https_url = [](const std::wstring& wurl, std::wstring& hostOut, std::wstring& pathOut) -> bool {
-        const std::wstring prefix = L"https://";
-        if (wurl.compare(0, prefix.size(), prefix) != 0) return false;
-        size_t pos = wurl.find(L'/', prefix.size());
-        if (pos == std::wstring::npos) {
-            hostOut = wurl.substr(prefix.size());
-            pathOut = L"/";
-        } else {
-            hostOut = wurl.substr(prefix.size(), pos - prefix.size());
-            pathOut = wurl.substr(pos);
-        }
-        return !hostOut.empty();
-    };
-
-    HINTERNET hSession = WinHttpOpen(L"Video2SRT-Native/ModelManager",
-                                     WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                                     WINHTTP_NO_PROXY_NAME,
-                                     WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) return false;
+    if (!HttpClient::available()) {
+        (void)progress_cb;
+        record_download_result(false);
+        std::cerr << "当前构建未包含 HTTP 支持（需要 WinHTTP 或 libcurl），无法下载模型\n";
+        return false;
+    }
 
-    // 设置超时
-    WinHttpSetTimeouts(hSession, 30000, 30000, 30000, 30000); // 30s 连接/发送/接收/解析
+    // 与翻译器共用 HttpClient：连接/TLS 会话复用，重定向（HF -> CDN）由客户端自动跟随
+    HttpRetryPolicy policy;
+    policy.max_retries = 1;
+    policy.backoff = std::chrono::milliseconds(1000);
 
-    const int kMaxRedirect = 5;
     bool success = false;
-    size_t totalBytes = 0;
+    const std::string model_name = normalize_size(size);
 
     for (size_t i = 0; i < candidate_urls.size() && !success; ++i) {
         const std::string& url = candidate_urls[i];
-        std::wstring initialUrl(url.begin(), url.end());
-        std::wstring host, wpath;
-        if (!parse_https_url(initialUrl, host, wpath)) {
-            std::cerr << "模型下载 URL 解析失败: " << url << std::endl;
-            continue;
-        }
-
-        std::cerr << "[ModelManager] 尝试下载地址 (" << (i+1) << "/" << candidate_urls.size() << "): " << url << std::endl;
-
-        // 每个地址单独写入，失败则清理零字节文件
-        std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
-        if (!ofs.is_open()) {
-            std::cerr << "[ModelManager] 打开输出文件失败: " << path.string() << std::endl;
-            continue;
-        }
-
-        int redirectCount = 0;
-        size_t downloaded = 0;
-
-        while (redirectCount <= kMaxRedirect) {
-            std::cerr << "[ModelManager] 请求: https://" << std::string(host.begin(), host.end())
-                      << std::string(wpath.begin(), wpath.end()) << std::endl;
-
-            HINTERNET hConnect = WinHttpConnect(hSession, host.c_str(), INTERNET_DEFAULT_HTTPS_PORT, 0);
-            if (!hConnect) {
-                std::cerr << "[ModelManager] WinHttpConnect 失败, 错误码: " << GetLastError() << std::endl;
-                break;
-            }
-
-            HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"GET", wpath.c_str(),
-                                                    NULL, WINHTTP_NO_REFERER,
-                                                    WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                                    WINHTTP_FLAG_SECURE);
-            if (!hRequest) { 
-                std::cerr << "[ModelManager] WinHttpOpenRequest 失败, 错误码: " << GetLastError() << std::endl;
-                WinHttpCloseHandle(hConnect);
-                break; 
+        std::chrono::milliseconds delay{0};
+        for (int attempt = 0; attempt <= policy.max_retries && !success; ++attempt) {
+            std::cerr << "[ModelManager] 尝试下载地址 (" << (i+1) << "/" << candidate_urls.size() << "): " << url << std::endl;
+
+            // 每次尝试单独写入，失败则清理残留文件
+            std::ofstream ofs(path, std::ios::binary | std::ios::trunc);
+            if (!ofs.is_open()) {
+                std::cerr << "[ModelManager] 打开输出文件失败: " << path.string() << std::endl;
+                record_download_result(false);
+                return false;
             }
 
-            // 限制协议为 TLS1.2，避免旧系统默认不启用导致握手失败
-            DWORD secureProtocols = WINHTTP_FLAG_SECURE_PROTOCOL_TLS1_2;
-            WinHttpSetOption(hRequest, WINHTTP_OPTION_SECURE_PROTOCOLS, &secureProtocols, sizeof(secureProtocols));
-
-            if (!WinHttpSendRequest(hRequest, WINHTTP_NO_ADDITIONAL_HEADERS, 0,
-                                    WINHTTP_NO_REQUEST_DATA, 0, 0, 0)) {
-                std::cerr << "[ModelManager] WinHttpSendRequest 失败, 错误码: " << GetLastError() << std::endl;
-                WinHttpCloseHandle(hRequest); WinHttpCloseHandle(hConnect);
-                break; // 尝试下一个地址
-            }
-            if (!WinHttpReceiveResponse(hRequest, NULL)) {
-                std::cerr << "[ModelManager] WinHttpReceiveResponse 失败, 错误码: " << GetLastError() << std::endl;
-                WinHttpCloseHandle(hRequest); WinHttpCloseHandle(hConnect);
-                break; // 尝试下一个地址
+            HttpRequest req;
+            req.url = url;
+            req.timeout_seconds = 0;           // 大文件不限总时长，仅在长时间无数据时中止
+            req.connect_timeout_seconds = 30;
+            req.max_redirects = 5;
+            req.on_data = [&](const char* data, size_t n) {
+                ofs.write(data, static_cast<std::streamsize>(n));
+                download_bytes_counter().inc(static_cast<double>(n));
+                return static_cast<bool>(ofs);
+            };
+            if (progress_cb) {
+                req.on_progress = [&](uint64_t received, uint64_t total) {
+                    progress_cb(model_name, static_cast<size_t>(received), static_cast<size_t>(total));
+                };
             }
 
-            // 检查状态码
-            DWORD statusCode = 0; DWORD scSize = sizeof(statusCode);
-            if (!WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-                                     WINHTTP_HEADER_NAME_BY_INDEX, &statusCode, &scSize, WINHTTP_NO_HEADER_INDEX)) {
-                std::cerr << "[ModelManager] 查询状态码失败, 错误码: " << GetLastError() << std::endl;
-                statusCode = 0;
+            HttpResponse resp = HttpClient::shared().send(req);
+            ofs.close();
+            std::cerr << "[ModelManager] 响应状态码: " << resp.status;
+            if (!resp.error.empty()) std::cerr << " (" << resp.error << ")";
+            std::cerr << std::endl;
+
+            success = resp.ok() && std::filesystem::exists(path) && std::filesystem::file_size(path) > 0;
+            if (!success) {
+                // 失败时删除不完整文件（含 404 等错误页）
+                try { if (std::filesystem::exists(path)) std::filesystem::remove(path); } catch (...) {}
+                if (!HttpRetryPolicy::is_retryable(resp) || attempt >= policy.max_retries) break;
+                delay = policy.next_delay(delay, resp);
+                req.cancel.wait_for(delay);
             }
-
-            std::cerr << "[ModelManager] 响应状态码: " << statusCode << std::endl;
-            if (statusCode >= 300 && statusCode < 400) {
-                // 重定向：读取 Location，解析新 host/path
-                DWORD locSize = 0;
-                WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_LOCATION, WINHTTP_HEADER_NAME_BY_INDEX,
-                                    NULL, &locSize, WINHTTP_NO_HEADER_INDEX);
-                if (GetLastError() == ERROR_INSUFFICIENT_BUFFER && locSize > 0) {
-                    std::wstring location; location.resize(locSize / sizeof(wchar_t));
-                    if (WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_LOCATION, WINHTTP_HEADER_NAME_BY_INDEX,
-                                            location.data(), &locSize, WINHTTP_NO_HEADER_INDEX)) {
-                        // 去掉可能的尾部空字符
-                        if (!location.empty() && location.back() == L'\0') location.pop_back();
-                        std::wstring newHost, newPath;
-                        if (parse_https_url(location, newHost, newPath)) {
-                            std::cerr << "[ModelManager] 重定向至: https://" << std::string(newHost.begin(), newHost.end())
-                                      << std::string(newPath.begin(), newPath.end()) << std::endl;
-                            host = std::move(newHost);
-                            wpath = std::move(newPath);
-                            redirectCount++;
-                            WinHttpCloseHandle(hRequest);
-                            WinHttpCloseHandle(hConnect);
-                            continue; // 重新发起请求
-                        }
-                        std::cerr << "[ModelManager] Location 非 https URL 或解析失败" << std::endl;
-                    }
-                }
-                // 未能处理重定向，视为失败，尝试下一个地址
-                WinHttpCloseHandle(hRequest);
-                WinHttpCloseHandle(hConnect);
-                break;
-            }
-
-            // 读取 Content-Length（可能为 0 或缺失）
-            DWORD dwSize = sizeof(DWORD);
-            DWORD dwIndex = 0;
-            DWORD content_length = 0;
-            WinHttpQueryHeaders(hRequest, WINHTTP_QUERY_CONTENT_LENGTH | WINHTTP_QUERY_FLAG_NUMBER,
-                                WINHTTP_HEADER_NAME_BY_INDEX, &content_length, &dwSize, &dwIndex);
-            totalBytes = static_cast<size_t>(content_length);
-
-            // 当无法获取总大小时，使用不确定进度
-            std::string buffer;
-            buffer.resize(1 << 16); // 64KB
-
-            bool readOk = false;
-            for (;;) {
-                DWORD avail = 0;
-                if (!WinHttpQueryDataAvailable(hRequest, &avail)) { readOk = false; break; }
-                if (avail == 0) { readOk = true; break; }
-                DWORD read = 0;
-                if (!WinHttpReadData(hRequest, buffer.data(), std::min<DWORD>(avail, (DWORD)buffer.size()), &read)) { readOk = false; break; }
-                if (read == 0) { readOk = true; break; }
-                ofs.write(buffer.data(), read);
-                downloaded += read;
-                if (progress_cb) {
-                    progress_cb(normalize_size(size), downloaded, totalBytes);
-                }
-            }
-
-            WinHttpCloseHandle(hRequest);
-            WinHttpCloseHandle(hConnect);
-
-            success = readOk && (std::filesystem::exists(path) && std::filesystem::file_size(path) > 0);
-            break; // 已完成读取或失败，退出重定向循环
-        }
-
-        ofs.close();
-
-        if (!success) {
-            // 失败时删除空文件
-            try { if (std::filesystem::exists(path) && std::filesystem::file_size(path) == 0) std::filesystem::remove(path); } catch (...) {}
         }
     }
 
-    WinHttpCloseHandle(hSession);
-
+    record_download_result(success);
     return success;
-#else
-    (void)progress_cb;
-    std::cerr << "当前平台未实现模型下载（仅Windows WinHTTP提供内置实现）\n";
-    return false;
-#endif
 }
 
 bool ModelManager::delete_model(const std::string& size) {
@@ -1,29 +1,31 @@
 // Cross-platform OpenAI translator implementation
-// - Windows: WinHTTP
-// - Non-Windows: libcurl (if available)
+// HTTP goes through the shared pooled HttpClient (WinHTTP on Windows, libcurl elsewhere)
 
 #include "video2srt_native/openai_translator.hpp"
 #include "video2srt_native/models.hpp"
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/metrics.hpp"
+#include "video2srt_native/probes.hpp"
+#include "video2srt_native/executor.hpp"
+#include "video2srt_native/http_client.hpp"
+#include "video2srt_native/token_estimator.hpp"
+#include "video2srt_native/stream_parser.hpp"
+#include "video2srt_native/batch_wire_format.hpp"
+#include "video2srt_native/translation_broker.hpp"
 #include <string>
 #include <vector>
-#include <optional>
 #include <sstream>
 #include <algorithm>
 #include <chrono>
-#include <thread>
+#include <cmath>
+#include <filesystem>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <mutex>
 
 #include <nlohmann/json.hpp>
 
-#ifdef _WIN32
-#include <windows.h>
-#include <winhttp.h>
-#pragma comment(lib, "winhttp.lib")
-#endif
-
-#ifdef V2S_HAVE_LIBCURL
-#include <curl/curl.h>
-#endif
-
 namespace v2s {
 
 namespace {
@@ -54,6 +56,10 @@ static std::string strip_code_fences(const std::string& content) {
     return trim(c);
 }
 
+// Bump whenever either system prompt or the batch wire format changes so that
+// persistent cache entries produced by the old prompt are not reused.
+constexpr const char* kPromptVersion = "2";
+
 // Build the chat completion request body for single-text translation
 static std::string build_chat_body_single(const TranslatorOptions& opts,
                                           const std::string& text,
@@ -72,24 +78,76 @@ static std::string build_chat_body_single(const TranslatorOptions& opts,
         nlohmann::json{{"role","system"},{"content",system_prompt}},
         nlohmann::json{{"role","user"},{"content",text}}
     });
-    return j.dump();
+    // Invalid UTF-8 is replaced with U+FFFD instead of throwing: the exception would
+    // be retried like a transport error although every attempt fails the same way
+    return j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
 }
 
-// Build the chat completion request body for batch translation
-static std::string build_chat_body_batch(const TranslatorOptions& opts,
-                                         const std::vector<std::string>& texts,
-                                         const std::string& target_lang,
-                                         const std::string& source_lang) {
-    std::string system_prompt = "You are a professional translator. Translate the provided array of text segments";
-    if (!source_lang.empty()) system_prompt += " from " + source_lang;
-    if (!target_lang.empty()) system_prompt += " to " + target_lang;
-    system_prompt += ". Return ONLY a compact JSON object with a single key 'translations' whose value is an array of strings of the same length and order as the input. Do not include any extra words, explanations, or keys.";
+// Compact numbered lines (v2s-lines/1) unless the JSON wire format is requested
+static bool use_lines_format(const TranslatorOptions& opts) {
+    return opts.batch_format != "json";
+}
+
+// Batch system prompts start with a fixed instruction block and end with the language pair,
+// so the leading bytes are identical across requests and can be served from the provider's prompt cache.
+static const std::string& batch_instructions(bool lines) {
+    static const std::string kLines = std::string("Translate subtitles (") + kLinesWireFormatVersion +
+        "). Each line is N|text, <br> = line break. Reply N|translation per line, same N, nothing else.\n";
+    static const std::string kJson = "Translate subtitles. Input: a JSON array of strings.\n";
+    return lines ? kLines : kJson;
+}
 
-    nlohmann::json texts_json = nlohmann::json::array();
-    for (const auto& t : texts) {
-        texts_json.push_back(t);
+// Language pair suffix shared by both wire formats
+static std::string language_suffix(const std::string& source_lang, const std::string& targets) {
+    std::string suffix;
+    if (!source_lang.empty()) suffix += "Source: " + source_lang + ". ";
+    suffix += "Target: " + targets + ".";
+    return suffix;
+}
+
+// System prompt for batch translation (also counted against the batch token budget)
+static std::string batch_system_prompt(const TranslatorOptions& opts, const std::string& target_lang, const std::string& source_lang) {
+    const bool lines = use_lines_format(opts);
+    std::string system_prompt = batch_instructions(lines);
+    if (!lines) system_prompt += "Reply ONLY with {\"translations\": [...]}, same length and order.\n";
+    return system_prompt + language_suffix(source_lang, target_lang);
+}
+
+// Multi-target variant: one section (lines) or one object key (JSON) per target language
+static std::string multi_batch_system_prompt(const TranslatorOptions& opts,
+                                             const std::vector<std::string>& target_langs,
+                                             const std::string& source_lang) {
+    const bool lines = use_lines_format(opts);
+    std::string langs;
+    for (const auto& t : target_langs) {
+        if (!langs.empty()) langs += ", ";
+        langs += t;
+    }
+    std::string system_prompt = batch_instructions(lines);
+    if (lines) {
+        system_prompt += "Start each target language with a line @language, in the order given.\n";
+    } else {
+        system_prompt += "Reply ONLY with {\"<language>\": [...], ...}, one key per target, same length and order.\n";
+    }
+    return system_prompt + language_suffix(source_lang, langs);
+}
+
+// Build the chat completion request body for a batch of texts (numbered lines or a JSON array)
+static std::string build_chat_body_texts(const TranslatorOptions& opts,
+                                         const std::vector<std::string>& texts,
+                                         const std::string& system_prompt,
+                                         bool stream) {
+    const bool lines = use_lines_format(opts);
+    std::string user_content;
+    if (lines) {
+        user_content = encode_numbered_lines(texts);
+    } else {
+        nlohmann::json texts_json = nlohmann::json::array();
+        for (const auto& t : texts) {
+            texts_json.push_back(t);
+        }
+        user_content = texts_json.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
     }
-    std::string user_content = texts_json.dump();
 
     nlohmann::json j;
     j["model"] = opts.model.empty() ? "gpt-4o-mini" : opts.model;
@@ -99,339 +157,1042 @@ static std::string build_chat_body_batch(const TranslatorOptions& opts,
         nlohmann::json{{"role","system"},{"content",system_prompt}},
         nlohmann::json{{"role","user"},{"content",user_content}}
     });
-    if (opts.structured_json_output) {
+    if (!lines && opts.structured_json_output) {
         // Hint to return valid JSON (OpenAI supports response_format JSON for some models)
         j["response_format"] = nlohmann::json{{"type","json_object"}};
     }
-    return j.dump();
+    if (stream) {
+        j["stream"] = true;
+        // Ask for a final chunk carrying usage (ignored by servers without stream_options)
+        j["stream_options"] = nlohmann::json{{"include_usage", true}};
+    }
+    return j.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace);
 }
 
-#ifdef _WIN32
-struct ParsedUrl {
-    bool secure = true;
-    std::wstring host;
-    INTERNET_PORT port = 443;
-    std::wstring path;
-};
+// Build the chat completion request body for batch translation
+static std::string build_chat_body_batch(const TranslatorOptions& opts,
+                                         const std::vector<std::string>& texts,
+                                         const std::string& target_lang,
+                                         const std::string& source_lang) {
+    return build_chat_body_texts(opts, texts, batch_system_prompt(opts, target_lang, source_lang), opts.stream);
+}
 
-static ParsedUrl parse_url_w(const std::string& url) {
-    ParsedUrl out;
-    // very simple parse
-    std::string u = url;
-    if (u.rfind("https://", 0) == 0) {
-        out.secure = true;
-        u = u.substr(8);
-        out.port = 443;
-    } else if (u.rfind("http://", 0) == 0) {
-        out.secure = false;
-        u = u.substr(7);
-        out.port = 80;
-    }
-    size_t slash = u.find('/');
-    std::string host = (slash == std::string::npos) ? u : u.substr(0, slash);
-    std::string path = (slash == std::string::npos) ? "/" : u.substr(slash);
-    size_t colon = host.find(':');
-    if (colon != std::string::npos) {
-        out.port = static_cast<INTERNET_PORT>(std::stoi(host.substr(colon+1)));
-        host = host.substr(0, colon);
-    }
-    out.host = std::wstring(host.begin(), host.end());
-    out.path = std::wstring(path.begin(), path.end());
-    return out;
+// usage.prompt_tokens / completion_tokens / prompt_tokens_details.cached_tokens (absent -> all zero)
+static TokenUsage parse_usage(const nlohmann::json& j) {
+    TokenUsage usage;
+    if (!j.contains("usage") || !j["usage"].is_object()) return usage;
+    const auto& u = j["usage"];
+    auto count = [](const nlohmann::json& obj, const char* key) -> size_t {
+        return obj.contains(key) && obj[key].is_number_unsigned() ? obj[key].get<size_t>() : 0;
+    };
+    usage.prompt_tokens = count(u, "prompt_tokens");
+    usage.completion_tokens = count(u, "completion_tokens");
+    if (u.contains("prompt_tokens_details") && u["prompt_tokens_details"].is_object()) {
+        usage.cached_prompt_tokens = count(u["prompt_tokens_details"], "cached_tokens");
+    }
+    usage.requests_with_usage = 1;
+    return usage;
 }
 
-static std::optional<std::string> http_post_winhttp(const std::string& url,
-                                                    const std::string& body,
-                                                    const std::vector<std::pair<std::string,std::string>>& headers,
-                                                    int timeout_seconds,
-                                                    bool ssl_bypass) {
-    auto pu = parse_url_w(url);
-    HINTERNET hSession = WinHttpOpen(L"Video2SRT/1.0",
-                                     WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
-                                     WINHTTP_NO_PROXY_NAME,
-                                     WINHTTP_NO_PROXY_BYPASS, 0);
-    if (!hSession) return std::nullopt;
-
-    // timeouts
-    DWORD t = static_cast<DWORD>(timeout_seconds * 1000);
-    WinHttpSetTimeouts(hSession, t, t, t, t);
-
-    HINTERNET hConnect = WinHttpConnect(hSession, pu.host.c_str(), pu.port, 0);
-    if (!hConnect) { WinHttpCloseHandle(hSession); return std::nullopt; }
-
-    HINTERNET hRequest = WinHttpOpenRequest(hConnect, L"POST", pu.path.c_str(),
-                                            NULL, WINHTTP_NO_REFERER,
-                                            WINHTTP_DEFAULT_ACCEPT_TYPES,
-                                            pu.secure ? WINHTTP_FLAG_SECURE : 0);
-    if (!hRequest) {
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return std::nullopt;
-    }
-
-    if (ssl_bypass) {
-        DWORD flags = SECURITY_FLAG_IGNORE_UNKNOWN_CA |
-                      SECURITY_FLAG_IGNORE_CERT_CN_INVALID |
-                      SECURITY_FLAG_IGNORE_CERT_DATE_INVALID |
-                      SECURITY_FLAG_IGNORE_CERT_WRONG_USAGE;
-        WinHttpSetOption(hRequest, WINHTTP_OPTION_SECURITY_FLAGS, &flags, sizeof(flags));
-    }
-
-    std::wstring hdrs;
-    for (const auto& kv : headers) {
-        std::wstring k(kv.first.begin(), kv.first.end());
-        std::wstring v(kv.second.begin(), kv.second.end());
-        hdrs += k + L": " + v + L"\r\n";
-    }
-
-    BOOL sent = WinHttpSendRequest(hRequest,
-                                   hdrs.c_str(), (DWORD)hdrs.size(),
-                                   (LPVOID)body.data(), (DWORD)body.size(), (DWORD)body.size(), 0);
-    if (!sent) {
-        WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return std::nullopt;
-    }
-
-    BOOL res = WinHttpReceiveResponse(hRequest, NULL);
-    if (!res) {
-        WinHttpCloseHandle(hRequest);
-        WinHttpCloseHandle(hConnect);
-        WinHttpCloseHandle(hSession);
-        return std::nullopt;
-    }
-
-    std::string response;
-    DWORD dwSize = 0;
-    do {
-        dwSize = 0;
-        if (!WinHttpQueryDataAvailable(hRequest, &dwSize)) break;
-        if (dwSize == 0) break;
-        std::string buf;
-        buf.resize(dwSize);
-        DWORD dwDownloaded = 0;
-        if (!WinHttpReadData(hRequest, &buf[0], dwSize, &dwDownloaded)) break;
-        response.append(buf.data(), dwDownloaded);
-    } while (dwSize > 0);
-
-    WinHttpCloseHandle(hRequest);
-    WinHttpCloseHandle(hConnect);
-    WinHttpCloseHandle(hSession);
-    return response.empty() ? std::nullopt : std::optional<std::string>(response);
-}
-#endif // _WIN32
-
-#ifdef V2S_HAVE_LIBCURL
-static size_t curl_write_cb(char* ptr, size_t size, size_t nmemb, void* userdata) {
-    auto* out = reinterpret_cast<std::string*>(userdata);
-    out->append(ptr, size * nmemb);
-    return size * nmemb;
-}
-
-static std::optional<std::string> http_post_curl(const std::string& url,
-                                                 const std::string& body,
-                                                 const std::vector<std::pair<std::string,std::string>>& headers,
-                                                 int timeout_seconds,
-                                                 bool ssl_bypass) {
-    CURL* curl = curl_easy_init();
-    if (!curl) return std::nullopt;
-    std::string response;
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, body.c_str());
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, curl_write_cb);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_TIMEOUT, timeout_seconds);
-    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, timeout_seconds);
-    if (ssl_bypass) {
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-    }
-    struct curl_slist* hdr = nullptr;
-    for (const auto& kv : headers) {
-        std::string h = kv.first + ": " + kv.second;
-        hdr = curl_slist_append(hdr, h.c_str());
-    }
-    if (hdr) curl_easy_setopt(curl, CURLOPT_HTTPHEADER, hdr);
-    CURLcode rc = curl_easy_perform(curl);
-    long http_code = 0;
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    if (hdr) curl_slist_free_all(hdr);
-    curl_easy_cleanup(curl);
-    if (rc != CURLE_OK) return std::nullopt;
-    if (http_code < 200 || http_code >= 300) return std::nullopt;
-    return response.empty() ? std::nullopt : std::optional<std::string>(response);
-}
-#endif // V2S_HAVE_LIBCURL
-
-static std::optional<std::string> http_post_any(const std::string& url,
-                                                const std::string& body,
-                                                const std::vector<std::pair<std::string,std::string>>& headers,
-                                                int timeout_seconds,
-                                                bool ssl_bypass) {
-#ifdef _WIN32
-    return http_post_winhttp(url, body, headers, timeout_seconds, ssl_bypass);
-#elif defined(V2S_HAVE_LIBCURL)
-    return http_post_curl(url, body, headers, timeout_seconds, ssl_bypass);
-#else
-    (void)url; (void)body; (void)headers; (void)timeout_seconds; (void)ssl_bypass;
-    return std::nullopt;
-#endif
+// Extract choices[0].message.content / finish_reason (and usage) from a non-streamed completion
+static bool parse_completion_envelope(const std::string& body, std::string& content, bool& finished_by_length,
+                                      TokenUsage& usage) {
+    try {
+        auto j = nlohmann::json::parse(body);
+        usage = parse_usage(j);
+        if (j.contains("choices") && j["choices"].is_array() && !j["choices"].empty()) {
+            const auto& choice = j["choices"][0];
+            const auto& msg = choice["message"]["content"];
+            if (msg.is_string()) content = msg.get<std::string>();
+            finished_by_length = choice.value("finish_reason", std::string()) == "length";
+            return true;
+        }
+    } catch (...) {
+    }
+    return false;
 }
 
-} // namespace
+// 进程级指标（所有 OpenAITranslator 实例共享）
+struct OpenAIMetrics {
+    metrics::Counter& requests;
+    metrics::Counter& failures;
+    metrics::Counter& retries;
+    metrics::Histogram& latency;
+    metrics::Counter& prompt_tokens;
+    metrics::Counter& cached_prompt_tokens;
+    metrics::Counter& completion_tokens;
+    metrics::Counter& wasted_tokens;
+};
 
-OpenAITranslator::OpenAITranslator(const TranslatorOptions& opts) : opts_(opts) {}
+OpenAIMetrics& openai_metrics() {
+    static const metrics::Labels labels = {{"translator", "openai"}};
+    static OpenAIMetrics m{
+        metrics::counter("v2s_translator_requests_total", "Translator HTTP requests sent", labels),
+        metrics::counter("v2s_translator_request_failures_total", "Translator requests that failed or returned unusable content", labels),
+        metrics::counter("v2s_translator_retries_total", "Translator request retries", labels),
+        metrics::histogram("v2s_http_request_duration_seconds", "Translator HTTP request latency",
+                           metrics::latency_buckets_seconds(), labels),
+        metrics::counter("v2s_translator_tokens_total", "Tokens reported by the translation API",
+                         {{"translator", "openai"}, {"type", "prompt"}}),
+        metrics::counter("v2s_translator_tokens_total", "Tokens reported by the translation API",
+                         {{"translator", "openai"}, {"type", "cached_prompt"}}),
+        metrics::counter("v2s_translator_tokens_total", "Tokens reported by the translation API",
+                         {{"translator", "openai"}, {"type", "completion"}}),
+        metrics::counter("v2s_translator_tokens_total", "Tokens reported by the translation API",
+                         {{"translator", "openai"}, {"type", "wasted"}})
+    };
+    return m;
+}
+
+} // namespace
 
 static std::string default_base_url() {
     return "https://api.openai.com/v1/chat/completions";
 }
 
-// Single-text translation with retries and JSON parsing
-std::string OpenAITranslator::translate_text(const std::string& text,
-                                             const std::string& target_language,
-                                             const std::string& source_language) {
-    const std::string url = opts_.base_url.empty() ? default_base_url() : opts_.base_url;
-    const std::string body = build_chat_body_single(opts_, text, target_language, source_language);
-    std::vector<std::pair<std::string,std::string>> headers = {
+OpenAITranslator::OpenAITranslator(const TranslatorOptions& opts) : opts_(opts) {
+    limiter_ = EndpointLimiter::for_url(opts_.base_url.empty() ? default_base_url() : opts_.base_url);
+    limiter_config_ = limiter_->configure(opts_.rate_limit_rps, opts_.rate_limit_burst, std::max(1, opts_.max_concurrency));
+    if (!opts_.usage_log_path.empty()) usage_log_ = UsageLog::open(opts_.usage_log_path);
+}
+
+void OpenAITranslator::record_request(CallState& state, double ms) {
+    {
+        std::lock_guard<std::mutex> lock(state.stats_mutex);
+        state.stats.request_count++;
+        state.stats.request_latencies_ms.push_back(ms);
+    }
+    openai_metrics().requests.inc();
+    openai_metrics().latency.observe(ms / 1000.0);
+}
+
+void OpenAITranslator::account_request(CallState& state, const RequestAccounting& acct, const HttpRequest& req,
+                                       const HttpResponse& resp, TokenUsage usage) {
+    if (usage.requests_with_usage > 0 && acct.items > 0 && acct.unusable_items > 0) {
+        const size_t unusable = std::min(acct.unusable_items, acct.items);
+        usage.wasted_tokens = static_cast<size_t>(
+            std::llround(static_cast<double>(usage.total_tokens()) * static_cast<double>(unusable) / static_cast<double>(acct.items)));
+    }
+    {
+        std::lock_guard<std::mutex> lock(state.stats_mutex);
+        if (acct.attempt > 0) state.stats.retries++;
+        state.stats.usage += usage;
+    }
+    auto& m = openai_metrics();
+    m.prompt_tokens.inc(static_cast<double>(usage.prompt_tokens));
+    m.cached_prompt_tokens.inc(static_cast<double>(usage.cached_prompt_tokens));
+    m.completion_tokens.inc(static_cast<double>(usage.completion_tokens));
+    m.wasted_tokens.inc(static_cast<double>(usage.wasted_tokens));
+
+    if (!usage_log_) return;
+    const auto now_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+    nlohmann::json line{
+        {"ts_ms", now_ms},
+        {"tag", opts_.usage_tag},
+        {"translator", "openai"},
+        {"model", opts_.model.empty() ? "gpt-4o-mini" : opts_.model},
+        {"kind", acct.kind},
+        {"source", acct.source ? *acct.source : std::string()},
+        {"targets", acct.targets},
+        {"items", acct.items},
+        {"unusable_items", acct.unusable_items},
+        {"attempt", acct.attempt},
+        {"status", resp.status},
+        {"latency_ms", resp.elapsed_ms},
+        {"request_bytes", req.body.size()},
+        {"usage_reported", usage.requests_with_usage > 0},
+        {"prompt_tokens", usage.prompt_tokens},
+        {"cached_prompt_tokens", usage.cached_prompt_tokens},
+        {"completion_tokens", usage.completion_tokens},
+        {"wasted_tokens", usage.wasted_tokens},
+        {"outcome", acct.outcome}
+    };
+    usage_log_->append(line.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace));
+}
+
+HttpRequest OpenAITranslator::build_request(const CallState& state, std::string body) const {
+    HttpRequest req;
+    req.method = "POST";
+    req.url = opts_.base_url.empty() ? default_base_url() : opts_.base_url;
+    req.headers = {
         {"Content-Type","application/json"},
         {"Authorization","Bearer " + opts_.api_key}
     };
+    req.body = std::move(body);
+    req.timeout_seconds = opts_.timeout_seconds;
+    req.ssl_bypass = opts_.ssl_bypass;
+    req.cancel = state.cancel;
+    return req;
+}
 
-    for (int attempt = 0; attempt <= std::max(0, opts_.retry_count); ++attempt) {
-        auto resp = http_post_any(url, body, headers, opts_.timeout_seconds, opts_.ssl_bypass);
-        if (resp) {
+HttpResponse OpenAITranslator::send_limited(CallState& state, const HttpRequest& req) {
+    EndpointLimiter::Permit permit = limiter_->acquire(state.cancel);
+    if (!permit.valid()) {
+        HttpResponse resp;
+        resp.cancelled = true;
+        resp.error = cancellation_message(state.cancel.reason());
+        return resp;
+    }
+    HttpResponse resp = HttpClient::shared().send(req);
+    limiter_->on_response(resp);
+    record_request(state, resp.elapsed_ms);
+    return resp;
+}
+
+HttpRetryPolicy OpenAITranslator::retry_policy() const {
+    HttpRetryPolicy policy;
+    policy.max_retries = std::max(0, opts_.retry_count);
+    policy.backoff = std::chrono::milliseconds(500);
+    return policy;
+}
+
+// Cache identity: model + prompt version (base_url is deliberately excluded so gateways share entries)
+std::string OpenAITranslator::cache_namespace() const {
+    return std::string("openai/") + (opts_.model.empty() ? "gpt-4o-mini" : opts_.model) + "/p" + kPromptVersion;
+}
+
+// Single-text translation with retries and JSON parsing
+std::optional<std::string> OpenAITranslator::translate_text(CallState& state,
+                                                            const std::string& text,
+                                                            const std::string& target_language,
+                                                            const std::string& source_language) {
+    V2S_TRACE_SPAN("OpenAITranslator::translate_text", "translate");
+    const HttpRequest req = build_request(state, build_chat_body_single(opts_, text, target_language, source_language));
+    const HttpRetryPolicy policy = retry_policy();
+    std::chrono::milliseconds delay{0};
+
+    for (int attempt = 0; attempt <= policy.max_retries; ++attempt) {
+        if (state.cancel.is_cancelled()) break;
+        V2S_PROBE3(translator_request, "openai", attempt, req.body.size());
+        const HttpResponse resp = send_limited(state, req);
+        V2S_PROBE4(translator_response, "openai", attempt, resp.ok() ? 1 : 0,
+                   static_cast<long long>(resp.elapsed_ms * 1000.0));
+        RequestAccounting acct;
+        acct.kind = "segment";
+        acct.targets = target_language;
+        acct.source = &source_language;
+        acct.items = 1;
+        acct.attempt = attempt;
+        TokenUsage usage;
+        if (resp.ok() && !resp.body.empty()) {
             try {
-                auto j = nlohmann::json::parse(*resp);
+                auto j = nlohmann::json::parse(resp.body);
+                usage = parse_usage(j);
                 if (j.contains("choices") && j["choices"].is_array() && !j["choices"].empty()) {
                     const auto& msg = j["choices"][0]["message"]["content"];
                     if (!msg.is_null()) {
-                        return trim(msg.get<std::string>());
+                        std::string content = trim(msg.get<std::string>());
+                        account_request(state, acct, req, resp, usage);
+                        return content;
                     }
                 }
             } catch (...) {
                 // fallthrough to retry
             }
         }
-        if (attempt < opts_.retry_count) {
-#ifdef _WIN32
-            Sleep(500);
-#else
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-#endif
+        acct.unusable_items = 1;
+        acct.outcome = resp.ok() ? "malformed_json" : "http_error";
+        account_request(state, acct, req, resp, usage);
+        {
+            std::lock_guard<std::mutex> lock(state.stats_mutex);
+            state.stats.failed_requests++;
+        }
+        openai_metrics().failures.inc();
+        // 401/400 等不可重试的错误直接回退原文
+        if (!resp.ok() && !HttpRetryPolicy::is_retryable(resp)) break;
+        if (attempt < policy.max_retries) {
+            openai_metrics().retries.inc();
+            V2S_PROBE2(translator_retry, "openai", attempt + 1);
+            delay = policy.next_delay(delay, resp);
+            if (state.cancel.wait_for(delay)) break;
         }
     }
-    // Fallback: return original text
-    return text;
+    // Caller falls back to the original text
+    return std::nullopt;
 }
 
-// Batch translation returning array of translated strings
-std::vector<std::string> OpenAITranslator::translate_texts_batch(const std::vector<std::string>& texts,
-                                                                 const std::string& target_language,
-                                                                 const std::string& source_language) {
-    const std::string url = opts_.base_url.empty() ? default_base_url() : opts_.base_url;
-    const std::string body = build_chat_body_batch(opts_, texts, target_language, source_language);
-    std::vector<std::pair<std::string,std::string>> headers = {
-        {"Content-Type","application/json"},
-        {"Authorization","Bearer " + opts_.api_key}
+// Why a batch response was not (fully) usable; also the metric label
+static const char* batch_failure_reason_name(OpenAITranslator::BatchFailure f) {
+    switch (f) {
+        case OpenAITranslator::BatchFailure::None: return "none";
+        case OpenAITranslator::BatchFailure::Http: return "http_error";
+        case OpenAITranslator::BatchFailure::MalformedJson: return "malformed_json";
+        case OpenAITranslator::BatchFailure::MissingTranslations: return "missing_translations";
+        case OpenAITranslator::BatchFailure::Truncated: return "truncated";
+        case OpenAITranslator::BatchFailure::ShortArray: return "short_array";
+        case OpenAITranslator::BatchFailure::LengthMismatch: return "length_mismatch";
+        case OpenAITranslator::BatchFailure::InvalidItem: return "invalid_item";
+    }
+    return "unknown";
+}
+
+namespace {
+
+// Read complete JSON string literals from a (possibly truncated) "translations" array.
+// Stops at the first element that is not a complete string.
+std::vector<std::string> salvage_string_prefix(const std::string& content) {
+    std::vector<std::string> out;
+    size_t pos = content.find("\"translations\"");
+    if (pos == std::string::npos) return out;
+    pos = content.find('[', pos);
+    if (pos == std::string::npos) return out;
+    ++pos;
+    while (pos < content.size()) {
+        const char c = content[pos];
+        if (c == ' ' || c == '\n' || c == '\r' || c == '\t' || c == ',') { ++pos; continue; }
+        if (c != '"') break;
+        size_t end = pos + 1;
+        bool closed = false;
+        while (end < content.size()) {
+            if (content[end] == '\\') { end += 2; continue; }
+            if (content[end] == '"') { closed = true; break; }
+            ++end;
+        }
+        if (!closed) break;
+        try {
+            out.push_back(nlohmann::json::parse(content.substr(pos, end - pos + 1)).get<std::string>());
+        } catch (...) {
+            break;
+        }
+        pos = end + 1;
+    }
+    return out;
+}
+
+// Fill items from a parsed "translations" value; returns the failure kind (None when all items are valid)
+OpenAITranslator::BatchFailure collect_batch_items(const nlohmann::json& translations,
+                                                   const std::vector<std::string>& texts,
+                                                   std::vector<std::optional<std::string>>& items) {
+    using BatchFailure = OpenAITranslator::BatchFailure;
+    const size_t n = texts.size();
+    BatchFailure failure = BatchFailure::None;
+    auto accept = [&](size_t i, const nlohmann::json& v) {
+        // Non-string or empty output for a non-empty input is treated as missing
+        if (!v.is_string() || (v.get_ref<const std::string&>().empty() && !trim(texts[i]).empty())) {
+            failure = BatchFailure::InvalidItem;
+            return;
+        }
+        items[i] = v.get<std::string>();
     };
+    if (!translations.is_array()) return BatchFailure::MissingTranslations;
+
+    if (!translations.empty() && translations[0].is_object()) {
+        // Indexed form: [{"index": 0, "text": "..."}, ...] (0-based)
+        for (const auto& obj : translations) {
+            const nlohmann::json* idx = nullptr;
+            const nlohmann::json* txt = nullptr;
+            if (obj.is_object()) {
+                for (const char* k : {"index", "id", "i"}) if (obj.contains(k)) { idx = &obj[k]; break; }
+                for (const char* k : {"text", "translation", "t"}) if (obj.contains(k)) { txt = &obj[k]; break; }
+            }
+            if (!idx || !txt || !idx->is_number_integer()) { failure = BatchFailure::InvalidItem; continue; }
+            const auto i = idx->get<long long>();
+            if (i < 0 || static_cast<size_t>(i) >= n) { failure = BatchFailure::InvalidItem; continue; }
+            accept(static_cast<size_t>(i), *txt);
+        }
+    } else if (translations.size() > n) {
+        // Positions cannot be trusted when the model split or invented lines
+        return BatchFailure::LengthMismatch;
+    } else {
+        // Positional form; a short array keeps its prefix
+        for (size_t i = 0; i < translations.size(); ++i) accept(i, translations[i]);
+        if (translations.size() < n && failure == BatchFailure::None) failure = BatchFailure::ShortArray;
+    }
+    if (failure == BatchFailure::None) {
+        for (const auto& item : items) {
+            if (!item) return BatchFailure::ShortArray;
+        }
+    }
+    return failure;
+}
+
+// JSON wire format: parse {"translations": [...]} and salvage the complete leading strings of a broken reply
+OpenAITranslator::BatchFailure collect_json_batch(const std::string& content, bool truncated,
+                                                  const std::vector<std::string>& texts,
+                                                  std::vector<std::optional<std::string>>& items) {
+    using BatchFailure = OpenAITranslator::BatchFailure;
+    try {
+        auto j = nlohmann::json::parse(content);
+        return j.is_object() && j.contains("translations")
+            ? collect_batch_items(j["translations"], texts, items)
+            : BatchFailure::MissingTranslations;
+    } catch (...) {
+        // Output cut off by max_tokens (or otherwise broken): keep the complete leading strings
+        auto prefix = salvage_string_prefix(content);
+        if (prefix.size() > texts.size()) prefix.clear();
+        for (size_t i = 0; i < prefix.size(); ++i) {
+            if (!prefix[i].empty() || trim(texts[i]).empty()) items[i] = std::move(prefix[i]);
+        }
+        return truncated ? BatchFailure::Truncated : BatchFailure::MalformedJson;
+    }
+}
+
+// Numbered-lines wire format: every well-formed line counts, whatever else the reply contains
+OpenAITranslator::BatchFailure collect_numbered_items(std::string_view content, bool truncated,
+                                                      const std::vector<std::string>& texts,
+                                                      std::vector<std::optional<std::string>>& items) {
+    using BatchFailure = OpenAITranslator::BatchFailure;
+    NumberedLines parsed = parse_numbered_lines(content, texts.size());
+    if (parsed.numbered_lines == 0) return truncated ? BatchFailure::Truncated : BatchFailure::MissingTranslations;
+    // The last line of a truncated reply may stop mid-sentence
+    if (truncated && parsed.last_index) parsed.items[*parsed.last_index].reset();
+    BatchFailure failure = BatchFailure::None;
+    for (size_t i = 0; i < texts.size(); ++i) {
+        if (!parsed.items[i]) continue;
+        if (parsed.items[i]->empty() && !trim(texts[i]).empty()) {
+            failure = BatchFailure::InvalidItem;
+            continue;
+        }
+        items[i] = std::move(parsed.items[i]);
+    }
+    if (failure == BatchFailure::None) {
+        for (const auto& item : items) {
+            if (!item) return truncated ? BatchFailure::Truncated : BatchFailure::ShortArray;
+        }
+    }
+    return failure;
+}
+
+} // namespace
 
-    for (int attempt = 0; attempt <= std::max(0, opts_.retry_count); ++attempt) {
-        auto resp = http_post_any(url, body, headers, opts_.timeout_seconds, opts_.ssl_bypass);
-        if (resp) {
+// Batch translation: one request (with transport retries), then salvage every usable item.
+// Content-level problems are not retried here; translate_batch_recovering re-requests the gaps.
+OpenAITranslator::BatchOutcome OpenAITranslator::translate_texts_batch(CallState& state,
+                                                                       const std::vector<std::string>& texts,
+                                                                       const std::string& target_language,
+                                                                       const std::string& source_language,
+                                                                       const SegmentCallback& on_item) {
+    V2S_TRACE_SPAN("OpenAITranslator::translate_texts_batch", "translate");
+    HttpRequest req = build_request(state, build_chat_body_batch(opts_, texts, target_language, source_language));
+    const bool lines = use_lines_format(opts_);
+    const HttpRetryPolicy policy = retry_policy();
+    std::chrono::milliseconds delay{0};
+
+    BatchOutcome outcome;
+    outcome.items.resize(texts.size());
+    outcome.failure = BatchFailure::Http;
+
+    for (int attempt = 0; attempt <= policy.max_retries; ++attempt) {
+        if (state.cancel.is_cancelled()) break;
+        std::string content;
+        bool finished_by_length = false;
+        TokenUsage usage;
+
+        // Streaming: decode SSE chunks on the fly and hand out each "translations" element as soon as it closes.
+        // Runs on the HTTP client's network thread, so the per-chunk work stays small.
+        std::string raw;   // body kept for servers that ignore "stream": true
+        auto emit = [&](size_t i, std::string value) {
+            if (on_item && i < texts.size() && (!value.empty() || trim(texts[i]).empty())) on_item(i, value);
+        };
+        JsonStringArrayStreamer json_streamer("translations", emit);
+        NumberedLinesStreamer lines_streamer(texts.size(), emit);
+        SseDecoder sse([&](const std::string&, const std::string& data) {
+            if (data == "[DONE]") return;
             try {
-                auto j = nlohmann::json::parse(*resp);
-                std::string content;
-                if (j.contains("choices") && j["choices"].is_array() && !j["choices"].empty()) {
-                    const auto& msg = j["choices"][0]["message"]["content"];
-                    if (!msg.is_null()) {
-                        content = msg.get<std::string>();
-                    }
+                auto j = nlohmann::json::parse(data);
+                // include_usage: the final chunk carries usage (and an empty choices array)
+                if (j.contains("usage") && j["usage"].is_object()) usage = parse_usage(j);
+                if (!j.contains("choices") || !j["choices"].is_array() || j["choices"].empty()) return;
+                const auto& choice = j["choices"][0];
+                if (choice.contains("delta") && choice["delta"].contains("content") && choice["delta"]["content"].is_string()) {
+                    const auto& delta = choice["delta"]["content"].get_ref<const std::string&>();
+                    content += delta;
+                    if (lines) lines_streamer.feed(delta);
+                    else json_streamer.feed(delta);
                 }
-                content = strip_code_fences(content);
-                auto j2 = nlohmann::json::parse(content);
-                std::vector<std::string> out;
-                if (j2.contains("translations") && j2["translations"].is_array()) {
-                    for (const auto& item : j2["translations"]) {
-                        out.push_back(item.get<std::string>());
-                    }
+                if (choice.contains("finish_reason") && choice["finish_reason"].is_string()) {
+                    finished_by_length = choice["finish_reason"].get<std::string>() == "length";
                 }
-                if (!out.empty()) return out;
             } catch (...) {
-                // fallthrough to retry
+                // Malformed event: ignored here, the assembled content is validated below
+            }
+        });
+        if (opts_.stream) {
+            req.on_data = [&](const char* data, size_t size) {
+                if (sse.event_count() == 0 && raw.size() < (1u << 20)) raw.append(data, size);
+                sse.feed(std::string_view(data, size));
+                return true;
+            };
+        }
+
+        V2S_PROBE3(translator_request, "openai", attempt, req.body.size());
+        const HttpResponse resp = send_limited(state, req);
+        V2S_PROBE4(translator_response, "openai", attempt, resp.ok() ? 1 : 0,
+                   static_cast<long long>(resp.elapsed_ms * 1000.0));
+        outcome.status = resp.status;
+        outcome.latency_ms = resp.elapsed_ms;
+        outcome.timed_out = resp.timed_out;
+        RequestAccounting acct;
+        acct.kind = "batch";
+        acct.targets = target_language;
+        acct.source = &source_language;
+        acct.items = texts.size();
+        acct.attempt = attempt;
+        if (opts_.stream) {
+            sse.finish();
+            if (resp.ok() && sse.event_count() == 0) {
+                // Plain JSON completion despite "stream": true
+                parse_completion_envelope(raw, content, finished_by_length, usage);
+            } else if (lines && resp.ok() && !finished_by_length) {
+                lines_streamer.finish();
+            }
+        } else if (resp.ok() && !resp.body.empty()) {
+            // Broken envelope: handled like a transport failure (retried below)
+            parse_completion_envelope(resp.body, content, finished_by_length, usage);
+        }
+        if (resp.ok() && !content.empty()) {
+            outcome.failure = lines
+                ? collect_numbered_items(content, finished_by_length, texts, outcome.items)
+                : collect_json_batch(strip_code_fences(content), finished_by_length, texts, outcome.items);
+            acct.unusable_items = static_cast<size_t>(
+                std::count(outcome.items.begin(), outcome.items.end(), std::nullopt));
+            acct.outcome = batch_failure_reason_name(outcome.failure);
+            account_request(state, acct, req, resp, usage);
+            if (outcome.failure != BatchFailure::None) {
+                {
+                    std::lock_guard<std::mutex> lock(state.stats_mutex);
+                    state.stats.failed_requests++;
+                }
+                openai_metrics().failures.inc();
             }
+            return outcome;
         }
-        if (attempt < opts_.retry_count) {
-#ifdef _WIN32
-            Sleep(500);
-#else
-            std::this_thread::sleep_for(std::chrono::milliseconds(500));
-#endif
+        acct.unusable_items = texts.size();
+        acct.outcome = resp.ok() ? batch_failure_reason_name(BatchFailure::MalformedJson)
+                                 : batch_failure_reason_name(BatchFailure::Http);
+        account_request(state, acct, req, resp, usage);
+        {
+            std::lock_guard<std::mutex> lock(state.stats_mutex);
+            state.stats.failed_requests++;
+        }
+        openai_metrics().failures.inc();
+        // 401/400 等不可重试的错误直接回退原文
+        if (!resp.ok() && !HttpRetryPolicy::is_retryable(resp)) break;
+        if (attempt < policy.max_retries) {
+            openai_metrics().retries.inc();
+            V2S_PROBE2(translator_retry, "openai", attempt + 1);
+            delay = policy.next_delay(delay, resp);
+            if (state.cancel.wait_for(delay)) break;
         }
     }
-    // Fallback: return original texts
-    return texts;
+    return outcome;
 }
 
-// Helper to group segments by total char length and max count
-static std::vector<std::vector<size_t>> group_indices_by_limits(const std::vector<Segment>& segs, size_t max_chars, int max_segments) {
+// Multi-target batch: one request, one "translations"-style array per language key.
+// Transport failures are retried; content problems are reported per language for recovery.
+std::vector<OpenAITranslator::BatchOutcome> OpenAITranslator::translate_texts_multi(CallState& state,
+                                                                                     const std::vector<std::string>& texts,
+                                                                                    const std::vector<std::string>& target_languages,
+                                                                                    const std::string& source_language) {
+    V2S_TRACE_SPAN("OpenAITranslator::translate_texts_multi", "translate");
+    const HttpRequest req = build_request(state, build_chat_body_texts(
+        opts_, texts, multi_batch_system_prompt(opts_, target_languages, source_language), /*stream*/false));
+    const HttpRetryPolicy policy = retry_policy();
+    std::chrono::milliseconds delay{0};
+
+    std::vector<BatchOutcome> outcomes(target_languages.size());
+    for (auto& outcome : outcomes) {
+        outcome.items.resize(texts.size());
+        outcome.failure = BatchFailure::Http;
+    }
+
+    for (int attempt = 0; attempt <= policy.max_retries; ++attempt) {
+        if (state.cancel.is_cancelled()) break;
+        V2S_PROBE3(translator_request, "openai", attempt, req.body.size());
+        const HttpResponse resp = send_limited(state, req);
+        V2S_PROBE4(translator_response, "openai", attempt, resp.ok() ? 1 : 0,
+                   static_cast<long long>(resp.elapsed_ms * 1000.0));
+        for (auto& outcome : outcomes) {
+            outcome.status = resp.status;
+            outcome.latency_ms = resp.elapsed_ms;
+            outcome.timed_out = resp.timed_out;
+        }
+        RequestAccounting acct;
+        acct.kind = "multi";
+        acct.source = &source_language;
+        acct.items = texts.size() * target_languages.size();
+        acct.attempt = attempt;
+        for (const auto& lang : target_languages) {
+            if (!acct.targets.empty()) acct.targets += ',';
+            acct.targets += lang;
+        }
+        std::string content;
+        bool finished_by_length = false;
+        TokenUsage usage;
+        if (resp.ok() && !resp.body.empty()) {
+            parse_completion_envelope(resp.body, content, finished_by_length, usage);
+        }
+        if (resp.ok() && !content.empty()) {
+            bool any_failed = false;
+            if (use_lines_format(opts_)) {
+                const auto sections = split_language_sections(content, target_languages);
+                // Sections follow the requested order, so only the last one can be cut off by max_tokens
+                size_t last_section = 0;
+                for (size_t t = 0; t < sections.size(); ++t) {
+                    if (!sections[t].empty()) last_section = t;
+                }
+                for (size_t t = 0; t < target_languages.size(); ++t) {
+                    outcomes[t].failure = sections[t].empty()
+                        ? BatchFailure::MissingTranslations
+                        : collect_numbered_items(sections[t], finished_by_length && t == last_section, texts, outcomes[t].items);
+                    any_failed = any_failed || outcomes[t].failure != BatchFailure::None;
+                }
+            } else {
+                try {
+                    auto j2 = nlohmann::json::parse(strip_code_fences(content));
+                    for (size_t t = 0; t < target_languages.size(); ++t) {
+                        outcomes[t].failure = j2.is_object() && j2.contains(target_languages[t])
+                            ? collect_batch_items(j2[target_languages[t]], texts, outcomes[t].items)
+                            : BatchFailure::MissingTranslations;
+                        any_failed = any_failed || outcomes[t].failure != BatchFailure::None;
+                    }
+                } catch (...) {
+                    // No per-language salvage for a broken object: every language is recovered separately
+                    for (auto& outcome : outcomes) {
+                        outcome.failure = finished_by_length ? BatchFailure::Truncated : BatchFailure::MalformedJson;
+                    }
+                    any_failed = true;
+                }
+            }
+            for (const auto& outcome : outcomes) {
+                acct.unusable_items += static_cast<size_t>(
+                    std::count(outcome.items.begin(), outcome.items.end(), std::nullopt));
+                if (outcome.failure != BatchFailure::None && std::string(acct.outcome) == "none") {
+                    acct.outcome = batch_failure_reason_name(outcome.failure);
+                }
+            }
+            account_request(state, acct, req, resp, usage);
+            if (any_failed) {
+                {
+                    std::lock_guard<std::mutex> lock(state.stats_mutex);
+                    state.stats.failed_requests++;
+                }
+                openai_metrics().failures.inc();
+            }
+            return outcomes;
+        }
+        acct.unusable_items = acct.items;
+        acct.outcome = resp.ok() ? batch_failure_reason_name(BatchFailure::MalformedJson)
+                                 : batch_failure_reason_name(BatchFailure::Http);
+        account_request(state, acct, req, resp, usage);
+        {
+            std::lock_guard<std::mutex> lock(state.stats_mutex);
+            state.stats.failed_requests++;
+        }
+        openai_metrics().failures.inc();
+        if (!resp.ok() && !HttpRetryPolicy::is_retryable(resp)) break;
+        if (attempt < policy.max_retries) {
+            openai_metrics().retries.inc();
+            V2S_PROBE2(translator_retry, "openai", attempt + 1);
+            delay = policy.next_delay(delay, resp);
+            if (state.cancel.wait_for(delay)) break;
+        }
+    }
+    return outcomes;
+}
+
+// Adaptive batch sizing feedback for one batch request
+static AdaptiveBatchSizer::Feedback batch_feedback(OpenAITranslator::BatchFailure failure, int status, bool timed_out) {
+    using F = OpenAITranslator::BatchFailure;
+    switch (failure) {
+        case F::None:
+        case F::InvalidItem:
+            return AdaptiveBatchSizer::Feedback::Ok;
+        case F::Http:
+            // Only timeouts and "request too large" say something about the batch size
+            return timed_out || status == 413 || status == 400 ? AdaptiveBatchSizer::Feedback::TooSlow
+                                                              : AdaptiveBatchSizer::Feedback::Ignore;
+        default:
+            return AdaptiveBatchSizer::Feedback::Malformed;
+    }
+}
+
+// Batch translation with recovery:
+// - items salvaged from a partial response are kept and only the missing ones are re-requested
+// - a batch that yields nothing is bisected; a single leftover item goes through translate_text
+// - HTTP failures other than "request too large" (400/413) or a timeout are not bisected (e.g. 401, or 5xx after retries)
+std::vector<std::optional<std::string>> OpenAITranslator::translate_batch_recovering(CallState& state,
+                                                                                     const std::vector<std::string>& texts,
+                                                                                     const std::string& target_language,
+                                                                                     const std::string& source_language,
+                                                                                     int depth,
+                                                                                     const SegmentCallback& on_item,
+                                                                                     AdaptiveBatchSizer* sizer) {
+    if (texts.size() == 1) {
+        return {translate_text(state, texts[0], target_language, source_language)};
+    }
+    BatchOutcome outcome = translate_texts_batch(state, texts, target_language, source_language, on_item);
+    if (sizer) sizer->record(texts.size(), outcome.latency_ms, batch_feedback(outcome.failure, outcome.status, outcome.timed_out));
+    std::vector<std::optional<std::string>> out = std::move(outcome.items);
+    if (outcome.failure == BatchFailure::None || state.cancel.is_cancelled()) return out;
+
+    std::vector<size_t> missing;
+    for (size_t i = 0; i < out.size(); ++i) {
+        if (!out[i]) missing.push_back(i);
+    }
+    const char* reason = batch_failure_reason_name(outcome.failure);
+    metrics::counter("v2s_translator_batch_failures_total", "Batch translation responses that were not fully usable",
+                     {{"translator", "openai"}, {"reason", reason}}).inc();
+    std::ostringstream log;
+    log << "[OpenAITranslator] 批量翻译部分失败: 原因=" << reason;
+    if (outcome.failure == BatchFailure::Http) log << (outcome.timed_out ? " (超时)" : " (HTTP " + std::to_string(outcome.status) + ")");
+    log << ", 缺失 " << missing.size() << "/" << texts.size() << ", 深度 " << depth;
+
+    const bool bisectable = outcome.failure != BatchFailure::Http || outcome.timed_out ||
+                            outcome.status == 400 || outcome.status == 413;
+    if (missing.empty()) {
+        std::cerr << log.str() << std::endl;
+    } else if (missing.size() < texts.size()) {
+        // Some items arrived: re-request just the gaps as one smaller batch
+        std::cerr << log.str() << ", 重新请求缺失项" << std::endl;
+        std::vector<std::string> sub;
+        sub.reserve(missing.size());
+        for (size_t i : missing) sub.push_back(texts[i]);
+        SegmentCallback sub_on_item;
+        if (on_item) sub_on_item = [&](size_t k, const std::string& text) { on_item(missing[k], text); };
+        auto sub_out = translate_batch_recovering(state, sub, target_language, source_language, depth + 1, sub_on_item);
+        for (size_t k = 0; k < missing.size(); ++k) out[missing[k]] = std::move(sub_out[k]);
+    } else if (bisectable) {
+        std::cerr << log.str() << ", 二分拆批重试" << std::endl;
+        const auto half = static_cast<std::ptrdiff_t>(texts.size() / 2);
+        std::vector<std::string> left(texts.begin(), texts.begin() + half);
+        std::vector<std::string> right(texts.begin() + half, texts.end());
+        SegmentCallback right_on_item;
+        if (on_item) right_on_item = [&](size_t k, const std::string& text) { on_item(static_cast<size_t>(half) + k, text); };
+        auto left_out = translate_batch_recovering(state, left, target_language, source_language, depth + 1, on_item);
+        auto right_out = translate_batch_recovering(state, right, target_language, source_language, depth + 1, right_on_item);
+        std::move(left_out.begin(), left_out.end(), out.begin());
+        std::move(right_out.begin(), right_out.end(), out.begin() + half);
+    } else {
+        std::cerr << log.str() << ", 放弃（保留原文）" << std::endl;
+    }
+    return out;
+}
+
+// Token budget packing for batch mode.
+// Each request is filled until either the estimated prompt (system prompt + encoded inputs +
+// chat framing) reaches max_batch_prompt_tokens, or the estimated completion (translations
+// in the same wire format) reaches ~90% of max_tokens, or it holds max_items segments.
+// Segment order is kept. Groups are taken one at a time so the segment cap can change
+// between groups (adaptive batch sizing).
+// completion_ratio is the summed token ratio of all requested target languages and
+// output_arrays the number of translation lists in the response (one per target language).
+class TokenBudgetPacker {
+public:
+    TokenBudgetPacker(const std::vector<Segment>& segs, const TranslatorOptions& opts, const std::string& system_prompt,
+                      double completion_ratio, size_t output_arrays)
+        : segs_(segs), lines_(use_lines_format(opts)), ratio_(completion_ratio) {
+        // Per-message framing of the chat format (role markers etc.)
+        constexpr size_t kMessageOverhead = 4;
+        arrays_ = std::max<size_t>(1, output_arrays);
+        // Lines: an "@lang" header per section when there are several; JSON: {"translations":[ ... ]} per array
+        response_envelope_ = lines_ ? (arrays_ > 1 ? 2 * arrays_ : 0) : 6 * arrays_;
+        // Lines: number, '|' and newline; JSON: quotes and comma
+        item_framing_ = lines_ ? 3 : 1;
+        const size_t input_envelope = lines_ ? 0 : 1;   // JSON: [ ]
+
+        prompt_fixed_ = estimate_tokens(system_prompt) + 2 * kMessageOverhead + 3 + input_envelope;
+        prompt_budget_ = std::max(prompt_fixed_, static_cast<size_t>(std::max(1, opts.max_batch_prompt_tokens)));
+        completion_budget_ = std::max<size_t>(response_envelope_ + 1, static_cast<size_t>(std::max(1, opts.max_tokens)) * 9 / 10);
+    }
+
+    bool done() const { return next_ >= segs_.size(); }
+
+    // Next group of at most max_items segments (empty when every segment has been packed)
+    std::vector<size_t> next(size_t max_items) {
+        std::vector<size_t> group;
+        size_t prompt_tokens = prompt_fixed_;
+        size_t completion_tokens = response_envelope_;
+        for (; next_ < segs_.size(); ++next_) {
+            size_t in = 0, out = 0;
+            item_tokens(segs_[next_].text, in, out);
+            if (!group.empty() && (prompt_tokens + in > prompt_budget_ ||
+                                   completion_tokens + out > completion_budget_ ||
+                                   group.size() >= max_items)) {
+                break;
+            }
+            // An oversized single segment still gets its own request
+            group.push_back(next_);
+            prompt_tokens += in;
+            completion_tokens += out;
+        }
+        return group;
+    }
+
+    // Share of one request's capacity taken by a segment (the tighter of the prompt and completion budgets)
+    double weight(const std::string& text) const {
+        size_t in = 0, out = 0;
+        item_tokens(text, in, out);
+        const double prompt_room = static_cast<double>(std::max<size_t>(1, prompt_budget_ - prompt_fixed_));
+        const double completion_room = static_cast<double>(std::max<size_t>(1, completion_budget_ - response_envelope_));
+        return std::max(static_cast<double>(in) / prompt_room, static_cast<double>(out) / completion_room);
+    }
+
+private:
+    // Estimated prompt tokens (input) and completion tokens (output) of one segment
+    void item_tokens(const std::string& text, size_t& in, size_t& out) const {
+        const size_t text_tokens = lines_ ? estimate_tokens(text) : estimate_json_string_tokens(text);
+        in = text_tokens + (lines_ ? item_framing_ : 0);
+        // Translated text(s) + framing, with a 15% margin on the language ratio
+        out = static_cast<size_t>(std::ceil(static_cast<double>(text_tokens) * ratio_ * 1.15)) + item_framing_ * arrays_;
+    }
+
+    const std::vector<Segment>& segs_;
+    const bool lines_;
+    const double ratio_;
+    size_t arrays_ = 1;
+    size_t response_envelope_ = 0;
+    size_t item_framing_ = 1;
+    size_t prompt_fixed_ = 0;
+    size_t prompt_budget_ = 0;
+    size_t completion_budget_ = 0;
+    size_t next_ = 0;
+};
+
+// Hand batches to max_parallel workers. Each worker takes the next group when it is free, so the
+// segment cap (fixed max_batch_segments or the adaptive size) is read at the moment a group is formed.
+static void for_each_batch(TokenBudgetPacker& packer, size_t max_parallel, const std::function<size_t()>& max_items,
+                           const CancellationToken& cancel, const std::function<void(const std::vector<size_t>&)>& fn) {
+    std::mutex packer_mutex;
+    parallel_for(max_parallel, max_parallel, [&](size_t) {
+        for (;;) {
+            if (cancel.is_cancelled()) return;
+            std::vector<size_t> group;
+            {
+                std::lock_guard<std::mutex> lock(packer_mutex);
+                if (packer.done()) return;
+                group = packer.next(std::max<size_t>(1, max_items()));
+            }
+            fn(group);
+        }
+    });
+}
+
+std::shared_ptr<AdaptiveBatchSizer> OpenAITranslator::batch_sizer(size_t targets) const {
+    if (!opts_.batch_mode || !opts_.adaptive_batch) return nullptr;
+    AdaptiveBatchSizer::Limits limits;
+    if (opts_.max_batch_segments > 0) limits.max_segments = static_cast<size_t>(opts_.max_batch_segments);
+    limits.min_segments = std::min(limits.min_segments, limits.max_segments);
+    limits.initial_segments = std::min<size_t>(24, limits.max_segments);
+    const std::filesystem::path dir = opts_.cache_dir.empty()
+        ? std::filesystem::current_path() / "cache"
+        : std::filesystem::path(opts_.cache_dir);
+    // Learned per endpoint, model, wire format and number of target languages
+    const std::string key = limiter_->endpoint() + "|" + (opts_.model.empty() ? "gpt-4o-mini" : opts_.model) + "|" +
+                            (use_lines_format(opts_) ? "lines" : "json") + "|" + std::to_string(targets);
+    return AdaptiveBatchSizer::for_key(key, dir / "batch_sizing.json", limits);
+}
+
+// Batches may only be shared by jobs whose requests would be identical apart from the texts,
+// and that are billed to the same account and usage tag
+std::string OpenAITranslator::coalesce_key(const std::string& target_language, const std::string& source_language) const {
+    std::ostringstream key;
+    key << limiter_->endpoint() << '|' << cache_namespace() << '|' << (use_lines_format(opts_) ? "lines" : "json")
+        << '|' << opts_.structured_json_output << '|' << opts_.temperature << '|' << opts_.max_tokens
+        << '|' << source_language << '>' << target_language
+        << '|' << std::hash<std::string>{}(opts_.api_key) << '|' << opts_.usage_tag;
+    return key.str();
+}
+
+std::vector<std::vector<size_t>> OpenAITranslator::request_groups(const std::vector<Segment>& segments,
+                                                                 const std::string& target_language,
+                                                                 const std::string& source_language) const {
+    if (!opts_.batch_mode) return ITranslator::request_groups(segments, target_language, source_language);
+    TokenBudgetPacker packer(segments, opts_, batch_system_prompt(opts_, target_language, source_language),
+                             translation_token_ratio(source_language, target_language), 1);
+    const auto sizer = batch_sizer(1);
+    const size_t max_items = sizer ? sizer->batch_segments()
+        : opts_.max_batch_segments > 0 ? static_cast<size_t>(opts_.max_batch_segments)
+                                       : std::numeric_limits<size_t>::max();
     std::vector<std::vector<size_t>> groups;
-    std::vector<size_t> current;
-    size_t char_count = 0;
-    for (size_t i = 0; i < segs.size(); ++i) {
-        const auto& s = segs[i];
-        size_t len = s.text.size();
-        if (!current.empty() && ((char_count + len) > max_chars || (int)current.size() >= max_segments)) {
-            groups.push_back(current);
-            current.clear();
-            char_count = 0;
-        }
-        current.push_back(i);
-        char_count += len;
-    }
-    if (!current.empty()) groups.push_back(current);
+    while (!packer.done()) groups.push_back(packer.next(max_items));
     return groups;
 }
 
 TranslationResult OpenAITranslator::translate_segments(const std::vector<Segment>& segments,
                                                        const std::string& target_language,
                                                        const std::string& source_language) {
+    return translate_call(segments, target_language, source_language, TranslationCall{CancellationToken{}, segment_callback_});
+}
+
+TranslationResult OpenAITranslator::translate_call(const std::vector<Segment>& segments,
+                                                   const std::string& target_language,
+                                                   const std::string& source_language,
+                                                   const TranslationCall& call) {
+    CallState state;
+    state.cancel = link_cancel(opts_.cancel, call.cancel);
     TranslationResult result;
     result.target_language = target_language;
     result.source_language = source_language;
-    result.segments.reserve(segments.size());
+    result.translator_name = "openai";
+    // 结果按原下标写回；失败或未执行（取消）的槽位保留原文并记入 failed_indices
+    result.segments = segments;
+    std::vector<char> failed(segments.size(), 1);
+    const size_t concurrency = static_cast<size_t>(std::max(1, opts_.max_concurrency));
 
     if (!opts_.batch_mode) {
         // per-segment translation
-        for (const auto& seg : segments) {
-            std::string translated = translate_text(seg.text, target_language, source_language);
-            Segment out = seg;
-            out.text = translated;
-            result.segments.push_back(std::move(out));
+        parallel_for(segments.size(), concurrency, [&](size_t idx) {
+            if (state.cancel.is_cancelled()) return;
+            if (auto translated = translate_text(state, segments[idx].text, target_language, source_language)) {
+                result.segments[idx].text = std::move(*translated);
+                failed[idx] = 0;
+                call.notify(idx, result.segments[idx].text);
+            }
+        });
+    } else {
+        // aggregated translation
+        TokenBudgetPacker packer(segments, opts_, batch_system_prompt(opts_, target_language, source_language),
+                                 translation_token_ratio(source_language, target_language), 1);
+        const auto sizer = batch_sizer(1);
+        const size_t fixed_max = opts_.max_batch_segments > 0 ? static_cast<size_t>(opts_.max_batch_segments)
+                                                              : std::numeric_limits<size_t>::max();
+        const std::function<size_t()> max_items = [&] { return sizer ? sizer->batch_segments() : fixed_max; };
+        // 流式模式下已提前回调的段（各批次下标互不重叠）
+        std::vector<char> notified(segments.size(), 0);
+
+        if (opts_.coalesce_batches) {
+            // 跨任务合并：本任务的段与其他并发任务的段拼批，由等待中的任务轮流发送
+            std::vector<TranslationBroker::Item> items;
+            items.reserve(segments.size());
+            for (const auto& seg : segments) items.push_back({seg.text, packer.weight(seg.text)});
+            auto broker = TranslationBroker::for_key(coalesce_key(target_language, source_language));
+            auto translated_list = broker->translate(
+                items,
+                [&](const std::vector<std::string>& texts) {
+                    return translate_batch_recovering(state, texts, target_language, source_language, 0, nullptr, sizer.get());
+                },
+                max_items, std::chrono::milliseconds(std::max(0, opts_.coalesce_linger_ms)), concurrency, state.cancel,
+                [&](size_t i, const std::string& text) {
+                    notified[i] = 1;
+                    call.notify(i, text);
+                });
+            for (size_t i = 0; i < segments.size(); ++i) {
+                if (!translated_list[i]) continue;
+                result.segments[i].text = std::move(*translated_list[i]);
+                failed[i] = 0;
+                if (!notified[i]) call.notify(i, result.segments[i].text);
+            }
+        } else {
+            for_each_batch(packer, concurrency, max_items, state.cancel, [&](const std::vector<size_t>& group) {
+                std::vector<std::string> texts;
+                texts.reserve(group.size());
+                for (size_t idx : group) texts.push_back(segments[idx].text);
+                SegmentCallback on_item;
+                if (opts_.stream && call.on_segment) {
+                    on_item = [&](size_t i, const std::string& text) {
+                        notified[group[i]] = 1;
+                        call.notify(group[i], text);
+                    };
+                }
+                auto translated_list = translate_batch_recovering(state, texts, target_language, source_language, 0, on_item, sizer.get());
+                // map back（各批次下标互不重叠，可并发写入）
+                for (size_t i = 0; i < group.size(); ++i) {
+                    if (!translated_list[i]) continue;
+                    result.segments[group[i]].text = std::move(*translated_list[i]);
+                    failed[group[i]] = 0;
+                    if (!notified[group[i]]) call.notify(group[i], result.segments[group[i]].text);
+                }
+            });
         }
-        return result;
+        if (sizer) sizer->save();
     }
 
-    // aggregated translation
-    auto groups = group_indices_by_limits(segments, opts_.max_batch_chars, std::max(1, opts_.max_batch_segments));
-    result.segments.resize(segments.size());
+    for (size_t i = 0; i < failed.size(); ++i) {
+        if (failed[i]) result.failed_indices.push_back(i);
+    }
+    result.stats = std::move(state.stats);
+    return result;
+}
 
-    for (const auto& group : groups) {
+std::vector<TranslationResult> OpenAITranslator::translate_call_multi(const std::vector<Segment>& segments,
+                                                                      const std::vector<std::string>& target_languages,
+                                                                      const std::string& source_language,
+                                                                      const TranslationCall& call) {
+    // Per-segment mode has no shared prompt to amortise: translate each language separately
+    if (!opts_.batch_mode || target_languages.size() < 2) {
+        return ITranslator::translate_call_multi(segments, target_languages, source_language, call);
+    }
+
+    const size_t targets = target_languages.size();
+    std::vector<TranslationResult> results(targets);
+    for (size_t t = 0; t < targets; ++t) {
+        results[t].target_language = target_languages[t];
+        results[t].source_language = source_language;
+        results[t].translator_name = "openai";
+        results[t].segments = segments;
+        for (auto& seg : results[t].segments) seg.language = target_languages[t];
+    }
+    CallState state;
+    state.cancel = link_cancel(opts_.cancel, call.cancel);
+    std::vector<std::vector<char>> failed(targets, std::vector<char>(segments.size(), 1));
+    const size_t concurrency = static_cast<size_t>(std::max(1, opts_.max_concurrency));
+
+    double ratio = 0.0;
+    for (const auto& target : target_languages) ratio += translation_token_ratio(source_language, target);
+    TokenBudgetPacker packer(segments, opts_, multi_batch_system_prompt(opts_, target_languages, source_language),
+                             ratio, targets);
+    const auto sizer = batch_sizer(targets);
+    const size_t fixed_max = opts_.max_batch_segments > 0 ? static_cast<size_t>(opts_.max_batch_segments)
+                                                          : std::numeric_limits<size_t>::max();
+
+    for_each_batch(packer, concurrency, [&]() -> size_t { return sizer ? sizer->batch_segments() : fixed_max; }, state.cancel,
+                   [&](const std::vector<size_t>& group) {
         std::vector<std::string> texts;
         texts.reserve(group.size());
         for (size_t idx : group) texts.push_back(segments[idx].text);
-        auto translated_list = translate_texts_batch(texts, target_language, source_language);
-        // map back
-        for (size_t i = 0; i < group.size(); ++i) {
-            size_t idx = group[i];
-            Segment out = segments[idx];
-            out.text = (i < translated_list.size()) ? translated_list[i] : segments[idx].text;
-            result.segments[idx] = std::move(out);
+
+        auto outcomes = translate_texts_multi(state, texts, target_languages, source_language);
+        if (sizer) {
+            // The worst language decides: a malformed section means the batch asked for too much
+            auto feedback = AdaptiveBatchSizer::Feedback::Ok;
+            for (const auto& outcome : outcomes) {
+                const auto f = batch_feedback(outcome.failure, outcome.status, outcome.timed_out);
+                if (f != AdaptiveBatchSizer::Feedback::Ok) feedback = f;
+            }
+            sizer->record(texts.size(), outcomes.front().latency_ms, feedback);
         }
-    }
+        for (size_t t = 0; t < targets; ++t) {
+            auto& items = outcomes[t].items;
+            if (outcomes[t].failure != BatchFailure::None && !state.cancel.is_cancelled()) {
+                std::vector<size_t> missing;
+                for (size_t i = 0; i < items.size(); ++i) {
+                    if (!items[i]) missing.push_back(i);
+                }
+                const char* reason = batch_failure_reason_name(outcomes[t].failure);
+                metrics::counter("v2s_translator_batch_failures_total", "Batch translation responses that were not fully usable",
+                                 {{"translator", "openai"}, {"reason", reason}}).inc();
+                std::cerr << "[OpenAITranslator] 多语言批量翻译部分失败: 语言=" << target_languages[t] << ", 原因=" << reason
+                          << ", 缺失 " << missing.size() << "/" << texts.size()
+                          << (missing.empty() ? "" : ", 按单一语言重新请求") << std::endl;
+                if (!missing.empty()) {
+                    std::vector<std::string> sub;
+                    sub.reserve(missing.size());
+                    for (size_t i : missing) sub.push_back(texts[i]);
+                    auto sub_out = translate_batch_recovering(state, sub, target_languages[t], source_language, 1, nullptr);
+                    for (size_t k = 0; k < missing.size(); ++k) items[missing[k]] = std::move(sub_out[k]);
+                }
+            }
+            // map back（各批次下标互不重叠，可并发写入）
+            for (size_t i = 0; i < group.size(); ++i) {
+                if (!items[i]) continue;
+                results[t].segments[group[i]].text = std::move(*items[i]);
+                failed[t][group[i]] = 0;
+                call.notify(group[i], results[t].segments[group[i]].text);
+            }
+        }
+    });
 
-    return result;
+    if (sizer) sizer->save();
+
+    for (size_t t = 0; t < targets; ++t) {
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (failed[t][i]) results[t].failed_indices.push_back(i);
+        }
+    }
+    results.front().stats = std::move(state.stats);
+    return results;
 }
 
-} // namespace v2s
\ No newline at end of file
+} // namespace v2s
@@ -1,5 +1,7 @@
 #include "video2srt_native/output_formats.hpp"
 #include "video2srt_native/models.hpp"
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/probes.hpp"
 #include <sstream>
 #include <iomanip>
 #include <fstream>
@@ -59,6 +61,7 @@ std::string WebVTTFormatter::format_vtt_time(double seconds) {
 
 std::string WebVTTFormatter::format_segments(const std::vector<Segment>& segments,
                                              double min_duration) {
+    V2S_TRACE_SPAN("WebVTTFormatter::format_segments", "format");
     auto fixed = fix_segments_for_vtt(segments, min_duration);
 
     std::ostringstream vtt;
@@ -73,12 +76,14 @@ std::string WebVTTFormatter::format_segments(const std::vector<Segment>& segment
 
 bool WebVTTFormatter::save_vtt(const std::string& content,
                                const std::filesystem::path& output_path) {
+    V2S_TRACE_SPAN("WebVTTFormatter::save_vtt", "io");
     try {
         std::filesystem::create_directories(output_path.parent_path());
         std::ofstream file(output_path, std::ios::out | std::ios::trunc);
         if (!file.is_open()) return false;
         file << content;
         file.close();
+        V2S_PROBE3(formatter_write, "vtt", content.size(), file.good() ? 1 : 0);
         return true;
     } catch (...) {
         return false;
@@ -168,6 +173,7 @@ std::string ASSFormatter::format_ass_time(double seconds) {
 std::string ASSFormatter::format_segments(const std::vector<Segment>& segments,
                                           const ASSStyleConfig& style,
                                           double min_duration) {
+    V2S_TRACE_SPAN("ASSFormatter::format_segments", "format");
     auto fixed = fix_segments_for_ass(segments, min_duration);
 
     // Header & Styles
@@ -205,12 +211,14 @@ std::string ASSFormatter::format_segments(const std::vector<Segment>& segments,
 
 bool ASSFormatter::save_ass(const std::string& content,
                             const std::filesystem::path& output_path) {
+    V2S_TRACE_SPAN("ASSFormatter::save_ass", "io");
     try {
         std::filesystem::create_directories(output_path.parent_path());
         std::ofstream file(output_path, std::ios::out | std::ios::trunc);
         if (!file.is_open()) return false;
         file << content;
         file.close();
+        V2S_PROBE3(formatter_write, "ass", content.size(), file.good() ? 1 : 0);
         return true;
     } catch (...) {
         return false;
@@ -3,22 +3,205 @@
 #include "video2srt_native/core.hpp"
 #include "video2srt_native/translator.hpp"
 #include "video2srt_native/output_formats.hpp"
+#include "video2srt_native/stats.hpp"
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/metrics.hpp"
 #include <iostream>
 #include <sstream>
 #include <algorithm>
 #include <random>
+#include <atomic>
+#include <stdexcept>
+#include <mutex>
+#include <unordered_map>
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
 
 namespace v2s {
 
+// 作用域退出时执行清理（保证提前返回、取消与异常路径都能删除临时文件）
+template <typename F>
+class ScopeExit {
+public:
+    explicit ScopeExit(F fn) : fn_(std::move(fn)) {}
+    ~ScopeExit() { fn_(); }
+    ScopeExit(const ScopeExit&) = delete;
+    ScopeExit& operator=(const ScopeExit&) = delete;
+private:
+    F fn_;
+};
+
+// 将单个作业的结果汇入进程级指标
+static void record_job_metrics(const ProcessingResult& result) {
+    const ProcessingStats& stats = result.stats;
+    metrics::counter("v2s_jobs_total", "Processing jobs finished",
+                     {{"result", result.success ? "success" : "failure"}}).inc();
+
+    static metrics::Counter& segments = metrics::counter("v2s_segments_total", "Subtitle segments produced");
+    static metrics::Counter& audio_seconds = metrics::counter("v2s_audio_seconds_total", "Seconds of audio processed");
+    static metrics::Histogram& rtf = metrics::histogram("v2s_real_time_factor", "Job wall time divided by audio duration",
+                                                        {0.05, 0.1, 0.25, 0.5, 1, 2, 4, 8});
+    if (result.transcription.has_value()) {
+        segments.inc(static_cast<double>(result.transcription->segments.size()));
+    }
+    audio_seconds.inc(stats.audio_duration_seconds);
+    if (stats.real_time_factor > 0.0) {
+        rtf.observe(stats.real_time_factor);
+    }
+
+    const std::pair<const char*, const StageTiming*> stages[] = {
+        {"probe", &stats.probe}, {"extract", &stats.extract}, {"model_load", &stats.model_load},
+        {"transcribe", &stats.transcribe}, {"merge", &stats.merge}, {"translate", &stats.translate},
+        {"format", &stats.format}, {"write", &stats.write}, {"total", &stats.total}
+    };
+    for (const auto& st : stages) {
+        if (st.second->wall_seconds <= 0.0) continue; // 未执行的阶段不计入
+        metrics::histogram("v2s_stage_duration_seconds", "Wall time per pipeline stage",
+                           metrics::latency_buckets_seconds(), {{"stage", st.first}})
+            .observe(st.second->wall_seconds);
+    }
+}
+
 Processor::Processor(const ProcessingConfig& config)
     : config_(config), transcriber_(nullptr) {
 }
 
 ProcessingResult Processor::process(const std::filesystem::path& input_path,
                                   const std::filesystem::path& output_path,
-                                  ProgressCallback progress_callback) {
+                                  ProgressCallback progress_callback,
+                                  const CancellationToken& cancel) {
+    V2S_TRACE_SPAN("Processor::process", "pipeline");
+    const auto start_time = std::chrono::steady_clock::now();
+    const double cpu_start = process_cpu_seconds();
+
+    static metrics::Gauge& in_progress = metrics::gauge("v2s_jobs_in_progress", "Processing jobs currently running");
+    ProcessingResult result;
+    {
+        metrics::ScopedGaugeInc running(in_progress);
+        result = run_pipeline(input_path, output_path, progress_callback, cancel);
+    }
+
+    // 汇总总耗时、实时率与峰值内存（成功与失败均填充，便于排查）
+    result.set_processing_time(start_time);
+    ProcessingStats& stats = result.stats;
+    stats.total.wall_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start_time).count();
+    stats.total.cpu_seconds = std::max(0.0, process_cpu_seconds() - cpu_start);
+    if (stats.audio_duration_seconds > 0.0) {
+        stats.real_time_factor = stats.total.wall_seconds / stats.audio_duration_seconds;
+    }
+    stats.peak_rss_bytes = peak_rss_bytes();
+    record_job_metrics(result);
+    return result;
+}
+
+ProcessingHandle Processor::process_async(const std::filesystem::path& input_path,
+                                          const std::filesystem::path& output_path,
+                                          ProgressCallback progress_callback,
+                                          std::chrono::milliseconds timeout) {
+    ProcessingHandle handle;
+    handle.token_ = CancellationToken::create();
+    if (timeout.count() > 0) {
+        handle.token_.set_deadline(CancellationToken::Clock::now() + timeout);
+    }
+    CancellationToken token = handle.token_;
+    handle.future_ = std::async(std::launch::async,
+        [this, input_path, output_path, progress_callback, token]() {
+            return process(input_path, output_path, progress_callback, token);
+        }).share();
+    return handle;
+}
+
+bool ProcessingHandle::is_ready() const {
+    return wait_for(std::chrono::milliseconds::zero());
+}
+
+bool ProcessingHandle::wait_for(std::chrono::milliseconds timeout) const {
+    if (!future_.valid()) return false;
+    return future_.wait_for(timeout) == std::future_status::ready;
+}
+
+ProcessingResult ProcessingHandle::get() const {
+    if (!future_.valid()) {
+        return ProcessingResult("无效的处理句柄");
+    }
+    return future_.get();
+}
+
+// 文件大小（不存在或出错时返回 0）
+static uint64_t file_size_or_zero(const std::filesystem::path& path) {
+    std::error_code ec;
+    auto size = std::filesystem::file_size(path, ec);
+    return ec ? 0 : static_cast<uint64_t>(size);
+}
+
+// 语言标签归一为两字母代码：容器多用 ISO 639-2（eng/chi/zho），配置与 Whisper 使用 ISO 639-1（en/zh），
+// 也可能带地区后缀（zh-CN、en_US）；und 返回空，未收录的代码原样（小写）返回
+static std::string normalize_language_tag(const std::string& tag) {
+    static const std::unordered_map<std::string, std::string> iso639_2 = {
+        {"eng", "en"}, {"chi", "zh"}, {"zho", "zh"}, {"jpn", "ja"}, {"kor", "ko"},
+        {"fre", "fr"}, {"fra", "fr"}, {"ger", "de"}, {"deu", "de"}, {"spa", "es"},
+        {"ita", "it"}, {"rus", "ru"}, {"por", "pt"}, {"ara", "ar"}, {"hin", "hi"},
+        {"tha", "th"}, {"vie", "vi"}, {"ind", "id"}, {"tur", "tr"}, {"pol", "pl"},
+        {"dut", "nl"}, {"nld", "nl"}, {"swe", "sv"}, {"ukr", "uk"}, {"gre", "el"},
+        {"ell", "el"}, {"heb", "he"}, {"may", "ms"}, {"msa", "ms"}, {"per", "fa"},
+        {"fas", "fa"}, {"cze", "cs"}, {"ces", "cs"}, {"hun", "hu"}, {"fin", "fi"},
+        {"dan", "da"}, {"nor", "no"}, {"nob", "no"}, {"rum", "ro"}, {"ron", "ro"}
+    };
+    std::string lang;
+    for (char c : tag) {
+        if (c == '-' || c == '_') break;
+        lang += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (lang == "und" || lang == "auto") return {};
+    auto it = iso639_2.find(lang);
+    return it != iso639_2.end() ? it->second : lang;
+}
+
+// 按 embedded_subtitles 策略选择可复用的文本字幕流，没有合适的流时返回 nullptr
+// - auto：语言须与源语言一致（指定的源语言，未指定时取音频流的语言标签），任一方未知则不复用
+// - always：任意文本字幕流，依次优先语言一致、默认轨道、容器内顺序
+// 强制轨道通常只含外语对白或标牌，不是完整字幕，始终跳过
+static const SubtitleStreamInfo* select_subtitle_stream(const MediaInfo& info,
+                                                        const std::string& policy,
+                                                        const std::optional<std::string>& language) {
+    if (policy != "auto" && policy != "always") return nullptr;
+    const std::string source = normalize_language_tag(language ? *language : info.audio_language);
+    if (policy == "auto" && source.empty()) return nullptr;
+
+    const SubtitleStreamInfo* best = nullptr;
+    int best_score = -1;
+    for (const auto& sub : info.subtitle_streams) {
+        if (!sub.is_text || sub.is_forced) continue;
+        const bool match = !source.empty() && normalize_language_tag(sub.language) == source;
+        if (policy == "auto" && !match) continue;
+        const int score = (match ? 2 : 0) + (sub.is_default ? 1 : 0);
+        if (score > best_score) {
+            best = &sub;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+ProcessingResult Processor::run_pipeline(const std::filesystem::path& input_path,
+                                         const std::filesystem::path& output_path,
+                                         ProgressCallback progress_callback,
+                                         const CancellationToken& cancel) {
     ProcessingResult result;
     result.success = false;
+    ProcessingStats& stats = result.stats;
+
+    // 阶段间检查点：已取消时填充结果并返回 true
+    auto check_cancelled = [&]() {
+        if (!cancel.is_cancelled()) return false;
+        result.cancelled = true;
+        result.error_message = cancellation_message(cancel.reason());
+        report_progress(progress_callback, "取消", 0.0, result.error_message);
+        return true;
+    };
     
     try {
         // 验证输入
@@ -38,138 +221,276 @@ ProcessingResult Processor::process(const std::filesystem::path& input_path,
         }
         
         report_progress(progress_callback, "初始化", 0.0, "开始处理...");
+
+        // 探测媒体信息（失败不影响后续流程，仅用于统计）
+        MediaInfo media_info;
+        {
+            StageTimer timer(stats.probe);
+            V2S_TRACE_SPAN("stage.probe", "pipeline");
+            probe_media(input_path.string(), media_info);
+        }
         
-        // 创建临时目录
-        std::filesystem::path temp_dir = create_temp_directory();
+        if (check_cancelled()) return result;
+
+        // 容器已带源语言文本字幕时直接复用：跳过音频提取、模型加载与转录
+        TranscriptionResult transcription;
+        if (const SubtitleStreamInfo* sub = select_subtitle_stream(media_info, config_.embedded_subtitles,
+                                                                   config_.language)) {
+            report_progress(progress_callback, "字幕复用", 0.1,
+                            "正在读取内嵌字幕流 #" + std::to_string(sub->index) + " (" + sub->codec + ")...");
+            std::vector<Segment> segments;
+            bool decoded = false;
+            {
+                StageTimer timer(stats.extract);
+                V2S_TRACE_SPAN("stage.extract_subtitles", "pipeline");
+                decoded = extract_subtitle_segments(input_path.string(), sub->index, segments, cancel);
+            }
+            if (check_cancelled()) return result;
+            if (decoded && !segments.empty()) {
+                std::string language = normalize_language_tag(sub->language);
+                if (language.empty() && config_.language) language = normalize_language_tag(*config_.language);
+                std::string full_text;
+                for (auto& seg : segments) {
+                    if (!language.empty()) seg.language = language;
+                    if (!full_text.empty()) full_text += ' ';
+                    full_text += seg.text;
+                }
+                transcription = TranscriptionResult(segments, language, full_text, "embedded:" + sub->codec);
+                stats.subtitle_stream_index = sub->index;
+                stats.bytes_read += file_size_or_zero(input_path);
+                stats.audio_duration_seconds = media_info.duration_seconds > 0.0
+                    ? media_info.duration_seconds : transcription.duration;
+                static metrics::Counter& reused = metrics::counter("v2s_embedded_subtitle_jobs_total",
+                                                                   "Jobs that reused an embedded text subtitle track instead of ASR");
+                reused.inc();
+                report_progress(progress_callback, "字幕复用", 0.8,
+                                "已复用内嵌字幕，共 " + std::to_string(segments.size()) + " 段");
+            } else {
+                std::cerr << "[Processor] 内嵌字幕流 #" << sub->index << " (" << sub->codec
+                          << ") 读取失败或为空，改用语音转录" << std::endl;
+            }
+        }
+
+        if (stats.subtitle_stream_index < 0) {
+            // 创建临时目录（函数退出时自动清理）
+            std::filesystem::path temp_dir = create_temp_directory();
+            ScopeExit<std::function<void()>> temp_guard([this, temp_dir]() { cleanup_temp_files(temp_dir); });
         
-        // 阶段1: 音频提取
-        report_progress(progress_callback, "音频提取", 0.1, "正在提取音频...");
+            // 阶段1: 音频提取
+            report_progress(progress_callback, "音频提取", 0.1, "正在提取音频...");
         
-        std::filesystem::path audio_path = temp_dir / "extracted_audio.wav";
+            std::filesystem::path audio_path = temp_dir / "extracted_audio.wav";
         
-        if (!extract_audio_to_wav(input_path.string(), audio_path.string(), 16000)) {
-            cleanup_temp_files(temp_dir);
-            result.error_message = "音频提取失败";
-            return result;
-        }
+            bool extracted = false;
+            {
+                StageTimer timer(stats.extract);
+                V2S_TRACE_SPAN("stage.extract", "pipeline");
+                extracted = extract_audio_to_wav(input_path.string(), audio_path.string(), 16000, cancel);
+            }
+            if (check_cancelled()) return result;
+            if (!extracted) {
+                result.error_message = "音频提取失败";
+                return result;
+            }
+
+            // 16kHz 单声道 s16 WAV：按数据区字节数计算实际音频时长
+            const uint64_t wav_bytes = file_size_or_zero(audio_path);
+            stats.bytes_read += file_size_or_zero(input_path);
+            stats.bytes_written += wav_bytes;
+            if (wav_bytes > 44) {
+                stats.audio_duration_seconds = static_cast<double>(wav_bytes - 44) / (16000.0 * 2.0);
+            } else {
+                stats.audio_duration_seconds = media_info.duration_seconds;
+            }
         
-        report_progress(progress_callback, "音频提取", 0.3, "音频提取完成");
+            report_progress(progress_callback, "音频提取", 0.3, "音频提取完成");
         
-        // 阶段2: 语音转录
-        report_progress(progress_callback, "语音转录", 0.4, "正在加载转录模型...");
+            // 阶段2: 语音转录
+            report_progress(progress_callback, "语音转录", 0.4, "正在加载转录模型...");
         
-        if (!initialize_transcriber()) {
-            cleanup_temp_files(temp_dir);
-            result.error_message = "转录器初始化失败";
-            return result;
-        }
+            bool transcriber_ready = false;
+            {
+                StageTimer timer(stats.model_load);
+                V2S_TRACE_SPAN("stage.model_load", "pipeline");
+                transcriber_ready = initialize_transcriber();
+            }
+            if (!transcriber_ready) {
+                result.error_message = "转录器初始化失败";
+                return result;
+            }
+            if (check_cancelled()) return result;
         
-        report_progress(progress_callback, "语音转录", 0.5, "正在转录音频...");
+            report_progress(progress_callback, "语音转录", 0.5, "正在转录音频...");
         
-        TranscriptionResult transcription = transcriber_->transcribe(audio_path, config_.language);
+            {
+                StageTimer timer(stats.transcribe);
+                V2S_TRACE_SPAN("stage.transcribe", "pipeline");
+                transcription = transcriber_->transcribe(audio_path, config_.language, cancel);
+            }
+            stats.bytes_read += wav_bytes;
+            if (check_cancelled()) return result;
         
-        report_progress(progress_callback, "语音转录", 0.8, "转录完成");
+            report_progress(progress_callback, "语音转录", 0.8, "转录完成");
+        }
         
         // 阶段3: 合并与翻译
         report_progress(progress_callback, "处理字幕", 0.85, "正在整理字幕段...");
 
         // 应用段合并与限制
-        std::vector<Segment> processed_segments = transcription.segments;
-        if (config_.merge_segments) {
-            processed_segments = merge_segments(processed_segments,
-                                               config_.max_segment_duration,
-                                               config_.max_segment_chars);
+        std::vector<Segment> processed_segments;
+        {
+            StageTimer timer(stats.merge);
+            V2S_TRACE_SPAN("stage.merge", "pipeline");
+            processed_segments = transcription.segments;
+            if (config_.merge_segments) {
+                processed_segments = merge_segments(processed_segments,
+                                                   config_.max_segment_duration,
+                                                   config_.max_segment_chars);
+            }
         }
 
-        // 翻译（如果需要）
-        std::optional<TranslationResult> translation_result;
-        if (config_.translate_to.has_value()) {
+        // 翻译（如果需要）：多个目标语言时一次请求同时翻译，每种语言各输出一个文件
+        std::vector<TranslationResult> translation_results;
+        if (!config_.translate_to.empty()) {
             report_progress(progress_callback, "翻译", 0.9, "正在翻译字幕...");
-            auto translator = create_translator(config_.translator_type, config_.translator_options);
-            translation_result = translator->translate_segments(processed_segments,
-                                                                config_.translate_to.value(),
-                                                                transcription.language);
+            StageTimer timer(stats.translate);
+            V2S_TRACE_SPAN("stage.translate", "pipeline");
+            const size_t target_count = config_.translate_to.size();
+            // 翻译队列深度：等待翻译的字幕段数
+            static metrics::Gauge& pending = metrics::gauge("v2s_translation_queue_segments",
+                                                            "Segments waiting for translation");
+            metrics::ScopedGaugeInc queued(pending, static_cast<double>(processed_segments.size() * target_count));
+            TranslatorOptions translator_options = config_.translator_options;
+            translator_options.cancel = cancel;
+            auto translator = create_translator(config_.translator_type, translator_options,
+                                                config_.fallback_translators);
+            // 逐段进度：译文就绪即上报（流式批量翻译时可能在网络线程中并发回调）
+            std::mutex progress_mutex;
+            size_t translated_count = 0;
+            const size_t total_segments = processed_segments.size() * target_count;
+            if (progress_callback && total_segments > 0) {
+                translator->set_segment_callback([&](size_t, const std::string&) {
+                    std::lock_guard<std::mutex> lock(progress_mutex);
+                    translated_count = std::min(total_segments, translated_count + 1);
+                    report_progress(progress_callback, "翻译",
+                                    0.9 + 0.05 * static_cast<double>(translated_count) / static_cast<double>(total_segments),
+                                    "已翻译 " + std::to_string(translated_count) + "/" + std::to_string(total_segments));
+                });
+            }
+            if (target_count == 1) {
+                translation_results.push_back(translator->translate_segments(processed_segments,
+                                                                             config_.translate_to.front(),
+                                                                             transcription.language));
+            } else {
+                translation_results = translator->translate_segments_multi(processed_segments, config_.translate_to,
+                                                                           transcription.language);
+            }
+            // 请求统计只在第一个结果上；失败与缓存按语言累加
+            const TranslationStats& tstats = translation_results.front().stats;
+            stats.http = summarize_http_requests(tstats);
+            stats.translation.segment_count = processed_segments.size() * target_count;
+            stats.translation.deduplicated_segments = tstats.deduplicated_segments;
+            stats.translation.hedged_requests = tstats.hedged_requests;
+            stats.translation.hedge_wins = tstats.hedge_wins;
+            stats.translation.failover_segments = tstats.failover_segments;
+            stats.translation.retries = tstats.retries;
+            stats.translation.usage = tstats.usage;
+            stats.translation.estimated_cost = estimate_translation_cost(tstats.usage, config_.translator_options);
+            for (const auto& tr : translation_results) {
+                stats.translation.failed_count += tr.failed_indices.size();
+                stats.translation.cache_hits += tr.stats.cache_hits;
+                stats.translation.cache_misses += tr.stats.cache_misses;
+                stats.translation.fuzzy_hits += tr.stats.fuzzy_hits;
+            }
         }
+        if (check_cancelled()) return result;
 
         // 阶段4: 格式化与保存
         report_progress(progress_callback, "保存", 0.95, "正在生成输出文件...");
 
-        bool save_ok = false;
         std::string fmt = config_.output_format;
         std::transform(fmt.begin(), fmt.end(), fmt.begin(), ::tolower);
 
-        if (fmt == "vtt") {
-            // 生成VTT内容
-            std::string vtt_content;
-            if (translation_result.has_value()) {
-                if (config_.bilingual) {
-                    vtt_content = WebVTTFormatter::create_bilingual_vtt(processed_segments, translation_result->segments);
-                } else {
-                    vtt_content = WebVTTFormatter::format_segments(translation_result->segments, config_.min_segment_duration);
-                }
-            } else {
-                vtt_content = WebVTTFormatter::format_segments(processed_segments, config_.min_segment_duration);
+        // 格式化一份字幕（translated 为空表示仅原文）
+        auto render = [&](const std::vector<Segment>* translated) {
+            if (fmt == "vtt") {
+                if (!translated) return WebVTTFormatter::format_segments(processed_segments, config_.min_segment_duration);
+                if (config_.bilingual) return WebVTTFormatter::create_bilingual_vtt(processed_segments, *translated);
+                return WebVTTFormatter::format_segments(*translated, config_.min_segment_duration);
             }
-            save_ok = WebVTTFormatter::save_vtt(vtt_content, output_path);
-            if (!save_ok) {
-                cleanup_temp_files(temp_dir);
-                result.error_message = "保存VTT文件失败: " + output_path.string();
-                return result;
+            if (fmt == "ass") {
+                if (!translated) return ASSFormatter::format_segments(processed_segments, config_.ass_style, config_.min_segment_duration);
+                if (config_.bilingual) return ASSFormatter::create_bilingual_ass(processed_segments, *translated, config_.ass_style, config_.min_segment_duration);
+                return ASSFormatter::format_segments(*translated, config_.ass_style, config_.min_segment_duration);
             }
-        } else if (fmt == "ass") {
-            // 生成ASS内容
-            std::string ass_content;
-            if (translation_result.has_value()) {
-                if (config_.bilingual) {
-                    ass_content = ASSFormatter::create_bilingual_ass(processed_segments, translation_result->segments, config_.ass_style, config_.min_segment_duration);
-                } else {
-                    ass_content = ASSFormatter::format_segments(translation_result->segments, config_.ass_style, config_.min_segment_duration);
-                }
-            } else {
-                ass_content = ASSFormatter::format_segments(processed_segments, config_.ass_style, config_.min_segment_duration);
+            // 默认SRT
+            if (!translated) return SRTFormatter::format_segments(processed_segments, config_.min_segment_duration);
+            if (config_.bilingual) return SRTFormatter::create_bilingual_srt(processed_segments, *translated);
+            return SRTFormatter::format_segments(*translated, config_.min_segment_duration);
+        };
+
+        // 输出文件：单一目标语言沿用 output_path；多个目标语言时为 <stem>.<lang><ext>
+        std::vector<std::pair<std::filesystem::path, const std::vector<Segment>*>> outputs;
+        if (translation_results.empty()) {
+            outputs.emplace_back(output_path, nullptr);
+        } else if (translation_results.size() == 1) {
+            outputs.emplace_back(output_path, &translation_results.front().segments);
+        } else {
+            for (size_t t = 0; t < translation_results.size(); ++t) {
+                std::filesystem::path path = output_path;
+                path.replace_filename(output_path.stem().string() + "." + config_.translate_to[t] +
+                                      output_path.extension().string());
+                outputs.emplace_back(path, &translation_results[t].segments);
             }
-            save_ok = ASSFormatter::save_ass(ass_content, output_path);
-            if (!save_ok) {
-                cleanup_temp_files(temp_dir);
-                result.error_message = "保存ASS文件失败: " + output_path.string();
-                return result;
+        }
+
+        for (const auto& [path, translated] : outputs) {
+            std::string content;
+            {
+                StageTimer timer(stats.format);
+                V2S_TRACE_SPAN("stage.format", "pipeline");
+                content = render(translated);
             }
-        } else { // 默认SRT
-            std::string srt_content;
-            if (translation_result.has_value()) {
-                if (config_.bilingual) {
-                    srt_content = SRTFormatter::create_bilingual_srt(processed_segments, translation_result->segments);
+
+            bool save_ok = false;
+            std::string fmt_label;
+            {
+                StageTimer timer(stats.write);
+                V2S_TRACE_SPAN("stage.write", "pipeline");
+                if (fmt == "vtt") {
+                    fmt_label = "VTT";
+                    save_ok = WebVTTFormatter::save_vtt(content, path);
+                } else if (fmt == "ass") {
+                    fmt_label = "ASS";
+                    save_ok = ASSFormatter::save_ass(content, path);
                 } else {
-                    srt_content = SRTFormatter::format_segments(translation_result->segments, config_.min_segment_duration);
+                    fmt_label = "SRT";
+                    save_ok = SRTFormatter::save_srt(content, path);
                 }
-            } else {
-                srt_content = SRTFormatter::format_segments(processed_segments, config_.min_segment_duration);
             }
-            save_ok = SRTFormatter::save_srt(srt_content, output_path);
             if (!save_ok) {
-                cleanup_temp_files(temp_dir);
-                result.error_message = "保存SRT文件失败: " + output_path.string();
+                result.error_message = "保存" + fmt_label + "文件失败: " + path.string();
                 return result;
             }
+            stats.bytes_written += file_size_or_zero(path);
+            result.output_paths.push_back(path.string());
         }
         
         report_progress(progress_callback, "完成", 1.0, "处理完成");
         
-        // 清理临时文件
-        cleanup_temp_files(temp_dir);
-        
         // 设置结果
         result.success = true;
-        result.output_path = output_path.string();
+        result.output_path = result.output_paths.front();
         result.transcription = transcription;
-        if (translation_result.has_value()) {
-            result.translation = translation_result.value();
+        if (!translation_results.empty()) {
+            result.translation = translation_results.front();
         }
-        // result.segments = processed_segments;  // ProcessingResult没有segments字段
-        result.processing_time = 0.0;  // TODO: 实际计算处理时间
+        result.translations = std::move(translation_results);
         
     } catch (const std::exception& e) {
-        result.error_message = "处理过程中发生错误: " + std::string(e.what());
+        if (!check_cancelled()) {
+            result.error_message = "处理过程中发生错误: " + std::string(e.what());
+        }
     }
     
     return result;
@@ -177,7 +498,8 @@ ProcessingResult Processor::process(const std::filesystem::path& input_path,
 
 bool Processor::extract_audio_only(const std::filesystem::path& input_path,
                                  const std::filesystem::path& output_path,
-                                 ProgressCallback progress_callback) {
+                                 ProgressCallback progress_callback,
+                                 const CancellationToken& cancel) {
     try {
         if (!std::filesystem::exists(input_path)) {
             return false;
@@ -185,7 +507,7 @@ bool Processor::extract_audio_only(const std::filesystem::path& input_path,
         
         report_progress(progress_callback, "音频提取", 0.0, "开始提取音频...");
         
-        bool success = extract_audio_to_wav(input_path.string(), output_path.string(), 16000);
+        bool success = extract_audio_to_wav(input_path.string(), output_path.string(), 16000, cancel);
         
         if (success) {
             report_progress(progress_callback, "音频提取", 1.0, "音频提取完成");
@@ -312,18 +634,33 @@ bool Processor::initialize_transcriber() {
 std::filesystem::path Processor::create_temp_directory() {
     // 创建临时目录
     std::filesystem::path temp_base = std::filesystem::temp_directory_path();
-    
-    // 生成随机目录名
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(1000, 9999);
-    
-    std::string temp_name = "video2srt_" + std::to_string(dis(gen));
-    std::filesystem::path temp_dir = temp_base / temp_name;
-    
-    std::filesystem::create_directories(temp_dir);
-    
-    return temp_dir;
+
+    // 目录名：进程号 + 进程内序号 + 64 位随机数；并发作业与多个进程互不冲突
+    static std::atomic<uint64_t> sequence{0};
+    static std::mutex rng_mutex;
+    static std::mt19937_64 rng{(static_cast<uint64_t>(std::random_device{}()) << 32) ^ std::random_device{}()};
+#ifdef _WIN32
+    const unsigned long pid = static_cast<unsigned long>(_getpid());
+#else
+    const unsigned long pid = static_cast<unsigned long>(getpid());
+#endif
+
+    for (int attempt = 0; attempt < 16; ++attempt) {
+        uint64_t nonce;
+        {
+            std::lock_guard<std::mutex> lock(rng_mutex);
+            nonce = rng();
+        }
+        std::ostringstream name;
+        name << "video2srt_" << pid << '_' << sequence.fetch_add(1) << '_' << std::hex << nonce;
+        std::filesystem::path temp_dir = temp_base / name.str();
+
+        // create_directory 对已存在的目录返回 false：换一个名字重试，绝不复用他人的目录
+        if (std::filesystem::create_directory(temp_dir)) {
+            return temp_dir;
+        }
+    }
+    throw std::runtime_error("无法创建唯一的临时目录: " + temp_base.string());
 }
 
 void Processor::cleanup_temp_files(const std::filesystem::path& temp_dir) {
@@ -0,0 +1,327 @@
+#include "video2srt_native/rate_limiter.hpp"
+#include "video2srt_native/metrics.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <unordered_map>
+
+namespace v2s {
+
+namespace {
+
+// 单次条件变量等待的上限：保证取消在 100ms 内生效
+constexpr std::chrono::milliseconds kWaitSlice{100};
+// 两次乘性减小之间的最短间隔（同一波并发请求同时收到 429 时只减半一次）
+constexpr std::chrono::milliseconds kDecreaseInterval{1000};
+
+std::string to_lower(std::string s) {
+    std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return s;
+}
+
+/**
+ * 提取端点标识：scheme://host:port（小写，补全默认端口）
+ */
+std::string endpoint_of(const std::string& url) {
+    std::string lower = to_lower(url);
+    std::string scheme = "http";
+    size_t pos = lower.find("://");
+    size_t host_begin = 0;
+    if (pos != std::string::npos) {
+        scheme = lower.substr(0, pos);
+        host_begin = pos + 3;
+    }
+    size_t host_end = lower.find_first_of("/?#", host_begin);
+    std::string authority = lower.substr(host_begin, host_end == std::string::npos ? std::string::npos : host_end - host_begin);
+    size_t at = authority.rfind('@');
+    if (at != std::string::npos) authority = authority.substr(at + 1);
+    // IPv6 字面量 [::1]:port 的端口在 ']' 之后
+    size_t bracket = authority.rfind(']');
+    size_t colon = authority.rfind(':');
+    if (colon == std::string::npos || (bracket != std::string::npos && colon < bracket)) {
+        authority += scheme == "https" ? ":443" : ":80";
+    }
+    return scheme + "://" + authority;
+}
+
+/**
+ * 解析 OpenAI 风格的时长（"1s"、"6m0s"、"20ms"、"1h2m3.5s"），纯数字按秒处理
+ */
+std::optional<std::chrono::milliseconds> parse_duration(const std::string& s) {
+    if (s.empty()) return std::nullopt;
+    double total_ms = 0.0;
+    size_t i = 0;
+    bool any = false;
+    while (i < s.size()) {
+        while (i < s.size() && std::isspace(static_cast<unsigned char>(s[i]))) ++i;
+        if (i >= s.size()) break;
+        const char* begin = s.c_str() + i;
+        char* end = nullptr;
+        double v = std::strtod(begin, &end);
+        if (end == begin) return std::nullopt;
+        i += static_cast<size_t>(end - begin);
+        std::string unit;
+        while (i < s.size() && std::isalpha(static_cast<unsigned char>(s[i]))) unit += s[i++];
+        double factor;
+        if (unit.empty() || unit == "s") factor = 1000.0;
+        else if (unit == "ms") factor = 1.0;
+        else if (unit == "m") factor = 60000.0;
+        else if (unit == "h") factor = 3600000.0;
+        else return std::nullopt;
+        total_ms += v * factor;
+        any = true;
+    }
+    if (!any || total_ms < 0) return std::nullopt;
+    return std::chrono::milliseconds(static_cast<long long>(std::ceil(total_ms)));
+}
+
+/**
+ * 解析通用 ratelimit-reset / x-ratelimit-reset：剩余秒数，或（>= 1e9 时）Unix 时间戳
+ */
+std::optional<std::chrono::milliseconds> parse_reset_seconds(const std::string& s) {
+    char* end = nullptr;
+    double v = std::strtod(s.c_str(), &end);
+    if (end == s.c_str() || v < 0) return std::nullopt;
+    if (v >= 1e9) {
+        double now = static_cast<double>(std::time(nullptr));
+        v = std::max(0.0, v - now);
+    }
+    return std::chrono::milliseconds(static_cast<long long>(std::ceil(v * 1000.0)));
+}
+
+bool header_is_zero(const HttpResponse& resp, const char* name) {
+    auto v = resp.header(name);
+    if (!v) return false;
+    char* end = nullptr;
+    double n = std::strtod(v->c_str(), &end);
+    return end != v->c_str() && n <= 0.0;
+}
+
+} // namespace
+
+EndpointLimiter::Permit& EndpointLimiter::Permit::operator=(Permit&& other) noexcept {
+    if (this != &other) {
+        if (owner_) owner_->release();
+        owner_ = other.owner_;
+        other.owner_ = nullptr;
+    }
+    return *this;
+}
+
+EndpointLimiter::Permit::~Permit() {
+    if (owner_) owner_->release();
+}
+
+std::shared_ptr<EndpointLimiter> EndpointLimiter::for_url(const std::string& url) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<EndpointLimiter>> registry;
+    std::string endpoint = endpoint_of(url);
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[endpoint];
+    if (!slot) slot = std::make_shared<EndpointLimiter>(endpoint);
+    return slot;
+}
+
+EndpointLimiter::EndpointLimiter(std::string endpoint) : endpoint_(std::move(endpoint)) {}
+
+EndpointLimiter::Registration& EndpointLimiter::Registration::operator=(Registration&& other) noexcept {
+    if (this != &other) {
+        if (owner_) owner_->unregister(id_);
+        owner_ = other.owner_;
+        id_ = other.id_;
+        other.owner_ = nullptr;
+    }
+    return *this;
+}
+
+EndpointLimiter::Registration::~Registration() {
+    if (owner_) owner_->unregister(id_);
+}
+
+EndpointLimiter::Registration EndpointLimiter::configure(double requests_per_second, int burst, int max_concurrency) {
+    uint64_t id;
+    double limit_now;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        id = next_config_id_++;
+        configs_[id] = Config{requests_per_second, burst, std::max(1, max_concurrency)};
+        apply_configs_locked();
+        limit_now = limit_;
+    }
+    metrics::gauge("v2s_http_concurrency_limit", "AIMD concurrency limit per endpoint", {{"endpoint", endpoint_}})
+        .set(limit_now);
+    cv_.notify_all();
+    return Registration(this, id);
+}
+
+void EndpointLimiter::unregister(uint64_t id) {
+    double limit_now;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (configs_.erase(id) == 0) return;
+        apply_configs_locked();
+        limit_now = limit_;
+    }
+    metrics::gauge("v2s_http_concurrency_limit", "AIMD concurrency limit per endpoint", {{"endpoint", endpoint_}})
+        .set(limit_now);
+    cv_.notify_all();
+}
+
+// 按仍在登记的配置重新计算：速率取最严格者（连同其 burst），并发上限取最大值
+void EndpointLimiter::apply_configs_locked() {
+    const Config* strictest = nullptr;
+    int max_concurrency = 1;
+    for (const auto& [id, config] : configs_) {
+        if (config.requests_per_second > 0.0 &&
+            (!strictest || config.requests_per_second < strictest->requests_per_second)) {
+            strictest = &config;
+        }
+        max_concurrency = std::max(max_concurrency, config.max_concurrency);
+    }
+    refill_locked(Clock::now());
+    if (strictest) {
+        rate_ = strictest->requests_per_second;
+        const double b = strictest->burst > 0 ? static_cast<double>(strictest->burst) : std::floor(rate_);
+        burst_ = std::max(1.0, b);
+    } else {
+        rate_ = 0.0;
+        burst_ = 1.0;
+    }
+    tokens_ = std::min(tokens_, burst_);
+    max_concurrency_ = max_concurrency;
+    // 尚未被限流时直接取并发上界；出现 429/503 后保留 AIMD 的当前值，只按新上界截断（调高后由 AIMD 逐步增长）
+    if (last_decrease_ == Clock::time_point{}) {
+        limit_ = max_concurrency_;
+    } else {
+        limit_ = std::min(limit_, static_cast<double>(max_concurrency_));
+    }
+}
+
+void EndpointLimiter::refill_locked(Clock::time_point now) {
+    double rate = rate_;
+    if (learned_rate_ > 0.0) rate = rate > 0.0 ? std::min(rate, learned_rate_) : learned_rate_;
+    if (rate <= 0.0) {
+        tokens_ = burst_;
+        last_refill_ = now;
+        return;
+    }
+    double elapsed = std::chrono::duration<double>(now - last_refill_).count();
+    tokens_ = std::min(burst_, tokens_ + elapsed * rate);
+    last_refill_ = now;
+}
+
+EndpointLimiter::Permit EndpointLimiter::acquire(const CancellationToken& cancel) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        if (cancel.is_cancelled()) return Permit();
+        auto now = Clock::now();
+        Clock::time_point wake = now + kWaitSlice;
+        if (now < paused_until_) {
+            wake = std::min(wake, paused_until_);
+        } else if (in_flight_ >= std::max(1, static_cast<int>(limit_))) {
+            // 等待其他请求归还名额（release 会唤醒）
+        } else {
+            refill_locked(now);
+            if (tokens_ >= 1.0) {
+                tokens_ -= 1.0;
+                ++in_flight_;
+                return Permit(this);
+            }
+            double rate = rate_;
+            if (learned_rate_ > 0.0) rate = rate > 0.0 ? std::min(rate, learned_rate_) : learned_rate_;
+            if (rate > 0.0) {
+                auto need = std::chrono::duration<double>((1.0 - tokens_) / rate);
+                wake = std::min(wake, now + std::chrono::duration_cast<Clock::duration>(need));
+            }
+        }
+        cv_.wait_until(lock, wake);
+    }
+}
+
+void EndpointLimiter::release() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (in_flight_ > 0) --in_flight_;
+    }
+    cv_.notify_one();
+}
+
+void EndpointLimiter::pause_for(std::chrono::milliseconds duration) {
+    if (duration.count() <= 0) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    paused_until_ = std::max(paused_until_, Clock::now() + duration);
+}
+
+void EndpointLimiter::on_response(const HttpResponse& resp) {
+    if (resp.cancelled) return;
+
+    // 服务端要求的暂停：Retry-After 优先，其次 x-ratelimit-remaining-* 为 0 时等到对应 reset
+    if (auto retry_after = parse_retry_after(resp)) {
+        pause_for(std::min(*retry_after, std::chrono::milliseconds(60000)));
+    }
+    if (header_is_zero(resp, "x-ratelimit-remaining-requests")) {
+        if (auto v = resp.header("x-ratelimit-reset-requests")) {
+            if (auto d = parse_duration(*v)) pause_for(*d);
+        }
+    }
+    if (header_is_zero(resp, "x-ratelimit-remaining-tokens")) {
+        if (auto v = resp.header("x-ratelimit-reset-tokens")) {
+            if (auto d = parse_duration(*v)) pause_for(*d);
+        }
+    }
+    for (const char* prefix : {"ratelimit", "x-ratelimit"}) {
+        std::string p = prefix;
+        if (header_is_zero(resp, (p + "-remaining").c_str())) {
+            if (auto v = resp.header(p + "-reset")) {
+                if (auto d = parse_reset_seconds(*v)) pause_for(std::min(*d, std::chrono::milliseconds(60000)));
+            }
+        }
+    }
+
+    bool throttled = resp.status == 429 || resp.status == 503;
+    double limit_now;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // 学习服务端公布的每分钟请求上限
+        if (auto v = resp.header("x-ratelimit-limit-requests")) {
+            double rpm = std::strtod(v->c_str(), nullptr);
+            if (rpm > 0.0) {
+                learned_rate_ = rpm / 60.0;
+                if (burst_ < 1.0) burst_ = 1.0;
+            }
+        }
+
+        auto now = Clock::now();
+        if (throttled) {
+            if (now - last_decrease_ >= kDecreaseInterval) {
+                limit_ = std::max(1.0, limit_ / 2.0);
+                last_decrease_ = now;
+            }
+        } else if (resp.ok()) {
+            limit_ = std::min(static_cast<double>(max_concurrency_), limit_ + 1.0 / std::max(1.0, limit_));
+        }
+        limit_now = limit_;
+    }
+    if (throttled) {
+        metrics::counter("v2s_http_throttled_total", "HTTP responses signalling rate limiting (429/503)",
+                         {{"endpoint", endpoint_}}).inc();
+    }
+    metrics::gauge("v2s_http_concurrency_limit", "AIMD concurrency limit per endpoint", {{"endpoint", endpoint_}})
+        .set(limit_now);
+    cv_.notify_all();
+}
+
+double EndpointLimiter::concurrency_limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return limit_;
+}
+
+double EndpointLimiter::rate_limit() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (learned_rate_ > 0.0) return rate_ > 0.0 ? std::min(rate_, learned_rate_) : learned_rate_;
+    return rate_;
+}
+
+} // namespace v2s
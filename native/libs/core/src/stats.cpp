@@ -0,0 +1,195 @@
+#include "video2srt_native/stats.hpp"
+#include <algorithm>
+#include <cmath>
+#include <nlohmann/json.hpp>
+
+#if defined(_WIN32)
+#  include <windows.h>
+#  include <psapi.h>
+#else
+#  include <sys/resource.h>
+#  include <unistd.h>
+#  include <fstream>
+#endif
+
+namespace v2s {
+
+double process_cpu_seconds() {
+#if defined(_WIN32)
+    FILETIME creation, exit_time, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exit_time, &kernel, &user)) {
+        return 0.0;
+    }
+    auto to_seconds = [](const FILETIME& ft) {
+        ULARGE_INTEGER v;
+        v.LowPart = ft.dwLowDateTime;
+        v.HighPart = ft.dwHighDateTime;
+        return static_cast<double>(v.QuadPart) / 1e7; // 100ns 为单位
+    };
+    return to_seconds(kernel) + to_seconds(user);
+#else
+    struct rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        return 0.0;
+    }
+    auto to_seconds = [](const struct timeval& tv) {
+        return static_cast<double>(tv.tv_sec) + static_cast<double>(tv.tv_usec) / 1e6;
+    };
+    return to_seconds(ru.ru_utime) + to_seconds(ru.ru_stime);
+#endif
+}
+
+uint64_t peak_rss_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return static_cast<uint64_t>(pmc.PeakWorkingSetSize);
+    }
+    return 0;
+#else
+    struct rusage ru{};
+    if (getrusage(RUSAGE_SELF, &ru) != 0) {
+        return 0;
+    }
+#  if defined(__APPLE__)
+    return static_cast<uint64_t>(ru.ru_maxrss);          // macOS 单位为字节
+#  else
+    return static_cast<uint64_t>(ru.ru_maxrss) * 1024;   // Linux 单位为 KB
+#  endif
+#endif
+}
+
+uint64_t current_rss_bytes() {
+#if defined(_WIN32)
+    PROCESS_MEMORY_COUNTERS pmc{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+        return static_cast<uint64_t>(pmc.WorkingSetSize);
+    }
+    return 0;
+#elif defined(__linux__)
+    // /proc/self/statm 第二列为常驻页数
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size_pages = 0, resident_pages = 0;
+    if (statm >> size_pages >> resident_pages) {
+        return resident_pages * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+    }
+    return peak_rss_bytes();
+#else
+    return peak_rss_bytes();
+#endif
+}
+
+StageTimer::StageTimer(StageTiming& out)
+    : out_(&out)
+    , wall_start_(std::chrono::steady_clock::now())
+    , cpu_start_(process_cpu_seconds()) {
+}
+
+StageTimer::~StageTimer() {
+    stop();
+}
+
+void StageTimer::stop() {
+    if (!out_) return;
+    auto wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start_).count();
+    out_->wall_seconds += wall;
+    out_->cpu_seconds += std::max(0.0, process_cpu_seconds() - cpu_start_);
+    out_ = nullptr;
+}
+
+// 最近秩法（nearest-rank）计算分位数，输入需已排序
+static double percentile_sorted(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) return 0.0;
+    size_t rank = static_cast<size_t>(std::ceil(p * static_cast<double>(sorted.size())));
+    if (rank == 0) rank = 1;
+    return sorted[std::min(rank, sorted.size()) - 1];
+}
+
+HttpRequestStats summarize_http_requests(const TranslationStats& stats) {
+    HttpRequestStats out;
+    out.request_count = stats.request_count;
+    out.failed_count = stats.failed_requests;
+    if (stats.request_latencies_ms.empty()) {
+        return out;
+    }
+    std::vector<double> sorted = stats.request_latencies_ms;
+    std::sort(sorted.begin(), sorted.end());
+    out.latency_p50_ms = percentile_sorted(sorted, 0.50);
+    out.latency_p90_ms = percentile_sorted(sorted, 0.90);
+    out.latency_p99_ms = percentile_sorted(sorted, 0.99);
+    out.latency_max_ms = sorted.back();
+    return out;
+}
+
+double estimate_translation_cost(const TokenUsage& usage, const TranslatorOptions& options) {
+    const double cached_price = options.price_per_million_cached_tokens > 0.0
+        ? options.price_per_million_cached_tokens
+        : options.price_per_million_prompt_tokens;
+    const size_t cached = std::min(usage.cached_prompt_tokens, usage.prompt_tokens);
+    return (static_cast<double>(usage.prompt_tokens - cached) * options.price_per_million_prompt_tokens +
+            static_cast<double>(cached) * cached_price +
+            static_cast<double>(usage.completion_tokens) * options.price_per_million_completion_tokens) / 1e6;
+}
+
+std::string stats_to_json(const ProcessingStats& stats, int indent) {
+    // 使用 ordered_json 保持字段按流水线顺序输出
+    using json = nlohmann::ordered_json;
+    auto stage = [](const StageTiming& t) {
+        return json{{"wall_seconds", t.wall_seconds}, {"cpu_seconds", t.cpu_seconds}};
+    };
+
+    json j;
+    j["stages"] = json{
+        {"probe", stage(stats.probe)},
+        {"extract", stage(stats.extract)},
+        {"model_load", stage(stats.model_load)},
+        {"transcribe", stage(stats.transcribe)},
+        {"merge", stage(stats.merge)},
+        {"translate", stage(stats.translate)},
+        {"format", stage(stats.format)},
+        {"write", stage(stats.write)},
+        {"total", stage(stats.total)}
+    };
+    j["transcript_source"] = stats.subtitle_stream_index >= 0 ? "embedded_subtitles" : "asr";
+    if (stats.subtitle_stream_index >= 0) {
+        j["subtitle_stream_index"] = stats.subtitle_stream_index;
+    }
+    j["audio_duration_seconds"] = stats.audio_duration_seconds;
+    j["real_time_factor"] = stats.real_time_factor;
+    j["bytes_read"] = stats.bytes_read;
+    j["bytes_written"] = stats.bytes_written;
+    j["http"] = json{
+        {"request_count", stats.http.request_count},
+        {"failed_count", stats.http.failed_count},
+        {"latency_ms", json{
+            {"p50", stats.http.latency_p50_ms},
+            {"p90", stats.http.latency_p90_ms},
+            {"p99", stats.http.latency_p99_ms},
+            {"max", stats.http.latency_max_ms}
+        }}
+    };
+    j["translation"] = json{
+        {"segment_count", stats.translation.segment_count},
+        {"failed_count", stats.translation.failed_count},
+        {"cache_hits", stats.translation.cache_hits},
+        {"cache_misses", stats.translation.cache_misses},
+        {"fuzzy_hits", stats.translation.fuzzy_hits},
+        {"deduplicated_segments", stats.translation.deduplicated_segments},
+        {"hedged_requests", stats.translation.hedged_requests},
+        {"hedge_wins", stats.translation.hedge_wins},
+        {"failover_segments", stats.translation.failover_segments},
+        {"retries", stats.translation.retries},
+        {"tokens", json{
+            {"prompt", stats.translation.usage.prompt_tokens},
+            {"cached_prompt", stats.translation.usage.cached_prompt_tokens},
+            {"completion", stats.translation.usage.completion_tokens},
+            {"wasted", stats.translation.usage.wasted_tokens},
+            {"requests_with_usage", stats.translation.usage.requests_with_usage}
+        }},
+        {"estimated_cost", stats.translation.estimated_cost}
+    };
+    j["peak_rss_bytes"] = stats.peak_rss_bytes;
+    return j.dump(indent);
+}
+
+} // namespace v2s
@@ -0,0 +1,138 @@
+#include "video2srt_native/stream_parser.hpp"
+#include <nlohmann/json.hpp>
+
+namespace v2s {
+
+// ---------------- SseDecoder ----------------
+
+SseDecoder::SseDecoder(EventCallback on_event) : on_event_(std::move(on_event)) {}
+
+void SseDecoder::feed(std::string_view chunk) {
+    for (char c : chunk) {
+        if (pending_cr_) {
+            pending_cr_ = false;
+            if (c == '\n') continue;   // \r\n 视为一个换行
+        }
+        if (c == '\r' || c == '\n') {
+            pending_cr_ = (c == '\r');
+            process_line(line_);
+            line_.clear();
+        } else {
+            line_ += c;
+        }
+    }
+}
+
+void SseDecoder::finish() {
+    if (!line_.empty()) {
+        process_line(line_);
+        line_.clear();
+    }
+    dispatch();
+}
+
+void SseDecoder::process_line(std::string_view line) {
+    if (line.empty()) {
+        dispatch();
+        return;
+    }
+    if (line.front() == ':') return;   // 注释/心跳
+    std::string_view field = line;
+    std::string_view value;
+    const size_t colon = line.find(':');
+    if (colon != std::string_view::npos) {
+        field = line.substr(0, colon);
+        value = line.substr(colon + 1);
+        if (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+    }
+    if (field == "data") {
+        if (has_data_) data_ += '\n';
+        data_.append(value.data(), value.size());
+        has_data_ = true;
+    } else if (field == "event") {
+        event_.assign(value.data(), value.size());
+    }
+    // id / retry 与未知字段忽略
+}
+
+void SseDecoder::dispatch() {
+    if (has_data_) {
+        ++events_;
+        if (on_event_) on_event_(event_.empty() ? std::string("message") : event_, data_);
+    }
+    data_.clear();
+    event_.clear();
+    has_data_ = false;
+}
+
+// ---------------- JsonStringArrayStreamer ----------------
+
+JsonStringArrayStreamer::JsonStringArrayStreamer(std::string key, ItemCallback on_item)
+    : needle_("\"" + key + "\""), on_item_(std::move(on_item)) {}
+
+void JsonStringArrayStreamer::feed(std::string_view chunk) {
+    for (char c : chunk) {
+        if (state_ == State::Done || state_ == State::Stopped) return;
+        step(c);
+    }
+}
+
+void JsonStringArrayStreamer::step(char c) {
+    const bool ws = c == ' ' || c == '\n' || c == '\r' || c == '\t';
+    switch (state_) {
+        case State::SeekKey:
+            window_ += c;
+            if (window_.size() > needle_.size()) window_.erase(0, window_.size() - needle_.size());
+            if (window_ == needle_) {
+                window_.clear();
+                state_ = State::SeekColon;
+            }
+            break;
+        case State::SeekColon:
+            if (c == ':') state_ = State::SeekArray;
+            else if (!ws) state_ = State::Stopped;
+            break;
+        case State::SeekArray:
+            if (c == '[') state_ = State::InArray;
+            else if (!ws) state_ = State::Stopped;
+            break;
+        case State::InArray:
+            if (c == '"') {
+                current_.clear();
+                escape_ = false;
+                state_ = State::InString;
+            } else if (c == ']') {
+                state_ = State::Done;
+            } else if (!ws && c != ',') {
+                state_ = State::Stopped;   // 对象/数字等非字符串元素
+            }
+            break;
+        case State::InString:
+            if (escape_) {
+                escape_ = false;
+                current_ += c;
+            } else if (c == '\\') {
+                escape_ = true;
+                current_ += c;
+            } else if (c == '"') {
+                std::string value;
+                try {
+                    value = nlohmann::json::parse("\"" + current_ + "\"").get<std::string>();
+                } catch (...) {
+                    state_ = State::Stopped;
+                    return;
+                }
+                state_ = State::InArray;
+                const size_t index = emitted_++;
+                if (on_item_) on_item_(index, std::move(value));
+            } else {
+                current_ += c;
+            }
+            break;
+        case State::Done:
+        case State::Stopped:
+            break;
+    }
+}
+
+} // namespace v2s
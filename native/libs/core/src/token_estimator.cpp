@@ -0,0 +1,148 @@
+#include "video2srt_native/token_estimator.hpp"
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+
+namespace v2s {
+
+namespace {
+
+// 解码一个 UTF-8 码点（容错：非法字节按单字节处理），返回消耗的字节数
+size_t decode_utf8(std::string_view s, size_t i, uint32_t& cp) {
+    const unsigned char c = static_cast<unsigned char>(s[i]);
+    size_t len = 1;
+    if (c < 0x80) { cp = c; return 1; }
+    if ((c & 0xE0) == 0xC0) { cp = c & 0x1F; len = 2; }
+    else if ((c & 0xF0) == 0xE0) { cp = c & 0x0F; len = 3; }
+    else if ((c & 0xF8) == 0xF0) { cp = c & 0x07; len = 4; }
+    else { cp = 0xFFFD; return 1; }
+    if (i + len > s.size()) { cp = 0xFFFD; return 1; }
+    for (size_t k = 1; k < len; ++k) {
+        const unsigned char cc = static_cast<unsigned char>(s[i + k]);
+        if ((cc & 0xC0) != 0x80) { cp = 0xFFFD; return 1; }
+        cp = (cp << 6) | (cc & 0x3F);
+    }
+    return len;
+}
+
+bool is_latin_letter(uint32_t cp) {
+    return (cp >= 0x00C0 && cp <= 0x024F && cp != 0x00D7 && cp != 0x00F7) || (cp >= 0x1E00 && cp <= 0x1EFF);
+}
+
+// 非拉丁文字每个字符的平均 token 数（按 cl100k/o200k 在常见语料上的实测比例取偏高值）
+double script_weight(uint32_t cp) {
+    if (cp >= 0x0370 && cp <= 0x052F) return 0.45;   // 希腊、西里尔
+    if (cp >= 0x0530 && cp <= 0x05FF) return 0.6;    // 亚美尼亚、希伯来
+    if (cp >= 0x0600 && cp <= 0x06FF) return 0.5;    // 阿拉伯
+    if (cp >= 0x0900 && cp <= 0x0DFF) return 1.0;    // 印度诸文字
+    if (cp >= 0x0E00 && cp <= 0x0EFF) return 0.9;    // 泰、老挝
+    if (cp >= 0x1100 && cp <= 0x11FF) return 1.0;    // 谚文字母
+    if (cp >= 0x3000 && cp <= 0x303F) return 1.0;    // CJK 标点
+    if (cp >= 0x3040 && cp <= 0x30FF) return 0.9;    // 平假名、片假名
+    if (cp >= 0x3400 && cp <= 0x9FFF) return 1.0;    // 汉字
+    if (cp >= 0xAC00 && cp <= 0xD7AF) return 1.0;    // 谚文音节
+    if (cp >= 0xFF00 && cp <= 0xFFEF) return 1.0;    // 全角形式
+    if (cp >= 0x10000) return 2.0;                   // emoji 等增补平面字符
+    return 1.0;
+}
+
+size_t word_tokens(size_t letters) {
+    // 常见英文单词（<= 7 字母）多为单个 token，更长的词约每 4 字母 1 token
+    if (letters == 0) return 0;
+    if (letters <= 7) return 1;
+    return 1 + (letters - 7 + 3) / 4;
+}
+
+// 各语言相对英文的 token 密度（同一内容的 token 数之比）
+double language_density(const std::string& lang) {
+    std::string l;
+    for (char c : lang) {
+        if (c == '-' || c == '_') break;
+        l += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    if (l == "en") return 1.0;
+    if (l == "zh") return 1.2;
+    if (l == "ja") return 1.4;
+    if (l == "ko") return 1.5;
+    if (l == "fr" || l == "es" || l == "it" || l == "pt" || l == "de" || l == "nl") return 1.3;
+    if (l == "ru" || l == "uk" || l == "el") return 1.8;
+    if (l == "ar" || l == "he" || l == "fa") return 1.8;
+    if (l == "th" || l == "hi" || l == "vi") return 2.0;
+    return 0.0;   // 未知
+}
+
+} // namespace
+
+size_t estimate_tokens(std::string_view text) {
+    size_t tokens = 0;
+    double fractional = 0.0;
+    size_t word = 0;      // 当前拉丁单词的等效字母数
+    size_t digits = 0;    // 当前数字串长度
+    size_t i = 0;
+    auto flush = [&]() {
+        tokens += word_tokens(word);
+        tokens += (digits + 2) / 3;
+        word = 0;
+        digits = 0;
+    };
+    while (i < text.size()) {
+        const unsigned char c = static_cast<unsigned char>(text[i]);
+        if (c < 0x80) {
+            if (std::isalpha(c) || (c == '\'' && word > 0)) {
+                if (digits) flush();
+                ++word;
+            } else if (std::isdigit(c)) {
+                if (word) flush();
+                ++digits;
+            } else if (c == ' ' && i + 1 < text.size() && std::isalnum(static_cast<unsigned char>(text[i + 1]))) {
+                // 单个前导空格并入下一个单词
+                flush();
+            } else if (std::isspace(c)) {
+                flush();
+                ++tokens;
+                while (i + 1 < text.size() && std::isspace(static_cast<unsigned char>(text[i + 1]))) ++i;
+            } else {
+                flush();
+                ++tokens;   // 标点
+            }
+            ++i;
+            continue;
+        }
+        uint32_t cp = 0;
+        i += decode_utf8(text, i, cp);
+        if (is_latin_letter(cp)) {
+            if (digits) flush();
+            word += 2;   // 带变音符号的字母切分更碎
+            continue;
+        }
+        flush();
+        fractional += script_weight(cp);
+    }
+    flush();
+    return tokens + static_cast<size_t>(std::ceil(fractional));
+}
+
+size_t estimate_json_string_tokens(std::string_view text) {
+    size_t escapes = 0;
+    for (char ch : text) {
+        const unsigned char c = static_cast<unsigned char>(ch);
+        if (c == '"' || c == '\\' || c < 0x20) ++escapes;
+    }
+    // 两侧引号通常与相邻的 [ , ] 合并为 1 个 token
+    return estimate_tokens(text) + escapes + 1;
+}
+
+double translation_token_ratio(const std::string& source_language, const std::string& target_language) {
+    const double src = language_density(source_language);
+    const double dst = language_density(target_language);
+    if (src <= 0.0 || dst <= 0.0) {
+        // 只知道一侧时按英文折算，两侧都未知时按 1.0
+        if (dst > 0.0) return dst;
+        if (src > 0.0) return 1.0 / src;
+        return 1.0;
+    }
+    return dst / src;
+}
+
+} // namespace v2s
@@ -0,0 +1,172 @@
+#include "video2srt_native/trace.hpp"
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+namespace v2s {
+namespace trace {
+
+namespace detail {
+std::atomic<bool> g_enabled{false};
+}
+
+namespace {
+
+struct Event {
+    const char* name;
+    const char* category;
+    int64_t ts_us;
+    int64_t dur_us;
+};
+
+// 每个线程的事件缓冲由固定大小的块组成单链表：
+// 仅所属线程追加写入（无锁），导出线程按 count（release/acquire）读取已完成的事件
+constexpr size_t kChunkSize = 1024;
+
+struct Chunk {
+    Event events[kChunkSize];
+    std::atomic<size_t> count{0};
+    std::atomic<Chunk*> next{nullptr};
+};
+
+struct ThreadBuffer {
+    uint32_t tid = 0;
+    Chunk* head = nullptr;
+    Chunk* tail = nullptr;          // 仅所属线程访问
+    uint64_t skip = 0;              // start() 时已存在的事件数（导出时跳过），受 registry 锁保护
+
+    ~ThreadBuffer() {
+        Chunk* c = head;
+        while (c) {
+            Chunk* next = c->next.load(std::memory_order_relaxed);
+            delete c;
+            c = next;
+        }
+    }
+
+    uint64_t total() const {
+        uint64_t n = 0;
+        for (Chunk* c = head; c; c = c->next.load(std::memory_order_acquire)) {
+            n += c->count.load(std::memory_order_acquire);
+        }
+        return n;
+    }
+};
+
+struct Registry {
+    std::mutex mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+    uint32_t next_tid = 1;
+};
+
+Registry& registry() {
+    static Registry r;
+    return r;
+}
+
+const std::chrono::steady_clock::time_point& epoch() {
+    static const auto e = std::chrono::steady_clock::now();
+    return e;
+}
+
+thread_local ThreadBuffer* t_buffer = nullptr;
+
+ThreadBuffer* register_thread() {
+    auto buf = std::make_unique<ThreadBuffer>();
+    buf->head = buf->tail = new Chunk();
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+    buf->tid = r.next_tid++;
+    r.buffers.push_back(std::move(buf));
+    return r.buffers.back().get();
+}
+
+} // namespace
+
+namespace detail {
+
+int64_t now_us() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - epoch()).count();
+}
+
+void record(const char* name, const char* category, int64_t start_us, int64_t end_us) {
+    ThreadBuffer* buf = t_buffer;
+    if (!buf) {
+        buf = t_buffer = register_thread();
+    }
+    Chunk* c = buf->tail;
+    size_t n = c->count.load(std::memory_order_relaxed);
+    if (n == kChunkSize) {
+        Chunk* next = new Chunk();
+        c->next.store(next, std::memory_order_release);
+        buf->tail = c = next;
+        n = 0;
+    }
+    c->events[n] = Event{name, category, start_us, end_us - start_us};
+    c->count.store(n + 1, std::memory_order_release);
+}
+
+} // namespace detail
+
+void start() {
+    epoch(); // 确保时间基准已初始化
+    {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (auto& buf : r.buffers) {
+            buf->skip = buf->total();
+        }
+    }
+    detail::g_enabled.store(true, std::memory_order_relaxed);
+}
+
+void stop() {
+    detail::g_enabled.store(false, std::memory_order_relaxed);
+}
+
+bool write_chrome_json(const std::filesystem::path& path) {
+    std::ofstream ofs(path, std::ios::out | std::ios::trunc);
+    if (!ofs.is_open()) {
+        return false;
+    }
+
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mutex);
+
+    ofs << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+    bool first = true;
+    auto sep = [&]() {
+        if (!first) ofs << ",\n";
+        first = false;
+    };
+    for (const auto& buf : r.buffers) {
+        // 线程名元数据
+        sep();
+        ofs << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << buf->tid
+            << ",\"args\":{\"name\":\"thread-" << buf->tid << "\"}}";
+
+        uint64_t index = 0;
+        for (Chunk* c = buf->head; c; c = c->next.load(std::memory_order_acquire)) {
+            size_t count = c->count.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; ++i, ++index) {
+                if (index < buf->skip) continue;
+                const Event& e = c->events[i];
+                sep();
+                ofs << "{\"ph\":\"X\",\"name\":" << nlohmann::json(e.name).dump()
+                    << ",\"cat\":" << nlohmann::json(e.category).dump()
+                    << ",\"ts\":" << e.ts_us
+                    << ",\"dur\":" << e.dur_us
+                    << ",\"pid\":1,\"tid\":" << buf->tid << "}";
+            }
+        }
+    }
+    ofs << "]}\n";
+    return ofs.good();
+}
+
+} // namespace trace
+} // namespace v2s
@@ -4,6 +4,10 @@
 #include <sstream>
 #include <algorithm>
 #include "video2srt_native/model_manager.hpp"
+#include "video2srt_native/trace.hpp"
+#include "video2srt_native/metrics.hpp"
+#include "video2srt_native/probes.hpp"
+#include "video2srt_native/utf8.hpp"
 
 #if V2S_HAVE_WHISPER
 #include "whisper.h"
@@ -11,6 +15,14 @@
 
 namespace v2s {
 
+#if V2S_HAVE_WHISPER
+// 当前进程中已加载的 Whisper 模型数量
+static metrics::Gauge& loaded_models_gauge() {
+    static metrics::Gauge& g = metrics::gauge("v2s_models_loaded", "Whisper models currently loaded in memory");
+    return g;
+}
+#endif
+
 Transcriber::Transcriber(const TranscriptionConfig& config)
     : config_(config)
     , model_loaded_(false) {
@@ -48,6 +60,7 @@ Transcriber& Transcriber::operator=(Transcriber&& other) noexcept {
 }
 
 bool Transcriber::load_model() {
+    V2S_TRACE_SPAN("Transcriber::load_model", "whisper");
 #if V2S_HAVE_WHISPER
     if (model_loaded_) {
         return true;
@@ -76,6 +89,7 @@ bool Transcriber::load_model() {
     }
     
     model_loaded_ = true;
+    loaded_models_gauge().inc();
     std::cout << "模型加载完成" << std::endl;
     return true;
 #else
@@ -89,7 +103,9 @@ bool Transcriber::is_model_loaded() const {
 }
 
 TranscriptionResult Transcriber::transcribe(const std::filesystem::path& audio_path,
-                                          const std::optional<std::string>& language) {
+                                          const std::optional<std::string>& language,
+                                          const CancellationToken& cancel) {
+    V2S_TRACE_SPAN("Transcriber::transcribe", "whisper");
 #if V2S_HAVE_WHISPER
     if (!model_loaded_) {
         if (!load_model()) {
@@ -127,9 +143,24 @@ TranscriptionResult Transcriber::transcribe(const std::filesystem::path& audio_p
         wparams.language = language->c_str();
     }
     
+    // 取消支持：ggml 计算图在每个节点间调用 abort_callback，返回 true 时 whisper_full 提前返回
+    wparams.abort_callback = [](void* user_data) -> bool {
+        return static_cast<const CancellationToken*>(user_data)->is_cancelled();
+    };
+    wparams.abort_callback_user_data = const_cast<CancellationToken*>(&cancel);
+
     // 执行转录
-    int result = whisper_full(ctx_, wparams, audio_data.data(), static_cast<int>(audio_data.size()));
+    int result = 0;
+    {
+        V2S_TRACE_SPAN("whisper_full", "whisper");
+        V2S_PROBE2(whisper_full_start, audio_data.size(), wparams.n_threads);
+        result = whisper_full(ctx_, wparams, audio_data.data(), static_cast<int>(audio_data.size()));
+        V2S_PROBE2(whisper_full_end, audio_data.size(), result);
+    }
     
+    if (cancel.is_cancelled()) {
+        throw std::runtime_error(cancellation_message(cancel.reason()));
+    }
     if (result != 0) {
         throw std::runtime_error("Whisper转录失败，错误代码: " + std::to_string(result));
     }
@@ -150,8 +181,6 @@ TranscriptionResult Transcriber::transcribe(const std::filesystem::path& audio_p
     int n_segments = whisper_full_n_segments(ctx_);
     transcription_result.segments.reserve(n_segments);
     
-    std::ostringstream full_text;
-    
     for (int i = 0; i < n_segments; ++i) {
         const char* text = whisper_full_get_segment_text(ctx_, i);
         int64_t start_time = whisper_full_get_segment_t0(ctx_, i);
@@ -171,21 +200,33 @@ TranscriptionResult Transcriber::transcribe(const std::filesystem::path& audio_p
         segment.confidence = 0.8;  // 默认置信度
         
         transcription_result.segments.push_back(segment);
-        
-        if (!segment.text.empty()) {
-            full_text << segment.text;
-            if (i < n_segments - 1) {
+        V2S_PROBE4(segment_emitted, i, start_time * 10, end_time * 10, segment.text.size());
+    }
+
+    // Whisper 按 token 切分，多字节字符（如中日韩文字）可能被拆到相邻两段：
+    // 拼回完整字符并替换其余非法字节，保证下游（翻译请求的 JSON、字幕文件）拿到的都是合法 UTF-8
+    if (const size_t fixes = repair_utf8_segments(transcription_result.segments)) {
+        metrics::counter("v2s_transcript_utf8_repairs_total",
+                         "Split or invalid UTF-8 sequences repaired in transcribed segment text").inc(static_cast<double>(fixes));
+    }
+
+    std::ostringstream full_text;
+    for (size_t i = 0; i < transcription_result.segments.size(); ++i) {
+        const std::string& text = transcription_result.segments[i].text;
+        if (!text.empty()) {
+            full_text << text;
+            if (i + 1 < transcription_result.segments.size()) {
                 full_text << " ";
             }
         }
     }
-    
     transcription_result.text = full_text.str();
     
     std::cout << "转录完成，共 " << n_segments << " 个分段" << std::endl;
     
     return transcription_result;
 #else
+    (void)audio_path; (void)language; (void)cancel;
     throw std::runtime_error("Whisper.cpp支持未启用");
 #endif
 }
@@ -261,6 +302,7 @@ void Transcriber::cleanup() {
     if (ctx_) {
         whisper_free(ctx_);
         ctx_ = nullptr;
+        loaded_models_gauge().dec();
     }
 #endif
     model_loaded_ = false;
@@ -276,6 +318,7 @@ std::filesystem::path Transcriber::get_model_file_path() const {
 }
 
 std::vector<float> Transcriber::load_audio_data(const std::filesystem::path& audio_path) {
+    V2S_TRACE_SPAN("Transcriber::load_audio_data", "io");
     // 这里简化实现，实际应该使用FFmpeg或其他音频库来加载WAV文件
     // 假设输入是16kHz单声道WAV文件
     
@@ -0,0 +1,163 @@
+#include "video2srt_native/translation_broker.hpp"
+#include "video2srt_native/executor.hpp"
+#include "video2srt_native/metrics.hpp"
+#include <algorithm>
+#include <unordered_map>
+
+namespace v2s {
+
+namespace {
+
+// 等待期间检查取消的间隔（取消令牌不会唤醒合并器的条件变量）
+constexpr std::chrono::milliseconds kCancelPoll{50};
+
+struct BrokerMetrics {
+    metrics::Counter& solo_batches;
+    metrics::Counter& shared_batches;
+    metrics::Counter& items;
+};
+
+BrokerMetrics& broker_metrics() {
+    static BrokerMetrics m{
+        metrics::counter("v2s_translation_broker_batches_total", "Batches sent by the cross-job translation broker",
+                         {{"jobs", "single"}}),
+        metrics::counter("v2s_translation_broker_batches_total", "Batches sent by the cross-job translation broker",
+                         {{"jobs", "shared"}}),
+        metrics::counter("v2s_translation_broker_items_total", "Items routed through the cross-job translation broker")
+    };
+    return m;
+}
+
+} // namespace
+
+std::shared_ptr<TranslationBroker> TranslationBroker::for_key(const std::string& key) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::shared_ptr<TranslationBroker>> registry;
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[key];
+    if (!slot) slot = std::make_shared<TranslationBroker>(key);
+    return slot;
+}
+
+TranslationBroker::TranslationBroker(std::string key) : key_(std::move(key)) {}
+
+std::vector<TranslationBroker::Pending> TranslationBroker::take_batch(size_t max_items) {
+    std::vector<Pending> batch;
+    double weight = 0.0;
+    while (!queue_.empty()) {
+        Pending& next = queue_.front();
+        // 超出容量的单条仍独占一个请求
+        if (!batch.empty() && (weight + next.weight > 1.0 || batch.size() >= max_items)) break;
+        weight += next.weight;
+        batch.push_back(std::move(next));
+        queue_.pop_front();
+    }
+    queued_weight_ = std::max(0.0, queued_weight_ - weight);
+    if (queue_.empty()) queued_weight_ = 0.0;
+    return batch;
+}
+
+std::vector<std::optional<std::string>> TranslationBroker::translate(const std::vector<Item>& items,
+                                                                     const BatchSender& send,
+                                                                     const std::function<size_t()>& max_items,
+                                                                     std::chrono::milliseconds linger,
+                                                                     size_t parallel,
+                                                                     const CancellationToken& cancel,
+                                                                     const ItemCallback& on_item) {
+    auto ticket = std::make_shared<Ticket>();
+    ticket->results.resize(items.size());
+    ticket->remaining = items.size();
+    if (items.empty()) return {};
+    broker_metrics().items.inc(static_cast<double>(items.size()));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        const auto now = Clock::now();
+        for (size_t i = 0; i < items.size(); ++i) {
+            queue_.push_back(Pending{ticket, i, items[i].text, items[i].weight, now});
+            queued_weight_ += items[i].weight;
+        }
+    }
+    cv_.notify_all();
+
+    parallel_for(std::max<size_t>(1, parallel), std::max<size_t>(1, parallel), [&](size_t) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (;;) {
+            // 先回调已送达的条目（在本任务线程中执行，锁外）
+            if (!ticket->ready.empty()) {
+                std::vector<size_t> ready;
+                ready.swap(ticket->ready);
+                std::vector<std::pair<size_t, std::string>> done;
+                for (size_t i : ready) {
+                    if (ticket->results[i]) done.emplace_back(i, *ticket->results[i]);
+                }
+                lock.unlock();
+                if (on_item) {
+                    for (const auto& [i, text] : done) on_item(i, text);
+                }
+                lock.lock();
+                continue;
+            }
+            if (ticket->remaining == 0 || ticket->abandoned) return;
+            if (cancel.is_cancelled()) {
+                // 撤回仍在排队的本任务条目；发送中的条目由其 leader 送达后丢弃
+                auto it = std::remove_if(queue_.begin(), queue_.end(), [&](const Pending& p) {
+                    if (p.ticket != ticket) return false;
+                    queued_weight_ = std::max(0.0, queued_weight_ - p.weight);
+                    return true;
+                });
+                queue_.erase(it, queue_.end());
+                ticket->abandoned = true;
+                cv_.notify_all();
+                return;
+            }
+
+            const auto now = Clock::now();
+            if (!queue_.empty()) {
+                const size_t limit = std::max<size_t>(1, max_items());
+                const bool full = queued_weight_ >= 1.0 || queue_.size() >= limit;
+                const auto due = queue_.front().enqueued + linger;
+                if (full || now >= due) {
+                    // 担任 leader：用本任务的发送函数发出这一批（可能包含其他任务的条目）
+                    std::vector<Pending> batch = take_batch(limit);
+                    lock.unlock();
+                    std::vector<std::string> texts;
+                    texts.reserve(batch.size());
+                    bool shared = false;
+                    for (const auto& p : batch) {
+                        texts.push_back(p.text);
+                        shared = shared || p.ticket != ticket;
+                    }
+                    (shared ? broker_metrics().shared_batches : broker_metrics().solo_batches).inc();
+                    auto results = send(texts);
+                    results.resize(batch.size());
+                    const bool leader_cancelled = cancel.is_cancelled();
+                    lock.lock();
+                    for (size_t k = 0; k < batch.size(); ++k) {
+                        Pending& p = batch[k];
+                        // 本任务被取消导致其他任务的条目失败：放回队首由其他任务重新发送
+                        if (leader_cancelled && !results[k] && p.ticket != ticket && !p.ticket->abandoned) {
+                            queued_weight_ += p.weight;
+                            queue_.push_front(std::move(p));
+                            continue;
+                        }
+                        p.ticket->remaining--;
+                        if (p.ticket->abandoned) continue;
+                        p.ticket->results[p.index] = std::move(results[k]);
+                        p.ticket->ready.push_back(p.index);
+                    }
+                    cv_.notify_all();
+                    continue;
+                }
+                cv_.wait_until(lock, std::min(due, now + kCancelPoll));
+            } else {
+                // 本任务的条目都在其他 leader 手中：等待送达
+                cv_.wait_until(lock, now + kCancelPoll);
+            }
+        }
+    });
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    return ticket->results;
+}
+
+} // namespace v2s
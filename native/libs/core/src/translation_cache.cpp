@@ -0,0 +1,565 @@
+#include "video2srt_native/translation_cache.hpp"
+#include "video2srt_native/file_io.hpp"
+#include "video2srt_native/fuzzy_memory.hpp"
+#include "video2srt_native/metrics.hpp"
+#include "video2srt_native/trace.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <random>
+
+namespace v2s {
+
+namespace {
+
+// 日志格式：
+//   头部 16 字节：magic "V2TC" | u32 格式版本 | u64 代数
+//   记录：u32 key_len | u32 value_len | u32 checksum(FNV-1a，覆盖 key+value) | u32 保留 | key | value
+// 整数均为小端序（与目标平台一致，直接按内存布局读写）
+constexpr char kMagic[4] = {'V', '2', 'T', 'C'};
+constexpr uint32_t kFormatVersion = 1;
+constexpr uint64_t kHeaderSize = 16;
+constexpr uint64_t kRecordHeaderSize = 16;
+constexpr uint32_t kMaxFieldLen = 1u << 20;   // 单个键/值上限 1MB，超出视为损坏
+// 键格式版本：键的拼接规则或规范化规则变化时递增
+constexpr const char* kKeyVersion = "k1";
+
+uint32_t fnv1a32(const char* data, size_t n, uint32_t h = 2166136261u) {
+    for (size_t i = 0; i < n; ++i) {
+        h ^= static_cast<unsigned char>(data[i]);
+        h *= 16777619u;
+    }
+    return h;
+}
+
+uint64_t fnv1a64(const std::string& s) {
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+uint64_t new_generation() {
+    std::random_device rd;
+    const uint64_t t = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    return (static_cast<uint64_t>(rd()) << 32) ^ rd() ^ t;
+}
+
+void put_u32(std::string& out, uint32_t v) { out.append(reinterpret_cast<const char*>(&v), 4); }
+void put_u64(std::string& out, uint64_t v) { out.append(reinterpret_cast<const char*>(&v), 8); }
+
+void append_record(std::string& out, const std::string& key, const std::string& value) {
+    put_u32(out, static_cast<uint32_t>(key.size()));
+    put_u32(out, static_cast<uint32_t>(value.size()));
+    put_u32(out, fnv1a32(value.data(), value.size(), fnv1a32(key.data(), key.size())));
+    put_u32(out, 0);
+    out += key;
+    out += value;
+}
+
+std::string make_header(uint64_t generation) {
+    std::string h(kMagic, 4);
+    put_u32(h, kFormatVersion);
+    put_u64(h, generation);
+    return h;
+}
+
+struct CacheMetrics {
+    metrics::Counter& hits;
+    metrics::Counter& misses;
+    metrics::Counter& evictions;
+    metrics::Counter& fuzzy_hits;
+};
+
+CacheMetrics& cache_metrics() {
+    static CacheMetrics m{
+        metrics::counter("v2s_translation_cache_hits_total", "Segments served from the persistent translation cache"),
+        metrics::counter("v2s_translation_cache_misses_total", "Segments not found in the persistent translation cache"),
+        metrics::counter("v2s_translation_cache_compactions_total", "Translation cache compactions (size-bounded eviction)"),
+        metrics::counter("v2s_translation_memory_fuzzy_hits_total",
+                         "Segments served from the fuzzy translation memory (near-duplicate source lines)")
+    };
+    return m;
+}
+
+} // namespace
+
+// ---------------------------------------------------------------------------
+
+std::shared_ptr<TranslationCache> TranslationCache::open(const std::filesystem::path& dir, uint64_t max_bytes) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<TranslationCache>> registry;
+
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (!std::filesystem::is_directory(dir, ec)) return nullptr;
+    const std::string canonical = std::filesystem::weakly_canonical(dir, ec).string();
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[canonical.empty() ? dir.string() : canonical];
+    if (auto existing = slot.lock()) {
+        // lookup/insert 在实例锁下读取上限
+        std::lock_guard<std::mutex> instance_lock(existing->mutex_);
+        existing->max_bytes_ = max_bytes;
+        return existing;
+    }
+    std::shared_ptr<TranslationCache> cache(new TranslationCache(dir, max_bytes));
+    slot = cache;
+    return cache;
+}
+
+TranslationCache::TranslationCache(std::filesystem::path dir, uint64_t max_bytes)
+    : dir_(std::move(dir)),
+      log_path_(dir_ / "translations.log"),
+      lock_path_(dir_ / "translations.lock"),
+      max_bytes_(max_bytes) {}
+
+TranslationCache::~TranslationCache() = default;
+
+std::string TranslationCache::normalize_text(const std::string& text) {
+    std::string out;
+    out.reserve(text.size());
+    bool pending_space = false;
+    for (unsigned char c : text) {
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '\v' || c == '\f') {
+            pending_space = !out.empty();
+            continue;
+        }
+        if (pending_space) {
+            out += ' ';
+            pending_space = false;
+        }
+        out += static_cast<char>(c);
+    }
+    return out;
+}
+
+std::string TranslationCache::make_key(const std::string& translator_namespace,
+                                       const std::string& source_language,
+                                       const std::string& target_language,
+                                       const std::string& text) {
+    auto lower = [](std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        return s;
+    };
+    // 字段以 0x1F（单元分隔符）拼接，避免与文本内容冲突
+    std::string key = kKeyVersion;
+    key += '\x1f'; key += translator_namespace;
+    key += '\x1f'; key += lower(source_language.empty() ? "auto" : source_language);
+    key += '\x1f'; key += lower(target_language);
+    key += '\x1f'; key += normalize_text(text);
+    return key;
+}
+
+// 重新打开日志：代数变化（其他进程压缩过）时重建索引，否则只扫描新增部分
+bool TranslationCache::refresh_locked() {
+    auto fresh = std::make_unique<AppendFile>();
+    if (!fresh->open(log_path_, false)) {
+        file_.reset();
+        index_.clear();
+        scanned_ = 0;
+        generation_ = 0;
+        return false;
+    }
+    const uint64_t size = fresh->size();
+    if (size < kHeaderSize) {
+        file_ = std::move(fresh);
+        index_.clear();
+        scanned_ = 0;
+        generation_ = 0;
+        return true;
+    }
+    char header[kHeaderSize];
+    uint32_t version = 0;
+    uint64_t generation = 0;
+    const bool read = fresh->read_at(0, header, sizeof(header));
+    if (read) {
+        std::memcpy(&version, header + 4, 4);
+        std::memcpy(&generation, header + 8, 8);
+    }
+    if (!read || std::memcmp(header, kMagic, 4) != 0 || version != kFormatVersion) {
+        // 不是本格式版本的日志：不读也不写（追加时先改名保留，见 append_locked）
+        file_.reset();
+        index_.clear();
+        scanned_ = 0;
+        generation_ = 0;
+        foreign_ = read;
+        return false;
+    }
+
+    foreign_ = false;
+    file_ = std::move(fresh);
+    if (generation != generation_ || size < scanned_) {
+        index_.clear();
+        generation_ = generation;
+        scanned_ = kHeaderSize;
+    }
+    if (size > scanned_) scan_locked(scanned_, size);
+    return true;
+}
+
+void TranslationCache::scan_locked(uint64_t from, uint64_t to) {
+    uint64_t off = from;
+    std::string key;
+    while (off + kRecordHeaderSize <= to) {
+        uint32_t rh[4];
+        if (!file_->read_at(off, rh, sizeof(rh))) break;
+        const uint32_t key_len = rh[0], value_len = rh[1], checksum = rh[2];
+        if (key_len == 0 || key_len > kMaxFieldLen || value_len > kMaxFieldLen) {
+            // 长度字段损坏，无法定位后续记录：停止扫描（下次压缩时丢弃尾部）
+            off = to;
+            break;
+        }
+        const uint64_t record_size = kRecordHeaderSize + key_len + value_len;
+        if (off + record_size > to) break;   // 尾部记录尚未写完（或写入中断）
+        std::string payload(key_len + value_len, '\0');
+        if (!file_->read_at(off + kRecordHeaderSize, &payload[0], payload.size())) break;
+        if (fnv1a32(payload.data(), payload.size()) == checksum) {
+            key.assign(payload.data(), key_len);
+            index_[fnv1a64(key)] = Entry{off, key_len, value_len};
+        }
+        off += record_size;
+    }
+    scanned_ = off;
+}
+
+std::optional<std::string> TranslationCache::read_value_locked(const Entry& e, const std::string& key) {
+    if (!file_ || e.key_len != key.size()) return std::nullopt;
+    std::string payload(e.key_len + e.value_len, '\0');
+    if (!file_->read_at(e.record_offset + kRecordHeaderSize, &payload[0], payload.size())) return std::nullopt;
+    if (payload.compare(0, e.key_len, key) != 0) return std::nullopt;   // 哈希冲突
+    return payload.substr(e.key_len);
+}
+
+std::vector<std::optional<std::string>> TranslationCache::lookup(const std::vector<std::string>& keys) {
+    V2S_TRACE_SPAN("TranslationCache::lookup", "cache");
+    std::vector<std::optional<std::string>> out(keys.size());
+    std::vector<std::pair<std::string, std::string>> promote;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        refresh_locked();
+        if (!file_) return out;
+        const uint64_t size = scanned_;
+        // 仅在接近容量上限时才需要提升，避免小缓存反复追加
+        const bool near_capacity = max_bytes_ > 0 && size > max_bytes_ / 2;
+        for (size_t i = 0; i < keys.size(); ++i) {
+            auto it = index_.find(fnv1a64(keys[i]));
+            if (it == index_.end()) continue;
+            out[i] = read_value_locked(it->second, keys[i]);
+            // 位于最旧 1/4 的命中记录重新追加，使常用条目在压缩时得以保留
+            if (out[i] && near_capacity && it->second.record_offset < kHeaderSize + (size - kHeaderSize) / 4) {
+                promote.emplace_back(keys[i], *out[i]);
+            }
+        }
+    }
+    if (!promote.empty()) insert(promote);
+    return out;
+}
+
+bool TranslationCache::append_locked(const std::vector<std::pair<std::string, std::string>>& entries) {
+    std::string buf;
+    for (const auto& kv : entries) {
+        if (kv.first.empty() || kv.first.size() > kMaxFieldLen || kv.second.size() > kMaxFieldLen) continue;
+        append_record(buf, kv.first, kv.second);
+    }
+    if (buf.empty()) return true;
+
+    if (!file_) {
+        if (foreign_) {
+            // 其他格式版本（或并非本缓存）的日志：改名保留后新建，绝不在其上截断或追加
+            const auto aside = log_path_.string() + ".old";
+            std::error_code ec;
+            std::filesystem::rename(log_path_, aside, ec);
+            if (ec) return false;
+            std::cerr << "[TranslationCache] 日志格式不兼容，已改名为 " << aside << " 并新建缓存日志" << std::endl;
+            foreign_ = false;
+        }
+        file_ = std::make_unique<AppendFile>();
+        if (!file_->open(log_path_, true)) {
+            file_.reset();
+            return false;
+        }
+    }
+    if (generation_ == 0 && file_->size() >= kHeaderSize) {
+        // 头部未经 refresh_locked 校验（不应发生）：不写入
+        return false;
+    }
+    if (file_->size() < kHeaderSize) {
+        // 新文件（或上次创建时只写了半个头部）：写入头部
+        if (file_->size() != 0) return false;
+        generation_ = new_generation();
+        if (!file_->append(make_header(generation_))) return false;
+        scanned_ = kHeaderSize;
+    }
+    if (file_->size() > scanned_) {
+        // 头部已校验（generation_ 非 0），尾部是中断写入留下的不完整记录（持有独占锁，不会是正在写入的记录）：先截掉，
+        // 否则新记录接在残片之后，重新扫描时无法对齐，之后追加的记录全部丢失
+        std::error_code ec;
+        std::filesystem::resize_file(log_path_, scanned_, ec);
+        if (ec || file_->size() != scanned_) return false;
+    }
+    const uint64_t start = file_->size();
+    if (!file_->append(buf)) return false;
+    // 持有独占锁，新记录紧跟在 start 之后；直接扫描更新索引
+    scan_locked(start, start + buf.size());
+    return true;
+}
+
+void TranslationCache::insert(const std::vector<std::pair<std::string, std::string>>& entries) {
+    if (entries.empty()) return;
+    V2S_TRACE_SPAN("TranslationCache::insert", "cache");
+    std::lock_guard<std::mutex> lock(mutex_);
+    FileLock file_lock(lock_path_);
+    if (!file_lock.locked()) return;
+    refresh_locked();
+    if (!append_locked(entries)) return;
+    if (max_bytes_ > 0 && file_ && file_->size() > max_bytes_) {
+        compact_locked();
+    }
+}
+
+// 压缩：新近优先保留有效记录至约 3/4 上限，写入临时文件后原子替换
+void TranslationCache::compact_locked() {
+    V2S_TRACE_SPAN("TranslationCache::compact", "cache");
+    std::vector<Entry> live;
+    live.reserve(index_.size());
+    for (const auto& kv : index_) live.push_back(kv.second);
+    std::sort(live.begin(), live.end(), [](const Entry& a, const Entry& b) { return a.record_offset > b.record_offset; });
+
+    const uint64_t budget = max_bytes_ - max_bytes_ / 4;
+    uint64_t total = kHeaderSize;
+    size_t keep = 0;
+    for (; keep < live.size(); ++keep) {
+        const uint64_t sz = kRecordHeaderSize + live[keep].key_len + live[keep].value_len;
+        if (total + sz > budget) break;
+        total += sz;
+    }
+    live.resize(keep);
+    // 按原顺序写出，保持“越靠后越新”
+    std::reverse(live.begin(), live.end());
+
+    const uint64_t generation = new_generation();
+    std::string buf = make_header(generation);
+    buf.reserve(static_cast<size_t>(total));
+    for (const auto& e : live) {
+        const size_t n = kRecordHeaderSize + e.key_len + e.value_len;
+        const size_t pos = buf.size();
+        buf.resize(pos + n);
+        if (!file_->read_at(e.record_offset, &buf[pos], n)) buf.resize(pos);
+    }
+
+    const auto tmp_path = log_path_.string() + ".tmp";
+    {
+        AppendFile tmp;
+        std::error_code ec;
+        std::filesystem::remove(tmp_path, ec);
+        if (!tmp.open(tmp_path, true) || !tmp.append(buf)) {
+            tmp.close();
+            std::filesystem::remove(tmp_path, ec);
+            return;
+        }
+    }
+    file_.reset();   // Windows 需先关闭自身句柄才能替换
+    std::error_code ec;
+    std::filesystem::rename(tmp_path, log_path_, ec);
+    if (ec) {
+        // 其他进程仍占用旧文件（Windows）：保留旧日志，下次写入时重试
+        std::filesystem::remove(tmp_path, ec);
+    } else {
+        cache_metrics().evictions.inc();
+    }
+    generation_ = 0;
+    refresh_locked();
+}
+
+size_t TranslationCache::entry_count() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    refresh_locked();
+    return index_.size();
+}
+
+uint64_t TranslationCache::size_bytes() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return file_ ? file_->size() : 0;
+}
+
+// ---------------------------------------------------------------------------
+
+CachedTranslator::CachedTranslator(std::unique_ptr<ITranslator> inner, std::shared_ptr<TranslationCache> cache)
+    : inner_(std::move(inner)), cache_(std::move(cache)) {}
+
+void CachedTranslator::set_fuzzy_memory(std::shared_ptr<FuzzyTranslationMemory> memory, double threshold, size_t max_chars) {
+    fuzzy_ = std::move(memory);
+    fuzzy_threshold_ = std::clamp(threshold, 0.0, 1.0);
+    fuzzy_max_chars_ = max_chars;
+}
+
+TranslationResult CachedTranslator::translate_segments(const std::vector<Segment>& segments,
+                                                       const std::string& target_language,
+                                                       const std::string& source_language) {
+    return translate_call(segments, target_language, source_language, TranslationCall{CancellationToken{}, segment_callback_});
+}
+
+TranslationResult CachedTranslator::translate_call(const std::vector<Segment>& segments,
+                                                   const std::string& target_language,
+                                                   const std::string& source_language,
+                                                   const TranslationCall& call) {
+    return std::move(run(segments, {target_language}, source_language, call).front());
+}
+
+std::vector<TranslationResult> CachedTranslator::translate_call_multi(const std::vector<Segment>& segments,
+                                                                      const std::vector<std::string>& target_languages,
+                                                                      const std::string& source_language,
+                                                                      const TranslationCall& call) {
+    return run(segments, target_languages, source_language, call);
+}
+
+std::vector<TranslationResult> CachedTranslator::run(const std::vector<Segment>& segments,
+                                                     const std::vector<std::string>& target_languages,
+                                                     const std::string& source_language,
+                                                     const TranslationCall& call) {
+    const std::string ns = inner_->cache_namespace();
+    auto call_inner = [&](const std::vector<Segment>& segs, const TranslationCall& inner_call) {
+        if (target_languages.size() == 1) {
+            std::vector<TranslationResult> single;
+            single.push_back(inner_->translate_call(segs, target_languages.front(), source_language, inner_call));
+            return single;
+        }
+        return inner_->translate_call_multi(segs, target_languages, source_language, inner_call);
+    };
+    if (!cache_ || ns.empty()) {
+        return call_inner(segments, call);
+    }
+
+    // 每个目标语言各自查询；任一语言未命中的段都交给内部翻译器（一次多语言请求）
+    const size_t targets = target_languages.size();
+    std::vector<std::vector<std::string>> keys(targets);
+    std::vector<std::vector<std::optional<std::string>>> cached(targets);
+    std::vector<std::vector<char>> fuzzy_hit(targets, std::vector<char>(segments.size(), 0));
+    std::vector<uint64_t> scopes(targets, 0);
+    std::vector<char> missing(segments.size(), 0);
+    for (size_t t = 0; t < targets; ++t) {
+        keys[t].reserve(segments.size());
+        for (const auto& seg : segments) {
+            keys[t].push_back(TranslationCache::make_key(ns, source_language, target_languages[t], seg.text));
+        }
+        cached[t] = cache_->lookup(keys[t]);
+        if (fuzzy_) {
+            // 精确未命中的（短）行再查模糊记忆
+            scopes[t] = FuzzyTranslationMemory::make_scope(ns, source_language, target_languages[t]);
+            std::vector<size_t> probe;
+            std::vector<std::string> texts;
+            for (size_t i = 0; i < segments.size(); ++i) {
+                if (cached[t][i]) continue;
+                if (fuzzy_max_chars_ > 0 && FuzzyTranslationMemory::char_count(segments[i].text) > fuzzy_max_chars_) continue;
+                probe.push_back(i);
+                texts.push_back(segments[i].text);
+            }
+            if (!texts.empty()) {
+                auto matches = fuzzy_->lookup(scopes[t], texts, fuzzy_threshold_);
+                for (size_t k = 0; k < probe.size(); ++k) {
+                    if (!matches[k]) continue;
+                    cached[t][probe[k]] = std::move(matches[k]->translation);
+                    fuzzy_hit[t][probe[k]] = 1;
+                }
+            }
+        }
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (!cached[t][i]) missing[i] = 1;
+        }
+    }
+
+    std::vector<size_t> miss_indices;
+    std::vector<Segment> miss_segments;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        if (missing[i]) {
+            miss_indices.push_back(i);
+            miss_segments.push_back(segments[i]);
+        }
+    }
+
+    // 命中的段立即回调；未命中段的回调下标映射回原列表
+    for (size_t t = 0; t < targets; ++t) {
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (cached[t][i]) call.notify(i, *cached[t][i]);
+        }
+    }
+    std::vector<TranslationResult> inner_results;
+    if (!miss_segments.empty()) {
+        TranslationCall inner_call{call.cancel, nullptr};
+        if (call.on_segment) {
+            inner_call.on_segment = [&call, &miss_indices](size_t m, const std::string& text) {
+                if (m < miss_indices.size()) call.notify(miss_indices[m], text);
+            };
+        }
+        inner_results = call_inner(miss_segments, inner_call);
+    }
+    inner_results.resize(targets);
+
+    std::vector<TranslationResult> results;
+    results.reserve(targets);
+    std::vector<std::pair<std::string, std::string>> to_store;
+    for (size_t t = 0; t < targets; ++t) {
+        TranslationResult& inner = inner_results[t];
+        size_t hits = 0;
+        size_t fuzzy_hits = 0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            if (fuzzy_hit[t][i]) {
+                ++fuzzy_hits;
+            } else if (cached[t][i]) {
+                ++hits;
+            }
+        }
+        const size_t misses = segments.size() - hits - fuzzy_hits;
+        cache_metrics().hits.inc(static_cast<double>(hits));
+        cache_metrics().misses.inc(static_cast<double>(misses));
+        cache_metrics().fuzzy_hits.inc(static_cast<double>(fuzzy_hits));
+
+        TranslationResult result;
+        result.source_language = inner.source_language.empty() ? source_language : inner.source_language;
+        result.target_language = target_languages[t];
+        result.translator_name = inner.translator_name;
+        result.stats = std::move(inner.stats);
+        result.stats.cache_hits += hits;
+        result.stats.cache_misses += misses;
+        result.stats.fuzzy_hits += fuzzy_hits;
+        result.segments.reserve(segments.size());
+
+        for (size_t i = 0; i < segments.size(); ++i) {
+            Segment seg = segments[i];
+            if (cached[t][i]) seg.text = *cached[t][i];
+            result.segments.push_back(std::move(seg));
+        }
+
+        // 回填未命中的结果；只缓存内部翻译器确认成功的段（模糊复用的译文不写回）
+        std::vector<std::pair<std::string, std::string>> to_remember;
+        std::vector<char> failed(miss_segments.size(), 0);
+        for (size_t f : inner.failed_indices) {
+            if (f < failed.size()) failed[f] = 1;
+        }
+        for (size_t m = 0; m < miss_indices.size(); ++m) {
+            const size_t idx = miss_indices[m];
+            if (cached[t][idx]) continue;   // 该语言已命中，仅因其他语言未命中才随批请求
+            if (m < inner.segments.size()) {
+                result.segments[idx] = std::move(inner.segments[m]);
+            }
+            if (failed[m] || m >= inner.segments.size()) {
+                result.failed_indices.push_back(idx);
+            } else if (!TranslationCache::normalize_text(segments[idx].text).empty()) {
+                to_store.emplace_back(keys[t][idx], result.segments[idx].text);
+                if (fuzzy_) to_remember.emplace_back(segments[idx].text, result.segments[idx].text);
+            }
+        }
+        if (fuzzy_) fuzzy_->insert(scopes[t], to_remember);
+        std::sort(result.failed_indices.begin(), result.failed_indices.end());
+        results.push_back(std::move(result));
+    }
+    cache_->insert(to_store);
+    return results;
+}
+
+} // namespace v2s
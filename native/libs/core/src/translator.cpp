@@ -1,13 +1,167 @@
 #include "video2srt_native/translator.hpp"
+#include "video2srt_native/executor.hpp"
+#include "video2srt_native/failover_translator.hpp"
+#include "video2srt_native/fuzzy_memory.hpp"
 #include "video2srt_native/google_translator.hpp"
 #include "video2srt_native/openai_translator.hpp"
+#include "video2srt_native/translation_cache.hpp"
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
 #include <memory>
+#include <unordered_map>
 
 namespace v2s {
 
+namespace {
+
+// 异步调用专用线程池的线程上限：超出的调用排队等待，调用内部的并发请求仍由共享线程池承担
+constexpr size_t kMaxAsyncCallWorkers = 8;
+
+// 正在运行或排队的异步调用数（每个调用在整个翻译期间占用一个工作线程）
+std::atomic<size_t> g_async_calls{0};
+
+Executor& async_call_executor() {
+    static Executor instance;
+    return instance;
+}
+
+} // namespace
+
+TranslationHandle::TranslationHandle(size_t total, CancellationToken cancel)
+    : completed_(total, 0), cancel_(std::move(cancel)), future_(promise_.get_future().share()) {}
+
+void TranslationHandle::on_segment(SegmentCallback callback) {
+    std::vector<std::pair<size_t, std::string>> replay;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        callback_ = callback;
+        // 暂存的事件交给本回调后即释放；有回调期间不再暂存
+        if (callback) replay.swap(events_);
+    }
+    for (const auto& [index, text] : replay) callback(index, text);
+}
+
+TranslationHandle::Progress TranslationHandle::progress() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return Progress{completed_count_, completed_.size()};
+}
+
+void TranslationHandle::report_segment(size_t index, const std::string& text) {
+    SegmentCallback callback;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!callback_) events_.emplace_back(index, text);
+        if (index < completed_.size() && !completed_[index]) {
+            completed_[index] = 1;
+            ++completed_count_;
+        }
+        callback = callback_;
+    }
+    if (callback) callback(index, text);
+}
+
+void TranslationHandle::finish(TranslationResult result) {
+    promise_.set_value(std::move(result));
+}
+
+void TranslationHandle::fail(std::exception_ptr error) {
+    promise_.set_exception(std::move(error));
+}
+
+ITranslator::~ITranslator() {
+    finish_calls();
+}
+
+CancellationToken ITranslator::link_cancel(const CancellationToken& options_cancel,
+                                           const CancellationToken& call_cancel) {
+    if (!call_cancel.can_be_cancelled()) return options_cancel;
+    if (!options_cancel.can_be_cancelled()) return call_cancel;
+    return CancellationToken::create_linked({options_cancel, call_cancel});
+}
+
+std::shared_ptr<TranslationHandle> ITranslator::start_call(size_t total,
+                                                           std::function<TranslationResult(const TranslationCall&)> body) {
+    auto handle = std::make_shared<TranslationHandle>(total, CancellationToken::create());
+    // 回调在调用方线程取快照，调用体只通过参数拿到它，不读写本实例的成员
+    TranslationCall call{handle->cancellation(), nullptr};
+    call.on_segment = [handle, user = segment_callback_](size_t index, const std::string& text) {
+        handle->report_segment(index, text);
+        if (user) user(index, text);
+    };
+    {
+        std::lock_guard<std::mutex> lock(calls_mutex_);
+        calls_.push_back(handle);
+    }
+    // 每个进行中的异步调用一个工作线程（不超过上限），不占用共享线程池
+    Executor& executor = async_call_executor();
+    executor.ensure_workers(std::min(g_async_calls.fetch_add(1) + 1, kMaxAsyncCallWorkers));
+    executor.submit([this, handle, call = std::move(call), body = std::move(body)] {
+        try {
+            handle->finish(body(call));
+        } catch (...) {
+            handle->fail(std::current_exception());
+        }
+        g_async_calls.fetch_sub(1);
+        // 最后一步：移出进行中列表后析构函数即可返回，此后不再访问本实例
+        std::lock_guard<std::mutex> lock(calls_mutex_);
+        calls_.erase(std::find(calls_.begin(), calls_.end(), handle));
+        calls_cv_.notify_all();
+    });
+    return handle;
+}
+
+void ITranslator::finish_calls() {
+    std::unique_lock<std::mutex> lock(calls_mutex_);
+    for (const auto& handle : calls_) handle->cancel();
+    calls_cv_.wait(lock, [this] { return calls_.empty(); });
+}
+
+TranslationResult ITranslator::translate_call(const std::vector<Segment>& segments,
+                                              const std::string& target_language,
+                                              const std::string& source_language,
+                                              const TranslationCall& call) {
+    TranslationResult result = translate_segments(segments, target_language, source_language);
+    if (call.on_segment) {
+        std::vector<char> failed(result.segments.size(), 0);
+        for (size_t f : result.failed_indices) {
+            if (f < failed.size()) failed[f] = 1;
+        }
+        for (size_t i = 0; i < result.segments.size(); ++i) {
+            if (!failed[i]) call.notify(i, result.segments[i].text);
+        }
+    }
+    return result;
+}
+
+std::vector<std::vector<size_t>> ITranslator::request_groups(const std::vector<Segment>& segments,
+                                                             const std::string& target_language,
+                                                             const std::string& source_language) const {
+    (void)target_language; (void)source_language;
+    std::vector<std::vector<size_t>> groups(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) groups[i].push_back(i);
+    return groups;
+}
+
+std::shared_ptr<TranslationHandle> ITranslator::translate_segments_async(const std::vector<Segment>& segments,
+                                                                         const std::string& target_language,
+                                                                         const std::string& source_language) {
+    return start_call(segments.size(),
+                      [this, segments, target_language, source_language](const TranslationCall& call) {
+        return translate_call(segments, target_language, source_language, call);
+    });
+}
+
 TranslationResult SimpleTranslator::translate_segments(const std::vector<Segment>& segments,
                                                        const std::string& target_language,
                                                        const std::string& source_language) {
+    return translate_call(segments, target_language, source_language, TranslationCall{CancellationToken{}, segment_callback_});
+}
+
+TranslationResult SimpleTranslator::translate_call(const std::vector<Segment>& segments,
+                                                   const std::string& target_language,
+                                                   const std::string& source_language,
+                                                   const TranslationCall& call) {
     TranslationResult result;
     result.source_language = source_language.empty() ? "auto" : source_language;
     result.target_language = target_language;
@@ -15,27 +169,160 @@ TranslationResult SimpleTranslator::translate_segments(const std::vector<Segment
 
     // 占位实现：直接复制原文内容
     result.segments.reserve(segments.size());
-    for (const auto& seg : segments) {
-        Segment tseg = seg;
+    for (size_t i = 0; i < segments.size(); ++i) {
+        Segment tseg = segments[i];
         tseg.language = target_language;
-        // 这里可以在后续替换为真实翻译文本
-        tseg.text = seg.text; 
         result.segments.push_back(std::move(tseg));
+        if (call.cancel.is_cancelled()) {
+            result.failed_indices.push_back(i);
+            continue;
+        }
+        // 这里可以在后续替换为真实翻译文本
+        call.notify(i, result.segments.back().text);
     }
 
     return result;
 }
 
-std::unique_ptr<ITranslator> create_translator(const std::string& translator_type,
-                                               const TranslatorOptions& opts) {
-    // 简单工厂：目前支持 simple、google（仅Windows）、openai
+std::vector<TranslationResult> ITranslator::translate_segments_multi(const std::vector<Segment>& segments,
+                                                                    const std::vector<std::string>& target_languages,
+                                                                    const std::string& source_language) {
+    return translate_call_multi(segments, target_languages, source_language,
+                                TranslationCall{CancellationToken{}, segment_callback_});
+}
+
+std::vector<TranslationResult> ITranslator::translate_call_multi(const std::vector<Segment>& segments,
+                                                                const std::vector<std::string>& target_languages,
+                                                                const std::string& source_language,
+                                                                const TranslationCall& call) {
+    std::vector<TranslationResult> results;
+    results.reserve(target_languages.size());
+    for (const auto& target : target_languages) {
+        results.push_back(translate_call(segments, target, source_language, call));
+        if (results.size() == 1) continue;
+        // 请求统计并入第一个结果
+        TranslationStats& total = results.front().stats;
+        TranslationStats& s = results.back().stats;
+        total.request_count += s.request_count;
+        total.failed_requests += s.failed_requests;
+        total.request_latencies_ms.insert(total.request_latencies_ms.end(),
+                                          s.request_latencies_ms.begin(), s.request_latencies_ms.end());
+        total.hedged_requests += s.hedged_requests;
+        total.hedge_wins += s.hedge_wins;
+        total.failover_segments += s.failover_segments;
+        total.retries += s.retries;
+        total.usage += s.usage;
+        s.request_count = s.failed_requests = s.hedged_requests = s.hedge_wins = s.failover_segments = s.retries = 0;
+        s.request_latencies_ms.clear();
+        s.usage = TokenUsage{};
+    }
+    return results;
+}
+
+DeduplicatingTranslator::DeduplicatingTranslator(std::unique_ptr<ITranslator> inner)
+    : inner_(std::move(inner)) {}
+
+TranslationResult DeduplicatingTranslator::translate_segments(const std::vector<Segment>& segments,
+                                                              const std::string& target_language,
+                                                              const std::string& source_language) {
+    return translate_call(segments, target_language, source_language, TranslationCall{CancellationToken{}, segment_callback_});
+}
+
+TranslationResult DeduplicatingTranslator::translate_call(const std::vector<Segment>& segments,
+                                                          const std::string& target_language,
+                                                          const std::string& source_language,
+                                                          const TranslationCall& call) {
+    return std::move(run(segments, {target_language}, source_language, call).front());
+}
+
+std::vector<TranslationResult> DeduplicatingTranslator::translate_call_multi(const std::vector<Segment>& segments,
+                                                                             const std::vector<std::string>& target_languages,
+                                                                             const std::string& source_language,
+                                                                             const TranslationCall& call) {
+    return run(segments, target_languages, source_language, call);
+}
+
+std::vector<TranslationResult> DeduplicatingTranslator::run(const std::vector<Segment>& segments,
+                                                            const std::vector<std::string>& target_languages,
+                                                            const std::string& source_language,
+                                                            const TranslationCall& call) {
+    // 唯一文本 -> 内部请求中的下标；空文本不参与去重
+    std::unordered_map<std::string, size_t> first_of;
+    std::vector<size_t> unique_of(segments.size());
+    std::vector<std::vector<size_t>> fanout;
+    std::vector<Segment> unique_segments;
+    first_of.reserve(segments.size());
+    for (size_t i = 0; i < segments.size(); ++i) {
+        std::string key = TranslationCache::normalize_text(segments[i].text);
+        auto it = key.empty() ? first_of.end() : first_of.find(key);
+        if (it == first_of.end()) {
+            const size_t u = unique_segments.size();
+            if (!key.empty()) first_of.emplace(std::move(key), u);
+            unique_segments.push_back(segments[i]);
+            fanout.emplace_back();
+            unique_of[i] = u;
+        } else {
+            unique_of[i] = it->second;
+        }
+        fanout[unique_of[i]].push_back(i);
+    }
+    auto call_inner = [&](const std::vector<Segment>& segs, const TranslationCall& inner_call) {
+        if (target_languages.size() == 1) {
+            std::vector<TranslationResult> single;
+            single.push_back(inner_->translate_call(segs, target_languages.front(), source_language, inner_call));
+            return single;
+        }
+        return inner_->translate_call_multi(segs, target_languages, source_language, inner_call);
+    };
+    if (unique_segments.size() == segments.size()) {
+        return call_inner(segments, call);
+    }
+
+    TranslationCall inner_call{call.cancel, nullptr};
+    if (call.on_segment) {
+        inner_call.on_segment = [&call, &fanout](size_t u, const std::string& text) {
+            if (u >= fanout.size()) return;
+            for (size_t idx : fanout[u]) call.notify(idx, text);
+        };
+    }
+    std::vector<TranslationResult> inner_results = call_inner(unique_segments, inner_call);
+
+    std::vector<TranslationResult> results;
+    results.reserve(inner_results.size());
+    for (auto& inner : inner_results) {
+        TranslationResult result;
+        result.source_language = inner.source_language;
+        result.target_language = inner.target_language;
+        result.translator_name = inner.translator_name;
+        result.stats = std::move(inner.stats);
+        result.stats.deduplicated_segments += segments.size() - unique_segments.size();
+
+        std::vector<char> failed(unique_segments.size(), 0);
+        for (size_t f : inner.failed_indices) {
+            if (f < failed.size()) failed[f] = 1;
+        }
+        result.segments.reserve(segments.size());
+        for (size_t i = 0; i < segments.size(); ++i) {
+            const size_t u = unique_of[i];
+            // 译文回填到每个重复位置，时间轴等保留各自原值
+            Segment seg = segments[i];
+            if (u < inner.segments.size()) {
+                seg.text = inner.segments[u].text;
+                seg.language = inner.segments[u].language;
+            }
+            result.segments.push_back(std::move(seg));
+            if (u >= inner.segments.size() || failed[u]) result.failed_indices.push_back(i);
+        }
+        results.push_back(std::move(result));
+    }
+    return results;
+}
+
+static std::unique_ptr<ITranslator> create_base_translator(const std::string& translator_type,
+                                                          const TranslatorOptions& opts) {
+    // 简单工厂：目前支持 simple、google、openai
     if (translator_type == "google") {
-#ifdef _WIN32
         return std::make_unique<GoogleTranslator>(opts);
-#else
-        // 非 Windows 平台尚未实现 GoogleTranslator，退化为简单译者（保持兼容）
-        return std::make_unique<SimpleTranslator>();
-#endif
     }
     if (translator_type == "openai") {
         return std::make_unique<OpenAITranslator>(opts);
@@ -43,4 +330,50 @@ std::unique_ptr<ITranslator> create_translator(const std::string& translator_typ
     return std::make_unique<SimpleTranslator>();
 }
 
+std::unique_ptr<ITranslator> create_translator(const std::string& translator_type,
+                                               const TranslatorOptions& opts) {
+    return create_translator(translator_type, opts, {});
+}
+
+std::unique_ptr<ITranslator> create_translator(const std::string& translator_type,
+                                               const TranslatorOptions& opts,
+                                               const std::vector<TranslatorBackend>& fallbacks) {
+    auto translator = create_base_translator(translator_type, opts);
+    // 对冲/故障转移：主翻译器可缓存（真实翻译器）时才有意义
+    if (!translator->cache_namespace().empty()) {
+        std::vector<TranslatorBackend> chain;
+        chain.push_back(TranslatorBackend{translator_type, opts});
+        for (const auto& fb : fallbacks) {
+            if (fb.type == translator_type) continue;
+            if (create_base_translator(fb.type, fb.options)->cache_namespace().empty()) continue;
+            TranslatorBackend backend = fb;
+            backend.options.cancel = opts.cancel;
+            chain.push_back(std::move(backend));
+        }
+        if (chain.size() > 1 || opts.hedge_requests) {
+            translator = std::make_unique<FailoverTranslator>(std::move(chain), create_base_translator);
+        }
+    }
+    // 去重在缓存之内：缓存未命中的段再合并重复文本
+    if (opts.deduplicate && !translator->cache_namespace().empty()) {
+        translator = std::make_unique<DeduplicatingTranslator>(std::move(translator));
+    }
+    // 持久缓存：仅包装可缓存的翻译器（占位翻译器 cache_namespace 为空）
+    if (opts.cache_enabled && !translator->cache_namespace().empty()) {
+        const std::filesystem::path dir = opts.cache_dir.empty()
+            ? std::filesystem::current_path() / "cache"
+            : std::filesystem::path(opts.cache_dir);
+        if (auto cache = TranslationCache::open(dir, opts.cache_max_bytes)) {
+            auto cached = std::make_unique<CachedTranslator>(std::move(translator), std::move(cache));
+            if (opts.fuzzy_memory) {
+                if (auto memory = FuzzyTranslationMemory::open(dir / "fuzzy", opts.cache_max_bytes)) {
+                    cached->set_fuzzy_memory(std::move(memory), opts.fuzzy_threshold, opts.fuzzy_max_chars);
+                }
+            }
+            translator = std::move(cached);
+        }
+    }
+    return translator;
+}
+
 } // namespace v2s
\ No newline at end of file
@@ -0,0 +1,38 @@
+#include "video2srt_native/usage_log.hpp"
+#include <iostream>
+#include <unordered_map>
+
+namespace v2s {
+
+std::shared_ptr<UsageLog> UsageLog::open(const std::filesystem::path& path) {
+    static std::mutex registry_mutex;
+    static std::unordered_map<std::string, std::weak_ptr<UsageLog>> registry;
+
+    std::error_code ec;
+    std::filesystem::path key = std::filesystem::weakly_canonical(path, ec);
+    if (ec) key = path;
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    auto& slot = registry[key.string()];
+    if (auto existing = slot.lock()) return existing;
+
+    if (path.has_parent_path()) std::filesystem::create_directories(path.parent_path(), ec);
+    std::ofstream out(path, std::ios::out | std::ios::app | std::ios::binary);
+    if (!out) {
+        std::cerr << "[UsageLog] 无法打开用量日志: " << path.string() << std::endl;
+        return nullptr;
+    }
+    auto log = std::make_shared<UsageLog>(std::move(out));
+    slot = log;
+    return log;
+}
+
+UsageLog::UsageLog(std::ofstream out) : out_(std::move(out)) {}
+
+void UsageLog::append(const std::string& line) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    out_ << line << '\n';
+    out_.flush();
+}
+
+} // namespace v2s
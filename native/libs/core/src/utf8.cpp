@@ -0,0 +1,152 @@
+#include "video2srt_native/utf8.hpp"
+#include <cstdint>
+#include <cstring>
+
+namespace v2s {
+
+namespace {
+
+constexpr uint64_t kHighBits = 0x8080808080808080ull;
+constexpr char kReplacement[] = "\xEF\xBF\xBD";   // U+FFFD
+
+enum class SeqStatus {
+    Valid,       // 完整合法的字符
+    Truncated,   // 到文本末尾为止的字节都合法，但字符不完整
+    Invalid      // 非法
+};
+
+struct SeqCheck {
+    SeqStatus status;
+    size_t length;   // Valid：字符字节数；其余：最大非法子序列的字节数（至少 1）
+};
+
+// 检查 p 处的一个非 ASCII 序列（Unicode 表 3-7）
+SeqCheck check_sequence(const unsigned char* p, size_t n) {
+    const unsigned char c = p[0];
+    size_t need;
+    unsigned char lo = 0x80, hi = 0xBF;   // 第二个字节的合法范围
+    if (c >= 0xC2 && c <= 0xDF) {
+        need = 2;
+    } else if (c >= 0xE0 && c <= 0xEF) {
+        need = 3;
+        if (c == 0xE0) lo = 0xA0;        // 过长编码
+        if (c == 0xED) hi = 0x9F;        // 代理区
+    } else if (c >= 0xF0 && c <= 0xF4) {
+        need = 4;
+        if (c == 0xF0) lo = 0x90;        // 过长编码
+        if (c == 0xF4) hi = 0x8F;        // 超出 U+10FFFF
+    } else {
+        return {SeqStatus::Invalid, 1};  // 续字节、C0/C1 或 F5..FF 不能作为首字节
+    }
+    for (size_t k = 1; k < need; ++k) {
+        if (k >= n) return {SeqStatus::Truncated, k};
+        const unsigned char b = p[k];
+        const bool ok = k == 1 ? (b >= lo && b <= hi) : (b >= 0x80 && b <= 0xBF);
+        if (!ok) return {SeqStatus::Invalid, k};
+    }
+    return {SeqStatus::Valid, need};
+}
+
+// 从 i 开始跳过 ASCII（先按 8 字节一组检查最高位）
+size_t skip_ascii(const unsigned char* p, size_t n, size_t i) {
+    while (i + 8 <= n) {
+        uint64_t word;
+        std::memcpy(&word, p + i, 8);
+        if (word & kHighBits) break;
+        i += 8;
+    }
+    while (i < n && p[i] < 0x80) ++i;
+    return i;
+}
+
+bool is_continuation(unsigned char b) { return (b & 0xC0) == 0x80; }
+
+// 末尾被截断的多字节字符：返回其起始偏移与还缺的字节数（无截断时 missing 为 0）
+size_t truncated_tail(const std::string& text, size_t& missing) {
+    missing = 0;
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+    for (size_t back = 1; back <= 3 && back <= n; ++back) {
+        const size_t start = n - back;
+        if (is_continuation(p[start])) continue;
+        const SeqCheck check = check_sequence(p + start, back);
+        if (p[start] >= 0x80 && check.status == SeqStatus::Truncated) {
+            const size_t need = p[start] >= 0xF0 ? 4 : p[start] >= 0xE0 ? 3 : 2;
+            missing = need - back;
+            return start;
+        }
+        break;
+    }
+    return n;
+}
+
+} // namespace
+
+size_t find_invalid_utf8(std::string_view text) {
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+    size_t i = 0;
+    while ((i = skip_ascii(p, n, i)) < n) {
+        const SeqCheck check = check_sequence(p + i, n - i);
+        if (check.status != SeqStatus::Valid) return i;
+        i += check.length;
+    }
+    return n;
+}
+
+size_t repair_utf8(std::string& text) {
+    size_t i = find_invalid_utf8(text);
+    if (i == text.size()) return 0;
+
+    const auto* p = reinterpret_cast<const unsigned char*>(text.data());
+    const size_t n = text.size();
+    std::string out;
+    out.reserve(n + 8);
+    out.append(text, 0, i);
+    size_t replaced = 0;
+    while (i < n) {
+        const size_t ascii_end = skip_ascii(p, n, i);
+        out.append(text, i, ascii_end - i);
+        i = ascii_end;
+        if (i >= n) break;
+        const SeqCheck check = check_sequence(p + i, n - i);
+        if (check.status == SeqStatus::Valid) {
+            out.append(text, i, check.length);
+        } else {
+            out += kReplacement;
+            ++replaced;
+        }
+        i += check.length;
+    }
+    text = std::move(out);
+    return replaced;
+}
+
+size_t repair_utf8_segments(std::vector<Segment>& segments) {
+    size_t fixes = 0;
+    for (size_t s = 0; s < segments.size(); ++s) {
+        std::string& text = segments[s].text;
+        size_t missing = 0;
+        const size_t tail = truncated_tail(text, missing);
+        if (missing > 0 && s + 1 < segments.size()) {
+            // 下一段开头恰好是所缺的续字节，且拼接后为合法字符：移回本段
+            std::string& next = segments[s + 1].text;
+            if (next.size() >= missing) {
+                bool continuation = true;
+                for (size_t k = 0; k < missing && continuation; ++k) {
+                    continuation = is_continuation(static_cast<unsigned char>(next[k]));
+                }
+                const std::string joined = text.substr(tail) + next.substr(0, missing);
+                if (continuation && is_valid_utf8(joined)) {
+                    text.append(next, 0, missing);
+                    next.erase(0, missing);
+                    ++fixes;
+                }
+            }
+        }
+        fixes += repair_utf8(text);
+    }
+    return fixes;
+}
+
+} // namespace v2s
@@ -0,0 +1,137 @@
+// OpenAI 批量模式的 token 预算装箱（经 request_groups 观察）：覆盖与顺序、段数上限、提示词与译文预算、超大单段
+#include "video2srt_native/openai_translator.hpp"
+#include "video2srt_native/token_estimator.hpp"
+#include "test_support.hpp"
+
+#include <cmath>
+#include <string>
+
+using namespace v2s;
+
+namespace {
+
+std::vector<Segment> corpus(size_t count) {
+    static const char* kLines[] = {
+        "Listen to me.",
+        "We have to go back to the house before tomorrow night.",
+        "What do you think you are doing?",
+        "I never said that, and you know it.",
+        "Remember everything we talked about together?",
+    };
+    std::vector<Segment> segments;
+    for (size_t i = 0; i < count; ++i) {
+        segments.emplace_back(static_cast<double>(i), static_cast<double>(i) + 1.0, kLines[i % 5]);
+    }
+    return segments;
+}
+
+TranslatorOptions batch_options() {
+    TranslatorOptions opts;
+    opts.base_url = "http://127.0.0.1:9/v1/chat/completions";
+    opts.batch_mode = true;
+    opts.batch_format = "lines";
+    opts.max_batch_segments = 0;
+    opts.max_batch_prompt_tokens = 100000;
+    opts.max_tokens = 100000;
+    return opts;
+}
+
+std::vector<std::vector<size_t>> groups_for(const TranslatorOptions& opts, const std::vector<Segment>& segments) {
+    OpenAITranslator translator(opts);
+    return translator.request_groups(segments, "zh", "en");
+}
+
+// 每段按原顺序恰好出现一次，组内下标连续
+bool covers_in_order(const std::vector<std::vector<size_t>>& groups, size_t count) {
+    size_t next = 0;
+    for (const auto& group : groups) {
+        if (group.empty()) return false;
+        for (size_t idx : group) {
+            if (idx != next++) return false;
+        }
+    }
+    return next == count;
+}
+
+void test_segment_cap() {
+    auto opts = batch_options();
+    opts.max_batch_segments = 7;
+    const auto segments = corpus(30);
+    const auto groups = groups_for(opts, segments);
+    CHECK(covers_in_order(groups, segments.size()));
+    CHECK_EQ(groups.size(), size_t{5});
+    for (size_t g = 0; g + 1 < groups.size(); ++g) CHECK_EQ(groups[g].size(), size_t{7});
+    CHECK_EQ(groups.back().size(), size_t{2});
+}
+
+void test_prompt_budget() {
+    const auto segments = corpus(200);
+    auto opts = batch_options();
+    opts.max_batch_prompt_tokens = 600;
+    const auto groups = groups_for(opts, segments);
+    CHECK(covers_in_order(groups, segments.size()));
+    CHECK(groups.size() > 1);
+    CHECK(groups.size() < segments.size() / 4);   // 仍是多段一批
+    for (const auto& group : groups) {
+        // 每段至少占文本 token + 编号行框架，总和不超过预算
+        size_t tokens = 0;
+        for (size_t idx : group) tokens += estimate_tokens(segments[idx].text) + 1;
+        CHECK(tokens <= static_cast<size_t>(opts.max_batch_prompt_tokens));
+    }
+    // 预算减半，批次数随之增加
+    opts.max_batch_prompt_tokens = 300;
+    CHECK(groups_for(opts, segments).size() > groups.size());
+}
+
+void test_completion_budget() {
+    const auto segments = corpus(200);
+    auto opts = batch_options();
+    opts.max_tokens = 300;
+    const auto groups = groups_for(opts, segments);
+    CHECK(covers_in_order(groups, segments.size()));
+    const double ratio = translation_token_ratio("en", "zh");
+    for (const auto& group : groups) {
+        // 预计译文（按语言膨胀系数）不超过 max_tokens 的 90%
+        double completion = 0.0;
+        for (size_t idx : group) completion += std::ceil(static_cast<double>(estimate_tokens(segments[idx].text)) * ratio);
+        CHECK(completion <= 0.9 * opts.max_tokens);
+    }
+    opts.max_tokens = 1200;
+    CHECK(groups_for(opts, segments).size() < groups.size());
+}
+
+void test_oversized_segment() {
+    auto segments = corpus(6);
+    std::string huge;
+    for (int i = 0; i < 400; ++i) huge += "everything ";
+    segments[3].text = huge;
+    auto opts = batch_options();
+    opts.max_batch_prompt_tokens = 200;
+    const auto groups = groups_for(opts, segments);
+    CHECK(covers_in_order(groups, segments.size()));
+    // 超出预算的单段独占一个请求，前后的段不与它拼批
+    bool alone = false;
+    for (const auto& group : groups) {
+        if (group.size() == 1 && group.front() == 3) alone = true;
+    }
+    CHECK(alone);
+}
+
+void test_per_segment_mode() {
+    auto opts = batch_options();
+    opts.batch_mode = false;
+    const auto groups = groups_for(opts, corpus(4));
+    CHECK_EQ(groups.size(), size_t{4});
+    CHECK(covers_in_order(groups, 4));
+}
+
+} // namespace
+
+int main() {
+    test_segment_cap();
+    test_prompt_budget();
+    test_completion_budget();
+    test_oversized_segment();
+    test_per_segment_mode();
+    return test::exit_code();
+}
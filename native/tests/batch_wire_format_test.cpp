@@ -0,0 +1,87 @@
+// 编号行格式（v2s-lines/1）：编码与宽容解析的往返
+#include "video2srt_native/batch_wire_format.hpp"
+#include "test_support.hpp"
+
+using namespace v2s;
+
+namespace {
+
+void round_trip(const std::vector<std::string>& texts) {
+    const std::string encoded = encode_numbered_lines(texts);
+    const NumberedLines parsed = parse_numbered_lines(encoded, texts.size());
+    CHECK_EQ(parsed.items.size(), texts.size());
+    CHECK_EQ(parsed.numbered_lines, texts.size());
+    CHECK(!parsed.duplicates);
+    for (size_t i = 0; i < texts.size() && i < parsed.items.size(); ++i) {
+        CHECK(parsed.items[i].has_value());
+        if (parsed.items[i]) CHECK_EQ(*parsed.items[i], texts[i]);
+    }
+}
+
+void test_round_trips() {
+    round_trip({"Hello", "World"});
+    round_trip({"first line\nsecond line", "a | b | c", "2 apples", "你好，世界"});
+    round_trip({"- dash at start", "1. looks numbered", "@zh"});
+    round_trip({"single"});
+
+    // \r\n 与 \r 同样编码为 <br>，解码为 \n
+    const std::string encoded = encode_numbered_lines({"a\r\nb", "c\rd"});
+    CHECK_EQ(encoded.find('\r'), std::string::npos);
+    const NumberedLines parsed = parse_numbered_lines(encoded, 2);
+    CHECK_EQ(parsed.items[0].value_or("<missing>"), std::string("a\nb"));
+    CHECK_EQ(parsed.items[1].value_or("<missing>"), std::string("c\nd"));
+}
+
+void test_lenient_parse() {
+    // 前言、代码块标记、全角分隔符、列表标记、续行与超出范围的编号
+    const NumberedLines parsed = parse_numbered_lines(
+        "Here are the translations:\n```\n1｜一\n- 2: 二\n  还是二\n* 3) 三<br/>行\n7|溢出的编号\n```\n", 3);
+    CHECK_EQ(parsed.items.size(), size_t{3});
+    CHECK_EQ(parsed.items[0].value_or("<missing>"), std::string("一"));
+    CHECK_EQ(parsed.items[1].value_or("<missing>"), std::string("二\n还是二"));
+    CHECK_EQ(parsed.items[2].value_or("<missing>"), std::string("三\n行\n7|溢出的编号"));
+    CHECK_EQ(parsed.last_index.value_or(99), size_t{2});
+}
+
+void test_missing_and_duplicates() {
+    const NumberedLines parsed = parse_numbered_lines("1|a\n3|c\n1|again", 3);
+    CHECK(parsed.items[0].has_value());
+    CHECK(!parsed.items[1].has_value());
+    CHECK(parsed.duplicates);
+    CHECK_EQ(parsed.items[0].value_or("<missing>"), std::string("a"));
+}
+
+void test_streamer_matches_parser() {
+    const std::vector<std::string> texts = {"one", "two\nlines", "three"};
+    const std::string encoded = encode_numbered_lines(texts);
+    // 按每个字节的边界喂入：项在下一条编号行开始时完整，finish() 交出最后一项
+    std::vector<std::string> items(texts.size());
+    NumberedLinesStreamer streamer(texts.size(), [&](size_t index, std::string value) {
+        if (index < items.size()) items[index] = std::move(value);
+    });
+    const std::string stream = encoded + "\n";
+    for (char c : stream) streamer.feed(std::string_view(&c, 1));
+    CHECK_EQ(streamer.emitted(), texts.size() - 1);
+    streamer.finish();
+    CHECK_EQ(streamer.emitted(), texts.size());
+    for (size_t i = 0; i < texts.size(); ++i) CHECK_EQ(items[i], texts[i]);
+}
+
+void test_language_sections() {
+    const auto sections = split_language_sections("@zh\n1|你好\n## JA\n1|こんにちは\n", {"zh", "ja", "ko"});
+    CHECK_EQ(sections.size(), size_t{3});
+    CHECK_EQ(parse_numbered_lines(sections[0], 1).items[0].value_or("<missing>"), std::string("你好"));
+    CHECK_EQ(parse_numbered_lines(sections[1], 1).items[0].value_or("<missing>"), std::string("こんにちは"));
+    CHECK(sections[2].empty());
+}
+
+} // namespace
+
+int main() {
+    test_round_trips();
+    test_lenient_parse();
+    test_missing_and_duplicates();
+    test_streamer_matches_parser();
+    test_language_sections();
+    return test::exit_code();
+}
@@ -0,0 +1,130 @@
+// 对冲 + 故障转移组合翻译器（对进程内 OpenAI 模拟服务）：落败的对冲尝试同样计入请求统计，
+// 多目标语言走主翻译器的多语言请求，失败段逐语言故障转移
+#include "mock_openai_server.hpp"
+#include "video2srt_native/failover_translator.hpp"
+#include "video2srt_native/openai_translator.hpp"
+#include "video2srt_native/translator.hpp"
+#include "test_support.hpp"
+
+#include <atomic>
+#include <string>
+
+using namespace v2s;
+
+namespace {
+
+std::vector<Segment> corpus(size_t count) {
+    std::vector<Segment> segments;
+    for (size_t i = 0; i < count; ++i) {
+        segments.emplace_back(static_cast<double>(i), static_cast<double>(i) + 1.0,
+                              "Line number " + std::to_string(i) + " of the test corpus.");
+    }
+    return segments;
+}
+
+TranslatorOptions mock_options(const MockOpenAIServer& mock) {
+    TranslatorOptions opts;
+    opts.base_url = mock.base_url();
+    opts.retry_count = 0;
+    opts.timeout_seconds = 2;
+    opts.max_concurrency = 4;
+    opts.deduplicate = false;
+    opts.cache_enabled = false;
+    return opts;
+}
+
+void test_hedge_stats() {
+    // 约一成请求落入 800ms 长尾；对冲延迟（样本不足时为超时的四分之一，其后为 p95 与下限）远离两档耗时
+    MockOpenAIServer::Options mock_opts;
+    mock_opts.latency_ms = 5.0;
+    mock_opts.tail_rate = 0.1;
+    mock_opts.tail_ms = 800.0;
+    MockOpenAIServer mock(mock_opts);
+    CHECK(mock.start());
+
+    auto opts = mock_options(mock);
+    opts.hedge_requests = true;
+    opts.hedge_min_delay_ms = 150;
+    auto translator = create_translator("openai", opts);
+    const auto segments = corpus(80);
+    const auto result = translator->translate_segments(segments, "zh", "en");
+
+    CHECK(result.failed_indices.empty());
+    CHECK(result.stats.hedged_requests > 0);
+    // 服务端收到的每个请求（含被取消的落败尝试）都计入统计
+    CHECK_EQ(result.stats.request_count, static_cast<size_t>(mock.stats().requests));
+    CHECK(result.stats.request_count > segments.size());
+}
+
+const std::vector<std::string> kTargets = {"zh", "ja", "ko"};
+
+void test_multi_target_single_pass() {
+    MockOpenAIServer::Options mock_opts;
+    mock_opts.latency_ms = 5.0;
+    MockOpenAIServer mock(mock_opts);
+    CHECK(mock.start());
+
+    // 默认配置即带 google 后备：多目标语言仍应一批一个请求，而不是每种语言一个
+    auto opts = mock_options(mock);
+    opts.batch_mode = true;
+    auto translator = create_translator("openai", opts, {TranslatorBackend{"google", TranslatorOptions{}}});
+    std::atomic<size_t> callbacks{0};
+    translator->set_segment_callback([&](size_t, const std::string&) { callbacks++; });
+    const auto segments = corpus(20);
+    const auto results = translator->translate_segments_multi(segments, kTargets, "en");
+
+    const size_t batches = OpenAITranslator(opts).request_groups(segments, kTargets.front(), "en").size();
+    CHECK_EQ(batches, size_t{1});
+    CHECK_EQ(static_cast<size_t>(mock.stats().requests), batches);
+    CHECK_EQ(results.size(), kTargets.size());
+    CHECK_EQ(results.front().stats.request_count, batches);
+    for (const auto& r : results) {
+        CHECK(r.failed_indices.empty());
+        CHECK_EQ(r.segments.size(), segments.size());
+        if (!r.segments.empty()) CHECK_EQ(r.segments.front().language.value_or(""), r.target_language);
+    }
+    // 每个（段，目标语言）回调一次
+    CHECK_EQ(callbacks.load(), segments.size() * kTargets.size());
+}
+
+void test_multi_target_failover_per_language() {
+    MockOpenAIServer::Options broken_opts;
+    broken_opts.latency_ms = 1.0;
+    broken_opts.error_rate = 1.0;
+    MockOpenAIServer broken(broken_opts);
+    MockOpenAIServer::Options backup_opts;
+    backup_opts.latency_ms = 1.0;
+    MockOpenAIServer backup(backup_opts);
+    CHECK(broken.start());
+    CHECK(backup.start());
+
+    // 主翻译器的多语言请求整体失败，失败段逐语言交给链中的下一个翻译器
+    auto primary = mock_options(broken);
+    primary.batch_mode = true;
+    auto fallback = mock_options(backup);
+    fallback.batch_mode = true;
+    FailoverTranslator translator({TranslatorBackend{"openai", primary}, TranslatorBackend{"backup", fallback}},
+                                  [](const std::string&, const TranslatorOptions& o) -> std::unique_ptr<ITranslator> {
+                                      return std::make_unique<OpenAITranslator>(o);
+                                  });
+    const auto segments = corpus(20);
+    const auto results = translator.translate_segments_multi(segments, kTargets, "en");
+
+    CHECK_EQ(results.size(), kTargets.size());
+    for (const auto& r : results) {
+        CHECK(r.failed_indices.empty());
+        for (const auto& seg : r.segments) CHECK(seg.text.rfind("[mock] ", 0) == 0);
+    }
+    CHECK_EQ(static_cast<size_t>(backup.stats().requests), kTargets.size());
+    CHECK_EQ(results.front().stats.failover_segments, segments.size() * kTargets.size());
+    CHECK(results.front().stats.failed_requests > 0);
+}
+
+} // namespace
+
+int main() {
+    test_hedge_stats();
+    test_multi_target_single_pass();
+    test_multi_target_failover_per_language();
+    return test::exit_code();
+}
@@ -0,0 +1,134 @@
+// 模糊翻译记忆：数字与否定词守卫、按相似度复用、截断尾部后的继续追加与不兼容版本的日志
+#include "video2srt_native/fuzzy_memory.hpp"
+#include "test_support.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using namespace v2s;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t kMaxBytes = 1 << 20;
+constexpr double kThreshold = 0.6;
+
+fs::path fresh_dir(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    fs::path dir = fs::temp_directory_path() / ("v2s_fuzzy_test_" + name + "_" + std::to_string(stamp));
+    fs::remove_all(dir);
+    return dir;
+}
+
+fs::path log_path(const fs::path& dir) { return dir / "fuzzy.log"; }
+
+uint64_t scope() { return FuzzyTranslationMemory::make_scope("openai/test/p1", "en", "zh"); }
+
+std::string lookup(const std::shared_ptr<FuzzyTranslationMemory>& memory, const std::string& text) {
+    const auto match = memory->lookup(scope(), {text}, kThreshold).front();
+    return match ? match->translation : std::string("<miss>");
+}
+
+void test_guard_tokens() {
+    using M = FuzzyTranslationMemory;
+    CHECK(M::guard_tokens_match("See you at 10.", "see you at 10!"));
+    CHECK(!M::guard_tokens_match("See you at 10.", "See you at 11."));
+    CHECK(!M::guard_tokens_match("Room 12, floor 3.", "Room 3, floor 12."));   // 顺序也要一致
+    CHECK(M::guard_tokens_match("Wait １０ minutes.", "Wait 10 minutes."));    // 全角数字折叠
+    CHECK(!M::guard_tokens_match("It is not here.", "It is here."));
+    CHECK(M::guard_tokens_match("Don't go.", "Do not go."));                   // 否定词统一为一个标记
+    CHECK(M::guard_tokens_match("Don’t go.", "Don't go."));                    // 弯引号
+    CHECK(!M::guard_tokens_match("我知道了", "我不知道了"));
+    CHECK(!M::guard_tokens_match("Never again.", "Again."));
+}
+
+void test_lookup_respects_guards() {
+    const fs::path dir = fresh_dir("guard");
+    auto memory = FuzzyTranslationMemory::open(dir, kMaxBytes);
+    CHECK(memory != nullptr);
+    memory->insert(scope(), {{"I will meet you at the station at 10 tonight.", "今晚10点我在车站等你。"},
+                             {"We are going to the house tomorrow.", "我们明天去那所房子。"}});
+
+    // 仅标点或大小写不同：复用
+    CHECK_EQ(lookup(memory, "I will meet you at the station at 10 tonight!"), std::string("今晚10点我在车站等你。"));
+    CHECK_EQ(lookup(memory, "we are going to the house tomorrow"), std::string("我们明天去那所房子。"));
+
+    // 相似度达标，但数字或否定词不同：不复用
+    const std::string other_number = "I will meet you at the station at 11 tonight.";
+    const std::string negated = "We are not going to the house tomorrow.";
+    CHECK(FuzzyTranslationMemory::similarity(other_number, "I will meet you at the station at 10 tonight.") >= kThreshold);
+    CHECK(FuzzyTranslationMemory::similarity(negated, "We are going to the house tomorrow.") >= kThreshold);
+    CHECK_EQ(lookup(memory, other_number), std::string("<miss>"));
+    CHECK_EQ(lookup(memory, negated), std::string("<miss>"));
+
+    // 其他作用域（语言对）不命中
+    const auto other_scope = FuzzyTranslationMemory::make_scope("openai/test/p1", "en", "ja");
+    CHECK(!memory->lookup(other_scope, {"We are going to the house tomorrow."}, kThreshold).front());
+    memory.reset();
+    fs::remove_all(dir);
+}
+
+void test_torn_tail() {
+    const fs::path dir = fresh_dir("torn");
+    {
+        auto memory = FuzzyTranslationMemory::open(dir, kMaxBytes);
+        memory->insert(scope(), {{"Listen to me right now.", "现在听我说。"}});
+        memory->insert(scope(), {{"Remember this house forever.", "永远记住这所房子。"}});
+    }
+    // 模拟写入中断：最后一条记录只写了一部分
+    fs::resize_file(log_path(dir), fs::file_size(log_path(dir)) - 1);
+    {
+        auto memory = FuzzyTranslationMemory::open(dir, kMaxBytes);
+        CHECK_EQ(lookup(memory, "Listen to me right now!"), std::string("现在听我说。"));
+        CHECK_EQ(lookup(memory, "Remember this house forever!"), std::string("<miss>"));
+        memory->insert(scope(), {{"Everything is about water.", "一切都与水有关。"}});
+    }
+    // 残片被截掉后追加的记录在重新扫描时仍可对齐
+    auto memory = FuzzyTranslationMemory::open(dir, kMaxBytes);
+    CHECK_EQ(lookup(memory, "Listen to me right now"), std::string("现在听我说。"));
+    CHECK_EQ(lookup(memory, "Everything is about water!"), std::string("一切都与水有关。"));
+    CHECK_EQ(memory->entry_count(), size_t{2});
+    memory.reset();
+    fs::remove_all(dir);
+}
+
+void test_foreign_version() {
+    const fs::path dir = fresh_dir("version");
+    {
+        auto memory = FuzzyTranslationMemory::open(dir, kMaxBytes);
+        memory->insert(scope(), {{"Listen to me right now.", "现在听我说。"}});
+    }
+    // 改写头部的格式版本，模拟其他版本写出的日志
+    {
+        std::fstream file(log_path(dir), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(4);
+        file.put('\x02');
+    }
+    const uintmax_t foreign_size = fs::file_size(log_path(dir));
+    {
+        auto memory = FuzzyTranslationMemory::open(dir, kMaxBytes);
+        CHECK_EQ(lookup(memory, "Listen to me right now!"), std::string("<miss>"));
+        CHECK_EQ(fs::file_size(log_path(dir)), foreign_size);   // 只读不写
+        memory->insert(scope(), {{"Remember this house forever.", "永远记住这所房子。"}});
+    }
+    // 旧日志原样改名保留，新日志带有效头部，重新打开后仍可命中
+    const fs::path aside = log_path(dir).string() + ".old";
+    CHECK(fs::exists(aside));
+    if (fs::exists(aside)) CHECK_EQ(fs::file_size(aside), foreign_size);
+    auto memory = FuzzyTranslationMemory::open(dir, kMaxBytes);
+    CHECK_EQ(lookup(memory, "Remember this house forever!"), std::string("永远记住这所房子。"));
+    CHECK_EQ(memory->entry_count(), size_t{1});
+    memory.reset();
+    fs::remove_all(dir);
+}
+
+} // namespace
+
+int main() {
+    test_guard_tokens();
+    test_lookup_respects_guards();
+    test_torn_tail();
+    test_foreign_version();
+    return test::exit_code();
+}
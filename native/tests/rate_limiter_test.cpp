@@ -0,0 +1,133 @@
+// 端点限流器：配置登记的重新计算、AIMD 并发上限、并发名额、令牌桶速率与 Retry-After 暂停
+#include "video2srt_native/rate_limiter.hpp"
+#include "test_support.hpp"
+
+#include <chrono>
+#include <optional>
+#include <thread>
+
+using namespace v2s;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+HttpResponse response(int status, std::optional<std::string> retry_after = std::nullopt) {
+    HttpResponse resp;
+    resp.status = status;
+    if (retry_after) resp.headers.emplace_back("retry-after", *retry_after);
+    return resp;
+}
+
+double elapsed_ms(Clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - since).count();
+}
+
+void test_registrations() {
+    EndpointLimiter limiter("http://registrations:80");
+    std::optional<EndpointLimiter::Registration> strict = limiter.configure(2.0, 0, 4);
+    std::optional<EndpointLimiter::Registration> loose = limiter.configure(10.0, 0, 16);
+    // 速率取最严格者，并发上限取最大值
+    CHECK_EQ(limiter.rate_limit(), 2.0);
+    CHECK_EQ(limiter.concurrency_limit(), 16.0);
+
+    // 撤销后按剩余登记重新计算：调高速率、调低并发立即生效
+    strict.reset();
+    CHECK_EQ(limiter.rate_limit(), 10.0);
+    loose.reset();
+    CHECK_EQ(limiter.rate_limit(), 0.0);
+    CHECK_EQ(limiter.concurrency_limit(), 1.0);
+    auto narrow = limiter.configure(0.0, 0, 3);
+    CHECK_EQ(limiter.concurrency_limit(), 3.0);
+
+    // 登记可移动，移走的登记不会重复撤销
+    EndpointLimiter::Registration moved = std::move(narrow);
+    auto wide = limiter.configure(0.0, 0, 12);
+    CHECK_EQ(limiter.concurrency_limit(), 12.0);
+    wide = EndpointLimiter::Registration{};
+    CHECK_EQ(limiter.concurrency_limit(), 3.0);
+}
+
+void test_aimd() {
+    EndpointLimiter limiter("http://aimd:80");
+    auto config = limiter.configure(0.0, 0, 8);
+    CHECK_EQ(limiter.concurrency_limit(), 8.0);
+
+    // 429/503 乘性减半；同一波限流响应只减一次
+    limiter.on_response(response(429));
+    CHECK_EQ(limiter.concurrency_limit(), 4.0);
+    limiter.on_response(response(503));
+    CHECK_EQ(limiter.concurrency_limit(), 4.0);
+
+    // 成功响应加性恢复：每个上限周期约 +1，且不超过配置的上界
+    for (int i = 0; i < 4; ++i) limiter.on_response(response(200));
+    CHECK(limiter.concurrency_limit() > 4.9 && limiter.concurrency_limit() < 5.1);
+    for (int i = 0; i < 100; ++i) limiter.on_response(response(200));
+    CHECK_EQ(limiter.concurrency_limit(), 8.0);
+
+    // 其他错误不影响并发上限；被限流过后调低上界只截断当前值
+    limiter.on_response(response(500));
+    CHECK_EQ(limiter.concurrency_limit(), 8.0);
+    config = limiter.configure(0.0, 0, 2);
+    CHECK_EQ(limiter.concurrency_limit(), 2.0);
+}
+
+void test_concurrency_gate() {
+    EndpointLimiter limiter("http://gate:80");
+    auto config = limiter.configure(0.0, 0, 2);
+    CancellationToken none;
+    auto first = limiter.acquire(none);
+    auto second = limiter.acquire(none);
+    CHECK(first.valid() && second.valid());
+
+    // 名额用尽：等待直到取消
+    auto cancel = CancellationToken::create();
+    const auto start = Clock::now();
+    std::thread canceller([cancel] {
+        std::this_thread::sleep_for(std::chrono::milliseconds(150));
+        cancel.cancel();
+    });
+    auto third = limiter.acquire(cancel);
+    canceller.join();
+    CHECK(!third.valid());
+    CHECK(elapsed_ms(start) >= 140.0);
+
+    // 归还一个名额后立即可得
+    first = EndpointLimiter::Permit{};
+    auto fourth = limiter.acquire(none);
+    CHECK(fourth.valid());
+}
+
+void test_token_bucket() {
+    EndpointLimiter limiter("http://bucket:80");
+    auto config = limiter.configure(20.0, 1, 4);
+    CancellationToken none;
+    const auto start = Clock::now();
+    for (int i = 0; i < 5; ++i) {
+        auto permit = limiter.acquire(none);
+        CHECK(permit.valid());
+    }
+    // 桶容量 1、每秒 20 个：首个立即发出，其余约每 50ms 一个
+    CHECK(elapsed_ms(start) >= 180.0);
+}
+
+void test_retry_after_pause() {
+    EndpointLimiter limiter("http://pause:80");
+    auto config = limiter.configure(0.0, 0, 4);
+    limiter.on_response(response(429, "1"));
+    CancellationToken none;
+    const auto start = Clock::now();
+    auto permit = limiter.acquire(none);
+    CHECK(permit.valid());
+    CHECK(elapsed_ms(start) >= 900.0);
+}
+
+} // namespace
+
+int main() {
+    test_registrations();
+    test_aimd();
+    test_concurrency_gate();
+    test_token_bucket();
+    test_retry_after_pause();
+    return test::exit_code();
+}
@@ -0,0 +1,101 @@
+// 流式解析：SSE 分帧与 JSON 字符串数组的增量解析
+#include "video2srt_native/stream_parser.hpp"
+#include "test_support.hpp"
+
+#include <utility>
+#include <vector>
+
+using namespace v2s;
+
+namespace {
+
+using Events = std::vector<std::pair<std::string, std::string>>;
+
+// 按固定步长切片喂入，覆盖 \r\n 被拆在两片之间等边界情况
+Events decode(const std::string& stream, size_t step, bool finish = true) {
+    Events events;
+    SseDecoder decoder([&](const std::string& event, const std::string& data) { events.emplace_back(event, data); });
+    for (size_t off = 0; off < stream.size(); off += step) {
+        decoder.feed(std::string_view(stream).substr(off, step));
+    }
+    if (finish) decoder.finish();
+    CHECK_EQ(decoder.event_count(), events.size());
+    return events;
+}
+
+void test_sse_framing() {
+    const std::string stream =
+        ": keep-alive comment\r\n"
+        "data: {\"a\":1}\r\n\r\n"
+        "event: delta\n"
+        "data: line one\n"
+        "data: line two\n\n"
+        "data:no-space\r\r"
+        "data: [DONE]\n\n";
+    for (size_t step : {size_t{1}, size_t{2}, size_t{3}, size_t{7}, stream.size()}) {
+        const Events events = decode(stream, step);
+        CHECK_EQ(events.size(), size_t{4});
+        if (events.size() != 4) continue;
+        CHECK_EQ(events[0].second, std::string("{\"a\":1}"));
+        CHECK_EQ(events[1].first, std::string("delta"));
+        CHECK_EQ(events[1].second, std::string("line one\nline two"));
+        CHECK_EQ(events[2].second, std::string("no-space"));
+        CHECK_EQ(events[3].second, std::string("[DONE]"));
+    }
+}
+
+void test_sse_unterminated_tail() {
+    // 末尾事件没有空行：只有 finish() 才派发
+    const std::string stream = "data: first\n\ndata: tail";
+    CHECK_EQ(decode(stream, 4, false).size(), size_t{1});
+    const Events events = decode(stream, 4, true);
+    CHECK_EQ(events.size(), size_t{2});
+    if (events.size() == 2) CHECK_EQ(events[1].second, std::string("tail"));
+}
+
+void test_json_array_streamer() {
+    const std::string content = "```json\n{\"note\": \"x\", \"translations\": [\"你好\", \"say \\\"hi\\\"\\n\", \"\\u00e9\"]}\n```";
+    for (size_t step : {size_t{1}, size_t{5}, content.size()}) {
+        std::vector<std::string> items;
+        JsonStringArrayStreamer streamer("translations", [&](size_t index, std::string value) {
+            CHECK_EQ(index, items.size());
+            items.push_back(std::move(value));
+        });
+        for (size_t off = 0; off < content.size(); off += step) {
+            streamer.feed(std::string_view(content).substr(off, step));
+        }
+        CHECK(streamer.finished());
+        CHECK(!streamer.stopped());
+        CHECK_EQ(items.size(), size_t{3});
+        if (items.size() != 3) continue;
+        CHECK_EQ(items[0], std::string("你好"));
+        CHECK_EQ(items[1], std::string("say \"hi\"\n"));
+        CHECK_EQ(items[2], std::string("\xC3\xA9"));
+    }
+}
+
+void test_json_array_streamer_stops() {
+    // 非字符串元素：已闭合的元素照常回调，之后停止，由调用方回退到完整解析
+    std::vector<std::string> items;
+    JsonStringArrayStreamer streamer("translations", [&](size_t, std::string value) { items.push_back(std::move(value)); });
+    streamer.feed("{\"translations\": [\"a\", 42, \"b\"]}");
+    CHECK(streamer.stopped());
+    CHECK_EQ(items.size(), size_t{1});
+
+    // 截断的输出：未闭合的元素不回调
+    items.clear();
+    JsonStringArrayStreamer truncated("translations", [&](size_t, std::string value) { items.push_back(std::move(value)); });
+    truncated.feed("{\"translations\": [\"a\", \"b");
+    CHECK(!truncated.finished());
+    CHECK_EQ(items.size(), size_t{1});
+}
+
+} // namespace
+
+int main() {
+    test_sse_framing();
+    test_sse_unterminated_tail();
+    test_json_array_streamer();
+    test_json_array_streamer_stops();
+    return test::exit_code();
+}
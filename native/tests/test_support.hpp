@@ -0,0 +1,45 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+namespace v2s::test {
+
+/**
+ * 极简断言：失败时打印位置与实际值并累计失败数，main 以 test::exit_code() 返回
+ * 不引入第三方测试框架，单个可执行文件即一个 ctest 用例
+ */
+inline int& failures() {
+    static int count = 0;
+    return count;
+}
+
+inline int exit_code() {
+    if (failures() > 0) std::cerr << failures() << " 项检查失败" << std::endl;
+    return failures() == 0 ? 0 : 1;
+}
+
+template <typename A, typename B>
+void check_equal(const A& actual, const B& expected, const char* expr, const char* file, int line) {
+    if (actual == expected) return;
+    std::ostringstream a, e;
+    a << actual;
+    e << expected;
+    std::cerr << file << ":" << line << ": CHECK_EQ(" << expr << ") 失败\n"
+              << "  实际: " << a.str() << "\n  期望: " << e.str() << std::endl;
+    ++failures();
+}
+
+} // namespace v2s::test
+
+#define CHECK(cond)                                                                               \
+    do {                                                                                          \
+        if (!(cond)) {                                                                            \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") 失败" << std::endl;   \
+            ++::v2s::test::failures();                                                            \
+        }                                                                                         \
+    } while (0)
+
+#define CHECK_EQ(actual, expected) \
+    ::v2s::test::check_equal((actual), (expected), #actual ", " #expected, __FILE__, __LINE__)
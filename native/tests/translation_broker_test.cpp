@@ -0,0 +1,155 @@
+// 跨任务批量合并器：按容量与条目数组批、结果路由回各自任务、单条回调，以及 leader 取消时他人条目的放回
+#include "video2srt_native/translation_broker.hpp"
+#include "test_support.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+using namespace v2s;
+using namespace std::chrono_literals;
+
+namespace {
+
+using Results = std::vector<std::optional<std::string>>;
+
+std::vector<TranslationBroker::Item> items(const std::string& prefix, size_t count, double weight) {
+    std::vector<TranslationBroker::Item> out;
+    for (size_t i = 0; i < count; ++i) out.push_back({prefix + std::to_string(i), weight});
+    return out;
+}
+
+// 记录每批文本并返回 "T:" + 原文
+struct RecordingSender {
+    std::mutex mutex;
+    std::vector<std::vector<std::string>> batches;
+
+    TranslationBroker::BatchSender sender() {
+        return [this](const std::vector<std::string>& texts) {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                batches.push_back(texts);
+            }
+            Results out;
+            for (const auto& t : texts) out.emplace_back("T:" + t);
+            return out;
+        };
+    }
+};
+
+std::function<size_t()> fixed(size_t n) {
+    return [n] { return n; };
+}
+
+void test_capacity_and_item_cap() {
+    TranslationBroker broker("capacity");
+    RecordingSender rec;
+    CancellationToken none;
+    // 每条占 0.4 个请求容量：每批最多 2 条
+    auto out = broker.translate(items("a", 5, 0.4), rec.sender(), fixed(100), 0ms, 1, none, nullptr);
+    CHECK_EQ(rec.batches.size(), size_t{3});
+    if (rec.batches.size() == 3) {
+        CHECK_EQ(rec.batches[0].size(), size_t{2});
+        CHECK_EQ(rec.batches[1].size(), size_t{2});
+        CHECK_EQ(rec.batches[2].size(), size_t{1});
+    }
+    for (size_t i = 0; i < out.size(); ++i) CHECK_EQ(out[i].value_or("<miss>"), "T:a" + std::to_string(i));
+
+    // 条目数上限
+    rec.batches.clear();
+    broker.translate(items("b", 5, 0.01), rec.sender(), fixed(2), 0ms, 1, none, nullptr);
+    CHECK_EQ(rec.batches.size(), size_t{3});
+
+    // 超出容量的单条独占一批
+    rec.batches.clear();
+    auto big = items("c", 3, 0.3);
+    big[1].weight = 1.5;
+    broker.translate(big, rec.sender(), fixed(100), 0ms, 1, none, nullptr);
+    CHECK_EQ(rec.batches.size(), size_t{3});
+}
+
+void test_routing_across_jobs() {
+    TranslationBroker broker("routing");
+    RecordingSender rec;
+    CancellationToken none;
+    std::atomic<size_t> callbacks_a{0}, callbacks_b{0};
+    std::atomic<bool> index_ok{true};
+    Results out_a, out_b;
+
+    // 两个任务在 linger 内先后提交：合并为一批，结果按条目路由回各自任务
+    std::thread job_a([&] {
+        out_a = broker.translate(items("a", 3, 0.05), rec.sender(), fixed(100), 400ms, 1, none,
+                                 [&](size_t i, const std::string& text) {
+                                     if (text != "T:a" + std::to_string(i)) index_ok = false;
+                                     callbacks_a++;
+                                 });
+    });
+    std::this_thread::sleep_for(50ms);
+    std::thread job_b([&] {
+        out_b = broker.translate(items("b", 4, 0.05), rec.sender(), fixed(100), 400ms, 1, none,
+                                 [&](size_t i, const std::string& text) {
+                                     if (text != "T:b" + std::to_string(i)) index_ok = false;
+                                     callbacks_b++;
+                                 });
+    });
+    job_a.join();
+    job_b.join();
+
+    CHECK_EQ(rec.batches.size(), size_t{1});
+    if (!rec.batches.empty()) CHECK_EQ(rec.batches.front().size(), size_t{7});
+    CHECK_EQ(out_a.size(), size_t{3});
+    CHECK_EQ(out_b.size(), size_t{4});
+    for (size_t i = 0; i < out_a.size(); ++i) CHECK_EQ(out_a[i].value_or("<miss>"), "T:a" + std::to_string(i));
+    for (size_t i = 0; i < out_b.size(); ++i) CHECK_EQ(out_b[i].value_or("<miss>"), "T:b" + std::to_string(i));
+    // 每条恰好回调一次，在提交者自己的调用中
+    CHECK_EQ(callbacks_a.load(), size_t{3});
+    CHECK_EQ(callbacks_b.load(), size_t{4});
+    CHECK(index_ok.load());
+}
+
+void test_cancelled_leader_puts_back() {
+    TranslationBroker broker("cancel");
+    CancellationToken cancel_a = CancellationToken::create();
+    CancellationToken none;
+    std::vector<std::vector<std::string>> sent_by_a;
+    RecordingSender rec_b;
+    Results out_a, out_b;
+
+    // A 的 linger 较短，先担任 leader；发送期间 A 被取消，整批失败
+    TranslationBroker::BatchSender sender_a = [&](const std::vector<std::string>& texts) {
+        sent_by_a.push_back(texts);
+        cancel_a.cancel();
+        return Results(texts.size());
+    };
+    std::thread job_a([&] {
+        out_a = broker.translate(items("a", 2, 0.05), sender_a, fixed(100), 200ms, 1, cancel_a, nullptr);
+    });
+    std::this_thread::sleep_for(50ms);
+    std::thread job_b([&] {
+        out_b = broker.translate(items("b", 3, 0.05), rec_b.sender(), fixed(100), 600ms, 1, none, nullptr);
+    });
+    job_a.join();
+    job_b.join();
+
+    CHECK_EQ(sent_by_a.size(), size_t{1});
+    if (!sent_by_a.empty()) CHECK_EQ(sent_by_a.front().size(), size_t{5});
+    CHECK_EQ(out_a.size(), size_t{2});
+    for (const auto& r : out_a) CHECK(!r);
+    // B 的条目被放回队首，由 B 自己重新发送，且不含 A 的条目
+    CHECK_EQ(rec_b.batches.size(), size_t{1});
+    if (!rec_b.batches.empty()) {
+        CHECK_EQ(rec_b.batches.front().size(), size_t{3});
+        for (const auto& t : rec_b.batches.front()) CHECK_EQ(t.substr(0, 1), std::string("b"));
+    }
+    for (size_t i = 0; i < out_b.size(); ++i) CHECK_EQ(out_b[i].value_or("<miss>"), "T:b" + std::to_string(i));
+}
+
+} // namespace
+
+int main() {
+    test_capacity_and_item_cap();
+    test_routing_across_jobs();
+    test_cancelled_leader_puts_back();
+    return test::exit_code();
+}
@@ -0,0 +1,147 @@
+// 持久翻译缓存：重新打开时的日志扫描（截断尾部、校验和损坏）、截断后的继续追加与不兼容版本的日志
+#include "video2srt_native/translation_cache.hpp"
+#include "test_support.hpp"
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+using namespace v2s;
+namespace fs = std::filesystem;
+
+namespace {
+
+constexpr uint64_t kMaxBytes = 1 << 20;
+
+fs::path fresh_dir(const std::string& name) {
+    const auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+    fs::path dir = fs::temp_directory_path() / ("v2s_cache_test_" + name + "_" + std::to_string(stamp));
+    fs::remove_all(dir);
+    return dir;
+}
+
+fs::path log_path(const fs::path& dir) { return dir / "translations.log"; }
+
+std::string hits(const std::shared_ptr<TranslationCache>& cache, const std::vector<std::string>& keys) {
+    std::string out;
+    for (const auto& value : cache->lookup(keys)) out += value ? '1' : '0';
+    return out;
+}
+
+void test_reopen() {
+    const fs::path dir = fresh_dir("reopen");
+    {
+        auto cache = TranslationCache::open(dir, kMaxBytes);
+        CHECK(cache != nullptr);
+        cache->insert({{"a", "1"}, {"b", "2"}});
+        cache->insert({{"a", "1b"}});   // 同键后写覆盖先写
+    }
+    auto cache = TranslationCache::open(dir, kMaxBytes);
+    CHECK_EQ(cache->entry_count(), size_t{2});
+    const auto values = cache->lookup({"a", "b", "c"});
+    CHECK_EQ(values[0].value_or("<miss>"), std::string("1b"));
+    CHECK_EQ(values[1].value_or("<miss>"), std::string("2"));
+    CHECK(!values[2]);
+    fs::remove_all(dir);
+}
+
+void test_torn_tail() {
+    const fs::path dir = fresh_dir("torn");
+    {
+        auto cache = TranslationCache::open(dir, kMaxBytes);
+        cache->insert({{"a", "1"}, {"b", "2"}, {"c", "3"}});
+    }
+    // 模拟写入中断：最后一条记录只写了一部分
+    fs::resize_file(log_path(dir), fs::file_size(log_path(dir)) - 1);
+    {
+        auto cache = TranslationCache::open(dir, kMaxBytes);
+        CHECK_EQ(hits(cache, {"a", "b", "c"}), std::string("110"));
+        cache->insert({{"d", "4"}});
+        CHECK_EQ(hits(cache, {"a", "b", "c", "d"}), std::string("1101"));
+    }
+    // 残片被截掉后追加的记录在重新扫描时仍可对齐
+    auto cache = TranslationCache::open(dir, kMaxBytes);
+    CHECK_EQ(hits(cache, {"a", "b", "c", "d"}), std::string("1101"));
+    CHECK_EQ(cache->entry_count(), size_t{3});
+    fs::remove_all(dir);
+}
+
+void test_torn_record_header() {
+    const fs::path dir = fresh_dir("torn_header");
+    {
+        auto cache = TranslationCache::open(dir, kMaxBytes);
+        cache->insert({{"a", "1"}});
+    }
+    // 只写出记录头的前几个字节
+    {
+        std::ofstream out(log_path(dir), std::ios::binary | std::ios::app);
+        out.write("\x05\x00\x00", 3);
+    }
+    {
+        auto cache = TranslationCache::open(dir, kMaxBytes);
+        CHECK_EQ(hits(cache, {"a"}), std::string("1"));
+        cache->insert({{"b", "2"}});
+    }
+    auto cache = TranslationCache::open(dir, kMaxBytes);
+    CHECK_EQ(hits(cache, {"a", "b"}), std::string("11"));
+    fs::remove_all(dir);
+}
+
+void test_checksum_mismatch() {
+    const fs::path dir = fresh_dir("checksum");
+    {
+        auto cache = TranslationCache::open(dir, kMaxBytes);
+        cache->insert({{"key-one", "value-one"}});
+        cache->insert({{"key-two", "value-two"}});
+    }
+    // 篡改第一条记录的值：该记录被跳过，后续记录照常可读
+    {
+        std::fstream file(log_path(dir), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(16 + 16 + 7);   // 文件头 + 记录头 + 键
+        file.put('X');
+    }
+    auto cache = TranslationCache::open(dir, kMaxBytes);
+    CHECK_EQ(hits(cache, {"key-one", "key-two"}), std::string("01"));
+    fs::remove_all(dir);
+}
+
+void test_foreign_version() {
+    const fs::path dir = fresh_dir("version");
+    {
+        auto cache = TranslationCache::open(dir, kMaxBytes);
+        cache->insert({{"a", "1"}, {"b", "2"}});
+    }
+    // 改写头部的格式版本，模拟其他版本写出的日志
+    {
+        std::fstream file(log_path(dir), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(4);
+        file.put('\x02');
+    }
+    const uintmax_t foreign_size = fs::file_size(log_path(dir));
+    {
+        auto cache = TranslationCache::open(dir, kMaxBytes);
+        CHECK_EQ(hits(cache, {"a", "b"}), std::string("00"));
+        CHECK_EQ(fs::file_size(log_path(dir)), foreign_size);   // 只读不写
+        cache->insert({{"c", "3"}});
+        CHECK_EQ(hits(cache, {"a", "c"}), std::string("01"));
+    }
+    // 旧日志原样改名保留，新日志带有效头部，重新打开后仍可命中
+    const fs::path aside = log_path(dir).string() + ".old";
+    CHECK(fs::exists(aside));
+    if (fs::exists(aside)) CHECK_EQ(fs::file_size(aside), foreign_size);
+    auto cache = TranslationCache::open(dir, kMaxBytes);
+    CHECK_EQ(hits(cache, {"c"}), std::string("1"));
+    CHECK_EQ(cache->entry_count(), size_t{1});
+    fs::remove_all(dir);
+}
+
+} // namespace
+
+int main() {
+    test_reopen();
+    test_torn_tail();
+    test_torn_record_header();
+    test_checksum_mismatch();
+    test_foreign_version();
+    return test::exit_code();
+}
@@ -0,0 +1,80 @@
+// UTF-8 校验与修复：最大非法子序列替换与相邻字幕段拼接
+#include "video2srt_native/utf8.hpp"
+#include "video2srt_native/models.hpp"
+#include "test_support.hpp"
+
+using namespace v2s;
+
+namespace {
+
+const std::string kFffd = "\xEF\xBF\xBD";
+
+std::string repaired(std::string text, size_t expected_replacements) {
+    CHECK_EQ(repair_utf8(text), expected_replacements);
+    CHECK(is_valid_utf8(text));
+    return text;
+}
+
+void test_validation() {
+    CHECK(is_valid_utf8(""));
+    CHECK(is_valid_utf8("plain ascii that is longer than eight bytes"));
+    CHECK(is_valid_utf8("你好, мир, \xF0\x9F\x98\x80"));
+    CHECK_EQ(find_invalid_utf8("abcdefghij\x80"), size_t{10});
+    CHECK_EQ(find_invalid_utf8("ab\xE4\xBD"), size_t{2});           // 末尾截断
+    CHECK(!is_valid_utf8("\xC0\xAF"));                               // 过长编码
+    CHECK(!is_valid_utf8("\xED\xA0\x80"));                           // 代理区
+    CHECK(!is_valid_utf8("\xF4\x90\x80\x80"));                       // 超出 U+10FFFF
+}
+
+void test_maximal_subparts() {
+    // 合法文本不做改动
+    CHECK_EQ(repaired("你好 world", 0), std::string("你好 world"));
+    // 截断的多字节字符是一个最大子序列，替换为一个 U+FFFD
+    CHECK_EQ(repaired("a\xE2\x82 b", 1), "a" + kFffd + " b");
+    CHECK_EQ(repaired("end\xF0\x9F\x98", 1), "end" + kFffd);
+    // 首字节后的续字节不在允许范围内：每个字节各自是一个最大子序列（Unicode 表 3-8）
+    CHECK_EQ(repaired("\xC0\xAF", 2), kFffd + kFffd);
+    CHECK_EQ(repaired("\xED\xA0\x80", 3), kFffd + kFffd + kFffd);
+    CHECK_EQ(repaired("\xF4\x90\x80\x80", 4), kFffd + kFffd + kFffd + kFffd);
+    CHECK_EQ(repaired("\xF0\x80\x80", 3), kFffd + kFffd + kFffd);
+    // 孤立续字节与非法首字节
+    CHECK_EQ(repaired("x\x80y\xFFz", 2), "x" + kFffd + "y" + kFffd + "z");
+    // 合法前缀后接非法字节：前缀整体为一个子序列，非法字节重新作为起点
+    CHECK_EQ(repaired("\xE4\xBD" "A", 1), kFffd + "A");
+    CHECK_EQ(repaired("\xE4\xBD\xE4\xBD\xA0", 1), kFffd + "你");
+}
+
+void test_segment_stitching() {
+    // 段末截断的字符由下一段开头的续字节补全
+    std::vector<Segment> segments = {Segment(0, 1, "ab\xE4\xBD"), Segment(1, 2, "\xA0" "cd"), Segment(2, 3, "ok")};
+    CHECK_EQ(repair_utf8_segments(segments), size_t{1});
+    CHECK_EQ(segments[0].text, std::string("ab你"));
+    CHECK_EQ(segments[1].text, std::string("cd"));
+    CHECK_EQ(segments[2].text, std::string("ok"));
+
+    // 四字节字符跨段拆成 2 + 2
+    segments = {Segment(0, 1, "x\xF0\x9F"), Segment(1, 2, "\x98\x80y")};
+    CHECK_EQ(repair_utf8_segments(segments), size_t{1});
+    CHECK_EQ(segments[0].text, std::string("x\xF0\x9F\x98\x80"));
+    CHECK_EQ(segments[1].text, std::string("y"));
+
+    // 下一段无法补全：前一段末尾替换为 U+FFFD，下一段不受影响
+    segments = {Segment(0, 1, "a\xE4\xBD"), Segment(1, 2, "b")};
+    CHECK_EQ(repair_utf8_segments(segments), size_t{1});
+    CHECK_EQ(segments[0].text, "a" + kFffd);
+    CHECK_EQ(segments[1].text, std::string("b"));
+
+    // 最后一段的截断字符与段内非法字节
+    segments = {Segment(0, 1, "ok"), Segment(1, 2, "z\x80" "z\xE4")};
+    CHECK_EQ(repair_utf8_segments(segments), size_t{2});
+    CHECK_EQ(segments[1].text, "z" + kFffd + "z" + kFffd);
+}
+
+} // namespace
+
+int main() {
+    test_validation();
+    test_maximal_subparts();
+    test_segment_stitching();
+    return test::exit_code();
+}
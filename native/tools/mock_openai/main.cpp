@@ -0,0 +1,70 @@
+// 本地 OpenAI 兼容模拟服务：在前台运行，Ctrl+C 退出
+// 用法示例: v2s_mock_openai --port 8089 --latency lognormal --latency-ms 300 --429-rate 0.05
+// 然后把翻译器 base_url 指向 http://127.0.0.1:8089/v1/chat/completions
+
+#include "mock_openai_server.hpp"
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <iostream>
+#include <string>
+#include <thread>
+
+namespace {
+std::atomic<bool> g_stop{false};
+void on_signal(int) { g_stop = true; }
+}
+
+static void print_usage(const char* prog) {
+    std::cout << "用法: " << prog << " [选项]\n";
+    std::cout << "  --host <addr>           监听地址 (默认: 127.0.0.1)\n";
+    std::cout << "  --port <n>              监听端口 (默认: 8089，0 为自动分配)\n";
+    std::cout << "  -h, --help              显示帮助\n";
+    v2s::print_mock_options_help();
+}
+
+int main(int argc, char** argv) {
+    v2s::MockOpenAIServer::Options options;
+    std::string host = "127.0.0.1";
+    int port = 8089;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        const int consumed = v2s::parse_mock_option(argc, argv, i, options);
+        if (consumed < 0) {
+            std::cerr << "错误: " << arg << " 缺少参数或取值无效\n";
+            return 1;
+        }
+        if (consumed > 0) {
+            i += consumed - 1;
+            continue;
+        }
+        if ((arg == "--host" || arg == "--port") && i + 1 < argc) {
+            if (arg == "--host") host = argv[++i];
+            else port = std::stoi(argv[++i]);
+        } else {
+            std::cerr << "错误: 未知参数 " << arg << "\n";
+            print_usage(argv[0]);
+            return 1;
+        }
+    }
+
+    v2s::MockOpenAIServer server(options);
+    if (!server.start(host, static_cast<uint16_t>(port))) {
+        std::cerr << "错误: 无法监听 " << host << ":" << port << "\n";
+        return 1;
+    }
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::cout << "模拟 OpenAI 服务已启动: " << server.base_url() << "（统计: GET /stats）" << std::endl;
+    while (!g_stop) std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+    const auto s = server.stats();
+    server.stop();
+    std::cout << "请求 " << s.requests << "，成功 " << s.ok << "，500 " << s.errors << "，429 " << s.rate_limited
+              << "，畸形 " << s.malformed << std::endl;
+    return 0;
+}
@@ -0,0 +1,378 @@
+#include "mock_openai_server.hpp"
+#include "video2srt_native/batch_wire_format.hpp"
+#include "video2srt_native/token_estimator.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+
+namespace v2s {
+
+namespace {
+
+using json = nlohmann::json;
+
+LocalHttpServer::Response json_response(int status, const json& body) {
+    LocalHttpServer::Response resp;
+    resp.status = status;
+    resp.content_type = "application/json";
+    resp.body = body.dump();
+    return resp;
+}
+
+LocalHttpServer::Response error_response(int status, const std::string& type, const std::string& message) {
+    return json_response(status, json{{"error", json{{"type", type}, {"message", message}}}});
+}
+
+std::string mock_translate(const std::string& text) {
+    return "[mock] " + text;
+}
+
+// 多目标语言批量提示词（"... Target: zh, ja."）中的语言列表；单目标时为空
+std::vector<std::string> multi_target_languages(const std::string& system_prompt) {
+    static const std::string kMarker = "Target: ";
+    std::vector<std::string> langs;
+    const size_t begin = system_prompt.find(kMarker);
+    if (begin == std::string::npos) return langs;
+    const size_t list_begin = begin + kMarker.size();
+    const size_t end = system_prompt.find('.', list_begin);
+    std::stringstream ss(system_prompt.substr(list_begin, end == std::string::npos ? std::string::npos : end - list_begin));
+    std::string lang;
+    while (std::getline(ss, lang, ',')) {
+        lang.erase(0, lang.find_first_not_of(' '));
+        if (!lang.empty()) langs.push_back(lang);
+    }
+    if (langs.size() < 2) langs.clear();
+    return langs;
+}
+
+// 把完整回复切成若干 delta 事件（每块约 16 字节，不切断 UTF-8 字符）
+std::string to_sse(const std::string& id, const std::string& model, const std::string& content, const json& usage) {
+    std::string out;
+    auto emit = [&](const json& chunk) {
+        out += "data: ";
+        out += chunk.dump();
+        out += "\n\n";
+    };
+    size_t pos = 0;
+    while (pos < content.size()) {
+        size_t end = std::min(content.size(), pos + 16);
+        while (end < content.size() && (static_cast<unsigned char>(content[end]) & 0xC0) == 0x80) ++end;
+        emit(json{{"id", id}, {"object", "chat.completion.chunk"}, {"model", model},
+                  {"choices", json::array({json{{"index", 0}, {"delta", json{{"content", content.substr(pos, end - pos)}}},
+                                                {"finish_reason", nullptr}}})}});
+        pos = end;
+    }
+    emit(json{{"id", id}, {"object", "chat.completion.chunk"}, {"model", model},
+              {"choices", json::array({json{{"index", 0}, {"delta", json::object()}, {"finish_reason", "stop"}}})},
+              {"usage", usage}});
+    out += "data: [DONE]\n\n";
+    return out;
+}
+
+} // namespace
+
+bool parse_latency_distribution(const std::string& name, MockOpenAIServer::LatencyDistribution& out) {
+    if (name == "fixed") out = MockOpenAIServer::LatencyDistribution::Fixed;
+    else if (name == "uniform") out = MockOpenAIServer::LatencyDistribution::Uniform;
+    else if (name == "lognormal") out = MockOpenAIServer::LatencyDistribution::LogNormal;
+    else return false;
+    return true;
+}
+
+int parse_mock_option(int argc, char** argv, int i, MockOpenAIServer::Options& options) {
+    const std::string arg = argv[i];
+    struct NumberOption {
+        const char* name;
+        double* target;
+    };
+    const NumberOption numbers[] = {
+        {"--latency-ms", &options.latency_ms},
+        {"--jitter-ms", &options.jitter_ms},
+        {"--sigma", &options.lognormal_sigma},
+        {"--per-token-ms", &options.per_output_token_ms},
+        {"--tail-rate", &options.tail_rate},
+        {"--tail-ms", &options.tail_ms},
+        {"--error-rate", &options.error_rate},
+        {"--429-rate", &options.rate_limit_rate},
+        {"--malformed-rate", &options.malformed_rate},
+    };
+    const bool known = arg == "--latency" || arg == "--retry-after" || arg == "--max-inflight" || arg == "--seed"
+        || std::any_of(std::begin(numbers), std::end(numbers), [&](const NumberOption& o) { return arg == o.name; });
+    if (!known) return 0;
+    if (i + 1 >= argc) return -1;
+    const std::string value = argv[i + 1];
+    try {
+        if (arg == "--latency") {
+            if (!parse_latency_distribution(value, options.distribution)) return -1;
+        } else if (arg == "--retry-after") {
+            options.retry_after_seconds = std::stoi(value);
+        } else if (arg == "--max-inflight") {
+            options.max_inflight = std::stoi(value);
+        } else if (arg == "--seed") {
+            options.seed = static_cast<uint32_t>(std::stoul(value));
+        } else {
+            for (const auto& o : numbers) {
+                if (arg == o.name) *o.target = std::stod(value);
+            }
+        }
+    } catch (...) {
+        return -1;
+    }
+    return 2;
+}
+
+void print_mock_options_help() {
+    std::cout << "模拟服务选项:\n";
+    std::cout << "  --latency <dist>        基础延迟分布: fixed / uniform / lognormal (默认: fixed)\n";
+    std::cout << "  --latency-ms <ms>       基础延迟（lognormal 为中位数，默认: 50）\n";
+    std::cout << "  --jitter-ms <ms>        uniform 分布的半宽\n";
+    std::cout << "  --sigma <s>             lognormal 分布的形状参数 (默认: 0.5)\n";
+    std::cout << "  --per-token-ms <ms>     每个输出 token 的生成耗时\n";
+    std::cout << "  --tail-rate <p>         长尾请求比例，额外等待 --tail-ms\n";
+    std::cout << "  --tail-ms <ms>          长尾请求的额外延迟\n";
+    std::cout << "  --error-rate <p>        返回 500 的比例\n";
+    std::cout << "  --429-rate <p>          返回 429（带 Retry-After）的比例\n";
+    std::cout << "  --retry-after <sec>     429 响应的 Retry-After (默认: 1)\n";
+    std::cout << "  --malformed-rate <p>    返回截断 JSON 的比例\n";
+    std::cout << "  --max-inflight <n>      并发超过 n 时返回 429（0 为不限）\n";
+    std::cout << "  --seed <n>              随机种子 (默认: 42)\n";
+}
+
+MockOpenAIServer::MockOpenAIServer(Options options) : options_(options), rng_(options.seed) {}
+
+MockOpenAIServer::~MockOpenAIServer() {
+    stop();
+}
+
+bool MockOpenAIServer::start(const std::string& host, uint16_t port) {
+    host_ = host;
+    server_ = std::make_unique<LocalHttpServer>([this](const LocalHttpServer::Request& req) { return handle(req); });
+    if (!server_->start(host, port)) {
+        server_.reset();
+        return false;
+    }
+    return true;
+}
+
+void MockOpenAIServer::stop() {
+    if (server_) {
+        server_->stop();
+        server_.reset();
+    }
+}
+
+std::string MockOpenAIServer::base_url() const {
+    return "http://" + host_ + ":" + std::to_string(port()) + "/v1/chat/completions";
+}
+
+MockOpenAIServer::Stats MockOpenAIServer::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void MockOpenAIServer::reset_stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_ = Stats{};
+}
+
+double MockOpenAIServer::uniform01() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::uniform_real_distribution<double>(0.0, 1.0)(rng_);
+}
+
+double MockOpenAIServer::sample_latency_ms(size_t output_tokens) {
+    double base = options_.latency_ms;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        switch (options_.distribution) {
+            case LatencyDistribution::Fixed:
+                break;
+            case LatencyDistribution::Uniform:
+                base = std::uniform_real_distribution<double>(options_.latency_ms - options_.jitter_ms,
+                                                              options_.latency_ms + options_.jitter_ms)(rng_);
+                break;
+            case LatencyDistribution::LogNormal:
+                base = std::lognormal_distribution<double>(std::log(std::max(1e-3, options_.latency_ms)),
+                                                           options_.lognormal_sigma)(rng_);
+                break;
+        }
+    }
+    double total = std::max(0.0, base) + options_.per_output_token_ms * static_cast<double>(output_tokens);
+    if (options_.tail_rate > 0.0 && uniform01() < options_.tail_rate) total += options_.tail_ms;
+    return total;
+}
+
+LocalHttpServer::Response MockOpenAIServer::handle(const LocalHttpServer::Request& req) {
+    const std::string path = req.path.substr(0, req.path.find('?'));
+    if (req.method == "GET" && path == "/stats") {
+        const Stats s = stats();
+        return json_response(200, json{{"requests", s.requests}, {"ok", s.ok}, {"errors", s.errors},
+                                       {"rate_limited", s.rate_limited}, {"malformed", s.malformed},
+                                       {"bad_requests", s.bad_requests}, {"prompt_tokens", s.prompt_tokens},
+                                       {"completion_tokens", s.completion_tokens}});
+    }
+    if (req.method != "POST" || (path != "/v1/chat/completions" && path != "/chat/completions")) {
+        return error_response(404, "not_found", "unknown endpoint: " + req.method + " " + path);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.requests++;
+    }
+    const int inflight = inflight_.fetch_add(1) + 1;
+    struct InflightGuard {
+        std::atomic<int>& counter;
+        ~InflightGuard() { counter.fetch_sub(1); }
+    } guard{inflight_};
+
+    auto rate_limited = [&](const std::string& message) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.rate_limited++;
+        }
+        auto resp = error_response(429, "rate_limit_exceeded", message);
+        const std::string retry = std::to_string(std::max(0, options_.retry_after_seconds));
+        resp.headers = {{"Retry-After", retry},
+                        {"x-ratelimit-remaining-requests", "0"},
+                        {"x-ratelimit-reset-requests", retry + "s"}};
+        return resp;
+    };
+    if (options_.max_inflight > 0 && inflight > options_.max_inflight) {
+        return rate_limited("too many concurrent requests");
+    }
+    if (options_.rate_limit_rate > 0.0 && uniform01() < options_.rate_limit_rate) {
+        return rate_limited("injected rate limit");
+    }
+    if (options_.error_rate > 0.0 && uniform01() < options_.error_rate) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stats_.errors++;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(sample_latency_ms(0)));
+        return error_response(500, "server_error", "injected failure");
+    }
+    return handle_completion(req);
+}
+
+LocalHttpServer::Response MockOpenAIServer::handle_completion(const LocalHttpServer::Request& req) {
+    json body;
+    try {
+        body = json::parse(req.body);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.bad_requests++;
+        return error_response(400, "invalid_request_error", "request body is not valid JSON");
+    }
+    if (!body.is_object() || !body.contains("messages") || !body["messages"].is_array() || body["messages"].empty()) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.bad_requests++;
+        return error_response(400, "invalid_request_error", "missing messages");
+    }
+
+    size_t prompt_tokens = 0;
+    std::string user_content;
+    std::string system_content;
+    for (const auto& m : body["messages"]) {
+        if (!m.is_object() || !m.contains("content") || !m["content"].is_string()) continue;
+        const std::string content = m["content"].get<std::string>();
+        prompt_tokens += estimate_tokens(content) + 4;
+        if (m.value("role", "") == "user") user_content = content;
+        else if (m.value("role", "") == "system") system_content = content;
+    }
+
+    // 批量请求：编号行格式（系统提示词带格式版本）或 user 消息为字符串数组；
+    // 系统提示词列出多个目标语言时按语言分节 / 分键返回
+    std::string reply;
+    bool batch = false;
+    const auto targets = multi_target_languages(system_content);
+    if (system_content.find(kLinesWireFormatVersion) != std::string::npos) {
+        const size_t count = static_cast<size_t>(std::count(user_content.begin(), user_content.end(), '\n')) + 1;
+        const auto parsed = parse_numbered_lines(user_content, count);
+        auto translate_all = [&](const std::string& prefix) {
+            std::vector<std::string> out;
+            for (const auto& item : parsed.items) out.push_back(item ? prefix + mock_translate(*item) : std::string());
+            return encode_numbered_lines(out);
+        };
+        if (targets.empty()) {
+            reply = translate_all("");
+        } else {
+            for (const auto& lang : targets) reply += "@" + lang + "\n" + translate_all("[" + lang + "] ") + "\n";
+        }
+        batch = true;
+    } else {
+        try {
+            json items = json::parse(user_content);
+            if (items.is_array()) {
+                auto translate_all = [&](const std::string& prefix) {
+                    json out = json::array();
+                    for (const auto& item : items) {
+                        out.push_back(prefix + mock_translate(item.is_string() ? item.get<std::string>() : item.dump()));
+                    }
+                    return out;
+                };
+                if (targets.empty()) {
+                    reply = json{{"translations", translate_all("")}}.dump();
+                } else {
+                    json by_language = json::object();
+                    for (const auto& lang : targets) by_language[lang] = translate_all("[" + lang + "] ");
+                    reply = by_language.dump();
+                }
+                batch = true;
+            }
+        } catch (...) {
+        }
+    }
+    if (!batch) reply = mock_translate(user_content);
+
+    const size_t completion_tokens = estimate_tokens(reply);
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(sample_latency_ms(completion_tokens)));
+
+    const bool malformed = options_.malformed_rate > 0.0 && uniform01() < options_.malformed_rate;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (malformed) stats_.malformed++;
+        else stats_.ok++;
+        stats_.prompt_tokens += prompt_tokens;
+        stats_.completion_tokens += completion_tokens;
+    }
+    if (malformed) {
+        // 回复内容截断一半：JSON 批量无法解析，编号行批量缺少后半部分
+        reply = reply.substr(0, reply.size() / 2);
+    }
+
+    const std::string model = body.value("model", std::string("mock"));
+    const json usage{{"prompt_tokens", prompt_tokens},
+                     {"completion_tokens", completion_tokens},
+                     {"total_tokens", prompt_tokens + completion_tokens}};
+    const std::string id = "chatcmpl-mock";
+    if (body.value("stream", false)) {
+        LocalHttpServer::Response resp;
+        resp.content_type = "text/event-stream";
+        resp.body = to_sse(id, model, reply, usage);
+        return resp;
+    }
+    json resp_body{{"id", id},
+                   {"object", "chat.completion"},
+                   {"model", model},
+                   {"choices", json::array({json{{"index", 0},
+                                                 {"message", json{{"role", "assistant"}, {"content", reply}}},
+                                                 {"finish_reason", "stop"}}})},
+                   {"usage", usage}};
+    if (malformed && !batch) {
+        // 逐段模式：截断整个响应体，让客户端在外层 JSON 上失败
+        LocalHttpServer::Response resp;
+        resp.content_type = "application/json";
+        resp.body = resp_body.dump();
+        resp.body.resize(resp.body.size() / 2);
+        return resp;
+    }
+    return json_response(200, resp_body);
+}
+
+} // namespace v2s
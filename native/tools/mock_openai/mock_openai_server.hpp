@@ -0,0 +1,110 @@
+#pragma once
+
+#include "video2srt_native/http_server.hpp"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace v2s {
+
+/**
+ * 本地 OpenAI 兼容模拟服务（/chat/completions），用于离线压测与回归 OpenAITranslator
+ * - 逐段请求：user 消息原样“翻译”为 "[mock] " + 原文
+ * - 批量请求：编号行格式（v2s-lines/1）按行返回 "<n>|[mock] 原文"；
+ *   user 消息为 JSON 字符串数组时返回 {"translations":[...]}；
+ *   系统提示词列出多个目标语言时按 "@<lang>" 分节 / 返回 {"<lang>":[...], ...}
+ * - 支持 stream=true（SSE，按小块 delta 输出，最后 data: [DONE]）
+ * - 延迟模型：基础延迟（fixed/uniform/lognormal 分布）+ 每个输出 token 的生成耗时 + 可选长尾
+ * - 故障注入：5xx、429（带 Retry-After 与 x-ratelimit-* 头）、畸形 JSON、并发超限 429
+ * 响应带 usage（按 estimate_tokens 估算）；线程安全，随机数按种子可复现
+ */
+class MockOpenAIServer {
+public:
+    enum class LatencyDistribution {
+        Fixed,      // 恒为 latency_ms
+        Uniform,    // [latency_ms - jitter_ms, latency_ms + jitter_ms]
+        LogNormal   // 中位数 latency_ms，形状参数 lognormal_sigma
+    };
+
+    struct Options {
+        LatencyDistribution distribution = LatencyDistribution::Fixed;
+        double latency_ms = 50.0;            // 基础延迟（首 token 前）
+        double jitter_ms = 0.0;              // Uniform 分布的半宽
+        double lognormal_sigma = 0.5;        // LogNormal 分布的形状参数
+        double per_output_token_ms = 0.0;    // 每个输出 token 的生成耗时
+        double tail_rate = 0.0;              // 长尾请求比例（额外等待 tail_ms）
+        double tail_ms = 0.0;
+        double error_rate = 0.0;             // 返回 500 的比例
+        double rate_limit_rate = 0.0;        // 返回 429 的比例
+        int retry_after_seconds = 1;         // 429 响应的 Retry-After
+        double malformed_rate = 0.0;         // 返回 200 但 JSON 截断/畸形的比例
+        int max_inflight = 0;                // 同时处理的请求上限，超出返回 429；0 为不限
+        uint32_t seed = 42;
+    };
+
+    struct Stats {
+        uint64_t requests = 0;
+        uint64_t ok = 0;
+        uint64_t errors = 0;                 // 注入的 5xx
+        uint64_t rate_limited = 0;           // 注入或并发超限的 429
+        uint64_t malformed = 0;
+        uint64_t bad_requests = 0;           // 请求体无法解析
+        uint64_t prompt_tokens = 0;
+        uint64_t completion_tokens = 0;
+    };
+
+    explicit MockOpenAIServer(Options options);
+    ~MockOpenAIServer();
+
+    /**
+     * 监听 host:port（port 为 0 时由系统分配）
+     */
+    bool start(const std::string& host = "127.0.0.1", uint16_t port = 0);
+    void stop();
+
+    uint16_t port() const { return server_ ? server_->port() : 0; }
+
+    /**
+     * 供 TranslatorOptions::base_url 使用的完整端点（http://host:port/v1/chat/completions）
+     */
+    std::string base_url() const;
+
+    Stats stats() const;
+    void reset_stats();
+
+private:
+    LocalHttpServer::Response handle(const LocalHttpServer::Request& req);
+    LocalHttpServer::Response handle_completion(const LocalHttpServer::Request& req);
+    double sample_latency_ms(size_t output_tokens);
+    double uniform01();
+
+    Options options_;
+    std::string host_ = "127.0.0.1";
+    std::unique_ptr<LocalHttpServer> server_;
+    std::atomic<int> inflight_{0};
+
+    mutable std::mutex mutex_;   // 保护 rng_ 与 stats_
+    std::mt19937_64 rng_;
+    Stats stats_;
+};
+
+/**
+ * 解析延迟分布名称（fixed / uniform / lognormal），未知名称返回 false
+ */
+bool parse_latency_distribution(const std::string& name, MockOpenAIServer::LatencyDistribution& out);
+
+/**
+ * 解析模拟服务的命令行选项（--latency-ms、--error-rate 等，模拟服务与基准工具共用）
+ * @return 消耗的参数个数；0 表示 argv[i] 不是模拟服务选项；-1 表示缺少参数或取值无效
+ */
+int parse_mock_option(int argc, char** argv, int i, MockOpenAIServer::Options& options);
+
+/**
+ * 打印模拟服务选项的帮助
+ */
+void print_mock_options_help();
+
+} // namespace v2s
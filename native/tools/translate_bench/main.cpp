@@ -0,0 +1,257 @@
+// 翻译吞吐基准：用合成字幕语料驱动 OpenAITranslator::translate_segments（多目标语言时为 translate_segments_multi），
+// 对每组（批量模式 × 请求格式 × 并发数）配置报告请求数/秒、段数/秒、请求延迟 p50/p99，
+// 以及（使用进程内模拟服务时）每段的提示词/译文 token 数
+// 默认在进程内启动模拟服务；--base-url 可改为压测外部（兼容）服务
+
+#include "mock_openai_server.hpp"
+#include "video2srt_native/translator.hpp"
+#include "video2srt_native/stats.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct BenchOptions {
+    size_t segments = 500;
+    std::vector<int> concurrency = {1, 4, 16};
+    std::vector<std::string> modes = {"single", "batch"};   // single / batch / stream
+    std::vector<std::string> formats = {"lines", "json"};   // 批量请求格式（single 模式不适用）
+    int repeat = 1;
+    uint32_t corpus_seed = 7;
+    std::string base_url;                                   // 为空时使用进程内模拟服务
+    std::string api_key = "mock-key";
+    std::string model = "mock-model";
+    std::vector<std::string> target_languages = {"zh"};
+    int max_batch_prompt_tokens = 2000;
+    int retry_count = 3;
+    long max_segment_errors = -1;                           // 失败段总数超过该值时以非零状态退出（-1 不检查）
+};
+
+// 合成字幕语料：5~14 个常见英文单词一句，偶尔带数字与问句，按种子可复现
+std::vector<v2s::Segment> make_corpus(size_t count, uint32_t seed) {
+    static const char* kWords[] = {
+        "the", "you", "what", "we", "have", "to", "go", "now", "this", "is", "not", "my", "time",
+        "know", "think", "right", "there", "want", "just", "they", "come", "back", "really", "people",
+        "going", "need", "something", "tonight", "remember", "never", "always", "house", "water",
+        "listen", "about", "little", "before", "tomorrow", "everything", "nothing", "believe", "together"};
+    std::mt19937 rng(seed);
+    std::uniform_int_distribution<size_t> word(0, sizeof(kWords) / sizeof(kWords[0]) - 1);
+    std::uniform_int_distribution<int> length(5, 14);
+    std::uniform_int_distribution<int> percent(0, 99);
+    std::vector<v2s::Segment> segments;
+    segments.reserve(count);
+    double t = 0.0;
+    for (size_t i = 0; i < count; ++i) {
+        std::string text;
+        const int n = length(rng);
+        for (int w = 0; w < n; ++w) {
+            if (!text.empty()) text += ' ';
+            text += kWords[word(rng)];
+        }
+        if (percent(rng) < 10) text += " " + std::to_string(percent(rng) * 7);
+        text[0] = static_cast<char>(std::toupper(static_cast<unsigned char>(text[0])));
+        text += percent(rng) < 25 ? "?" : ".";
+        const double duration = 1.0 + static_cast<double>(n) * 0.25;
+        segments.emplace_back(t, t + duration, text);
+        t += duration + 0.2;
+    }
+    return segments;
+}
+
+std::vector<int> parse_int_list(const std::string& value) {
+    std::vector<int> out;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(std::stoi(item));
+    }
+    return out;
+}
+
+std::vector<std::string> parse_string_list(const std::string& value) {
+    std::vector<std::string> out;
+    std::stringstream ss(value);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) out.push_back(item);
+    }
+    return out;
+}
+
+void print_usage(const char* prog) {
+    std::cout << "用法: " << prog << " [选项]\n";
+    std::cout << "  --segments <n>          合成语料段数 (默认: 500)\n";
+    std::cout << "  --concurrency <list>    并发数列表，逗号分隔 (默认: 1,4,16)\n";
+    std::cout << "  --modes <list>          single / batch / stream，逗号分隔 (默认: single,batch)\n";
+    std::cout << "  --formats <list>        批量请求格式 lines / json，逗号分隔 (默认: lines,json)\n";
+    std::cout << "  --repeat <n>            每组配置重复次数 (默认: 1)\n";
+    std::cout << "  --targets <list>        目标语言，逗号分隔；多个时批量模式一次请求全部语言 (默认: zh)\n";
+    std::cout << "  --batch-tokens <n>      批量模式每批提示词 token 预算 (默认: 2000)\n";
+    std::cout << "  --retry <n>             翻译器重试次数 (默认: 3)\n";
+    std::cout << "  --corpus-seed <n>       语料随机种子 (默认: 7)\n";
+    std::cout << "  --max-segment-errors <n> 全部配置的失败段总数超过 n 时退出码为 2（用于 ctest，默认不检查）\n";
+    std::cout << "  --base-url <url>        压测外部服务（默认启动进程内模拟服务）\n";
+    std::cout << "  --api-key <key>         外部服务的 API 密钥\n";
+    std::cout << "  --model <name>          模型名称 (默认: mock-model)\n";
+    std::cout << "  -h, --help              显示帮助\n";
+    v2s::print_mock_options_help();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BenchOptions bench;
+    v2s::MockOpenAIServer::Options mock_options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") {
+            print_usage(argv[0]);
+            return 0;
+        }
+        const int consumed = v2s::parse_mock_option(argc, argv, i, mock_options);
+        if (consumed < 0) {
+            std::cerr << "错误: " << arg << " 缺少参数或取值无效\n";
+            return 1;
+        }
+        if (consumed > 0) {
+            i += consumed - 1;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "错误: 未知参数或缺少参数 " << arg << "\n";
+            return 1;
+        }
+        const std::string value = argv[++i];
+        try {
+            if (arg == "--segments") bench.segments = static_cast<size_t>(std::stoul(value));
+            else if (arg == "--concurrency") bench.concurrency = parse_int_list(value);
+            else if (arg == "--modes") bench.modes = parse_string_list(value);
+            else if (arg == "--formats") bench.formats = parse_string_list(value);
+            else if (arg == "--repeat") bench.repeat = std::max(1, std::stoi(value));
+            else if (arg == "--targets") bench.target_languages = parse_string_list(value);
+            else if (arg == "--batch-tokens") bench.max_batch_prompt_tokens = std::stoi(value);
+            else if (arg == "--retry") bench.retry_count = std::stoi(value);
+            else if (arg == "--corpus-seed") bench.corpus_seed = static_cast<uint32_t>(std::stoul(value));
+            else if (arg == "--max-segment-errors") bench.max_segment_errors = std::stol(value);
+            else if (arg == "--base-url") bench.base_url = value;
+            else if (arg == "--api-key") bench.api_key = value;
+            else if (arg == "--model") bench.model = value;
+            else {
+                std::cerr << "错误: 未知参数 " << arg << "\n";
+                print_usage(argv[0]);
+                return 1;
+            }
+        } catch (...) {
+            std::cerr << "错误: " << arg << " 的取值无效: " << value << "\n";
+            return 1;
+        }
+    }
+
+    if (bench.target_languages.empty()) {
+        std::cerr << "错误: --targets 至少需要一种语言\n";
+        return 1;
+    }
+
+    std::unique_ptr<v2s::MockOpenAIServer> mock;
+    std::string base_url = bench.base_url;
+    if (base_url.empty()) {
+        mock = std::make_unique<v2s::MockOpenAIServer>(mock_options);
+        if (!mock->start()) {
+            std::cerr << "错误: 无法启动模拟服务\n";
+            return 1;
+        }
+        base_url = mock->base_url();
+    }
+
+    const auto corpus = make_corpus(bench.segments, bench.corpus_seed);
+    std::cout << "语料: " << corpus.size() << " 段 × " << bench.target_languages.size() << " 种目标语言，服务: " << base_url << "\n";
+    std::printf("%-7s %-5s %5s %8s %7s %7s %9s %9s %9s %9s %7s %7s %7s\n",
+                "mode", "fmt", "conc", "seconds", "reqs", "failed", "req/s", "seg/s", "p50(ms)", "p99(ms)",
+                "in/seg", "out/seg", "seg_err");
+
+    uint64_t total_prompt_tokens = 0;
+    uint64_t total_completion_tokens = 0;
+    size_t total_segment_errors = 0;
+    for (const auto& mode : bench.modes) {
+        if (mode != "single" && mode != "batch" && mode != "stream") {
+            std::cerr << "跳过未知模式: " << mode << "\n";
+            continue;
+        }
+        // 逐段模式不使用批量格式，只跑一次
+        const std::vector<std::string> formats = mode == "single" ? std::vector<std::string>{"-"} : bench.formats;
+        for (const auto& format : formats) {
+            if (format != "-" && format != "lines" && format != "json") {
+                std::cerr << "跳过未知格式: " << format << "\n";
+                continue;
+            }
+            for (int concurrency : bench.concurrency) {
+                for (int run = 0; run < bench.repeat; ++run) {
+                    v2s::TranslatorOptions opts;
+                    opts.base_url = base_url;
+                    opts.api_key = bench.api_key;
+                    opts.model = bench.model;
+                    opts.retry_count = bench.retry_count;
+                    opts.max_concurrency = std::max(1, concurrency);
+                    opts.batch_mode = mode != "single";
+                    opts.stream = mode == "stream";
+                    if (format != "-") opts.batch_format = format;
+                    opts.max_batch_prompt_tokens = bench.max_batch_prompt_tokens;
+                    // 只测量翻译器本身：关闭去重与持久缓存
+                    opts.deduplicate = false;
+                    opts.cache_enabled = false;
+                    auto translator = v2s::create_translator("openai", opts);
+                    if (mock) {
+                        const auto before = mock->stats();
+                        total_prompt_tokens += before.prompt_tokens;
+                        total_completion_tokens += before.completion_tokens;
+                        mock->reset_stats();
+                    }
+
+                    const auto start = std::chrono::steady_clock::now();
+                    const auto results = translator->translate_segments_multi(corpus, bench.target_languages, "en");
+                    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                    const auto http = v2s::summarize_http_requests(results.front().stats);
+                    size_t segment_errors = 0;
+                    for (const auto& r : results) segment_errors += r.failed_indices.size();
+                    total_segment_errors += segment_errors;
+                    // seg/s 与 token/段均按“段 × 目标语言”计
+                    const double translated = static_cast<double>(corpus.size() * results.size());
+                    char in_per_seg[16] = "-";
+                    char out_per_seg[16] = "-";
+                    if (mock) {
+                        const auto s = mock->stats();
+                        std::snprintf(in_per_seg, sizeof(in_per_seg), "%.1f", static_cast<double>(s.prompt_tokens) / translated);
+                        std::snprintf(out_per_seg, sizeof(out_per_seg), "%.1f", static_cast<double>(s.completion_tokens) / translated);
+                    }
+                    std::printf("%-7s %-5s %5d %8.2f %7zu %7zu %9.1f %9.1f %9.1f %9.1f %7s %7s %7zu\n",
+                                mode.c_str(), format.c_str(), concurrency, seconds, http.request_count, http.failed_count,
+                                seconds > 0 ? static_cast<double>(http.request_count) / seconds : 0.0,
+                                seconds > 0 ? translated / seconds : 0.0,
+                                http.latency_p50_ms, http.latency_p99_ms, in_per_seg, out_per_seg, segment_errors);
+                    std::fflush(stdout);
+                }
+            }
+        }
+    }
+
+    if (mock) {
+        const auto s = mock->stats();
+        std::cout << "模拟服务（最后一组）: 请求 " << s.requests << "，成功 " << s.ok << "，500 " << s.errors
+                  << "，429 " << s.rate_limited << "，畸形 " << s.malformed << "\n";
+        std::cout << "模拟服务（全部）: prompt tokens " << total_prompt_tokens + s.prompt_tokens
+                  << "，completion tokens " << total_completion_tokens + s.completion_tokens << "\n";
+    }
+    if (bench.max_segment_errors >= 0 && total_segment_errors > static_cast<size_t>(bench.max_segment_errors)) {
+        std::cerr << "失败段总数 " << total_segment_errors << " 超过上限 " << bench.max_segment_errors << "\n";
+        return 2;
+    }
+    return 0;
+}